@@ -64,21 +64,34 @@
 #define W2N_ENABLE_MEMORY_TRACING 0
 #endif
 
-#ifndef APP_HEAP_SIZE_MIN
-#define APP_HEAP_SIZE_MIN (256)
+/* Protect the EMS heap with a mutex lock so that the host-managed heap
+   can be accessed by multiple host threads, each thread also gets a
+   cache of small objects to reduce the lock contention */
+#ifndef W2N_ENABLE_THREAD_SAFE_HEAP
+#define W2N_ENABLE_THREAD_SAFE_HEAP 0
 #endif
 
-/* Default wasm block address cache size and conflict list size */
-#ifndef BLOCK_ADDR_CACHE_SIZE
-#define BLOCK_ADDR_CACHE_SIZE 64
+#ifndef APP_HEAP_SIZE_MIN
+#define APP_HEAP_SIZE_MIN (256)
 #endif
-#define BLOCK_ADDR_CONFLICT_SIZE 2
 
 /* Default enable pthread */
 #ifndef W2N_ENABLE_PTHREAD
 #define W2N_ENABLE_PTHREAD 1
 #endif
 
+/* Number of the threads which validate the function bodies when loading
+   a wasm module, including the loading thread, 1 disables the worker
+   threads */
+#ifndef W2N_LOADER_THREAD_NUM
+#define W2N_LOADER_THREAD_NUM 4
+#endif
+
+/* Number of the functions which a loader thread validates at a time */
+#ifndef W2N_LOADER_CHUNK_FUNC_NUM
+#define W2N_LOADER_CHUNK_FUNC_NUM 64
+#endif
+
 #ifndef W2N_ENABLE_SPEC_TEST
 #define W2N_ENABLE_SPEC_TEST 0
 #endif
@@ -92,4 +105,47 @@
 #define W2N_MEM_ALLOC_MAX_SIZE (2U * 1024 * 1024 * 1024)
 #endif
 
+/* Max size of the fixed size linear memory which is placed in the .bss
+   section by the compiler, the static data of the generated object must
+   be less than 2GB in the small code model */
+#ifndef W2N_STATIC_MEMORY_MAX_SIZE
+#define W2N_STATIC_MEMORY_MAX_SIZE (1U * 1024 * 1024 * 1024)
+#endif
+
+/* Size of the bytes appended to the linear memory in the bounds mask
+   mode, so that an access at the end of the masked range stays in the
+   allocation, it should cover the max inline memory.copy/fill length */
+#ifndef W2N_BOUNDS_MASK_GUARD_SIZE
+#define W2N_BOUNDS_MASK_GUARD_SIZE 64
+#endif
+
+/* Estimated memory taken by the compiler for each byte of the wasm
+   function bodies, from the LLVM IR to the machine code, it decides
+   how many functions are compiled in a batch under --max-memory */
+#ifndef W2N_COMPILE_MEMORY_PER_CODE_BYTE
+#define W2N_COMPILE_MEMORY_PER_CODE_BYTE 512
+#endif
+
+/* The size of the stdout buffer shared by printf, puts, putchar and
+   fwrite of libc-builtin, set it to 0 to disable the buffering */
+#ifndef LIBC_BUILTIN_OUTPUT_BUF_SIZE
+#define LIBC_BUILTIN_OUTPUT_BUF_SIZE (4 * 1024)
+#endif
+
+/* Max number of the call sites recorded by the sampling allocation
+   profiler of libc-builtin, should be a power of 2 */
+#ifndef LIBC_BUILTIN_ALLOC_SITE_NUM
+#define LIBC_BUILTIN_ALLOC_SITE_NUM 256
+#endif
+
+/* Length from which memory.copy and memory.fill use non-temporal
+   stores, 0 to use the L2 cache size of the host, or at least 80 */
+#ifndef LIBC_BUILTIN_NT_STORE_THRESHOLD
+#define LIBC_BUILTIN_NT_STORE_THRESHOLD 0
+#endif
+
+/* Size of the jmp_buf which the export wrappers reserve on the stack
+   in hw trap mode, the vmlib checks that its jmp_buf fits in it */
+#define WASM_HW_TRAP_JMPBUF_SIZE 256
+
 #endif /* end of _CONFIG_H_ */
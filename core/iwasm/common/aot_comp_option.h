@@ -19,12 +19,27 @@ typedef struct AOTCompOption {
     bool enable_simd;
     bool enable_aux_stack_check;
     bool disable_llvm_lto;
+    bool enable_alloc_profiling;
+    bool trust_alignment_hints;
+    bool check_alignment_hints;
+    bool enable_hw_trap;
+    /* Don't print the target and the options of each module compiled,
+       e.g. when the modules are compiled in parallel */
+    bool quiet_mode;
     uint32_t opt_level;
     uint32_t size_level;
     uint32_t output_format;
+    uint32_t bounds_mode;
     uint32_t heap_size;
+    /* Compile the functions in batches to keep the memory used by the
+       compiler under it, in MB, 0 to compile them at once */
+    uint32_t max_memory;
     char **custom_sections;
     uint32_t custom_sections_count;
+    /* The LLVM target machine to reuse instead of creating one, which was
+       taken from a compile context created with the same options by
+       aot_take_target_machine, it isn't disposed with the compile context */
+    void *target_machine;
 } AOTCompOption, *aot_comp_option_t;
 
 #ifdef __cplusplus
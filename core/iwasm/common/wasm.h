@@ -233,6 +233,20 @@ typedef struct WASMImport {
     } u;
 } WASMImport;
 
+typedef struct BlockAddr {
+    const uint8 *start_addr;
+    uint8 *else_addr;
+    uint8 *end_addr;
+} BlockAddr;
+
+typedef struct BrTableCache {
+    struct BrTableCache *next;
+    /* Address of br_table opcode */
+    uint8 *br_table_op_addr;
+    uint32 br_count;
+    uint32 br_depths[1];
+} BrTableCache;
+
 struct WASMFunction {
     char *name;
     /* the type of function */
@@ -258,8 +272,17 @@ struct WASMFunction {
     uint32 code_size;
     uint8 *code;
 
+    /* Else and end addresses of each block/loop/if, sorted by the start
+       address, recorded when validating the function */
+    BlockAddr *block_addrs;
+    uint32 block_addr_count;
+    /* The br_table opcodes whose depths don't fit in one byte */
+    BrTableCache *br_table_caches;
+
     /* Whether function has opcode memory.grow */
     bool has_op_memory_grow;
+    /* Whether function has opcode memory.size */
+    bool has_op_memory_size;
     /* Whether function has opcode call or call_indirect */
     bool has_op_func_call;
     /* Whether function has memory operation opcodes */
@@ -306,25 +329,11 @@ typedef struct WASMDataSeg {
     uint8 *data;
 } WASMDataSeg;
 
-typedef struct BlockAddr {
-    const uint8 *start_addr;
-    uint8 *else_addr;
-    uint8 *end_addr;
-} BlockAddr;
-
 typedef struct StringNode {
     struct StringNode *next;
     char *str;
 } StringNode, *StringList;
 
-typedef struct BrTableCache {
-    struct BrTableCache *next;
-    /* Address of br_table opcode */
-    uint8 *br_table_op_addr;
-    uint32 br_count;
-    uint32 br_depths[1];
-} BrTableCache;
-
 typedef struct WASMCustomSection {
     struct WASMCustomSection *next;
     /* Start address of the section name */
@@ -479,8 +488,6 @@ struct WASMModule {
     bool possible_memory_grow;
 
     StringList const_str_list;
-    bh_list br_table_cache_list_head;
-    bh_list *br_table_cache_list;
 
     const uint8 *name_section_buf;
     const uint8 *name_section_buf_end;
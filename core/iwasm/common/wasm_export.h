@@ -52,6 +52,11 @@ typedef enum {
     AOT_LLVMIR_OPT_FILE,
 } aot_file_format_t;
 
+typedef enum {
+    AOT_BOUNDS_MODE_CHECK,
+    AOT_BOUNDS_MODE_MASK,
+} aot_bounds_mode_t;
+
 /**
  * Initialize the WASM runtime environment, and also initialize
  * the memory allocator with system allocator, which calls os_malloc
@@ -171,6 +176,43 @@ aot_emit_llvm_file(aot_comp_context_t comp_ctx, const char *file_name);
 bool
 aot_emit_object_file(aot_comp_context_t comp_ctx, const char *file_name);
 
+/**
+ * Take the LLVM target machine of the compile context, which isn't disposed
+ * with the compile context then, so that the next compile contexts created
+ * with the same options can reuse it by option->target_machine. A target
+ * machine doesn't depend on the LLVM context, but it isn't thread safe, it
+ * must not be used by two compile contexts at the same time.
+ *
+ * @param comp_ctx the compile context
+ *
+ * @return the target machine, which should be destroyed by
+ *         aot_destroy_target_machine
+ */
+void *
+aot_take_target_machine(aot_comp_context_t comp_ctx);
+
+void
+aot_destroy_target_machine(void *target_machine);
+
+/**
+ * Get the key to cache the output of compiling a wasm file, which is the
+ * hex string of a SHA-256 hash over the wasm file, the compile options,
+ * the host target, the build configs which change the generated code,
+ * and the versions of the compiler and LLVM.
+ *
+ * @param wasm_file the wasm file content
+ * @param wasm_file_size the size of the wasm file
+ * @param option the compile options
+ * @param key_buf the buffer to return the key, 65 bytes are enough
+ * @param key_buf_size the size of the buffer
+ *
+ * @return true if success, false otherwise
+ */
+bool
+aot_get_cache_key(const uint8_t *wasm_file, uint32_t wasm_file_size,
+                  aot_comp_option_t option, char *key_buf,
+                  uint32_t key_buf_size);
+
 const char *
 aot_get_last_error();
 
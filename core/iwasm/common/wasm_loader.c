@@ -75,12 +75,6 @@ check_buf1(const uint8 *buf, const uint8 *buf_end, uint32 length,
         }                                                                   \
     } while (0)
 
-#define skip_leb(p) while (*p++ & 0x80)
-#define skip_leb_int64(p, p_end) skip_leb(p)
-#define skip_leb_uint32(p, p_end) skip_leb(p)
-#define skip_leb_int32(p, p_end) skip_leb(p)
-#define skip_leb_mem_offset(p, p_end) skip_leb(p)
-
 static bool
 read_leb(uint8 **p_buf, const uint8 *buf_end, uint32 maxbits, bool sign,
          uint64 *p_result, char *error_buf, uint32 error_buf_size)
@@ -3014,6 +3008,109 @@ wasm_loader_prepare_bytecode(WASMModule *module, WASMFunction *func,
                              uint32 cur_func_idx, char *error_buf,
                              uint32 error_buf_size);
 
+#if W2N_ENABLE_PTHREAD != 0 && W2N_LOADER_THREAD_NUM > 1
+#define LOADER_THREAD_STACK_SIZE (256 * 1024)
+
+typedef struct ValidationTask {
+    WASMModule *module;
+    korp_mutex lock;
+    /* Index of the first function of the next chunk to validate */
+    uint32 next_func_idx;
+    /* The lowest index of the functions which failed to validate,
+       -1 if all succeeded */
+    uint32 error_func_idx;
+    char error_buf[256];
+} ValidationTask;
+
+static void *
+validate_funcs_thread(void *arg)
+{
+    ValidationTask *task = (ValidationTask *)arg;
+    WASMModule *module = task->module;
+    char error_buf[sizeof(task->error_buf)];
+    uint32 start, end, i;
+
+    while (true) {
+        os_mutex_lock(&task->lock);
+        start = task->next_func_idx;
+        /* The chunks after a failed function needn't be validated, the
+           chunks before it were taken earlier and are still validated,
+           so that the error of the lowest function index is reported */
+        if (start >= module->function_count || start > task->error_func_idx) {
+            os_mutex_unlock(&task->lock);
+            break;
+        }
+        end = start + W2N_LOADER_CHUNK_FUNC_NUM;
+        if (end > module->function_count)
+            end = module->function_count;
+        task->next_func_idx = end;
+        os_mutex_unlock(&task->lock);
+
+        for (i = start; i < end; i++) {
+            if (!wasm_loader_prepare_bytecode(module, module->functions[i], i,
+                                              error_buf, sizeof(error_buf))) {
+                os_mutex_lock(&task->lock);
+                if (i < task->error_func_idx) {
+                    task->error_func_idx = i;
+                    bh_memcpy_s(task->error_buf, sizeof(task->error_buf),
+                                error_buf, sizeof(error_buf));
+                }
+                os_mutex_unlock(&task->lock);
+                break;
+            }
+        }
+    }
+
+    return NULL;
+}
+
+/**
+ * Validate the function bodies with W2N_LOADER_THREAD_NUM threads including
+ * the current one, each thread takes W2N_LOADER_CHUNK_FUNC_NUM functions at
+ * a time. The functions are validated independently, the only state they
+ * share is the module, which is read only here.
+ */
+static bool
+validate_funcs_parallel(WASMModule *module, char *error_buf,
+                        uint32 error_buf_size)
+{
+    ValidationTask task = { 0 };
+    korp_tid tids[W2N_LOADER_THREAD_NUM - 1];
+    uint32 chunk_num, thread_num = 0, i;
+
+    chunk_num = (module->function_count + W2N_LOADER_CHUNK_FUNC_NUM - 1)
+                / W2N_LOADER_CHUNK_FUNC_NUM;
+
+    task.module = module;
+    task.error_func_idx = (uint32)-1;
+    if (os_mutex_init(&task.lock) != 0) {
+        set_error_buf(error_buf, error_buf_size, "init mutex failed");
+        return false;
+    }
+
+    /* Validate with fewer threads if some of them can't be created */
+    for (i = 0; i < W2N_LOADER_THREAD_NUM - 1 && i + 1 < chunk_num; i++) {
+        if (os_thread_create(&tids[thread_num], validate_funcs_thread, &task,
+                             LOADER_THREAD_STACK_SIZE)
+            != 0)
+            break;
+        thread_num++;
+    }
+
+    validate_funcs_thread(&task);
+
+    for (i = 0; i < thread_num; i++)
+        os_thread_join(tids[i], NULL);
+    os_mutex_destroy(&task.lock);
+
+    if (task.error_func_idx != (uint32)-1) {
+        snprintf(error_buf, error_buf_size, "%s", task.error_buf);
+        return false;
+    }
+    return true;
+}
+#endif
+
 static bool
 load_from_sections(WASMModule *module, WASMSection *sections,
                    bool is_load_from_file_buf, char *error_buf,
@@ -3324,12 +3421,24 @@ load_from_sections(WASMModule *module, WASMSection *sections,
         }
     }
 
-    for (i = 0; i < module->function_count; i++) {
-        WASMFunction *func = module->functions[i];
-        if (!wasm_loader_prepare_bytecode(module, func, i, error_buf,
-                                          error_buf_size)) {
+#if W2N_ENABLE_PTHREAD != 0 && W2N_LOADER_THREAD_NUM > 1
+    if (module->function_count > W2N_LOADER_CHUNK_FUNC_NUM) {
+        if (!validate_funcs_parallel(module, error_buf, error_buf_size))
             return false;
+    }
+    else
+#endif
+    {
+        for (i = 0; i < module->function_count; i++) {
+            if (!wasm_loader_prepare_bytecode(module, module->functions[i], i,
+                                              error_buf, error_buf_size)) {
+                return false;
+            }
         }
+    }
+
+    for (i = 0; i < module->function_count; i++) {
+        WASMFunction *func = module->functions[i];
 
         if (i == module->function_count - 1
             && func->code + func->code_size != buf_code_end) {
@@ -3337,6 +3446,9 @@ load_from_sections(WASMModule *module, WASMSection *sections,
                           "code section size mismatch");
             return false;
         }
+
+        if (func->has_op_memory_grow || func->has_op_memory_size)
+            module->possible_memory_grow = true;
     }
 
     if (!module->possible_memory_grow) {
@@ -3419,7 +3531,6 @@ create_module(char *error_buf, uint32 error_buf_size)
 {
     WASMModule *module =
         loader_malloc(sizeof(WASMModule), error_buf, error_buf_size);
-    bh_list_status ret;
 
     if (!module) {
         return NULL;
@@ -3428,11 +3539,6 @@ create_module(char *error_buf, uint32 error_buf_size)
     /* Set start_function to -1, means no start function */
     module->start_function = (uint32)-1;
 
-    module->br_table_cache_list = &module->br_table_cache_list_head;
-    ret = bh_list_init(module->br_table_cache_list);
-    bh_assert(ret == BH_LIST_SUCCESS);
-
-    (void)ret;
     return module;
 }
 
@@ -3647,6 +3753,17 @@ wasm_loader_unload(WASMModule *module)
             if (module->functions[i]) {
                 if (module->functions[i]->local_offsets)
                     wasm_runtime_free(module->functions[i]->local_offsets);
+                if (module->functions[i]->block_addrs)
+                    wasm_runtime_free(module->functions[i]->block_addrs);
+                if (module->functions[i]->br_table_caches) {
+                    BrTableCache *node = module->functions[i]->br_table_caches;
+                    BrTableCache *node_next;
+                    while (node) {
+                        node_next = node->next;
+                        wasm_runtime_free(node);
+                        node = node_next;
+                    }
+                }
                 wasm_runtime_free(module->functions[i]);
             }
         }
@@ -3690,16 +3807,6 @@ wasm_loader_unload(WASMModule *module)
         }
     }
 
-    if (module->br_table_cache_list) {
-        BrTableCache *node = bh_list_first_elem(module->br_table_cache_list);
-        BrTableCache *node_next;
-        while (node) {
-            node_next = bh_list_elem_next(node);
-            wasm_runtime_free(node);
-            node = node_next;
-        }
-    }
-
     if (module->code_relocs)
         wasm_runtime_free(module->code_relocs);
 
@@ -3713,511 +3820,26 @@ wasm_loader_unload(WASMModule *module)
 }
 
 bool
-wasm_loader_find_block_addr(BlockAddr *block_addr_cache,
-                            const uint8 *start_addr, const uint8 *code_end_addr,
-                            uint8 label_type, uint8 **p_else_addr,
-                            uint8 **p_end_addr)
+wasm_loader_find_block_addr(const WASMFunction *func, const uint8 *start_addr,
+                            uint8 **p_else_addr, uint8 **p_end_addr)
 {
-    const uint8 *p = start_addr, *p_end = code_end_addr;
-    uint8 *else_addr = NULL;
-    char error_buf[128];
-    uint32 block_nested_depth = 1, count, i, j, t;
-    uint32 error_buf_size = sizeof(error_buf);
-    uint8 opcode, u8;
-    BlockAddr block_stack[16] = { { 0 } }, *block;
-
-    i = ((uintptr_t)start_addr) & (uintptr_t)(BLOCK_ADDR_CACHE_SIZE - 1);
-    block = block_addr_cache + BLOCK_ADDR_CONFLICT_SIZE * i;
-
-    for (j = 0; j < BLOCK_ADDR_CONFLICT_SIZE; j++) {
-        if (block[j].start_addr == start_addr) {
-            /* Cache hit */
-            *p_else_addr = block[j].else_addr;
-            *p_end_addr = block[j].end_addr;
+    uint32 low = 0, high = func->block_addr_count, mid;
+
+    /* The block addresses are recorded in the order of the start
+       addresses while validating the function */
+    while (low < high) {
+        mid = low + (high - low) / 2;
+        if (func->block_addrs[mid].start_addr == start_addr) {
+            *p_else_addr = func->block_addrs[mid].else_addr;
+            *p_end_addr = func->block_addrs[mid].end_addr;
             return true;
         }
+        else if (func->block_addrs[mid].start_addr < start_addr)
+            low = mid + 1;
+        else
+            high = mid;
     }
 
-    /* Cache unhit */
-    block_stack[0].start_addr = start_addr;
-
-    while (p < code_end_addr) {
-        opcode = *p++;
-        switch (opcode) {
-            case WASM_OP_UNREACHABLE:
-            case WASM_OP_NOP:
-                break;
-
-            case WASM_OP_BLOCK:
-            case WASM_OP_LOOP:
-            case WASM_OP_IF:
-                /* block result type: 0x40/0x7F/0x7E/0x7D/0x7C */
-                u8 = read_uint8(p);
-                if (block_nested_depth
-                    < sizeof(block_stack) / sizeof(BlockAddr)) {
-                    block_stack[block_nested_depth].start_addr = p;
-                    block_stack[block_nested_depth].else_addr = NULL;
-                }
-                block_nested_depth++;
-                break;
-
-            case EXT_OP_BLOCK:
-            case EXT_OP_LOOP:
-            case EXT_OP_IF:
-                /* block type */
-                skip_leb_int32(p, p_end);
-                if (block_nested_depth
-                    < sizeof(block_stack) / sizeof(BlockAddr)) {
-                    block_stack[block_nested_depth].start_addr = p;
-                    block_stack[block_nested_depth].else_addr = NULL;
-                }
-                block_nested_depth++;
-                break;
-
-            case WASM_OP_ELSE:
-                if (label_type == LABEL_TYPE_IF && block_nested_depth == 1)
-                    else_addr = (uint8 *)(p - 1);
-                if (block_nested_depth - 1
-                    < sizeof(block_stack) / sizeof(BlockAddr))
-                    block_stack[block_nested_depth - 1].else_addr =
-                        (uint8 *)(p - 1);
-                break;
-
-            case WASM_OP_END:
-                if (block_nested_depth == 1) {
-                    if (label_type == LABEL_TYPE_IF)
-                        *p_else_addr = else_addr;
-                    *p_end_addr = (uint8 *)(p - 1);
-
-                    block_stack[0].end_addr = (uint8 *)(p - 1);
-                    for (t = 0; t < sizeof(block_stack) / sizeof(BlockAddr);
-                         t++) {
-                        start_addr = block_stack[t].start_addr;
-                        if (start_addr) {
-                            i = ((uintptr_t)start_addr)
-                                & (uintptr_t)(BLOCK_ADDR_CACHE_SIZE - 1);
-                            block =
-                                block_addr_cache + BLOCK_ADDR_CONFLICT_SIZE * i;
-                            for (j = 0; j < BLOCK_ADDR_CONFLICT_SIZE; j++)
-                                if (!block[j].start_addr)
-                                    break;
-
-                            if (j == BLOCK_ADDR_CONFLICT_SIZE) {
-                                memmove(block + 1, block,
-                                        (BLOCK_ADDR_CONFLICT_SIZE - 1)
-                                            * sizeof(BlockAddr));
-                                j = 0;
-                            }
-                            block[j].start_addr = block_stack[t].start_addr;
-                            block[j].else_addr = block_stack[t].else_addr;
-                            block[j].end_addr = block_stack[t].end_addr;
-                        }
-                        else
-                            break;
-                    }
-                    return true;
-                }
-                else {
-                    block_nested_depth--;
-                    if (block_nested_depth
-                        < sizeof(block_stack) / sizeof(BlockAddr))
-                        block_stack[block_nested_depth].end_addr =
-                            (uint8 *)(p - 1);
-                }
-                break;
-
-            case WASM_OP_BR:
-            case WASM_OP_BR_IF:
-                skip_leb_uint32(p, p_end); /* labelidx */
-                break;
-
-            case WASM_OP_BR_TABLE:
-                read_leb_uint32(p, p_end, count); /* label num */
-                p += count + 1;
-                while (*p == WASM_OP_NOP)
-                    p++;
-                break;
-
-            case EXT_OP_BR_TABLE_CACHE:
-                read_leb_uint32(p, p_end, count); /* label num */
-                while (*p == WASM_OP_NOP)
-                    p++;
-                break;
-
-            case WASM_OP_RETURN:
-                break;
-
-            case WASM_OP_CALL:
-            case WASM_OP_RETURN_CALL:
-                skip_leb_uint32(p, p_end); /* funcidx */
-                break;
-
-            case WASM_OP_CALL_INDIRECT:
-            case WASM_OP_RETURN_CALL_INDIRECT:
-                skip_leb_uint32(p, p_end); /* typeidx */
-                CHECK_BUF(p, p_end, 1);
-                u8 = read_uint8(p); /* 0x00 */
-                break;
-
-            case WASM_OP_DROP:
-            case WASM_OP_SELECT:
-            case WASM_OP_DROP_64:
-            case WASM_OP_SELECT_64:
-                break;
-
-            case WASM_OP_GET_LOCAL:
-            case WASM_OP_SET_LOCAL:
-            case WASM_OP_TEE_LOCAL:
-            case WASM_OP_GET_GLOBAL:
-            case WASM_OP_SET_GLOBAL:
-            case WASM_OP_GET_GLOBAL_64:
-            case WASM_OP_SET_GLOBAL_64:
-            case WASM_OP_SET_GLOBAL_AUX_STACK:
-                skip_leb_uint32(p, p_end); /* local index */
-                break;
-
-            case EXT_OP_GET_LOCAL_FAST:
-            case EXT_OP_SET_LOCAL_FAST:
-            case EXT_OP_TEE_LOCAL_FAST:
-                CHECK_BUF(p, p_end, 1);
-                p++;
-                break;
-
-            case WASM_OP_I32_LOAD:
-            case WASM_OP_I64_LOAD:
-            case WASM_OP_F32_LOAD:
-            case WASM_OP_F64_LOAD:
-            case WASM_OP_I32_LOAD8_S:
-            case WASM_OP_I32_LOAD8_U:
-            case WASM_OP_I32_LOAD16_S:
-            case WASM_OP_I32_LOAD16_U:
-            case WASM_OP_I64_LOAD8_S:
-            case WASM_OP_I64_LOAD8_U:
-            case WASM_OP_I64_LOAD16_S:
-            case WASM_OP_I64_LOAD16_U:
-            case WASM_OP_I64_LOAD32_S:
-            case WASM_OP_I64_LOAD32_U:
-            case WASM_OP_I32_STORE:
-            case WASM_OP_I64_STORE:
-            case WASM_OP_F32_STORE:
-            case WASM_OP_F64_STORE:
-            case WASM_OP_I32_STORE8:
-            case WASM_OP_I32_STORE16:
-            case WASM_OP_I64_STORE8:
-            case WASM_OP_I64_STORE16:
-            case WASM_OP_I64_STORE32:
-                skip_leb_uint32(p, p_end);     /* align */
-                skip_leb_mem_offset(p, p_end); /* offset */
-                break;
-
-            case WASM_OP_MEMORY_SIZE:
-            case WASM_OP_MEMORY_GROW:
-                skip_leb_uint32(p, p_end); /* 0x00 */
-                break;
-
-            case WASM_OP_I32_CONST:
-                skip_leb_int32(p, p_end);
-                break;
-            case WASM_OP_I64_CONST:
-                skip_leb_int64(p, p_end);
-                break;
-            case WASM_OP_F32_CONST:
-                p += sizeof(float32);
-                break;
-            case WASM_OP_F64_CONST:
-                p += sizeof(float64);
-                break;
-
-            case WASM_OP_I32_EQZ:
-            case WASM_OP_I32_EQ:
-            case WASM_OP_I32_NE:
-            case WASM_OP_I32_LT_S:
-            case WASM_OP_I32_LT_U:
-            case WASM_OP_I32_GT_S:
-            case WASM_OP_I32_GT_U:
-            case WASM_OP_I32_LE_S:
-            case WASM_OP_I32_LE_U:
-            case WASM_OP_I32_GE_S:
-            case WASM_OP_I32_GE_U:
-            case WASM_OP_I64_EQZ:
-            case WASM_OP_I64_EQ:
-            case WASM_OP_I64_NE:
-            case WASM_OP_I64_LT_S:
-            case WASM_OP_I64_LT_U:
-            case WASM_OP_I64_GT_S:
-            case WASM_OP_I64_GT_U:
-            case WASM_OP_I64_LE_S:
-            case WASM_OP_I64_LE_U:
-            case WASM_OP_I64_GE_S:
-            case WASM_OP_I64_GE_U:
-            case WASM_OP_F32_EQ:
-            case WASM_OP_F32_NE:
-            case WASM_OP_F32_LT:
-            case WASM_OP_F32_GT:
-            case WASM_OP_F32_LE:
-            case WASM_OP_F32_GE:
-            case WASM_OP_F64_EQ:
-            case WASM_OP_F64_NE:
-            case WASM_OP_F64_LT:
-            case WASM_OP_F64_GT:
-            case WASM_OP_F64_LE:
-            case WASM_OP_F64_GE:
-            case WASM_OP_I32_CLZ:
-            case WASM_OP_I32_CTZ:
-            case WASM_OP_I32_POPCNT:
-            case WASM_OP_I32_ADD:
-            case WASM_OP_I32_SUB:
-            case WASM_OP_I32_MUL:
-            case WASM_OP_I32_DIV_S:
-            case WASM_OP_I32_DIV_U:
-            case WASM_OP_I32_REM_S:
-            case WASM_OP_I32_REM_U:
-            case WASM_OP_I32_AND:
-            case WASM_OP_I32_OR:
-            case WASM_OP_I32_XOR:
-            case WASM_OP_I32_SHL:
-            case WASM_OP_I32_SHR_S:
-            case WASM_OP_I32_SHR_U:
-            case WASM_OP_I32_ROTL:
-            case WASM_OP_I32_ROTR:
-            case WASM_OP_I64_CLZ:
-            case WASM_OP_I64_CTZ:
-            case WASM_OP_I64_POPCNT:
-            case WASM_OP_I64_ADD:
-            case WASM_OP_I64_SUB:
-            case WASM_OP_I64_MUL:
-            case WASM_OP_I64_DIV_S:
-            case WASM_OP_I64_DIV_U:
-            case WASM_OP_I64_REM_S:
-            case WASM_OP_I64_REM_U:
-            case WASM_OP_I64_AND:
-            case WASM_OP_I64_OR:
-            case WASM_OP_I64_XOR:
-            case WASM_OP_I64_SHL:
-            case WASM_OP_I64_SHR_S:
-            case WASM_OP_I64_SHR_U:
-            case WASM_OP_I64_ROTL:
-            case WASM_OP_I64_ROTR:
-            case WASM_OP_F32_ABS:
-            case WASM_OP_F32_NEG:
-            case WASM_OP_F32_CEIL:
-            case WASM_OP_F32_FLOOR:
-            case WASM_OP_F32_TRUNC:
-            case WASM_OP_F32_NEAREST:
-            case WASM_OP_F32_SQRT:
-            case WASM_OP_F32_ADD:
-            case WASM_OP_F32_SUB:
-            case WASM_OP_F32_MUL:
-            case WASM_OP_F32_DIV:
-            case WASM_OP_F32_MIN:
-            case WASM_OP_F32_MAX:
-            case WASM_OP_F32_COPYSIGN:
-            case WASM_OP_F64_ABS:
-            case WASM_OP_F64_NEG:
-            case WASM_OP_F64_CEIL:
-            case WASM_OP_F64_FLOOR:
-            case WASM_OP_F64_TRUNC:
-            case WASM_OP_F64_NEAREST:
-            case WASM_OP_F64_SQRT:
-            case WASM_OP_F64_ADD:
-            case WASM_OP_F64_SUB:
-            case WASM_OP_F64_MUL:
-            case WASM_OP_F64_DIV:
-            case WASM_OP_F64_MIN:
-            case WASM_OP_F64_MAX:
-            case WASM_OP_F64_COPYSIGN:
-            case WASM_OP_I32_WRAP_I64:
-            case WASM_OP_I32_TRUNC_S_F32:
-            case WASM_OP_I32_TRUNC_U_F32:
-            case WASM_OP_I32_TRUNC_S_F64:
-            case WASM_OP_I32_TRUNC_U_F64:
-            case WASM_OP_I64_EXTEND_S_I32:
-            case WASM_OP_I64_EXTEND_U_I32:
-            case WASM_OP_I64_TRUNC_S_F32:
-            case WASM_OP_I64_TRUNC_U_F32:
-            case WASM_OP_I64_TRUNC_S_F64:
-            case WASM_OP_I64_TRUNC_U_F64:
-            case WASM_OP_F32_CONVERT_S_I32:
-            case WASM_OP_F32_CONVERT_U_I32:
-            case WASM_OP_F32_CONVERT_S_I64:
-            case WASM_OP_F32_CONVERT_U_I64:
-            case WASM_OP_F32_DEMOTE_F64:
-            case WASM_OP_F64_CONVERT_S_I32:
-            case WASM_OP_F64_CONVERT_U_I32:
-            case WASM_OP_F64_CONVERT_S_I64:
-            case WASM_OP_F64_CONVERT_U_I64:
-            case WASM_OP_F64_PROMOTE_F32:
-            case WASM_OP_I32_REINTERPRET_F32:
-            case WASM_OP_I64_REINTERPRET_F64:
-            case WASM_OP_F32_REINTERPRET_I32:
-            case WASM_OP_F64_REINTERPRET_I64:
-            case WASM_OP_I32_EXTEND8_S:
-            case WASM_OP_I32_EXTEND16_S:
-            case WASM_OP_I64_EXTEND8_S:
-            case WASM_OP_I64_EXTEND16_S:
-            case WASM_OP_I64_EXTEND32_S:
-                break;
-            case WASM_OP_MISC_PREFIX:
-            {
-                uint32 opcode1;
-
-                read_leb_uint32(p, p_end, opcode1);
-                /* opcode1 was checked in wasm_loader_prepare_bytecode and
-                   is no larger than UINT8_MAX */
-                opcode = (uint8)opcode1;
-
-                switch (opcode) {
-                    case WASM_OP_I32_TRUNC_SAT_S_F32:
-                    case WASM_OP_I32_TRUNC_SAT_U_F32:
-                    case WASM_OP_I32_TRUNC_SAT_S_F64:
-                    case WASM_OP_I32_TRUNC_SAT_U_F64:
-                    case WASM_OP_I64_TRUNC_SAT_S_F32:
-                    case WASM_OP_I64_TRUNC_SAT_U_F32:
-                    case WASM_OP_I64_TRUNC_SAT_S_F64:
-                    case WASM_OP_I64_TRUNC_SAT_U_F64:
-                        break;
-                    case WASM_OP_MEMORY_INIT:
-                        skip_leb_uint32(p, p_end);
-                        /* skip memory idx */
-                        p++;
-                        break;
-                    case WASM_OP_DATA_DROP:
-                        skip_leb_uint32(p, p_end);
-                        break;
-                    case WASM_OP_MEMORY_COPY:
-                        /* skip two memory idx */
-                        p += 2;
-                        break;
-                    case WASM_OP_MEMORY_FILL:
-                        /* skip memory idx */
-                        p++;
-                        break;
-                    default:
-                        return false;
-                }
-                break;
-            }
-
-            case WASM_OP_SIMD_PREFIX:
-            {
-                uint32 opcode1;
-
-                read_leb_uint32(p, p_end, opcode1);
-                /* opcode1 was checked in wasm_loader_prepare_bytecode and
-                   is no larger than UINT8_MAX */
-                opcode = (uint8)opcode1;
-
-                /* follow the order of enum WASMSimdEXTOpcode in wasm_opcode.h
-                 */
-                switch (opcode) {
-                    case SIMD_v128_load:
-                    case SIMD_v128_load8x8_s:
-                    case SIMD_v128_load8x8_u:
-                    case SIMD_v128_load16x4_s:
-                    case SIMD_v128_load16x4_u:
-                    case SIMD_v128_load32x2_s:
-                    case SIMD_v128_load32x2_u:
-                    case SIMD_v128_load8_splat:
-                    case SIMD_v128_load16_splat:
-                    case SIMD_v128_load32_splat:
-                    case SIMD_v128_load64_splat:
-                    case SIMD_v128_store:
-                        /* memarg align */
-                        skip_leb_uint32(p, p_end);
-                        /* memarg offset*/
-                        skip_leb_mem_offset(p, p_end);
-                        break;
-
-                    case SIMD_v128_const:
-                    case SIMD_v8x16_shuffle:
-                        /* immByte[16] immLaneId[16] */
-                        CHECK_BUF1(p, p_end, 16);
-                        p += 16;
-                        break;
-
-                    case SIMD_i8x16_extract_lane_s:
-                    case SIMD_i8x16_extract_lane_u:
-                    case SIMD_i8x16_replace_lane:
-                    case SIMD_i16x8_extract_lane_s:
-                    case SIMD_i16x8_extract_lane_u:
-                    case SIMD_i16x8_replace_lane:
-                    case SIMD_i32x4_extract_lane:
-                    case SIMD_i32x4_replace_lane:
-                    case SIMD_i64x2_extract_lane:
-                    case SIMD_i64x2_replace_lane:
-                    case SIMD_f32x4_extract_lane:
-                    case SIMD_f32x4_replace_lane:
-                    case SIMD_f64x2_extract_lane:
-                    case SIMD_f64x2_replace_lane:
-                        /* ImmLaneId */
-                        CHECK_BUF(p, p_end, 1);
-                        p++;
-                        break;
-
-                    case SIMD_v128_load8_lane:
-                    case SIMD_v128_load16_lane:
-                    case SIMD_v128_load32_lane:
-                    case SIMD_v128_load64_lane:
-                    case SIMD_v128_store8_lane:
-                    case SIMD_v128_store16_lane:
-                    case SIMD_v128_store32_lane:
-                    case SIMD_v128_store64_lane:
-                        /* memarg align */
-                        skip_leb_uint32(p, p_end);
-                        /* memarg offset*/
-                        skip_leb_mem_offset(p, p_end);
-                        /* ImmLaneId */
-                        CHECK_BUF(p, p_end, 1);
-                        p++;
-                        break;
-
-                    case SIMD_v128_load32_zero:
-                    case SIMD_v128_load64_zero:
-                        /* memarg align */
-                        skip_leb_uint32(p, p_end);
-                        /* memarg offset*/
-                        skip_leb_mem_offset(p, p_end);
-                        break;
-
-                    default:
-                        /*
-                         * since latest SIMD specific used almost every value
-                         * from 0x00 to 0xff, the default branch will present
-                         * all opcodes without imm
-                         * https://github.com/WebAssembly/simd/blob/main/proposals/simd/NewOpcodes.md
-                         */
-                        break;
-                }
-                break;
-            }
-
-            case WASM_OP_ATOMIC_PREFIX:
-            {
-                uint32 opcode1;
-
-                read_leb_uint32(p, p_end, opcode1);
-                /* opcode1 was checked in wasm_loader_prepare_bytecode and
-                   is no larger than UINT8_MAX */
-                opcode = (uint8)opcode1;
-
-                if (opcode != WASM_OP_ATOMIC_FENCE) {
-                    skip_leb_uint32(p, p_end);     /* align */
-                    skip_leb_mem_offset(p, p_end); /* offset */
-                }
-                else {
-                    /* atomic.fence doesn't have memarg */
-                    p++;
-                }
-                break;
-            }
-            default:
-                return false;
-        }
-    }
-
-    (void)u8;
-    return false;
-fail:
     return false;
 }
 
@@ -4248,6 +3870,10 @@ typedef struct BranchBlock {
      * pop any type of value directly without decreasing stack top pointer
      * and stack cell num. */
     bool is_stack_polymorphic;
+    /* Whether the else of the if block was added by the loader */
+    bool is_else_virtual;
+    /* Index of the block in the block addresses of the function */
+    uint32 block_addr_idx;
 } BranchBlock;
 
 typedef struct WASMLoaderContext {
@@ -4266,6 +3892,11 @@ typedef struct WASMLoaderContext {
     uint32 frame_csp_size;
     uint32 csp_num;
     uint32 max_csp_num;
+
+    /* block/loop/if addresses, moved to the function when validated */
+    BlockAddr *block_addrs;
+    uint32 block_addr_count;
+    uint32 block_addr_size;
 } WASMLoaderContext;
 
 typedef struct Const {
@@ -4390,6 +4021,8 @@ wasm_loader_ctx_destroy(WASMLoaderContext *ctx)
         if (ctx->frame_csp_bottom) {
             wasm_runtime_free(ctx->frame_csp_bottom);
         }
+        if (ctx->block_addrs)
+            wasm_runtime_free(ctx->block_addrs);
         wasm_runtime_free(ctx);
     }
 }
@@ -4542,6 +4175,36 @@ fail:
     return false;
 }
 
+static bool
+wasm_loader_add_block_addr(WASMLoaderContext *ctx, uint8 *start_addr,
+                           char *error_buf, uint32 error_buf_size)
+{
+    BlockAddr *block_addr;
+
+    if (ctx->block_addr_count * sizeof(BlockAddr) >= ctx->block_addr_size) {
+        if (!ctx->block_addrs) {
+            ctx->block_addr_size = sizeof(BlockAddr) * 8;
+            if (!(ctx->block_addrs = loader_malloc(
+                      ctx->block_addr_size, error_buf, error_buf_size)))
+                goto fail;
+        }
+        else {
+            MEM_REALLOC(ctx->block_addrs, ctx->block_addr_size,
+                        ctx->block_addr_size * 2);
+            ctx->block_addr_size *= 2;
+        }
+    }
+
+    (ctx->frame_csp - 1)->block_addr_idx = ctx->block_addr_count;
+    block_addr = ctx->block_addrs + ctx->block_addr_count++;
+    block_addr->start_addr = start_addr;
+    block_addr->else_addr = NULL;
+    block_addr->end_addr = NULL;
+    return true;
+fail:
+    return false;
+}
+
 static bool
 wasm_loader_pop_frame_csp(WASMLoaderContext *ctx, char *error_buf,
                           uint32 error_buf_size)
@@ -5165,6 +4828,9 @@ wasm_loader_prepare_bytecode(WASMModule *module, WASMFunction *func,
 
                 PUSH_CSP(LABEL_TYPE_BLOCK + (opcode - WASM_OP_BLOCK),
                          block_type, p);
+                if (!wasm_loader_add_block_addr(loader_ctx, p, error_buf,
+                                                error_buf_size))
+                    goto fail;
 
                 /* Pass parameters to block */
                 if (BLOCK_HAS_PARAM(block_type)) {
@@ -5230,13 +4896,22 @@ wasm_loader_prepare_bytecode(WASMModule *module, WASMFunction *func,
                     && !cur_block->else_addr) {
                     opcode = WASM_OP_ELSE;
                     p--;
+                    cur_block->is_else_virtual = true;
                     goto handle_op_else;
                 }
 
                 POP_CSP();
 
                 if (loader_ctx->csp_num > 0) {
+                    BlockAddr *block_addr =
+                        loader_ctx->block_addrs
+                        + loader_ctx->frame_csp->block_addr_idx;
+
                     loader_ctx->frame_csp->end_addr = p - 1;
+                    block_addr->end_addr = p - 1;
+                    if (!loader_ctx->frame_csp->is_else_virtual)
+                        block_addr->else_addr =
+                            loader_ctx->frame_csp->else_addr;
                 }
                 else {
                     /* end of function block, function will return */
@@ -5352,8 +5027,8 @@ wasm_loader_prepare_bytecode(WASMModule *module, WASMFunction *func,
                                 br_table_cache->br_depths[j] = p_depth_begin[j];
                             }
                             br_table_cache->br_depths[i] = depth;
-                            bh_list_insert(module->br_table_cache_list,
-                                           br_table_cache);
+                            br_table_cache->next = func->br_table_caches;
+                            func->br_table_caches = br_table_cache;
                         }
                         else {
                             /* The depth can be stored in one byte, use the
@@ -5809,7 +5484,7 @@ wasm_loader_prepare_bytecode(WASMModule *module, WASMFunction *func,
                 }
                 PUSH_PAGE_COUNT();
 
-                module->possible_memory_grow = true;
+                func->has_op_memory_size = true;
                 func->has_memory_operations = true;
                 break;
 
@@ -5823,7 +5498,6 @@ wasm_loader_prepare_bytecode(WASMModule *module, WASMFunction *func,
                 }
                 POP_AND_PUSH(mem_offset_type, mem_offset_type);
 
-                module->possible_memory_grow = true;
                 func->has_op_memory_grow = true;
                 func->has_memory_operations = true;
                 break;
@@ -7012,6 +6686,9 @@ wasm_loader_prepare_bytecode(WASMModule *module, WASMFunction *func,
 
     func->max_stack_cell_num = loader_ctx->max_stack_cell_num;
     func->max_block_num = loader_ctx->max_csp_num;
+    func->block_addrs = loader_ctx->block_addrs;
+    func->block_addr_count = loader_ctx->block_addr_count;
+    loader_ctx->block_addrs = NULL;
     return_value = true;
 
 fail:
@@ -35,25 +35,20 @@ wasm_loader_unload(WASMModule *module);
 
 /**
  * Find address of related else opcode and end opcode of opcode block/loop/if
- * according to the start address of opcode.
+ * according to the start address of opcode, from the block addresses
+ * recorded when the function was validated.
  *
- * @param module the module to find
+ * @param func the function to find
  * @param start_addr the next address of opcode block/loop/if
- * @param code_end_addr the end address of function code block
- * @param block_type the type of block, 0/1/2 denotes block/loop/if
- * @param p_else_addr returns the else addr if found
+ * @param p_else_addr returns the else addr if found, NULL if the block
+ *        isn't an if block with else branch
  * @param p_end_addr returns the end addr if found
- * @param error_buf returns the error log for this function
- * @param error_buf_size returns the error log string length
  *
  * @return true if success, false otherwise
  */
-
 bool
-wasm_loader_find_block_addr(BlockAddr *block_addr_cache,
-                            const uint8 *start_addr, const uint8 *code_end_addr,
-                            uint8 block_type, uint8 **p_else_addr,
-                            uint8 **p_end_addr);
+wasm_loader_find_block_addr(const WASMFunction *func, const uint8 *start_addr,
+                            uint8 **p_else_addr, uint8 **p_end_addr);
 
 #ifdef __cplusplus
 }
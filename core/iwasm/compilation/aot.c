@@ -5,7 +5,12 @@
 
 #include "aot.h"
 
-static char aot_error[128];
+/* Per thread, as the modules may be compiled by several threads */
+#if defined(_MSC_VER)
+static __declspec(thread) char aot_error[128];
+#else
+static __thread char aot_error[128];
+#endif
 
 const char *
 aot_get_last_error()
@@ -298,6 +303,10 @@ aot_create_funcs(const WASMModule *module)
         funcs[i]->local_cell_num = func->local_cell_num;
         funcs[i]->code = func->code;
         funcs[i]->code_size = func->code_size;
+        funcs[i]->has_op_set_global_aux_stack =
+            func->has_op_set_global_aux_stack;
+        /* Resolved by aot_index_func_code_relocs */
+        funcs[i]->code_reloc_start = funcs[i]->code_reloc_end = 0;
     }
 
     return funcs;
@@ -307,6 +316,43 @@ fail:
     return NULL;
 }
 
+/* Return the index of the first relocation at or after the offset */
+static uint32
+find_first_relocation(const WASMRelocation *relocs, uint32 reloc_count,
+                      uint32 offset)
+{
+    uint32 low = 0, high = reloc_count, mid;
+
+    while (low < high) {
+        mid = low + (high - low) / 2;
+        if (relocs[mid].offset < offset)
+            low = mid + 1;
+        else
+            high = mid;
+    }
+    return low;
+}
+
+/**
+ * Record the range of the code relocations of each function, the loader
+ * has checked that the relocations are sorted by offset.
+ */
+static void
+aot_index_func_code_relocs(const WASMModule *module, AOTFunc **funcs)
+{
+    uint32 code_offset, i;
+
+    for (i = 0; i < module->function_count; i++) {
+        code_offset =
+            (uint32)(uintptr_t)(funcs[i]->code - module->code_section_body);
+        funcs[i]->code_reloc_start = find_first_relocation(
+            module->code_relocs, module->code_reloc_count, code_offset);
+        funcs[i]->code_reloc_end = find_first_relocation(
+            module->code_relocs, module->code_reloc_count,
+            code_offset + funcs[i]->code_size);
+    }
+}
+
 AOTCompData *
 aot_create_comp_data(WASMModule *module, aot_comp_option_t option)
 {
@@ -499,6 +545,8 @@ aot_create_comp_data(WASMModule *module, aot_comp_option_t option)
 
     comp_data->code_reloc_count = module->code_reloc_count;
     comp_data->code_relocs = module->code_relocs;
+    if (comp_data->code_reloc_count && comp_data->func_count)
+        aot_index_func_code_relocs(module, comp_data->funcs);
     comp_data->data_reloc_count = module->data_reloc_count;
     comp_data->data_relocs = module->data_relocs;
     comp_data->symbol_count = module->symbol_count;
@@ -172,6 +172,12 @@ typedef struct AOTFunc {
     uint16 local_cell_num;
     uint32 code_size;
     uint8 *code;
+    /* whether the function sets the aux stack top global */
+    bool has_op_set_global_aux_stack;
+    /* the range [code_reloc_start, code_reloc_end) of the code relocations
+       which belong to the function */
+    uint32 code_reloc_start;
+    uint32 code_reloc_end;
 } AOTFunc;
 
 typedef struct AOTCompData {
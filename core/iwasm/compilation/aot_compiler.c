@@ -190,20 +190,22 @@ aot_compile_func(AOTCompContext *comp_ctx, uint32 func_index)
     float64 f64_const;
 
     /* Ignore relocations that don't belong to current function */
-    for (i = 0; i < comp_data->code_reloc_count; i++) {
-        if (comp_data->code_relocs[i].offset
-            >= (uint32)(uintptr_t)(frame_ip - code_section_body)) {
-            curr_relocation = &comp_data->code_relocs[i];
-            last_relocation =
-                &comp_data->code_relocs[comp_data->code_reloc_count - 1];
-            break;
-        }
+    if (func_ctx->aot_func->code_reloc_start
+        < func_ctx->aot_func->code_reloc_end) {
+        curr_relocation =
+            &comp_data->code_relocs[func_ctx->aot_func->code_reloc_start];
+        last_relocation =
+            &comp_data->code_relocs[func_ctx->aot_func->code_reloc_end - 1];
     }
 
     /* Start to translate the opcodes */
     LLVMPositionBuilderAtEnd(
         comp_ctx->builder,
         func_ctx->block_stack.block_list_head->llvm_entry_block);
+
+    if (!aot_promote_aux_stack_top(comp_ctx, func_ctx))
+        return false;
+
     while (frame_ip < frame_ip_end) {
         opcode = *frame_ip++;
 
@@ -321,15 +323,18 @@ aot_compile_func(AOTCompContext *comp_ctx, uint32 func_index)
 
             case EXT_OP_BR_TABLE_CACHE:
             {
-                BrTableCache *node = bh_list_first_elem(
-                    comp_ctx->comp_data->wasm_module->br_table_cache_list);
+                BrTableCache *node =
+                    comp_data->wasm_module
+                        ->functions[func_ctx->func_idx
+                                    - comp_data->import_func_count]
+                        ->br_table_caches;
                 BrTableCache *node_next;
                 uint8 *p_opcode = frame_ip - 1;
 
                 read_leb_uint32(frame_ip, frame_ip_end, br_count);
 
                 while (node) {
-                    node_next = bh_list_elem_next(node);
+                    node_next = node->next;
                     if (node->br_table_op_addr == p_opcode) {
                         br_depths = node->br_depths;
                         if (!aot_compile_op_br_table(comp_ctx, func_ctx,
@@ -2525,12 +2530,12 @@ fail:
 }
 
 static bool
-verify_module(AOTCompContext *comp_ctx)
+verify_module(LLVMModuleRef module)
 {
     char *msg = NULL;
     bool ret;
 
-    ret = LLVMVerifyModule(comp_ctx->module, LLVMPrintMessageAction, &msg);
+    ret = LLVMVerifyModule(module, LLVMPrintMessageAction, &msg);
     if (!ret && msg) {
         if (msg[0] != '\0') {
             aot_set_last_error(msg);
@@ -2543,6 +2548,106 @@ verify_module(AOTCompContext *comp_ctx)
     return true;
 }
 
+/**
+ * Get the index after the last function of the batch which starts from
+ * func_start, the batch takes at least one function, and the following
+ * ones while their total code size doesn't exceed the batch code size
+ */
+static uint32
+get_batch_func_end(const AOTCompContext *comp_ctx, uint32 func_start)
+{
+    AOTFunc **funcs = comp_ctx->comp_data->funcs;
+    uint64 code_size = funcs[func_start]->code_size;
+    uint32 func_end = func_start + 1;
+
+    while (func_end < comp_ctx->func_ctx_count
+           && code_size + funcs[func_end]->code_size
+                  <= comp_ctx->batch_code_size) {
+        code_size += funcs[func_end]->code_size;
+        func_end++;
+    }
+
+    return func_end;
+}
+
+/**
+ * Compile the functions batch by batch, the IR of a batch is moved to a
+ * module of its own, which is optimized and emitted to an object file
+ * in memory and then released, so that the memory used by LLVM is
+ * bounded by the size of the batch rather than the whole module
+ */
+static bool
+compile_wasm_in_batches(AOTCompContext *comp_ctx)
+{
+    LLVMModuleRef module = NULL;
+    char *err = NULL;
+    uint32 batch_count = 0, func_start, func_end, i;
+    uint64 total_size;
+
+    for (func_start = 0; func_start < comp_ctx->func_ctx_count;
+         func_start = func_end) {
+        func_end = get_batch_func_end(comp_ctx, func_start);
+        batch_count++;
+    }
+
+    total_size = sizeof(LLVMMemoryBufferRef) * (uint64)batch_count;
+    if (!(comp_ctx->batch_objs = wasm_runtime_malloc((uint32)total_size))) {
+        aot_set_last_error("allocate memory failed.");
+        return false;
+    }
+    memset(comp_ctx->batch_objs, 0, (uint32)total_size);
+
+    /* The functions and the runtime globals are referenced across the
+       objects of the batches */
+    aot_externalize_local_symbols(comp_ctx);
+
+    for (func_start = 0; func_start < comp_ctx->func_ctx_count;
+         func_start = func_end) {
+        func_end = get_batch_func_end(comp_ctx, func_start);
+
+        LOG_VERBOSE("Compile batch %u of %u, functions %u to %u",
+                    comp_ctx->batch_obj_count + 1, batch_count, func_start,
+                    func_end - 1);
+
+        for (i = func_start; i < func_end; i++) {
+            if (!aot_compile_func(comp_ctx, i)) {
+                return false;
+            }
+        }
+
+        if (!(module = aot_split_module_batch(comp_ctx, func_start, func_end))
+            || !verify_module(module)) {
+            goto fail;
+        }
+
+        if (comp_ctx->optimize) {
+            aot_apply_llvm_new_pass_manager(comp_ctx, module);
+        }
+
+        if (LLVMTargetMachineEmitToMemoryBuffer(
+                comp_ctx->target_machine, module, LLVMObjectFile, &err,
+                &comp_ctx->batch_objs[comp_ctx->batch_obj_count])
+            != 0) {
+            if (err) {
+                LLVMDisposeMessage(err);
+                err = NULL;
+            }
+            aot_set_last_error("emit elf to memory buffer failed.");
+            goto fail;
+        }
+        comp_ctx->batch_obj_count++;
+
+        LLVMDisposeModule(module);
+        module = NULL;
+    }
+
+    return true;
+fail:
+    if (module)
+        LLVMDisposeModule(module);
+    return false;
+}
+
 bool
 aot_compile_wasm(AOTCompContext *comp_ctx)
 {
@@ -2553,6 +2658,11 @@ aot_compile_wasm(AOTCompContext *comp_ctx)
         return false;
     }
 
+    if (comp_ctx->batch_code_size > 0) {
+        bh_print_time("Begin to compile WASM bytecode in batches");
+        return compile_wasm_in_batches(comp_ctx);
+    }
+
     bh_print_time("Begin to compile WASM bytecode to LLVM IR");
     for (i = 0; i < comp_ctx->func_ctx_count; i++) {
         if (!aot_compile_func(comp_ctx, i)) {
@@ -2561,7 +2671,7 @@ aot_compile_wasm(AOTCompContext *comp_ctx)
     }
 
     bh_print_time("Begin to verify LLVM module");
-    if (!verify_module(comp_ctx)) {
+    if (!verify_module(comp_ctx->module)) {
         return false;
     }
 
@@ -2605,10 +2715,17 @@ aot_emit_object_file(AOTCompContext *comp_ctx, const char *file_name)
     char *err = NULL;
     LLVMCodeGenFileType file_type = LLVMObjectFile;
 
+    if (comp_ctx->batch_obj_count > 0) {
+        bh_print_time("Begin to write the objects of the batches");
+        return aot_write_object_archive(file_name, comp_ctx->batch_objs,
+                                        comp_ctx->batch_obj_count);
+    }
+
     bh_print_time("Begin to emit object file");
 
+    /* The C API takes a non-const file name which it doesn't change */
     if (LLVMTargetMachineEmitToFile(comp_ctx->target_machine, comp_ctx->module,
-                                    file_name, file_type, &err)
+                                    (char *)file_name, file_type, &err)
         != 0) {
         if (err) {
             LLVMDisposeMessage(err);
@@ -93,6 +93,15 @@ check_type_compatible(uint8 src_type, uint8 dst_type)
     return false;
 }
 
+/* Whether the function returns all its results in a struct instead of
+   storing the extra ones through pointer parameters */
+static inline bool
+aot_func_ret_in_regs(const AOTFuncContext *func_ctx)
+{
+    return func_ctx->is_internal
+           && func_ctx->aot_func->func_type->result_count > 1;
+}
+
 #define CHECK_STACK()                                          \
     do {                                                       \
         if (!func_ctx->block_stack.block_list_end) {           \
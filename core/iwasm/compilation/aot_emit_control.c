@@ -6,6 +6,7 @@
 #include "aot_emit_control.h"
 #include "aot_compiler.h"
 #include "aot_emit_exception.h"
+#include "aot_emit_variable.h"
 #include "../common/wasm_loader.h"
 
 static char *block_name_prefix[] = { "block", "loop", "if" };
@@ -159,7 +160,7 @@ handle_next_reachable_block(AOTCompContext *comp_ctx, AOTFuncContext *func_ctx,
     uint8 *frame_ip = NULL;
     uint32 i;
     AOTFuncType *func_type;
-    LLVMValueRef ret;
+    LLVMValueRef ret, ret_struct = NULL;
 
     bh_assert(block);
 
@@ -229,11 +230,23 @@ handle_next_reachable_block(AOTCompContext *comp_ctx, AOTFuncContext *func_ctx,
     /* Pop block, push its return value, and destroy the block */
     block = aot_block_stack_pop(&func_ctx->block_stack);
     func_type = func_ctx->aot_func->func_type;
+    if (block->label_type == LABEL_TYPE_FUNCTION
+        && aot_func_ret_in_regs(func_ctx))
+        ret_struct = LLVMGetUndef(LLVMGetReturnType(func_ctx->func_type));
     for (i = 0; i < block->result_count; i++) {
         bh_assert(block->result_phis[i]);
         if (block->label_type != LABEL_TYPE_FUNCTION) {
             PUSH(block->result_phis[i], block->result_types[i]);
         }
+        else if (aot_func_ret_in_regs(func_ctx)) {
+            /* Collect all the return values into the returned struct */
+            if (!(ret_struct = LLVMBuildInsertValue(
+                      comp_ctx->builder, ret_struct, block->result_phis[i], i,
+                      "ret_struct"))) {
+                aot_set_last_error("llvm build insert value failed.");
+                goto fail;
+            }
+        }
         else {
             /* Store extra return values to function parameters */
             if (i != 0) {
@@ -250,7 +263,15 @@ handle_next_reachable_block(AOTCompContext *comp_ctx, AOTFuncContext *func_ctx,
         }
     }
     if (block->label_type == LABEL_TYPE_FUNCTION) {
-        if (block->result_count) {
+        if (!aot_commit_aux_stack_top(comp_ctx, func_ctx, false))
+            goto fail;
+        if (aot_func_ret_in_regs(func_ctx)) {
+            if (!(ret = LLVMBuildRet(comp_ctx->builder, ret_struct))) {
+                aot_set_last_error("llvm build return failed.");
+                goto fail;
+            }
+        }
+        else if (block->result_count) {
             /* Return the first return value */
             if (!(ret =
                       LLVMBuildRet(comp_ctx->builder, block->result_phis[0]))) {
@@ -397,7 +418,7 @@ aot_compile_op_block(AOTCompContext *comp_ctx, AOTFuncContext *func_ctx,
                      uint32 param_count, uint8 *param_types,
                      uint32 result_count, uint8 *result_types)
 {
-    BlockAddr block_addr_cache[BLOCK_ADDR_CACHE_SIZE][BLOCK_ADDR_CONFLICT_SIZE];
+    WASMModule *wasm_module = comp_ctx->comp_data->wasm_module;
     AOTBlock *block;
     uint8 *else_addr, *end_addr;
     LLVMValueRef value;
@@ -409,12 +430,11 @@ aot_compile_op_block(AOTCompContext *comp_ctx, AOTFuncContext *func_ctx,
         return false;
     }
 
-    memset(block_addr_cache, 0, sizeof(block_addr_cache));
-
     /* Get block info */
     if (!(wasm_loader_find_block_addr(
-            (BlockAddr *)block_addr_cache, *p_frame_ip, frame_ip_end,
-            (uint8)label_type, &else_addr, &end_addr))) {
+            wasm_module->functions[func_ctx->func_idx
+                                   - comp_ctx->import_func_count],
+            *p_frame_ip, &else_addr, &end_addr))) {
         aot_set_last_error("find block end addr failed.");
         return false;
     }
@@ -861,15 +881,22 @@ fail:
     return false;
 }
 
+/* The switch target of the br_table entries with the same depth */
+typedef struct BrTableTarget {
+    LLVMBasicBlockRef llvm_block;
+    uint32 entry_count;
+} BrTableTarget;
+
 bool
 aot_compile_op_br_table(AOTCompContext *comp_ctx, AOTFuncContext *func_ctx,
                         uint32 *br_depths, uint32 br_count, uint8 **p_frame_ip)
 {
-    uint32 i, j;
+    uint32 i, j, max_depth = 0;
     LLVMValueRef value_switch, value_cmp, value_case, value, *values = NULL;
     LLVMBasicBlockRef default_llvm_block = NULL, target_llvm_block;
-    LLVMBasicBlockRef next_llvm_end_block;
+    LLVMBasicBlockRef next_llvm_end_block, block_curr;
     AOTBlock *target_block;
+    BrTableTarget *targets = NULL;
     uint32 br_depth, depth_idx;
     uint32 param_index, result_index;
     uint64 size;
@@ -890,11 +917,41 @@ aot_compile_op_br_table(AOTCompContext *comp_ctx, AOTFuncContext *func_ctx,
     }
 
     if (!LLVMIsEfficientConstInt(value_cmp)) {
-        /* Compare value is not constant, create switch IR */
+        /* Compare value is not constant, create switch IR. The entries
+           of the same depth share one edge to the target: the values are
+           added to its phis once, and if the target takes values and has
+           several entries, their cases go to a br_table_case block which
+           jumps to it, so the phis have one incoming value per target
+           instead of one per entry */
+        for (i = 0; i <= br_count; i++) {
+            if (br_depths[i] > max_depth)
+                max_depth = br_depths[i];
+        }
+
+        size = sizeof(BrTableTarget) * ((uint64)max_depth + 1);
+        if (size >= UINT32_MAX
+            || !(targets = wasm_runtime_malloc((uint32)size))) {
+            aot_set_last_error("allocate memory failed.");
+            goto fail;
+        }
+        memset(targets, 0, (uint32)size);
+
+        for (i = 0; i <= br_count; i++)
+            targets[br_depths[i]].entry_count++;
+
+        block_curr = CURR_BLOCK();
+
         for (i = 0; i <= br_count; i++) {
+            BrTableTarget *target = &targets[br_depths[i]];
+            uint32 value_count;
+
+            if (target->llvm_block)
+                /* The target is handled by a previous entry */
+                continue;
+
             target_block = get_target_block(func_ctx, br_depths[i]);
             if (!target_block)
-                return false;
+                goto fail;
 
             if (target_block->label_type != LABEL_TYPE_LOOP) {
                 /* Dest block is Block/If/Function block */
@@ -909,15 +966,34 @@ aot_compile_op_br_table(AOTCompContext *comp_ctx, AOTFuncContext *func_ctx,
                         MOVE_BLOCK_BEFORE(target_block->llvm_end_block,
                                           next_llvm_end_block);
                 }
+                target_llvm_block = target_block->llvm_end_block;
+                value_count = target_block->result_count;
+                target_block->is_reachable = true;
+            }
+            else {
+                target_llvm_block = target_block->llvm_entry_block;
+                value_count = target_block->param_count;
+            }
+
+            target->llvm_block = target_llvm_block;
+            if (value_count > 0 && target->entry_count > 1) {
+                CREATE_BLOCK(target->llvm_block, "br_table_case");
+                MOVE_BLOCK_AFTER(target->llvm_block, block_curr);
+                SET_BUILDER_POS(target->llvm_block);
+            }
+
+            if (value_count > 0) {
+                size = sizeof(LLVMValueRef) * (uint64)value_count;
+                if (size >= UINT32_MAX
+                    || !(values = wasm_runtime_malloc((uint32)size))) {
+                    aot_set_last_error("allocate memory failed.");
+                    goto fail;
+                }
+            }
+
+            if (target_block->label_type != LABEL_TYPE_LOOP) {
                 /* Handle result values */
                 if (target_block->result_count) {
-                    size = sizeof(LLVMValueRef)
-                           * (uint64)target_block->result_count;
-                    if (size >= UINT32_MAX
-                        || !(values = wasm_runtime_malloc((uint32)size))) {
-                        aot_set_last_error("allocate memory failed.");
-                        goto fail;
-                    }
                     CREATE_RESULT_VALUE_PHIS(target_block);
                     for (j = 0; j < target_block->result_count; j++) {
                         result_index = target_block->result_count - 1 - j;
@@ -928,23 +1004,11 @@ aot_compile_op_br_table(AOTCompContext *comp_ctx, AOTFuncContext *func_ctx,
                     for (j = 0; j < target_block->result_count; j++) {
                         PUSH(values[j], target_block->result_types[j]);
                     }
-                    wasm_runtime_free(values);
-                    values = NULL;
                 }
-                target_block->is_reachable = true;
-                if (i == br_count)
-                    default_llvm_block = target_block->llvm_end_block;
             }
             else {
                 /* Handle Loop parameters */
                 if (target_block->param_count) {
-                    size = sizeof(LLVMValueRef)
-                           * (uint64)target_block->param_count;
-                    if (size >= UINT32_MAX
-                        || !(values = wasm_runtime_malloc((uint32)size))) {
-                        aot_set_last_error("allocate memory failed.");
-                        goto fail;
-                    }
                     for (j = 0; j < target_block->param_count; j++) {
                         param_index = target_block->param_count - 1 - j;
                         POP(value, target_block->param_types[param_index]);
@@ -954,34 +1018,41 @@ aot_compile_op_br_table(AOTCompContext *comp_ctx, AOTFuncContext *func_ctx,
                     for (j = 0; j < target_block->param_count; j++) {
                         PUSH(values[j], target_block->param_types[j]);
                     }
-                    wasm_runtime_free(values);
-                    values = NULL;
                 }
-                if (i == br_count)
-                    default_llvm_block = target_block->llvm_entry_block;
+            }
+
+            if (values) {
+                wasm_runtime_free(values);
+                values = NULL;
+            }
+
+            if (target->llvm_block != target_llvm_block) {
+                BUILD_BR(target_llvm_block);
+                SET_BUILDER_POS(block_curr);
             }
         }
 
+        default_llvm_block = targets[br_depths[br_count]].llvm_block;
+
         /* Create switch IR */
         if (!(value_switch = LLVMBuildSwitch(comp_ctx->builder, value_cmp,
                                              default_llvm_block, br_count))) {
             aot_set_last_error("llvm build switch failed.");
-            return false;
+            goto fail;
         }
 
-        /* Add each case for switch IR */
+        /* Add each case for switch IR, except the ones going to the
+           default target */
         for (i = 0; i < br_count; i++) {
+            target_llvm_block = targets[br_depths[i]].llvm_block;
+            if (target_llvm_block == default_llvm_block)
+                continue;
             value_case = I32_CONST(i);
             CHECK_LLVM_CONST(value_case);
-            target_block = get_target_block(func_ctx, br_depths[i]);
-            if (!target_block)
-                return false;
-            target_llvm_block = target_block->label_type != LABEL_TYPE_LOOP
-                                    ? target_block->llvm_end_block
-                                    : target_block->llvm_entry_block;
             LLVMAddCase(value_switch, value_case, target_llvm_block);
         }
 
+        wasm_runtime_free(targets);
         return handle_next_reachable_block(comp_ctx, func_ctx, p_frame_ip);
     }
     else {
@@ -996,6 +1067,8 @@ aot_compile_op_br_table(AOTCompContext *comp_ctx, AOTFuncContext *func_ctx,
 fail:
     if (values)
         wasm_runtime_free(values);
+    if (targets)
+        wasm_runtime_free(targets);
     return false;
 }
 
@@ -1004,7 +1077,7 @@ aot_compile_op_return(AOTCompContext *comp_ctx, AOTFuncContext *func_ctx,
                       uint8 **p_frame_ip)
 {
     AOTBlock *block_func = func_ctx->block_stack.block_list_head;
-    LLVMValueRef value;
+    LLVMValueRef value, result;
     LLVMValueRef ret;
     AOTFuncType *func_type;
     uint32 i, param_index, result_index;
@@ -1012,7 +1085,28 @@ aot_compile_op_return(AOTCompContext *comp_ctx, AOTFuncContext *func_ctx,
     bh_assert(block_func);
     func_type = func_ctx->aot_func->func_type;
 
-    if (block_func->result_count) {
+    if (!aot_commit_aux_stack_top(comp_ctx, func_ctx, false))
+        goto fail;
+
+    if (aot_func_ret_in_regs(func_ctx)) {
+        /* Return all the result values in a struct */
+        value = LLVMGetUndef(LLVMGetReturnType(func_ctx->func_type));
+        for (i = 0; i < block_func->result_count; i++) {
+            result_index = block_func->result_count - 1 - i;
+            POP(result, block_func->result_types[result_index]);
+            if (!(value = LLVMBuildInsertValue(comp_ctx->builder, value,
+                                               result, result_index,
+                                               "ret_struct"))) {
+                aot_set_last_error("llvm build insert value failed.");
+                goto fail;
+            }
+        }
+        if (!(ret = LLVMBuildRet(comp_ctx->builder, value))) {
+            aot_set_last_error("llvm build return failed.");
+            goto fail;
+        }
+    }
+    else if (block_func->result_count) {
         /* Store extra result values to function parameters */
         for (i = 0; i < block_func->result_count - 1; i++) {
             LLVMValueRef res;
@@ -18,6 +18,131 @@ call_fcmp_intrinsic(AOTCompContext *comp_ctx, AOTFuncContext *func_ctx,
     return res;
 }
 
+#define ADD_BASIC_BLOCK(block, name)                                           \
+    do {                                                                       \
+        if (!(block = LLVMAppendBasicBlockInContext(comp_ctx->context,         \
+                                                    func_ctx->func, name))) {  \
+            aot_set_last_error("llvm add basic block failed.");                \
+            goto fail;                                                         \
+        }                                                                      \
+                                                                               \
+        LLVMMoveBasicBlockAfter(block, LLVMGetInsertBlock(comp_ctx->builder)); \
+    } while (0)
+
+/* Convert with the x86-64 cvttss2si/cvttsd2si, which don't fault but
+   return the "integer indefinite" value 0x8000000000000000 on NaN or
+   overflow, so a single integer check of the result replaces the float
+   range checks, and the float checks only run on the trap path */
+static bool
+trunc_float_to_int_hw_trap(AOTCompContext *comp_ctx, AOTFuncContext *func_ctx,
+                           LLVMValueRef operand, LLVMTypeRef src_type,
+                           LLVMTypeRef dest_type, char *name, bool sign)
+{
+    bool is_f32 = src_type == F32_TYPE;
+    LLVMTypeRef vec_type = is_f32 ? V128_f32x4_TYPE : V128_f64x2_TYPE;
+    LLVMBasicBlockRef check_min_block = NULL, trap_block, overflow_block;
+    LLVMBasicBlockRef check_succ;
+    LLVMValueRef vec, res, in_range, is_min, is_nan, cond_br, min_value;
+
+    if (!(vec = LLVMBuildInsertElement(comp_ctx->builder,
+                                       LLVMGetUndef(vec_type), operand,
+                                       I32_ZERO, "vec"))) {
+        aot_set_last_error("llvm build insert element failed.");
+        goto fail;
+    }
+
+    if (!(res = aot_call_llvm_intrinsic(
+              comp_ctx, func_ctx,
+              is_f32 ? "llvm.x86.sse.cvttss2si64" : "llvm.x86.sse2.cvttsd2si64",
+              I64_TYPE, &vec_type, 1, vec)))
+        goto fail;
+
+    if (dest_type == I32_TYPE && sign) {
+        LLVMValueRef res_i32, res_i64;
+        if (!(res_i32 = LLVMBuildTrunc(comp_ctx->builder, res, I32_TYPE,
+                                       "res_i32"))
+            || !(res_i64 = LLVMBuildSExt(comp_ctx->builder, res_i32, I64_TYPE,
+                                         "res_i64"))) {
+            aot_set_last_error("llvm build conversion failed.");
+            goto fail;
+        }
+        in_range = LLVMBuildICmp(comp_ctx->builder, LLVMIntEQ, res_i64, res,
+                                 "in_range");
+    }
+    else if (dest_type == I32_TYPE) {
+        in_range = LLVMBuildICmp(comp_ctx->builder, LLVMIntULE, res,
+                                 I64_CONST(UINT32_MAX), "in_range");
+    }
+    else {
+        bh_assert(sign);
+        in_range = LLVMBuildICmp(comp_ctx->builder, LLVMIntNE, res, I64_MIN,
+                                 "in_range");
+    }
+    if (!in_range) {
+        aot_set_last_error("llvm build icmp failed.");
+        goto fail;
+    }
+
+    ADD_BASIC_BLOCK(check_succ, "check_succ");
+    ADD_BASIC_BLOCK(trap_block, "trunc_trap");
+    if (dest_type == I64_TYPE)
+        ADD_BASIC_BLOCK(check_min_block, "check_min");
+
+    if (!(cond_br = LLVMBuildCondBr(comp_ctx->builder, in_range, check_succ,
+                                    check_min_block ? check_min_block
+                                                    : trap_block))) {
+        aot_set_last_error("llvm build cond br failed.");
+        goto fail;
+    }
+    aot_set_unlikely_branch(comp_ctx, cond_br, false);
+
+    if (check_min_block) {
+        /* INT64_MIN is also the result of converting -2^63 */
+        LLVMPositionBuilderAtEnd(comp_ctx->builder, check_min_block);
+        min_value = is_f32 ? F32_CONST(-9223372036854775808.0f)
+                           : F64_CONST(-9223372036854775808.0);
+        CHECK_LLVM_CONST(min_value);
+        if (!(is_min = LLVMBuildFCmp(comp_ctx->builder, LLVMRealOEQ, operand,
+                                     min_value, "is_min"))) {
+            aot_set_last_error("llvm build fcmp failed.");
+            goto fail;
+        }
+        if (!LLVMBuildCondBr(comp_ctx->builder, is_min, check_succ,
+                             trap_block)) {
+            aot_set_last_error("llvm build cond br failed.");
+            goto fail;
+        }
+    }
+
+    LLVMPositionBuilderAtEnd(comp_ctx->builder, trap_block);
+    if (!(is_nan = LLVMBuildFCmp(comp_ctx->builder, LLVMRealUNO, operand,
+                                 operand, "is_nan"))) {
+        aot_set_last_error("llvm build fcmp failed.");
+        goto fail;
+    }
+    ADD_BASIC_BLOCK(overflow_block, "trunc_overflow");
+    if (!aot_emit_exception(comp_ctx, func_ctx,
+                            EXCE_INVALID_CONVERSION_TO_INTEGER, true, is_nan,
+                            overflow_block)
+        || !aot_emit_exception(comp_ctx, func_ctx, EXCE_INTEGER_OVERFLOW,
+                               false, NULL, NULL))
+        goto fail;
+
+    LLVMPositionBuilderAtEnd(comp_ctx->builder, check_succ);
+    if (dest_type == I32_TYPE) {
+        if (!(res = LLVMBuildTrunc(comp_ctx->builder, res, I32_TYPE, name))) {
+            aot_set_last_error("llvm build conversion failed.");
+            goto fail;
+        }
+        PUSH_I32(res);
+    }
+    else
+        PUSH_I64(res);
+    return true;
+fail:
+    return false;
+}
+
 static bool
 trunc_float_to_int(AOTCompContext *comp_ctx, AOTFuncContext *func_ctx,
                    LLVMValueRef operand, LLVMTypeRef src_type,
@@ -27,6 +152,11 @@ trunc_float_to_int(AOTCompContext *comp_ctx, AOTFuncContext *func_ctx,
     LLVMBasicBlockRef check_nan_succ, check_overflow_succ;
     LLVMValueRef is_less, is_greater, res;
 
+    /* i64.trunc_f32_u and i64.trunc_f64_u have no native instruction */
+    if (comp_ctx->enable_hw_trap && (dest_type == I32_TYPE || sign))
+        return trunc_float_to_int_hw_trap(comp_ctx, func_ctx, operand,
+                                          src_type, dest_type, name, sign);
+
     res = call_fcmp_intrinsic(comp_ctx, func_ctx, FLOAT_UNO, LLVMRealUNO,
                               operand, operand, src_type, "fcmp_is_nan");
 
@@ -108,17 +238,6 @@ fail:
     return false;
 }
 
-#define ADD_BASIC_BLOCK(block, name)                                           \
-    do {                                                                       \
-        if (!(block = LLVMAppendBasicBlockInContext(comp_ctx->context,         \
-                                                    func_ctx->func, name))) {  \
-            aot_set_last_error("llvm add basic block failed.");                \
-            goto fail;                                                         \
-        }                                                                      \
-                                                                               \
-        LLVMMoveBasicBlockAfter(block, LLVMGetInsertBlock(comp_ctx->builder)); \
-    } while (0)
-
 static bool
 trunc_sat_float_to_int(AOTCompContext *comp_ctx, AOTFuncContext *func_ctx,
                        LLVMValueRef operand, LLVMTypeRef src_type,
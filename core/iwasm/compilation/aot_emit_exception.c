@@ -4,6 +4,7 @@
  */
 
 #include "aot_emit_exception.h"
+#include "aot_emit_variable.h"
 #include "../common/wasm_runtime.h"
 
 bool
@@ -12,7 +13,7 @@ aot_emit_exception(AOTCompContext *comp_ctx, AOTFuncContext *func_ctx,
                    LLVMBasicBlockRef cond_br_else_block)
 {
     LLVMBasicBlockRef block_curr = LLVMGetInsertBlock(comp_ctx->builder);
-    LLVMValueRef exce_id;
+    LLVMValueRef exce_id, cond_br;
 
     if (comp_ctx->no_sandbox_mode) {
         /* Create return IR */
@@ -20,6 +21,9 @@ aot_emit_exception(AOTCompContext *comp_ctx, AOTFuncContext *func_ctx,
 
         bh_assert(!is_cond_br);
 
+        if (!aot_commit_aux_stack_top(comp_ctx, func_ctx, false))
+            return false;
+
         if (!aot_build_zero_function_ret(comp_ctx, func_ctx, aot_func_type)) {
             return false;
         }
@@ -49,16 +53,22 @@ aot_emit_exception(AOTCompContext *comp_ctx, AOTFuncContext *func_ctx,
             return false;
         }
 
-        LLVMValueRef exce_id_global;
+        LLVMValueRef throw_func;
 
-        exce_id_global = LLVMGetNamedGlobal(comp_ctx->module, "exception_id");
-        bh_assert(exce_id_global);
-        if (!LLVMBuildStore(comp_ctx->builder, func_ctx->exception_id_phi,
-                            exce_id_global)) {
-            aot_set_last_error("llvm build store failed.");
+        /* Call the cold wasm_throw_exception function to set the exception,
+           which marks the block and the paths to it as cold */
+        throw_func = LLVMGetNamedFunction(comp_ctx->module, "wasm_throw_exception");
+        bh_assert(throw_func);
+        if (!LLVMBuildCall2(comp_ctx->builder,
+                            LLVMGlobalGetValueType(throw_func), throw_func,
+                            &func_ctx->exception_id_phi, 1, "")) {
+            aot_set_last_error("llvm build call failed.");
             return false;
         }
 
+        if (!aot_commit_aux_stack_top(comp_ctx, func_ctx, false))
+            return false;
+
         /* Create return IR */
         AOTFuncType *aot_func_type = func_ctx->aot_func->func_type;
         if (!aot_build_zero_function_ret(comp_ctx, func_ctx, aot_func_type)) {
@@ -81,12 +91,13 @@ aot_emit_exception(AOTCompContext *comp_ctx, AOTFuncContext *func_ctx,
     }
     else {
         /* Create condition br */
-        if (!LLVMBuildCondBr(comp_ctx->builder, cond_br_if,
-                             func_ctx->got_exception_block,
-                             cond_br_else_block)) {
+        if (!(cond_br = LLVMBuildCondBr(comp_ctx->builder, cond_br_if,
+                                        func_ctx->got_exception_block,
+                                        cond_br_else_block))) {
             aot_set_last_error("llvm build cond br failed.");
             return false;
         }
+        aot_set_unlikely_branch(comp_ctx, cond_br, true);
         /* Start to translate the else block */
         LLVMPositionBuilderAtEnd(comp_ctx->builder, cond_br_else_block);
     }
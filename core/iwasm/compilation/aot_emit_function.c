@@ -6,6 +6,7 @@
 #include "aot_emit_function.h"
 #include "aot_emit_exception.h"
 #include "aot_emit_control.h"
+#include "aot_emit_variable.h"
 
 #define ADD_BASIC_BLOCK(block, name)                                          \
     do {                                                                      \
@@ -33,6 +34,8 @@ create_func_return_block(AOTCompContext *comp_ctx, AOTFuncContext *func_ctx)
         /* Create return IR */
         LLVMPositionBuilderAtEnd(comp_ctx->builder,
                                  func_ctx->func_return_block);
+        if (!aot_commit_aux_stack_top(comp_ctx, func_ctx, false))
+            return false;
         if (!aot_build_zero_function_ret(comp_ctx, func_ctx, aot_func_type)) {
             return false;
         }
@@ -47,7 +50,7 @@ static bool
 check_exception_thrown(AOTCompContext *comp_ctx, AOTFuncContext *func_ctx)
 {
     LLVMBasicBlockRef check_exce_succ_block;
-    LLVMValueRef exce_id_global, exce_id, cmp;
+    LLVMValueRef exce_id_global, exce_id, cmp, cond_br;
 
     if (comp_ctx->no_sandbox_mode)
         return true;
@@ -71,22 +74,67 @@ check_exception_thrown(AOTCompContext *comp_ctx, AOTFuncContext *func_ctx)
         aot_set_last_error("llvm build load failed.");
         return false;
     }
+    aot_set_memory_domain(comp_ctx, exce_id, AOT_MEMORY_DOMAIN_RUNTIME_STATE);
 
     if (!(cmp = LLVMBuildICmp(comp_ctx->builder, LLVMIntEQ, exce_id, I32_ZERO,
                               "cmp"))) {
         aot_set_last_error("llvm build cmp failed.");
         return false;
     }
-    if (!LLVMBuildCondBr(comp_ctx->builder, cmp, check_exce_succ_block,
-                         func_ctx->func_return_block)) {
+    if (!(cond_br = LLVMBuildCondBr(comp_ctx->builder, cmp,
+                                    check_exce_succ_block,
+                                    func_ctx->func_return_block))) {
         aot_set_last_error("llvm build cond br failed.");
         return false;
     }
+    aot_set_unlikely_branch(comp_ctx, cond_br, false);
 
     LLVMPositionBuilderAtEnd(comp_ctx->builder, check_exce_succ_block);
     return true;
 }
 
+/* Whether the import function allocates from the host managed heap */
+static bool
+is_alloc_import_func(const AOTImportFunc *import_func)
+{
+    static const char *alloc_func_names[] = { "malloc", "calloc", "realloc",
+                                              "strdup" };
+    uint32 i;
+
+    if (strcmp(import_func->module_name, "env"))
+        return false;
+
+    for (i = 0; i < sizeof(alloc_func_names) / sizeof(char *); i++) {
+        if (!strcmp(import_func->func_name, alloc_func_names[i]))
+            return true;
+    }
+    return false;
+}
+
+/* Store the index of current function to the alloc_call_site global,
+   so that the allocation profiler can get the call site */
+static bool
+record_alloc_call_site(AOTCompContext *comp_ctx, AOTFuncContext *func_ctx)
+{
+    LLVMValueRef call_site_global, func_idx, res;
+
+    call_site_global = LLVMGetNamedGlobal(comp_ctx->module, "alloc_call_site");
+    bh_assert(call_site_global);
+
+    func_idx = I32_CONST(func_ctx->func_idx);
+    CHECK_LLVM_CONST(func_idx);
+
+    if (!(res = LLVMBuildStore(comp_ctx->builder, func_idx,
+                               call_site_global))) {
+        aot_set_last_error("llvm build store failed.");
+        return false;
+    }
+    aot_set_memory_domain(comp_ctx, res, AOT_MEMORY_DOMAIN_RUNTIME_STATE);
+    return true;
+fail:
+    return false;
+}
+
 bool
 aot_compile_op_call(AOTCompContext *comp_ctx, AOTFuncContext *func_ctx,
                     uint32 func_idx, bool tail_call, WASMRelocation *relocation)
@@ -132,6 +180,10 @@ aot_compile_op_call(AOTCompContext *comp_ctx, AOTFuncContext *func_ctx,
     param_count = (int32)func_type->param_count;
     result_count = (int32)func_type->result_count;
     ext_ret_count = result_count > 1 ? result_count - 1 : 0;
+    /* An internal callee returns all the results in a struct */
+    if (func_idx >= import_func_count
+        && aot_func_ret_in_regs(func_ctxes[func_idx - import_func_count]))
+        ext_ret_count = 0;
     total_size = sizeof(LLVMValueRef) * (uint64)(param_count + ext_ret_count);
     if (total_size > 0) {
         if (total_size >= UINT32_MAX
@@ -189,6 +241,9 @@ aot_compile_op_call(AOTCompContext *comp_ctx, AOTFuncContext *func_ctx,
         }
     }
 
+    if (!aot_commit_aux_stack_top(comp_ctx, func_ctx, true))
+        goto fail;
+
     if (func_idx < import_func_count) {
         /* Initialize parameter types of the LLVM function */
         total_size = sizeof(LLVMTypeRef) * (uint64)param_count;
@@ -264,6 +319,11 @@ aot_compile_op_call(AOTCompContext *comp_ctx, AOTFuncContext *func_ctx,
                                      check_func_ptr_succ_block);
         }
 
+        if (comp_ctx->enable_alloc_profiling
+            && is_alloc_import_func(&import_funcs[func_idx])
+            && !record_alloc_call_site(comp_ctx, func_ctx))
+            goto fail;
+
         /* Call the function */
         if (!(value_ret = LLVMBuildCall2(
                   comp_ctx->builder, native_func_type, func, param_values,
@@ -298,11 +358,28 @@ aot_compile_op_call(AOTCompContext *comp_ctx, AOTFuncContext *func_ctx,
             goto fail;
         }
 
+        LLVMSetInstructionCallConv(value_ret, LLVMGetFunctionCallConv(func));
+
         if (tail_call)
             LLVMSetTailCall(value_ret, true);
     }
 
-    if (func_type->result_count > 0) {
+    if (!aot_reload_aux_stack_top(comp_ctx, func_ctx))
+        goto fail;
+
+    if (result_count > 1 && ext_ret_count == 0) {
+        /* Extract the results from the returned struct */
+        for (i = 0; i < result_count; i++) {
+            snprintf(buf, sizeof(buf), "func%d_ret%d", func_idx, i);
+            if (!(ext_ret = LLVMBuildExtractValue(comp_ctx->builder, value_ret,
+                                                  (uint32)i, buf))) {
+                aot_set_last_error("llvm build extract value failed.");
+                goto fail;
+            }
+            PUSH(ext_ret, func_type->types[param_count + i]);
+        }
+    }
+    else if (func_type->result_count > 0) {
         /* Push the first result to stack */
         PUSH(value_ret, func_type->types[func_type->param_count]);
         /* Load extra result from its address and push to stack */
@@ -478,6 +555,9 @@ compile_call_indirect_for_nosandbox(AOTCompContext *comp_ctx,
         goto fail;
     }
 
+    if (!aot_commit_aux_stack_top(comp_ctx, func_ctx, true))
+        goto fail;
+
     if (!(value_ret = LLVMBuildCall2(comp_ctx->builder, llvm_func_type, func,
                                      param_values, total_param_count,
                                      func_result_count > 0 ? "ret" : ""))) {
@@ -485,6 +565,9 @@ compile_call_indirect_for_nosandbox(AOTCompContext *comp_ctx,
         goto fail;
     }
 
+    if (!aot_reload_aux_stack_top(comp_ctx, func_ctx))
+        goto fail;
+
     if (func_result_count > 0) {
         /* Push the first result to stack */
         PUSH(value_ret, func_type->types[func_param_count]);
@@ -620,6 +703,7 @@ aot_compile_op_call_indirect(AOTCompContext *comp_ctx, AOTFuncContext *func_ctx,
         aot_set_last_error("llvm build load failed.");
         goto fail;
     }
+    aot_set_memory_domain(comp_ctx, func_idx, AOT_MEMORY_DOMAIN_TABLE);
 
     LLVMBasicBlockRef check_func_idx_succ;
     LLVMValueRef cmp_func_idx;
@@ -666,6 +750,7 @@ aot_compile_op_call_indirect(AOTCompContext *comp_ctx, AOTFuncContext *func_ctx,
         aot_set_last_error("llvm build load failed.");
         goto fail;
     }
+    aot_set_memory_domain(comp_ctx, ftype_idx, AOT_MEMORY_DOMAIN_RUNTIME_STATE);
 
     ftype_idx_const = I32_CONST(type_idx);
     CHECK_LLVM_CONST(ftype_idx_const);
@@ -807,6 +892,7 @@ aot_compile_op_call_indirect(AOTCompContext *comp_ctx, AOTFuncContext *func_ctx,
         aot_set_last_error("llvm build load failed.");
         goto fail;
     }
+    aot_set_memory_domain(comp_ctx, func_ptr, AOT_MEMORY_DOMAIN_RUNTIME_STATE);
 
     if (!(llvm_func_type =
               LLVMFunctionType(ret_type, param_types, total_param_count, false))
@@ -844,6 +930,9 @@ aot_compile_op_call_indirect(AOTCompContext *comp_ctx, AOTFuncContext *func_ctx,
 
     LLVMPositionBuilderAtEnd(comp_ctx->builder, check_func_ptr_succ_block);
 
+    if (!aot_commit_aux_stack_top(comp_ctx, func_ctx, true))
+        goto fail;
+
     if (!(value_ret = LLVMBuildCall2(comp_ctx->builder, llvm_func_type, func,
                                      param_values, total_param_count,
                                      func_result_count > 0 ? "ret" : ""))) {
@@ -851,6 +940,9 @@ aot_compile_op_call_indirect(AOTCompContext *comp_ctx, AOTFuncContext *func_ctx,
         goto fail;
     }
 
+    if (!aot_reload_aux_stack_top(comp_ctx, func_ctx))
+        goto fail;
+
     if (func_result_count > 0) {
         /* Push the first result to stack */
         PUSH(value_ret, func_type->types[func_param_count]);
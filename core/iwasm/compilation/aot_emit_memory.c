@@ -25,15 +25,18 @@
         }                                                                   \
     } while (0)
 
-#define ADD_BASIC_BLOCK(block, name)                                          \
+#define ADD_BASIC_BLOCK_IN_FUNC(block, func, name)                            \
     do {                                                                      \
-        if (!(block = LLVMAppendBasicBlockInContext(comp_ctx->context,        \
-                                                    func_ctx->func, name))) { \
+        if (!(block = LLVMAppendBasicBlockInContext(comp_ctx->context, func,  \
+                                                    name))) {                 \
             aot_set_last_error("llvm add basic block failed.");               \
             goto fail;                                                        \
         }                                                                     \
     } while (0)
 
+#define ADD_BASIC_BLOCK(block, name) \
+    ADD_BASIC_BLOCK_IN_FUNC(block, func_ctx->func, name)
+
 #define SET_BUILD_POS(block) LLVMPositionBuilderAtEnd(comp_ctx->builder, block)
 
 #define MOVE_BLOCK_AFTER(llvm_block, llvm_block_after) \
@@ -102,9 +105,40 @@ get_memory_check_bound(AOTCompContext *comp_ctx, AOTFuncContext *func_ctx,
         aot_set_last_error("llvm build load failed.");
         return NULL;
     }
+    aot_set_memory_domain(comp_ctx, mem_check_bound,
+                          AOT_MEMORY_DOMAIN_RUNTIME_STATE);
     return mem_check_bound;
 }
 
+/* Load the mask of the bounds mask mode, truncated to the type of the
+   address to mask */
+static LLVMValueRef
+get_memory_addr_mask(AOTCompContext *comp_ctx, LLVMTypeRef addr_type)
+{
+    LLVMValueRef mem_addr_mask_global, mem_addr_mask;
+
+    mem_addr_mask_global =
+        LLVMGetNamedGlobal(comp_ctx->module, "mem_addr_mask");
+    bh_assert(mem_addr_mask_global);
+
+    if (!(mem_addr_mask =
+              LLVMBuildLoad2(comp_ctx->builder, I64_TYPE, mem_addr_mask_global,
+                             "mem_addr_mask"))) {
+        aot_set_last_error("llvm build load failed.");
+        return NULL;
+    }
+    aot_set_memory_domain(comp_ctx, mem_addr_mask,
+                          AOT_MEMORY_DOMAIN_RUNTIME_STATE);
+
+    if (addr_type != I64_TYPE
+        && !(mem_addr_mask = LLVMBuildTrunc(comp_ctx->builder, mem_addr_mask,
+                                            addr_type, "mem_addr_mask_i32"))) {
+        aot_set_last_error("llvm build trunc failed.");
+        return NULL;
+    }
+    return mem_addr_mask;
+}
+
 #define MEMORY_DATA_SIZE_FIXED(aot_memory)                             \
     (aot_memory->mem_init_page_count == aot_memory->mem_max_page_count \
          ? true                                                        \
@@ -205,7 +239,18 @@ aot_check_memory_overflow(AOTCompContext *comp_ctx, AOTFuncContext *func_ctx,
 
     block_curr = LLVMGetInsertBlock(comp_ctx->builder);
 
-    if (!comp_ctx->no_sandbox_mode && aot_memory->mem_init_page_count == 0) {
+    if (comp_ctx->enable_bounds_mask) {
+        LLVMValueRef mem_addr_mask;
+
+        /* Wrap the address into the linear memory, the guard bytes
+           after the masked range hold the access at its end */
+        if (!(mem_addr_mask =
+                  get_memory_addr_mask(comp_ctx, LLVMTypeOf(offset1))))
+            goto fail;
+        BUILD_OP(And, offset1, mem_addr_mask, offset1, "offset1_masked");
+    }
+    else if (!comp_ctx->no_sandbox_mode
+             && aot_memory->mem_init_page_count == 0) {
         LLVMValueRef mem_size;
 
         if (!(mem_size = get_memory_curr_page_count(comp_ctx, func_ctx))) {
@@ -225,7 +270,7 @@ aot_check_memory_overflow(AOTCompContext *comp_ctx, AOTFuncContext *func_ctx,
         block_curr = check_succ;
     }
 
-    if (!comp_ctx->no_sandbox_mode) {
+    if (!comp_ctx->no_sandbox_mode && !comp_ctx->enable_bounds_mask) {
         if (!(mem_check_bound =
                   get_memory_check_bound(comp_ctx, func_ctx, bytes))) {
             goto fail;
@@ -302,14 +347,21 @@ fail:
         }                                                                  \
     } while (0)
 
-#define BUILD_LOAD(data_type)                                             \
+#define BUILD_LOAD(align, data_type)                                      \
     do {                                                                  \
+        uint32 alignment;                                                 \
+        if (!aot_get_access_alignment(comp_ctx, func_ctx, maddr, align,   \
+                                      &alignment)) {                      \
+            goto fail;                                                    \
+        }                                                                 \
         if (!(value = LLVMBuildLoad2(comp_ctx->builder, data_type, maddr, \
                                      "data"))) {                          \
             aot_set_last_error("llvm build load failed.");                \
             goto fail;                                                    \
         }                                                                 \
-        LLVMSetAlignment(value, 1);                                       \
+        LLVMSetAlignment(value, alignment);                               \
+        aot_set_memory_domain(comp_ctx, value,                            \
+                              AOT_MEMORY_DOMAIN_LINEAR_MEMORY);           \
     } while (0)
 
 #define BUILD_TRUNC(value, data_type)                                     \
@@ -321,14 +373,21 @@ fail:
         }                                                                 \
     } while (0)
 
-#define BUILD_STORE()                                                   \
+#define BUILD_STORE(align)                                              \
     do {                                                                \
         LLVMValueRef res;                                               \
+        uint32 alignment;                                               \
+        if (!aot_get_access_alignment(comp_ctx, func_ctx, maddr, align, \
+                                      &alignment)) {                    \
+            goto fail;                                                  \
+        }                                                               \
         if (!(res = LLVMBuildStore(comp_ctx->builder, value, maddr))) { \
             aot_set_last_error("llvm build store failed.");             \
             goto fail;                                                  \
         }                                                               \
-        LLVMSetAlignment(res, 1);                                       \
+        LLVMSetAlignment(res, alignment);                               \
+        aot_set_memory_domain(comp_ctx, res,                            \
+                              AOT_MEMORY_DOMAIN_LINEAR_MEMORY);         \
     } while (0)
 
 #define BUILD_SIGN_EXT(dst_type)                                        \
@@ -349,9 +408,9 @@ fail:
         }                                                               \
     } while (0)
 
-bool
+static bool
 check_memory_alignment(AOTCompContext *comp_ctx, AOTFuncContext *func_ctx,
-                       LLVMValueRef addr, uint32 align)
+                       LLVMValueRef addr, uint32 align, int32 exception_id)
 {
     LLVMBasicBlockRef block_curr = LLVMGetInsertBlock(comp_ctx->builder);
     LLVMBasicBlockRef check_align_succ;
@@ -378,8 +437,8 @@ check_memory_alignment(AOTCompContext *comp_ctx, AOTFuncContext *func_ctx,
     ADD_BASIC_BLOCK(check_align_succ, "check_align_succ");
     LLVMMoveBasicBlockAfter(check_align_succ, block_curr);
 
-    if (!aot_emit_exception(comp_ctx, func_ctx, EXCE_UNALIGNED_ATOMIC, true,
-                            res, check_align_succ)) {
+    if (!aot_emit_exception(comp_ctx, func_ctx, exception_id, true, res,
+                            check_align_succ)) {
         goto fail;
     }
 
@@ -390,9 +449,33 @@ fail:
     return false;
 }
 
+bool
+aot_get_access_alignment(AOTCompContext *comp_ctx, AOTFuncContext *func_ctx,
+                         LLVMValueRef maddr, uint32 align, uint32 *p_alignment)
+{
+    if (!comp_ctx->trust_alignment_hints) {
+        *p_alignment = 1;
+        return true;
+    }
+
+    /* The linear memory is allocated by malloc, which only guarantees
+       the 8-byte alignment on some targets */
+    if (align > 3)
+        align = 3;
+
+    if (comp_ctx->check_alignment_hints && align > 0
+        && !check_memory_alignment(comp_ctx, func_ctx, maddr, align,
+                                   EXCE_UNALIGNED_MEMORY_ACCESS))
+        return false;
+
+    *p_alignment = (uint32)1 << align;
+    return true;
+}
+
 #define BUILD_ATOMIC_LOAD(align, data_type)                                \
     do {                                                                   \
-        if (!(check_memory_alignment(comp_ctx, func_ctx, maddr, align))) { \
+        if (!(check_memory_alignment(comp_ctx, func_ctx, maddr, align,     \
+                                     EXCE_UNALIGNED_ATOMIC))) {            \
             goto fail;                                                     \
         }                                                                  \
         if (!(value = LLVMBuildLoad2(comp_ctx->builder, data_type, maddr,  \
@@ -401,6 +484,8 @@ fail:
             goto fail;                                                     \
         }                                                                  \
         LLVMSetAlignment(value, 1 << align);                               \
+        aot_set_memory_domain(comp_ctx, value,                             \
+                              AOT_MEMORY_DOMAIN_LINEAR_MEMORY);            \
         LLVMSetVolatile(value, true);                                      \
         LLVMSetOrdering(value, LLVMAtomicOrderingSequentiallyConsistent);  \
     } while (0)
@@ -408,7 +493,8 @@ fail:
 #define BUILD_ATOMIC_STORE(align)                                          \
     do {                                                                   \
         LLVMValueRef res;                                                  \
-        if (!(check_memory_alignment(comp_ctx, func_ctx, maddr, align))) { \
+        if (!(check_memory_alignment(comp_ctx, func_ctx, maddr, align,     \
+                                     EXCE_UNALIGNED_ATOMIC))) {            \
             goto fail;                                                     \
         }                                                                  \
         if (!(res = LLVMBuildStore(comp_ctx->builder, value, maddr))) {    \
@@ -416,6 +502,8 @@ fail:
             goto fail;                                                     \
         }                                                                  \
         LLVMSetAlignment(res, 1 << align);                                 \
+        aot_set_memory_domain(comp_ctx, res,                               \
+                              AOT_MEMORY_DOMAIN_LINEAR_MEMORY);            \
         LLVMSetVolatile(res, true);                                        \
         LLVMSetOrdering(res, LLVMAtomicOrderingSequentiallyConsistent);    \
     } while (0)
@@ -438,7 +526,7 @@ aot_compile_op_i32_load(AOTCompContext *comp_ctx, AOTFuncContext *func_ctx,
             if (atomic)
                 BUILD_ATOMIC_LOAD(align, I32_TYPE);
             else
-                BUILD_LOAD(I32_TYPE);
+                BUILD_LOAD(align, I32_TYPE);
             break;
         case 2:
         case 1:
@@ -456,7 +544,7 @@ aot_compile_op_i32_load(AOTCompContext *comp_ctx, AOTFuncContext *func_ctx,
                 BUILD_ZERO_EXT(I32_TYPE);
             }
             else {
-                BUILD_LOAD(data_type);
+                BUILD_LOAD(align, data_type);
                 if (sign)
                     BUILD_SIGN_EXT(I32_TYPE);
                 else
@@ -493,7 +581,7 @@ aot_compile_op_i64_load(AOTCompContext *comp_ctx, AOTFuncContext *func_ctx,
             if (atomic)
                 BUILD_ATOMIC_LOAD(align, I64_TYPE);
             else
-                BUILD_LOAD(I64_TYPE);
+                BUILD_LOAD(align, I64_TYPE);
             break;
         case 4:
         case 2:
@@ -516,7 +604,7 @@ aot_compile_op_i64_load(AOTCompContext *comp_ctx, AOTFuncContext *func_ctx,
                 BUILD_ZERO_EXT(I64_TYPE);
             }
             else {
-                BUILD_LOAD(data_type);
+                BUILD_LOAD(align, data_type);
                 if (sign)
                     BUILD_SIGN_EXT(I64_TYPE);
                 else
@@ -546,7 +634,7 @@ aot_compile_op_f32_load(AOTCompContext *comp_ctx, AOTFuncContext *func_ctx,
         return false;
 
     BUILD_PTR_CAST(F32_PTR_TYPE);
-    BUILD_LOAD(F32_TYPE);
+    BUILD_LOAD(align, F32_TYPE);
 
     PUSH_F32(value);
     return true;
@@ -565,7 +653,7 @@ aot_compile_op_f64_load(AOTCompContext *comp_ctx, AOTFuncContext *func_ctx,
         return false;
 
     BUILD_PTR_CAST(F64_PTR_TYPE);
-    BUILD_LOAD(F64_TYPE);
+    BUILD_LOAD(align, F64_TYPE);
 
     PUSH_F64(value);
     return true;
@@ -606,7 +694,7 @@ aot_compile_op_i32_store(AOTCompContext *comp_ctx, AOTFuncContext *func_ctx,
     if (atomic)
         BUILD_ATOMIC_STORE(align);
     else
-        BUILD_STORE();
+        BUILD_STORE(align);
     return true;
 fail:
     return false;
@@ -649,7 +737,7 @@ aot_compile_op_i64_store(AOTCompContext *comp_ctx, AOTFuncContext *func_ctx,
     if (atomic)
         BUILD_ATOMIC_STORE(align);
     else
-        BUILD_STORE();
+        BUILD_STORE(align);
     return true;
 fail:
     return false;
@@ -669,7 +757,7 @@ aot_compile_op_f32_store(AOTCompContext *comp_ctx, AOTFuncContext *func_ctx,
         return false;
 
     BUILD_PTR_CAST(F32_PTR_TYPE);
-    BUILD_STORE();
+    BUILD_STORE(align);
     return true;
 fail:
     return false;
@@ -689,17 +777,28 @@ aot_compile_op_f64_store(AOTCompContext *comp_ctx, AOTFuncContext *func_ctx,
         return false;
 
     BUILD_PTR_CAST(F64_PTR_TYPE);
-    BUILD_STORE();
+    BUILD_STORE(align);
     return true;
 fail:
     return false;
 }
 
+/* Get the current page count seen by the module, which excludes the pages of
+   the host managed heap appended to the linear memory. The memory can't grow
+   by the module with the heap, so the count is a constant then */
 static LLVMValueRef
 get_memory_curr_page_count(AOTCompContext *comp_ctx, AOTFuncContext *func_ctx)
 {
+    AOTMemory *aot_memory = &comp_ctx->comp_data->memories[0];
     LLVMValueRef cur_page_count_global, cur_page_count;
 
+    if (aot_memory->host_managed_heap_offset > 0) {
+        cur_page_count = I32_CONST(aot_memory->host_managed_heap_offset
+                                   / DEFAULT_NUM_BYTES_PER_PAGE);
+        CHECK_LLVM_CONST(cur_page_count);
+        return cur_page_count;
+    }
+
     cur_page_count_global =
         LLVMGetNamedGlobal(comp_ctx->module, "cur_page_count");
     bh_assert(cur_page_count_global);
@@ -710,6 +809,8 @@ get_memory_curr_page_count(AOTCompContext *comp_ctx, AOTFuncContext *func_ctx)
         aot_set_last_error("llvm build load failed.");
         goto fail;
     }
+    aot_set_memory_domain(comp_ctx, cur_page_count,
+                          AOT_MEMORY_DOMAIN_RUNTIME_STATE);
 
     return cur_page_count;
 fail:
@@ -739,12 +840,158 @@ fail:
     return false;
 }
 
-bool
-aot_compile_op_memory_grow(AOTCompContext *comp_ctx, AOTFuncContext *func_ctx)
+static bool
+migrate_host_managed_heap(AOTCompContext *comp_ctx, LLVMValueRef memory_data,
+                          LLVMValueRef memory_data_size)
+{
+    AOTMemory *aot_memory = &comp_ctx->comp_data->memories[0];
+    LLVMValueRef heap_offset, heap_mem, heap_size, heap_handle;
+    LLVMValueRef heap_handle_global, param_values[2], func;
+    LLVMTypeRef param_types[2], func_type;
+    char func_name[32];
+
+    heap_handle_global =
+        LLVMGetNamedGlobal(comp_ctx->module, "host_managed_heap_handle");
+    bh_assert(heap_handle_global);
+
+    param_types[0] = INT8_PTR_TYPE;
+    param_types[1] = I32_TYPE;
+    if (!(func_type = LLVMFunctionType(INT8_PTR_TYPE, param_types, 2, false))) {
+        aot_set_last_error("create LLVM function type failed.");
+        return false;
+    }
+
+    /* Add `void *mem_allocator_migrate(void *mem, uint32 size)` function */
+    snprintf(func_name, sizeof(func_name), "%s", "mem_allocator_migrate");
+    if (!(func = LLVMGetNamedFunction(comp_ctx->module, func_name))
+        && !(func = LLVMAddFunction(comp_ctx->module, func_name, func_type))) {
+        aot_set_last_error("add LLVM function failed.");
+        return false;
+    }
+
+    heap_offset = I32_CONST(aot_memory->host_managed_heap_offset);
+    CHECK_LLVM_CONST(heap_offset);
+    if (!(heap_mem = LLVMBuildInBoundsGEP2(comp_ctx->builder, INT8_TYPE,
+                                           memory_data, &heap_offset, 1,
+                                           "app_heap_mem"))) {
+        aot_set_last_error("llvm build inbounds gep failed.");
+        return false;
+    }
+
+    heap_offset = I64_CONST(aot_memory->host_managed_heap_offset);
+    CHECK_LLVM_CONST(heap_offset);
+    if (!(heap_size = LLVMBuildSub(comp_ctx->builder, memory_data_size,
+                                   heap_offset, "app_heap_size"))
+        || !(heap_size = LLVMBuildTrunc(comp_ctx->builder, heap_size, I32_TYPE,
+                                        "app_heap_size_i32"))) {
+        aot_set_last_error("llvm build sub or trunc failed.");
+        return false;
+    }
+
+    /* The heap structure resides in the linear memory, which may be
+       moved by realloc, re-attach the heap and give the new pages to it */
+    param_values[0] = heap_mem;
+    param_values[1] = heap_size;
+    if (!(heap_handle = LLVMBuildCall2(comp_ctx->builder, func_type, func,
+                                       param_values, 2, "heap_handle"))) {
+        aot_set_last_error("llvm build call failed.");
+        return false;
+    }
+
+    if (!LLVMBuildStore(comp_ctx->builder, heap_handle, heap_handle_global)) {
+        aot_set_last_error("llvm build store failed.");
+        return false;
+    }
+
+    return true;
+fail:
+    return false;
+}
+
+/* Round the new linear memory size up to a power of two in the bounds
+   mask mode, return the size to allocate with the guard bytes and the
+   new address mask */
+static bool
+build_memory_alloc_size(AOTCompContext *comp_ctx,
+                        LLVMValueRef memory_data_size,
+                        LLVMValueRef *p_alloc_size, LLVMValueRef *p_mask)
 {
+    LLVMTypeRef param_types[2], func_type;
+    LLVMValueRef func, param_values[2], size, pow2;
+    LLVMValueRef one = I64_CONST(1), bits = I64_CONST(64);
+    LLVMValueRef guard_size = I64_CONST(W2N_BOUNDS_MASK_GUARD_SIZE);
+    const char *func_name = "llvm.ctlz.i64";
+
+    CHECK_LLVM_CONST(one);
+    CHECK_LLVM_CONST(bits);
+    CHECK_LLVM_CONST(guard_size);
+
+    param_types[0] = I64_TYPE;
+    param_types[1] = LLVMInt1TypeInContext(comp_ctx->context);
+    if (!(func_type = LLVMFunctionType(I64_TYPE, param_types, 2, false))) {
+        aot_set_last_error("create LLVM function type failed.");
+        goto fail;
+    }
+    if (!(func = LLVMGetNamedFunction(comp_ctx->module, func_name))
+        && !(func = LLVMAddFunction(comp_ctx->module, func_name, func_type))) {
+        aot_set_last_error("add LLVM function failed.");
+        goto fail;
+    }
+
+    /* pow2 = 1 << (64 - ctlz(size - 1)), the size is larger than 0 */
+    BUILD_OP(Sub, memory_data_size, one, size, "size_minus_one");
+    param_values[0] = size;
+    if (!(param_values[1] = LLVMConstInt(param_types[1], false, true))) {
+        aot_set_last_error("llvm build const failed.");
+        goto fail;
+    }
+    if (!(size = LLVMBuildCall2(comp_ctx->builder, func_type, func,
+                                param_values, 2, "leading_zeros"))) {
+        aot_set_last_error("llvm build call failed.");
+        goto fail;
+    }
+    BUILD_OP(Sub, bits, size, size, "pow2_shift");
+    BUILD_OP(Shl, one, size, pow2, "pow2");
+
+    BUILD_OP(Sub, pow2, one, *p_mask, "mem_addr_mask_new");
+    BUILD_OP(Add, pow2, guard_size, *p_alloc_size,
+             "memory_data_alloc_size_new");
+    return true;
+fail:
+    return false;
+}
+
+/* The memory can't grow if its size is fixed: return the current page
+   count when growing zero page, and -1 otherwise */
+static LLVMValueRef
+build_fixed_memory_grow(AOTCompContext *comp_ctx, LLVMValueRef inc_page_count)
+{
+    LLVMValueRef cur_page_count, cmp, res;
+
+    /* Constant global, folded by LLVM */
+    if (!(cur_page_count = get_memory_curr_page_count(comp_ctx, NULL)))
+        goto fail;
+
+    BUILD_ICMP(LLVMIntEQ, inc_page_count, I32_ZERO, cmp, "is_zero");
+    if (!(res = LLVMBuildSelect(comp_ctx->builder, cmp, cur_page_count,
+                                I32_NEG_ONE, "mem_grow_ret"))) {
+        aot_set_last_error("llvm build select failed.");
+        goto fail;
+    }
+    return res;
+fail:
+    return NULL;
+}
+
+LLVMValueRef
+aot_build_memory_grow(AOTCompContext *comp_ctx, LLVMValueRef llvm_func,
+                      LLVMValueRef inc_page_count)
+{
+    AOTMemory *aot_memory = &comp_ctx->comp_data->memories[0];
     LLVMValueRef memory_data_global, memory_data_size_global;
     LLVMValueRef num_bytes_per_page_global;
     LLVMValueRef cur_page_count_global, max_page_count_global;
+    LLVMValueRef memory_grow_count_global, memory_grow_count;
     LLVMValueRef mem_bound_check_1byte_global, mem_bound_check_2bytes_global;
     LLVMValueRef mem_bound_check_4bytes_global, mem_bound_check_8bytes_global;
     LLVMValueRef mem_bound_check_16bytes_global;
@@ -752,13 +999,14 @@ aot_compile_op_memory_grow(AOTCompContext *comp_ctx, AOTFuncContext *func_ctx)
     LLVMValueRef memory_data_size, memory_data_size_new;
     LLVMValueRef num_bytes_per_page;
     LLVMValueRef cur_page_count, max_page_count, max_left_page_count;
-    LLVMValueRef inc_page_count, new_page_count;
+    LLVMValueRef new_page_count;
     LLVMValueRef mem_bound_check_1byte, mem_bound_check_2bytes;
     LLVMValueRef mem_bound_check_4bytes, mem_bound_check_8bytes;
     LLVMValueRef mem_bound_check_16bytes, cmp, phi, bytes_const;
     LLVMValueRef num_bytes_per_page_u64, new_page_count_u64;
     LLVMValueRef memory_data_zeroed, memory_data_size_zeroed;
     LLVMValueRef memory_data_size_new_i32 = NULL;
+    LLVMValueRef memory_data_alloc_size_new, mem_addr_mask_new = NULL;
     LLVMValueRef const_4G = I64_CONST(4 * (uint64)BH_GB);
     LLVMBasicBlockRef inc_page_count_non_zero;
     LLVMBasicBlockRef check_inc_page_count_succ;
@@ -770,6 +1018,9 @@ aot_compile_op_memory_grow(AOTCompContext *comp_ctx, AOTFuncContext *func_ctx)
     LLVMValueRef param_values[2], func;
     char func_name[32];
 
+    if (MEMORY_DATA_SIZE_FIXED(aot_memory))
+        return build_fixed_memory_grow(comp_ctx, inc_page_count);
+
     memory_data_global = LLVMGetNamedGlobal(comp_ctx->module, "memory_data");
     bh_assert(memory_data_global);
     memory_data_size_global =
@@ -784,6 +1035,9 @@ aot_compile_op_memory_grow(AOTCompContext *comp_ctx, AOTFuncContext *func_ctx)
     max_page_count_global =
         LLVMGetNamedGlobal(comp_ctx->module, "max_page_count");
     bh_assert(max_page_count_global);
+    memory_grow_count_global =
+        LLVMGetNamedGlobal(comp_ctx->module, "memory_grow_count");
+    bh_assert(memory_grow_count_global);
     mem_bound_check_1byte_global =
         LLVMGetNamedGlobal(comp_ctx->module, "mem_bound_check_1byte");
     bh_assert(mem_bound_check_1byte_global);
@@ -820,26 +1074,30 @@ aot_compile_op_memory_grow(AOTCompContext *comp_ctx, AOTFuncContext *func_ctx)
 
     cur_block = LLVMGetInsertBlock(comp_ctx->builder);
 
-    ADD_BASIC_BLOCK(inc_page_count_non_zero, "inc_page_count_non_zero");
+    ADD_BASIC_BLOCK_IN_FUNC(inc_page_count_non_zero, llvm_func,
+                            "inc_page_count_non_zero");
     MOVE_BLOCK_AFTER(inc_page_count_non_zero, cur_block);
 
-    ADD_BASIC_BLOCK(check_inc_page_count_succ, "check_inc_page_count_succ");
+    ADD_BASIC_BLOCK_IN_FUNC(check_inc_page_count_succ, llvm_func,
+                            "check_inc_page_count_succ");
     MOVE_BLOCK_AFTER(check_inc_page_count_succ, inc_page_count_non_zero);
 
     if (comp_ctx->pointer_size == sizeof(uint32)) {
-        ADD_BASIC_BLOCK(check_mem_data_size_new_succ,
-                        "check_mem_data_size_new_succ");
+        ADD_BASIC_BLOCK_IN_FUNC(check_mem_data_size_new_succ, llvm_func,
+                                "check_mem_data_size_new_succ");
         MOVE_BLOCK_AFTER(check_mem_data_size_new_succ,
                          check_inc_page_count_succ);
-        ADD_BASIC_BLOCK(check_realloc_succ, "check_realloc_succ");
+        ADD_BASIC_BLOCK_IN_FUNC(check_realloc_succ, llvm_func,
+                                "check_realloc_succ");
         MOVE_BLOCK_AFTER(check_realloc_succ, check_mem_data_size_new_succ);
     }
     else {
-        ADD_BASIC_BLOCK(check_realloc_succ, "check_realloc_succ");
+        ADD_BASIC_BLOCK_IN_FUNC(check_realloc_succ, llvm_func,
+                                "check_realloc_succ");
         MOVE_BLOCK_AFTER(check_realloc_succ, check_inc_page_count_succ);
     }
 
-    ADD_BASIC_BLOCK(memory_grow_ret, "memory_grow_ret");
+    ADD_BASIC_BLOCK_IN_FUNC(memory_grow_ret, llvm_func, "memory_grow_ret");
     MOVE_BLOCK_AFTER(memory_grow_ret, check_realloc_succ);
 
     SET_BUILD_POS(memory_grow_ret);
@@ -849,7 +1107,6 @@ aot_compile_op_memory_grow(AOTCompContext *comp_ctx, AOTFuncContext *func_ctx)
     }
     SET_BUILD_POS(cur_block);
 
-    POP_I32(inc_page_count);
     BUILD_ICMP(LLVMIntEQ, inc_page_count, I32_ZERO, cmp, "is_zero");
     BUILD_COND_BR(cmp, memory_grow_ret, inc_page_count_non_zero);
     LLVMAddIncoming(phi, &cur_page_count, &cur_block, 1);
@@ -889,14 +1146,25 @@ aot_compile_op_memory_grow(AOTCompContext *comp_ctx, AOTFuncContext *func_ctx)
         goto fail;
     }
 
+    memory_data_alloc_size_new = memory_data_size_new;
+    if (comp_ctx->enable_bounds_mask
+        && !build_memory_alloc_size(comp_ctx, memory_data_size_new,
+                                    &memory_data_alloc_size_new,
+                                    &mem_addr_mask_new))
+        goto fail;
+
     if (comp_ctx->pointer_size == sizeof(uint32)) {
-        BUILD_ICMP(LLVMIntNE, memory_data_size_new, const_4G, cmp,
-                   "memory_is_4GB");
+        if (comp_ctx->enable_bounds_mask)
+            BUILD_ICMP(LLVMIntULT, memory_data_alloc_size_new, const_4G, cmp,
+                       "alloc_size_lt_4GB");
+        else
+            BUILD_ICMP(LLVMIntNE, memory_data_size_new, const_4G, cmp,
+                       "memory_is_4GB");
         BUILD_COND_BR(cmp, check_mem_data_size_new_succ, memory_grow_ret);
         LLVMAddIncoming(phi, &I32_NEG_ONE, &check_inc_page_count_succ, 1);
         SET_BUILD_POS(check_mem_data_size_new_succ);
         if (!(memory_data_size_new_i32 =
-                  LLVMBuildTrunc(comp_ctx->builder, memory_data_size_new,
+                  LLVMBuildTrunc(comp_ctx->builder, memory_data_alloc_size_new,
                                  I32_TYPE, "memory_data_size_new_i32"))) {
             aot_set_last_error("llvm build trunc failed.");
             goto fail;
@@ -921,7 +1189,7 @@ aot_compile_op_memory_grow(AOTCompContext *comp_ctx, AOTFuncContext *func_ctx)
 
     param_values[0] = memory_data;
     param_values[1] = comp_ctx->pointer_size == sizeof(uint64)
-                          ? memory_data_size_new
+                          ? memory_data_alloc_size_new
                           : memory_data_size_new_i32;
     if (!(memory_data_new =
               LLVMBuildCall2(comp_ctx->builder, func_type, func, param_values,
@@ -944,6 +1212,8 @@ aot_compile_op_memory_grow(AOTCompContext *comp_ctx, AOTFuncContext *func_ctx)
         LLVMAddIncoming(phi, &I32_NEG_ONE, &check_mem_data_size_new_succ, 1);
 
     SET_BUILD_POS(check_realloc_succ);
+    /* Zero from the old memory size, which also clears the bytes written
+       after it through the masked addresses in the bounds mask mode */
     if (!(memory_data_zeroed = LLVMBuildInBoundsGEP2(
               comp_ctx->builder, INT8_TYPE, memory_data_new, &memory_data_size,
               1, "memory_data_zeroed"))) {
@@ -951,7 +1221,7 @@ aot_compile_op_memory_grow(AOTCompContext *comp_ctx, AOTFuncContext *func_ctx)
         goto fail;
     }
     if (!(memory_data_size_zeroed =
-              LLVMBuildSub(comp_ctx->builder, memory_data_size_new,
+              LLVMBuildSub(comp_ctx->builder, memory_data_alloc_size_new,
                            memory_data_size, "memory_data_size_zeroed"))) {
         aot_set_last_error("llvm build sub failed.");
         goto fail;
@@ -979,6 +1249,36 @@ aot_compile_op_memory_grow(AOTCompContext *comp_ctx, AOTFuncContext *func_ctx)
         goto fail;
     }
 
+    if (comp_ctx->enable_bounds_mask) {
+        LLVMValueRef mem_addr_mask_global =
+            LLVMGetNamedGlobal(comp_ctx->module, "mem_addr_mask");
+        bh_assert(mem_addr_mask_global);
+
+        if (!LLVMBuildStore(comp_ctx->builder, mem_addr_mask_new,
+                            mem_addr_mask_global)) {
+            aot_set_last_error("llvm build store failed.");
+            goto fail;
+        }
+    }
+
+    if (!(memory_grow_count =
+              LLVMBuildLoad2(comp_ctx->builder, I32_TYPE,
+                             memory_grow_count_global, "memory_grow_count"))) {
+        aot_set_last_error("llvm build load failed.");
+        goto fail;
+    }
+    if (!(memory_grow_count =
+              LLVMBuildAdd(comp_ctx->builder, memory_grow_count, I32_ONE,
+                           "memory_grow_count_new"))) {
+        aot_set_last_error("llvm build add failed.");
+        goto fail;
+    }
+    if (!LLVMBuildStore(comp_ctx->builder, memory_grow_count,
+                        memory_grow_count_global)) {
+        aot_set_last_error("llvm build store failed.");
+        goto fail;
+    }
+
     bytes_const = I64_CONST(1);
     CHECK_LLVM_CONST(bytes_const);
     if (!(mem_bound_check_1byte =
@@ -1049,12 +1349,64 @@ aot_compile_op_memory_grow(AOTCompContext *comp_ctx, AOTFuncContext *func_ctx)
         goto fail;
     }
 
+    if (aot_memory->host_managed_heap_offset > 0
+        && !migrate_host_managed_heap(comp_ctx, memory_data_new,
+                                      memory_data_size_new))
+        goto fail;
+
     LLVMAddIncoming(phi, &cur_page_count, &check_realloc_succ, 1);
     LLVMBuildBr(comp_ctx->builder, memory_grow_ret);
 
     SET_BUILD_POS(memory_grow_ret);
+    return phi;
+fail:
+    return NULL;
+}
+
+bool
+aot_compile_op_memory_grow(AOTCompContext *comp_ctx, AOTFuncContext *func_ctx)
+{
+    LLVMValueRef inc_page_count, ret;
+
+    POP_I32(inc_page_count);
+
+    if (!(ret = aot_build_memory_grow(comp_ctx, func_ctx->func,
+                                      inc_page_count)))
+        goto fail;
+
+    PUSH_I32(ret);
+    return true;
+fail:
+    return false;
+}
+
+/* Wrap the offset into the linear memory and cut the length at the end
+   of the masked range in the bounds mask mode, both are uint64 */
+static bool
+mask_bulk_memory_range(AOTCompContext *comp_ctx, LLVMValueRef *p_offset,
+                       LLVMValueRef *p_bytes)
+{
+    LLVMValueRef offset = *p_offset, bytes = *p_bytes;
+    LLVMValueRef mem_addr_mask, bytes_left, cmp, one = I64_CONST(1);
+
+    CHECK_LLVM_CONST(one);
+
+    if (!(mem_addr_mask = get_memory_addr_mask(comp_ctx, I64_TYPE)))
+        return false;
 
-    PUSH_I32(phi);
+    /* bytes_left = mask + 1 - offset */
+    BUILD_OP(And, offset, mem_addr_mask, offset, "offset_masked");
+    BUILD_OP(Sub, mem_addr_mask, offset, bytes_left, "bytes_left");
+    BUILD_OP(Add, bytes_left, one, bytes_left, "bytes_left");
+    BUILD_ICMP(LLVMIntUGT, bytes, bytes_left, cmp, "len_gt_bytes_left");
+    if (!(bytes = LLVMBuildSelect(comp_ctx->builder, cmp, bytes_left, bytes,
+                                  "len_masked"))) {
+        aot_set_last_error("llvm build select failed.");
+        return false;
+    }
+
+    *p_offset = offset;
+    *p_bytes = bytes;
     return true;
 fail:
     return false;
@@ -1062,9 +1414,9 @@ fail:
 
 static LLVMValueRef
 check_bulk_memory_overflow(AOTCompContext *comp_ctx, AOTFuncContext *func_ctx,
-                           LLVMValueRef offset, LLVMValueRef bytes)
+                           LLVMValueRef offset, LLVMValueRef *p_bytes)
 {
-    LLVMValueRef maddr, max_addr, mem_base_addr, cmp;
+    LLVMValueRef maddr, max_addr, mem_base_addr, cmp, bytes = *p_bytes;
     LLVMValueRef mem_data_size, mem_data_size_global;
     LLVMBasicBlockRef block_curr = LLVMGetInsertBlock(comp_ctx->builder);
     LLVMBasicBlockRef check_succ;
@@ -1072,24 +1424,30 @@ check_bulk_memory_overflow(AOTCompContext *comp_ctx, AOTFuncContext *func_ctx,
     if (!(mem_base_addr = aot_get_memory_base_addr(comp_ctx, func_ctx)))
         return false;
 
-    mem_data_size_global =
-        LLVMGetNamedGlobal(comp_ctx->module, "memory_data_size");
-    bh_assert(mem_data_size_global);
-
-    if (!(mem_data_size =
-              LLVMBuildLoad2(comp_ctx->builder, I64_TYPE, mem_data_size_global,
-                             "mem_data_size"))) {
-        aot_set_last_error("llvm build load failed.");
-        goto fail;
-    }
-
     offset =
         LLVMBuildZExt(comp_ctx->builder, offset, I64_TYPE, "extend_offset");
     bytes = LLVMBuildZExt(comp_ctx->builder, bytes, I64_TYPE, "extend_len");
 
-    BUILD_OP(Add, offset, bytes, max_addr, "max_addr");
+    if (comp_ctx->enable_bounds_mask) {
+        if (!mask_bulk_memory_range(comp_ctx, &offset, &bytes))
+            goto fail;
+        *p_bytes = bytes;
+    }
+    else if (!comp_ctx->no_sandbox_mode) {
+        mem_data_size_global =
+            LLVMGetNamedGlobal(comp_ctx->module, "memory_data_size");
+        bh_assert(mem_data_size_global);
+
+        if (!(mem_data_size = LLVMBuildLoad2(comp_ctx->builder, I64_TYPE,
+                                             mem_data_size_global,
+                                             "mem_data_size"))) {
+            aot_set_last_error("llvm build load failed.");
+            goto fail;
+        }
+        aot_set_memory_domain(comp_ctx, mem_data_size,
+                              AOT_MEMORY_DOMAIN_RUNTIME_STATE);
 
-    if (!comp_ctx->no_sandbox_mode) {
+        BUILD_OP(Add, offset, bytes, max_addr, "max_addr");
         BUILD_ICMP(LLVMIntUGT, max_addr, mem_data_size, cmp,
                    "cmp_max_mem_addr");
         ADD_BASIC_BLOCK(check_succ, "check_succ");
@@ -1112,21 +1470,309 @@ fail:
     return NULL;
 }
 
+/* Max constant length of memory.copy and memory.fill which is expanded
+   to unrolled loads and stores */
+#define BULK_MEMORY_INLINE_MAX_SIZE 64
+
+static LLVMValueRef
+get_bulk_memory_addr(AOTCompContext *comp_ctx, AOTFuncContext *func_ctx,
+                     LLVMValueRef offset)
+{
+    LLVMValueRef mem_base_addr, maddr;
+
+    if (!(mem_base_addr = aot_get_memory_base_addr(comp_ctx, func_ctx)))
+        return NULL;
+
+    if (!(offset = LLVMBuildZExt(comp_ctx->builder, offset, I64_TYPE,
+                                 "extend_offset"))) {
+        aot_set_last_error("llvm build zero extend failed.");
+        return NULL;
+    }
+
+    /* The inline length is covered by the guard bytes after the masked
+       range, only the offset is wrapped */
+    if (comp_ctx->enable_bounds_mask) {
+        LLVMValueRef mem_addr_mask;
+
+        if (!(mem_addr_mask = get_memory_addr_mask(comp_ctx, I64_TYPE)))
+            return NULL;
+        if (!(offset = LLVMBuildAnd(comp_ctx->builder, offset, mem_addr_mask,
+                                    "offset_masked"))) {
+            aot_set_last_error("llvm build and failed.");
+            return NULL;
+        }
+    }
+
+    if (!(maddr = LLVMBuildInBoundsGEP2(comp_ctx->builder, INT8_TYPE,
+                                        mem_base_addr, &offset, 1, "maddr"))) {
+        aot_set_last_error("llvm build inbounds gep failed.");
+        return NULL;
+    }
+    return maddr;
+}
+
+/* Split len bytes into the widest chunks, the last chunk overlaps with
+   the previous one if len isn't a multiple of the chunk size */
+static uint32
+get_bulk_memory_chunks(uint32 len, uint32 *p_chunk_size, uint32 *offsets)
+{
+    uint32 chunk_size = 16, offset, count = 0;
+
+    while (chunk_size > 1 && chunk_size > len)
+        chunk_size >>= 1;
+
+    for (offset = 0; offset + chunk_size <= len; offset += chunk_size)
+        offsets[count++] = offset;
+    if (len % chunk_size)
+        offsets[count++] = len - chunk_size;
+
+    *p_chunk_size = chunk_size;
+    return count;
+}
+
+static LLVMTypeRef
+get_bulk_memory_chunk_type(AOTCompContext *comp_ctx, uint32 chunk_size)
+{
+    switch (chunk_size) {
+        case 16:
+            return V128_i8x16_TYPE;
+        case 8:
+            return I64_TYPE;
+        case 4:
+            return I32_TYPE;
+        case 2:
+            return INT16_TYPE;
+        default:
+            bh_assert(chunk_size == 1);
+            return INT8_TYPE;
+    }
+}
+
+static LLVMValueRef
+get_bulk_memory_chunk_ptr(AOTCompContext *comp_ctx, LLVMValueRef maddr,
+                          uint32 offset, LLVMTypeRef chunk_type)
+{
+    LLVMValueRef offset_const = I32_CONST(offset), ptr;
+
+    if (!offset_const) {
+        aot_set_last_error("llvm build const failed.");
+        return NULL;
+    }
+
+    if (!(ptr = LLVMBuildInBoundsGEP2(comp_ctx->builder, INT8_TYPE, maddr,
+                                      &offset_const, 1, "chunk_addr"))
+        || !(ptr = LLVMBuildBitCast(comp_ctx->builder, ptr,
+                                    LLVMPointerType(chunk_type, 0),
+                                    "chunk_ptr"))) {
+        aot_set_last_error("llvm build gep or bitcast failed.");
+        return NULL;
+    }
+    return ptr;
+}
+
+/* Copy with all the chunks loaded before storing any of them, which is
+   correct for the overlapping source and destination */
+static bool
+build_small_memory_copy(AOTCompContext *comp_ctx, LLVMValueRef dst_addr,
+                        LLVMValueRef src_addr, uint32 len)
+{
+    uint32 offsets[BULK_MEMORY_INLINE_MAX_SIZE / 16 + 1], chunk_size = 0;
+    uint32 count = get_bulk_memory_chunks(len, &chunk_size, offsets), i;
+    LLVMValueRef values[BULK_MEMORY_INLINE_MAX_SIZE / 16 + 1], ptr, res;
+    LLVMTypeRef chunk_type = get_bulk_memory_chunk_type(comp_ctx, chunk_size);
+
+    for (i = 0; i < count; i++) {
+        if (!(ptr = get_bulk_memory_chunk_ptr(comp_ctx, src_addr, offsets[i],
+                                              chunk_type)))
+            return false;
+        if (!(values[i] = LLVMBuildLoad2(comp_ctx->builder, chunk_type, ptr,
+                                         "chunk"))) {
+            aot_set_last_error("llvm build load failed.");
+            return false;
+        }
+        LLVMSetAlignment(values[i], 1);
+        aot_set_memory_domain(comp_ctx, values[i],
+                              AOT_MEMORY_DOMAIN_LINEAR_MEMORY);
+    }
+
+    for (i = 0; i < count; i++) {
+        if (!(ptr = get_bulk_memory_chunk_ptr(comp_ctx, dst_addr, offsets[i],
+                                              chunk_type)))
+            return false;
+        if (!(res = LLVMBuildStore(comp_ctx->builder, values[i], ptr))) {
+            aot_set_last_error("llvm build store failed.");
+            return false;
+        }
+        LLVMSetAlignment(res, 1);
+        aot_set_memory_domain(comp_ctx, res, AOT_MEMORY_DOMAIN_LINEAR_MEMORY);
+    }
+    return true;
+}
+
+static bool
+build_small_memory_fill(AOTCompContext *comp_ctx, LLVMValueRef dst_addr,
+                        LLVMValueRef val, uint32 len)
+{
+    uint32 offsets[BULK_MEMORY_INLINE_MAX_SIZE / 16 + 1], chunk_size = 0;
+    uint32 count = get_bulk_memory_chunks(len, &chunk_size, offsets), i;
+    LLVMTypeRef chunk_type = get_bulk_memory_chunk_type(comp_ctx, chunk_size);
+    LLVMValueRef byte, chunk, ptr, res, mask;
+
+    if (count == 0)
+        return true;
+
+    if (!(byte = LLVMBuildTrunc(comp_ctx->builder, val, INT8_TYPE, "byte"))) {
+        aot_set_last_error("llvm build trunc failed.");
+        return false;
+    }
+
+    /* Replicate the byte to the whole chunk */
+    if (chunk_size == 16) {
+        if (!(mask = LLVMConstNull(LLVMVectorType(I32_TYPE, 16)))) {
+            aot_set_last_error("llvm build const failed.");
+            return false;
+        }
+        if (!(chunk = LLVMBuildInsertElement(comp_ctx->builder,
+                                             LLVMGetUndef(chunk_type), byte,
+                                             I32_ZERO, "chunk"))
+            || !(chunk = LLVMBuildShuffleVector(comp_ctx->builder, chunk,
+                                                LLVMGetUndef(chunk_type), mask,
+                                                "chunk_splat"))) {
+            aot_set_last_error("llvm build shuffle vector failed.");
+            return false;
+        }
+    }
+    else if (chunk_size > 1) {
+        if (!(chunk = LLVMBuildZExt(comp_ctx->builder, byte, chunk_type,
+                                    "chunk"))
+            || !(chunk = LLVMBuildMul(
+                     comp_ctx->builder, chunk,
+                     LLVMConstInt(chunk_type, 0x0101010101010101ULL, false),
+                     "chunk_splat"))) {
+            aot_set_last_error("llvm build mul failed.");
+            return false;
+        }
+    }
+    else
+        chunk = byte;
+
+    for (i = 0; i < count; i++) {
+        if (!(ptr = get_bulk_memory_chunk_ptr(comp_ctx, dst_addr, offsets[i],
+                                              chunk_type)))
+            return false;
+        if (!(res = LLVMBuildStore(comp_ctx->builder, chunk, ptr))) {
+            aot_set_last_error("llvm build store failed.");
+            return false;
+        }
+        LLVMSetAlignment(res, 1);
+        aot_set_memory_domain(comp_ctx, res, AOT_MEMORY_DOMAIN_LINEAR_MEMORY);
+    }
+    return true;
+}
+
+/* Call `void wasm_bulk_memory_copy(void *dst, const void *src, uint64 len)`
+   or `void wasm_bulk_memory_fill(void *dst, int32 val, uint64 len)` of
+   the vmlib, which switch to non-temporal stores for large lengths */
+static bool
+call_bulk_memory_func(AOTCompContext *comp_ctx, const char *func_name,
+                      LLVMValueRef dst_addr, LLVMValueRef src_or_val,
+                      LLVMValueRef len)
+{
+    LLVMTypeRef param_types[3], func_type;
+    LLVMValueRef func, params[3];
+
+    param_types[0] = INT8_PTR_TYPE;
+    param_types[1] = LLVMTypeOf(src_or_val);
+    param_types[2] = I64_TYPE;
+    if (!(func_type = LLVMFunctionType(VOID_TYPE, param_types, 3, false))) {
+        aot_set_last_error("create LLVM function type failed.");
+        return false;
+    }
+
+    if (!(func = LLVMGetNamedFunction(comp_ctx->module, func_name))
+        && !(func = LLVMAddFunction(comp_ctx->module, func_name, func_type))) {
+        aot_set_last_error("add LLVM function failed.");
+        return false;
+    }
+
+    params[0] = dst_addr;
+    params[1] = src_or_val;
+    if (!(params[2] = LLVMBuildZExt(comp_ctx->builder, len, I64_TYPE,
+                                    "len64"))) {
+        aot_set_last_error("llvm build zero extend failed.");
+        return false;
+    }
+    if (!LLVMBuildCall2(comp_ctx->builder, func_type, func, params, 3, "")) {
+        aot_set_last_error("llvm build call failed.");
+        return false;
+    }
+    return true;
+}
+
 bool
 aot_compile_op_memory_copy(AOTCompContext *comp_ctx, AOTFuncContext *func_ctx)
 {
-    LLVMValueRef src, dst, src_addr, dst_addr, len, res;
+    LLVMValueRef src, dst, src_addr, dst_addr, len, res, cmp, max_offset;
+    uint64 src_val, dst_val, len_val = 0;
+    bool is_const_len;
 
     POP_MEM_OFFSET(len);
     POP_MEM_OFFSET(src);
     POP_MEM_OFFSET(dst);
 
-    if (!(src_addr = check_bulk_memory_overflow(comp_ctx, func_ctx, src, len)))
+    if ((is_const_len = LLVMIsEfficientConstInt(len)))
+        len_val = LLVMConstIntGetZExtValue(len);
+
+    if (is_const_len && len_val <= BULK_MEMORY_INLINE_MAX_SIZE) {
+        /* One bounds check of the larger offset covers both ranges */
+        BUILD_ICMP(LLVMIntUGT, src, dst, cmp, "src_gt_dst");
+        if (!(max_offset = LLVMBuildSelect(comp_ctx->builder, cmp, src, dst,
+                                           "max_offset"))) {
+            aot_set_last_error("llvm build select failed.");
+            return false;
+        }
+        if ((!comp_ctx->enable_bounds_mask
+             && !check_bulk_memory_overflow(comp_ctx, func_ctx, max_offset,
+                                            &len))
+            || !(src_addr = get_bulk_memory_addr(comp_ctx, func_ctx, src))
+            || !(dst_addr = get_bulk_memory_addr(comp_ctx, func_ctx, dst)))
+            return false;
+
+        return build_small_memory_copy(comp_ctx, dst_addr, src_addr,
+                                       (uint32)len_val);
+    }
+
+    if (!(src_addr =
+              check_bulk_memory_overflow(comp_ctx, func_ctx, src, &len)))
         return false;
 
-    if (!(dst_addr = check_bulk_memory_overflow(comp_ctx, func_ctx, dst, len)))
+    if (!(dst_addr =
+              check_bulk_memory_overflow(comp_ctx, func_ctx, dst, &len)))
         return false;
 
+    /* The masked ranges may overlap even if the wasm ranges don't */
+    if (is_const_len && !comp_ctx->enable_bounds_mask
+        && LLVMIsEfficientConstInt(src) && LLVMIsEfficientConstInt(dst)) {
+        src_val = LLVMConstIntGetZExtValue(src);
+        dst_val = LLVMConstIntGetZExtValue(dst);
+        /* The ranges don't overlap */
+        if (src_val + len_val <= dst_val || dst_val + len_val <= src_val) {
+            if (!zero_extend_u64(comp_ctx, &len, "len64"))
+                return false;
+            if (!(res = LLVMBuildMemCpy(comp_ctx->builder, dst_addr, 1,
+                                        src_addr, 1, len))) {
+                aot_set_last_error("llvm build memcpy failed.");
+                return false;
+            }
+            return true;
+        }
+    }
+
+    /* The vmlib isn't linked in no-sandbox mode */
+    if (!comp_ctx->no_sandbox_mode)
+        return call_bulk_memory_func(comp_ctx, "wasm_bulk_memory_copy",
+                                     dst_addr, src_addr, len);
+
     if (!zero_extend_u64(comp_ctx, &len, "len64")) {
         return false;
     }
@@ -1146,43 +1792,44 @@ bool
 aot_compile_op_memory_fill(AOTCompContext *comp_ctx, AOTFuncContext *func_ctx)
 {
     LLVMValueRef val, dst, dst_addr, len, res;
-    LLVMTypeRef param_types[3], ret_type, func_type, func_ptr_type;
-    LLVMValueRef func, params[3];
+    uint64 len_val = 0;
+    bool is_const_len;
 
     POP_MEM_OFFSET(len);
     POP_I32(val);
     POP_MEM_OFFSET(dst);
 
-    if (!(dst_addr = check_bulk_memory_overflow(comp_ctx, func_ctx, dst, len)))
-        return false;
+    if ((is_const_len = LLVMIsEfficientConstInt(len)))
+        len_val = LLVMConstIntGetZExtValue(len);
 
-    /* TODO */
-    param_types[0] = INT8_PTR_TYPE;
-    param_types[1] = I32_TYPE;
-    param_types[2] = I32_TYPE;
-    ret_type = INT8_PTR_TYPE;
+    if (is_const_len && len_val <= BULK_MEMORY_INLINE_MAX_SIZE) {
+        if ((!comp_ctx->enable_bounds_mask
+             && !check_bulk_memory_overflow(comp_ctx, func_ctx, dst, &len))
+            || !(dst_addr = get_bulk_memory_addr(comp_ctx, func_ctx, dst)))
+            return false;
 
-    if (!(func_type = LLVMFunctionType(ret_type, param_types, 3, false))) {
-        aot_set_last_error("create LLVM function type failed.");
-        return false;
+        return build_small_memory_fill(comp_ctx, dst_addr, val,
+                                       (uint32)len_val);
     }
 
-    if (!(func_ptr_type = LLVMPointerType(func_type, 0))) {
-        aot_set_last_error("create LLVM function pointer type failed.");
+    if (!(dst_addr =
+              check_bulk_memory_overflow(comp_ctx, func_ctx, dst, &len)))
         return false;
-    }
 
-    if (!(func = LLVMGetNamedFunction(func_ctx->module, "memset"))
-        && !(func = LLVMAddFunction(func_ctx->module, "memset", func_type))) {
-        aot_set_last_error("llvm add function failed.");
+    /* The vmlib isn't linked in no-sandbox mode */
+    if (!comp_ctx->no_sandbox_mode)
+        return call_bulk_memory_func(comp_ctx, "wasm_bulk_memory_fill",
+                                     dst_addr, val, len);
+
+    if (!zero_extend_u64(comp_ctx, &len, "len64"))
+        return false;
+
+    if (!(val = LLVMBuildTrunc(comp_ctx->builder, val, INT8_TYPE, "byte"))) {
+        aot_set_last_error("llvm build trunc failed.");
         return false;
     }
 
-    params[0] = dst_addr;
-    params[1] = val;
-    params[2] = len;
-    if (!(res = LLVMBuildCall2(comp_ctx->builder, func_type, func, params, 3,
-                               "call_memset"))) {
+    if (!(res = LLVMBuildMemSet(comp_ctx->builder, dst_addr, val, len, 1))) {
         aot_set_last_error("llvm build memset failed.");
         return false;
     }
@@ -1208,7 +1855,8 @@ aot_compile_op_atomic_rmw(AOTCompContext *comp_ctx, AOTFuncContext *func_ctx,
                                             NULL)))
         return false;
 
-    if (!check_memory_alignment(comp_ctx, func_ctx, maddr, align))
+    if (!check_memory_alignment(comp_ctx, func_ctx, maddr, align,
+                                EXCE_UNALIGNED_ATOMIC))
         return false;
 
     switch (bytes) {
@@ -1281,7 +1929,8 @@ aot_compile_op_atomic_cmpxchg(AOTCompContext *comp_ctx,
                                             NULL)))
         return false;
 
-    if (!check_memory_alignment(comp_ctx, func_ctx, maddr, align))
+    if (!check_memory_alignment(comp_ctx, func_ctx, maddr, align,
+                                EXCE_UNALIGNED_ATOMIC))
         return false;
 
     switch (bytes) {
@@ -57,9 +57,34 @@ aot_check_memory_overflow(AOTCompContext *comp_ctx, AOTFuncContext *func_ctx,
                           uint64 offset, uint32 bytes,
                           WASMRelocation *relocation);
 
+/**
+ * Get the alignment of the native load or store of a wasm memory access,
+ * it is 1 unless `--trust-alignment-hints` is specified, in which case
+ * the alignment immediate is used, and the address is checked against
+ * it if `--check-alignment-hints` is also specified
+ *
+ * @param maddr the native address to access
+ * @param align the alignment immediate, log2 of the alignment in bytes
+ * @param p_alignment [out] the alignment in bytes
+ */
+bool
+aot_get_access_alignment(AOTCompContext *comp_ctx, AOTFuncContext *func_ctx,
+                         LLVMValueRef maddr, uint32 align, uint32 *p_alignment);
+
 bool
 aot_compile_op_memory_size(AOTCompContext *comp_ctx, AOTFuncContext *func_ctx);
 
+/**
+ * Build the IR to grow the linear memory by inc_page_count pages at the
+ * current position of function llvm_func, the host managed heap is also
+ * migrated and extended with the new pages if it exists
+ *
+ * @return the previous page count, or -1 if failed to grow
+ */
+LLVMValueRef
+aot_build_memory_grow(AOTCompContext *comp_ctx, LLVMValueRef llvm_func,
+                      LLVMValueRef inc_page_count);
+
 bool
 aot_compile_op_memory_grow(AOTCompContext *comp_ctx, AOTFuncContext *func_ctx);
 
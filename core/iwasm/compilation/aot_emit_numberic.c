@@ -333,6 +333,77 @@ fail:
     return false;
 }
 
+/* Build the division with an x86-64 div/idiv which faults on divided by
+   zero or integer overflow, and record its address and divisor width in
+   the w2n_hw_traps section, so that the SIGFPE handler of the vmlib can
+   find the divisor in rcx and tell the exception */
+static LLVMValueRef
+build_hw_trap_int_div(AOTCompContext *comp_ctx, IntArithmetic arith_op,
+                      bool is_i32, LLVMValueRef left, LLVMValueRef right)
+{
+    static const char *trap_entry = "\n.pushsection w2n_hw_traps,\"a\"\n"
+                                    ".long 1b - .\n"
+                                    ".long %d\n"
+                                    ".popsection";
+    static const char *constraints = "={ax},={dx},{ax},{cx},~{flags}";
+    bool is_signed = arith_op == INT_DIV_S || arith_op == INT_REM_S;
+    LLVMTypeRef int_type = is_i32 ? I32_TYPE : I64_TYPE, ret_types[2];
+    LLVMTypeRef ret_type, func_type, param_types[2];
+    LLVMValueRef inline_asm, res, params[2];
+    char asm_str[160];
+
+    snprintf(asm_str, sizeof(asm_str), "%s\n1:\t%s $3",
+             is_signed ? (is_i32 ? "cltd" : "cqto")
+                       : (is_i32 ? "xorl %edx, %edx" : "xorq %rdx, %rdx"),
+             is_signed ? (is_i32 ? "idivl" : "idivq")
+                       : (is_i32 ? "divl" : "divq"));
+    snprintf(asm_str + strlen(asm_str), sizeof(asm_str) - strlen(asm_str),
+             trap_entry, is_i32 ? 0 : 1);
+
+    ret_types[0] = ret_types[1] = int_type;
+    param_types[0] = param_types[1] = int_type;
+    if (!(ret_type =
+              LLVMStructTypeInContext(comp_ctx->context, ret_types, 2, false))
+        || !(func_type = LLVMFunctionType(ret_type, param_types, 2, false))) {
+        aot_set_last_error("create LLVM function type failed.");
+        return NULL;
+    }
+
+    /* Mark it side-effecting so that it isn't removed if the result
+       is unused, the wasm spec requires the trap */
+    if (!(inline_asm = LLVMGetInlineAsm(func_type, asm_str, strlen(asm_str),
+                                        (char *)constraints,
+                                        strlen(constraints), true, false,
+                                        LLVMInlineAsmDialectATT
+#if LLVM_VERSION_MAJOR >= 13
+                                        ,
+                                        false
+#endif
+                                        ))) {
+        aot_set_last_error("create LLVM inline asm failed.");
+        return NULL;
+    }
+
+    params[0] = left;
+    params[1] = right;
+    if (!(res = LLVMBuildCall2(comp_ctx->builder, func_type, inline_asm,
+                               params, 2, "hw_trap_div"))) {
+        aot_set_last_error("llvm build call failed.");
+        return NULL;
+    }
+
+    /* The quotient is in rax and the remainder is in rdx */
+    if (!(res = LLVMBuildExtractValue(
+              comp_ctx->builder, res,
+              (arith_op == INT_DIV_S || arith_op == INT_DIV_U) ? 0 : 1,
+              "hw_trap_div_res"))) {
+        aot_set_last_error("llvm build extract value failed.");
+        return NULL;
+    }
+
+    return res;
+}
+
 static bool
 compile_rems(AOTCompContext *comp_ctx, AOTFuncContext *func_ctx,
              LLVMValueRef left, LLVMValueRef right, LLVMValueRef overflow_cond,
@@ -360,9 +431,15 @@ compile_rems(AOTCompContext *comp_ctx, AOTFuncContext *func_ctx,
     /* Translate no_overflow_block */
     LLVMPositionBuilderAtEnd(comp_ctx->builder, no_overflow_block);
 
-    LLVM_BUILD_OP_OR_INTRINSIC(SRem, left, right, no_overflow_value,
-                               is_i32 ? "i32.rem_s" : "i64.rem_s", "rem_s",
-                               false);
+    if (comp_ctx->enable_hw_trap) {
+        if (!(no_overflow_value = build_hw_trap_int_div(
+                  comp_ctx, INT_REM_S, is_i32, left, right)))
+            return false;
+    }
+    else
+        LLVM_BUILD_OP_OR_INTRINSIC(SRem, left, right, no_overflow_value,
+                                   is_i32 ? "i32.rem_s" : "i64.rem_s", "rem_s",
+                                   false);
 
     /* Jump to rems_end block */
     if (!LLVMBuildBr(comp_ctx->builder, rems_end_block)) {
@@ -506,6 +583,24 @@ compile_int_div(AOTCompContext *comp_ctx, AOTFuncContext *func_ctx,
                 return true;
         }
     }
+    else if (comp_ctx->enable_hw_trap) {
+        /* Let div/idiv fault on divided by zero and integer overflow,
+           rem_s still checks the overflow since it returns 0 */
+        if (arith_op == INT_REM_S) {
+            if (is_i32)
+                CHECK_INT_OVERFLOW(I32);
+            else
+                CHECK_INT_OVERFLOW(I64);
+            return compile_rems(comp_ctx, func_ctx, left, right, overflow,
+                                is_i32);
+        }
+
+        if (!(res = build_hw_trap_int_div(comp_ctx, arith_op, is_i32, left,
+                                          right)))
+            goto fail;
+        PUSH_INT(res);
+        return true;
+    }
     else {
         if (!comp_ctx->no_sandbox_mode) {
             /* Check divided by zero */
@@ -105,34 +105,210 @@ fail:
     return false;
 }
 
-static bool
-compile_global(AOTCompContext *comp_ctx, AOTFuncContext *func_ctx,
-               uint32 global_idx, bool is_set, bool is_aux_stack,
-               WASMRelocation *relocation)
+static LLVMValueRef
+get_global_ptr(AOTCompContext *comp_ctx, uint32 global_idx,
+               uint8 *p_global_type)
 {
     const AOTCompData *comp_data = comp_ctx->comp_data;
     uint32 import_global_count = comp_data->import_global_count;
-    uint8 global_type;
-    LLVMValueRef global_ptr, global, res, mem_data, mem_addr;
+    LLVMValueRef global_ptr;
     char buf[48];
 
-    if (!(mem_data = aot_get_memory_base_addr(comp_ctx, func_ctx)))
-        return false;
-
     bh_assert(global_idx < import_global_count + comp_data->global_count);
 
     if (global_idx < import_global_count) {
-        global_type = comp_data->import_globals[global_idx].type;
+        *p_global_type = comp_data->import_globals[global_idx].type;
         snprintf(buf, sizeof(buf), "%s%u", "wasm_import_global#", global_idx);
     }
     else {
-        global_type = comp_data->globals[global_idx - import_global_count].type;
+        *p_global_type =
+            comp_data->globals[global_idx - import_global_count].type;
         snprintf(buf, sizeof(buf), "%s%u", "wasm_global#",
                  global_idx - import_global_count);
     }
 
     global_ptr = LLVMGetNamedGlobal(comp_ctx->module, buf);
     bh_assert(global_ptr);
+    return global_ptr;
+}
+
+/* Whether the current code is in the function body outside of any
+   block, which dominates all the code after it in the function */
+static bool
+is_in_func_body(const AOTFuncContext *func_ctx)
+{
+    return func_ctx->block_stack.block_list_end
+           == func_ctx->block_stack.block_list_head;
+}
+
+/* Check whether the aux stack top is in the range of the aux stack */
+static bool
+check_aux_stack_top(AOTCompContext *comp_ctx, AOTFuncContext *func_ctx,
+                    LLVMValueRef aux_stack_top)
+{
+    const AOTCompData *comp_data = comp_ctx->comp_data;
+    LLVMBasicBlockRef check_overflow_succ, check_underflow_succ;
+    LLVMValueRef aux_stack_bound, aux_stack_bottom, cmp;
+
+    if (!comp_ctx->enable_aux_stack_check || comp_ctx->no_sandbox_mode)
+        return true;
+
+    /* The aux stack grows downwards from aux_stack_bottom */
+    aux_stack_bound = I32_CONST(
+        (uint32)(comp_data->aux_stack_bottom - comp_data->aux_stack_size));
+    CHECK_LLVM_CONST(aux_stack_bound);
+    aux_stack_bottom = I32_CONST((uint32)comp_data->aux_stack_bottom);
+    CHECK_LLVM_CONST(aux_stack_bottom);
+
+    if (!(check_overflow_succ = LLVMAppendBasicBlockInContext(
+              comp_ctx->context, func_ctx->func, "check_overflow_succ"))
+        || !(check_underflow_succ = LLVMAppendBasicBlockInContext(
+                 comp_ctx->context, func_ctx->func, "check_underflow_succ"))) {
+        aot_set_last_error("llvm add basic block failed.");
+        return false;
+    }
+    LLVMMoveBasicBlockAfter(check_overflow_succ,
+                            LLVMGetInsertBlock(comp_ctx->builder));
+    LLVMMoveBasicBlockAfter(check_underflow_succ, check_overflow_succ);
+
+    if (!(cmp = LLVMBuildICmp(comp_ctx->builder, LLVMIntULT, aux_stack_top,
+                              aux_stack_bound, "cmp"))) {
+        aot_set_last_error("llvm build icmp failed.");
+        return false;
+    }
+    if (!aot_emit_exception(comp_ctx, func_ctx, EXCE_AUX_STACK_OVERFLOW, true,
+                            cmp, check_overflow_succ))
+        return false;
+
+    if (!(cmp = LLVMBuildICmp(comp_ctx->builder, LLVMIntUGT, aux_stack_top,
+                              aux_stack_bottom, "cmp"))) {
+        aot_set_last_error("llvm build icmp failed.");
+        return false;
+    }
+    if (!aot_emit_exception(comp_ctx, func_ctx, EXCE_AUX_STACK_UNDERFLOW, true,
+                            cmp, check_underflow_succ))
+        return false;
+
+    return true;
+fail:
+    return false;
+}
+
+bool
+aot_promote_aux_stack_top(AOTCompContext *comp_ctx, AOTFuncContext *func_ctx)
+{
+    uint32 global_idx = comp_ctx->comp_data->aux_stack_top_global_index;
+    uint8 global_type;
+    LLVMValueRef global_ptr, value;
+
+    if (!func_ctx->aot_func->has_op_set_global_aux_stack)
+        return true;
+
+    global_ptr = get_global_ptr(comp_ctx, global_idx, &global_type);
+
+    if (!(func_ctx->aux_stack_top = LLVMBuildAlloca(
+              comp_ctx->builder, TO_LLVM_TYPE(global_type), "aux_stack_top"))) {
+        aot_set_last_error("llvm build alloca failed.");
+        return false;
+    }
+
+    if (!(value = LLVMBuildLoad2(comp_ctx->builder, TO_LLVM_TYPE(global_type),
+                                 global_ptr, "aux_stack_top"))) {
+        aot_set_last_error("llvm build load failed.");
+        return false;
+    }
+    aot_set_memory_domain(comp_ctx, value, AOT_MEMORY_DOMAIN_WASM_GLOBAL);
+
+    if (!LLVMBuildStore(comp_ctx->builder, value, func_ctx->aux_stack_top)) {
+        aot_set_last_error("llvm build store failed.");
+        return false;
+    }
+    return true;
+}
+
+bool
+aot_commit_aux_stack_top(AOTCompContext *comp_ctx, AOTFuncContext *func_ctx,
+                         bool is_call)
+{
+    uint32 global_idx = comp_ctx->comp_data->aux_stack_top_global_index;
+    uint8 global_type;
+    LLVMValueRef global_ptr, value, res;
+
+    if (!func_ctx->aux_stack_top)
+        return true;
+
+    global_ptr = get_global_ptr(comp_ctx, global_idx, &global_type);
+
+    if (!(value = LLVMBuildLoad2(comp_ctx->builder, TO_LLVM_TYPE(global_type),
+                                 func_ctx->aux_stack_top, "aux_stack_top"))) {
+        aot_set_last_error("llvm build load failed.");
+        return false;
+    }
+
+    /* The callee may run on the aux stack top set after the last check,
+       the check only covers the later calls if it dominates them */
+    if (is_call && func_ctx->aux_stack_top_dirty) {
+        if (!check_aux_stack_top(comp_ctx, func_ctx, value))
+            return false;
+        if (is_in_func_body(func_ctx))
+            func_ctx->aux_stack_top_dirty = false;
+    }
+
+    if (!(res = LLVMBuildStore(comp_ctx->builder, value, global_ptr))) {
+        aot_set_last_error("llvm build store failed.");
+        return false;
+    }
+    aot_set_memory_domain(comp_ctx, res, AOT_MEMORY_DOMAIN_WASM_GLOBAL);
+    return true;
+}
+
+bool
+aot_reload_aux_stack_top(AOTCompContext *comp_ctx, AOTFuncContext *func_ctx)
+{
+    uint32 global_idx = comp_ctx->comp_data->aux_stack_top_global_index;
+    uint8 global_type;
+    LLVMValueRef global_ptr, value;
+
+    if (!func_ctx->aux_stack_top)
+        return true;
+
+    global_ptr = get_global_ptr(comp_ctx, global_idx, &global_type);
+
+    if (!(value = LLVMBuildLoad2(comp_ctx->builder, TO_LLVM_TYPE(global_type),
+                                 global_ptr, "aux_stack_top"))) {
+        aot_set_last_error("llvm build load failed.");
+        return false;
+    }
+    aot_set_memory_domain(comp_ctx, value, AOT_MEMORY_DOMAIN_WASM_GLOBAL);
+
+    if (!LLVMBuildStore(comp_ctx->builder, value, func_ctx->aux_stack_top)) {
+        aot_set_last_error("llvm build store failed.");
+        return false;
+    }
+    return true;
+}
+
+static bool
+compile_global(AOTCompContext *comp_ctx, AOTFuncContext *func_ctx,
+               uint32 global_idx, bool is_set, bool is_aux_stack,
+               WASMRelocation *relocation)
+{
+    uint8 global_type;
+    LLVMValueRef global_ptr, global, res, mem_data, mem_addr;
+    bool is_promoted;
+
+    if (!(mem_data = aot_get_memory_base_addr(comp_ctx, func_ctx)))
+        return false;
+
+    global_ptr = get_global_ptr(comp_ctx, global_idx, &global_type);
+
+    /* Access the promoted aux stack top instead of the global, which
+       is only written back around calls and returns */
+    is_promoted = func_ctx->aux_stack_top
+                  && global_idx
+                         == comp_ctx->comp_data->aux_stack_top_global_index;
+    if (is_promoted)
+        global_ptr = func_ctx->aux_stack_top;
 
     if (!is_set) {
         if (!(global =
@@ -141,6 +317,9 @@ compile_global(AOTCompContext *comp_ctx, AOTFuncContext *func_ctx,
             aot_set_last_error("llvm build load failed.");
             return false;
         }
+        if (!is_promoted)
+            aot_set_memory_domain(comp_ctx, global,
+                                  AOT_MEMORY_DOMAIN_WASM_GLOBAL);
 
         if (comp_ctx->no_sandbox_mode && relocation) {
             bh_assert(global_type == VALUE_TYPE_I64
@@ -181,10 +360,31 @@ compile_global(AOTCompContext *comp_ctx, AOTFuncContext *func_ctx,
             }
         }
 
+        /* Check the aux stack top once when the function first moves
+           it, which is the prologue for the code generated by clang,
+           the later moves are checked before the next call. Only the
+           code in the function body outside of any block is executed
+           on every path after it, so the moves in the blocks (loops,
+           branches) are always checked and never skip a check */
+        if (is_aux_stack) {
+            if (!is_promoted || !func_ctx->aux_stack_top_checked
+                || !is_in_func_body(func_ctx)) {
+                if (!check_aux_stack_top(comp_ctx, func_ctx, global))
+                    return false;
+                if (is_in_func_body(func_ctx))
+                    func_ctx->aux_stack_top_checked = true;
+            }
+            else {
+                func_ctx->aux_stack_top_dirty = true;
+            }
+        }
+
         if (!(res = LLVMBuildStore(comp_ctx->builder, global, global_ptr))) {
             aot_set_last_error("llvm build store failed.");
             return false;
         }
+        if (!is_promoted)
+            aot_set_memory_domain(comp_ctx, res, AOT_MEMORY_DOMAIN_WASM_GLOBAL);
     }
 
     return true;
@@ -33,6 +33,29 @@ aot_compile_op_set_global(AOTCompContext *comp_ctx, AOTFuncContext *func_ctx,
                           uint32 global_idx, bool is_aux_stack,
                           WASMRelocation *relocation);
 
+/**
+ * Keep the aux stack top global in a local variable of the function if
+ * the function sets it, so that LLVM can promote it into a register,
+ * the variable is written back to the global only around calls and
+ * returns. Must be called in the entry block of the function.
+ */
+bool
+aot_promote_aux_stack_top(AOTCompContext *comp_ctx, AOTFuncContext *func_ctx);
+
+/**
+ * Write the promoted aux stack top back to the global before a call or
+ * return, it is checked before a call if it was set after the last check
+ */
+bool
+aot_commit_aux_stack_top(AOTCompContext *comp_ctx, AOTFuncContext *func_ctx,
+                         bool is_call);
+
+/**
+ * Reload the promoted aux stack top from the global after a call
+ */
+bool
+aot_reload_aux_stack_top(AOTCompContext *comp_ctx, AOTFuncContext *func_ctx);
+
 #ifdef __cplusplus
 } /* end of extern "C" */
 #endif
@@ -7,6 +7,8 @@
 #include "aot_llvm_extra2.h"
 #include "aot_compiler.h"
 #include "aot_emit_exception.h"
+#include "aot_emit_memory.h"
+#include "../../shared/mem-alloc/mem_alloc.h"
 
 LLVMTypeRef
 wasm_type_to_llvm_type(const AOTLLVMTypes *llvm_types, uint8 wasm_type)
@@ -73,6 +75,7 @@ static const char *exception_msgs[] = {
     "host managed heap not found",   /* EXCE_HOST_MANAGED_HEAP_NOT_FOUND */
     "quick call entry not found",    /* EXCE_QUICK_CALL_ENTRY_NOT_FOUND */
     "unknown error",                 /* EXCE_UNKNOWN_ERROR */
+    "unaligned memory access",       /* EXCE_UNALIGNED_MEMORY_ACCESS */
 };
 /* clang-format on */
 
@@ -81,6 +84,42 @@ static const char *exception_msgs[] = {
          ? true                                                        \
          : false)
 
+static bool
+create_static_memory_data(AOTCompContext *comp_ctx, uint64 memory_data_size)
+{
+    LLVMTypeRef buf_type;
+    LLVMValueRef buf_global, initializer;
+
+    if (!(buf_type = LLVMArrayType(INT8_TYPE, (uint32)memory_data_size))
+        || !(initializer = LLVMConstNull(buf_type))) {
+        aot_set_last_error("create LLVM array type failed.");
+        return false;
+    }
+
+    /* Not in the .wasm_globals section, so that it goes to .bss */
+    if (!(buf_global =
+              LLVMAddGlobal(comp_ctx->module, buf_type, "memory_data_buf"))) {
+        aot_set_last_error("add LLVM global failed");
+        return false;
+    }
+    LLVMSetLinkage(buf_global, LLVMInternalLinkage);
+    LLVMSetInitializer(buf_global, initializer);
+    LLVMSetAlignment(buf_global, 4096);
+
+    if (!(comp_ctx->static_memory_data =
+              LLVMConstBitCast(buf_global, INT8_PTR_TYPE))) {
+        aot_set_last_error("llvm build const bitcast failed.");
+        return false;
+    }
+
+    /* Whether the buffer was used by an instance destroyed before, it
+       is zeroed when creating the instance again */
+    return create_wasm_global(comp_ctx, INT8_TYPE, "memory_data_buf_used",
+                              I8_ZERO, false)
+               ? true
+               : false;
+}
+
 static bool
 create_wasm_globals(const AOTCompData *comp_data, AOTCompContext *comp_ctx)
 {
@@ -89,6 +128,8 @@ create_wasm_globals(const AOTCompData *comp_data, AOTCompContext *comp_ctx)
     LLVMTypeRef global_type;
     uint64 memory_data_size = (uint64)aot_memory->num_bytes_per_page
                               * aot_memory->mem_init_page_count;
+    uint64 memory_data_alloc_size =
+        aot_get_memory_data_alloc_size(comp_ctx, memory_data_size);
     bool memory_data_size_fixed = MEMORY_DATA_SIZE_FIXED(aot_memory);
     uint64 total_size;
     uint32 i, j, k;
@@ -112,6 +153,19 @@ create_wasm_globals(const AOTCompData *comp_data, AOTCompContext *comp_ctx)
         return false;
     }
 
+    if (comp_ctx->enable_bounds_mask
+        && comp_ctx->pointer_size == sizeof(uint32)
+        && memory_data_alloc_size > UINT32_MAX) {
+        aot_set_last_error("linear memory is too large for bounds mask mode.");
+        return false;
+    }
+
+    if (!comp_ctx->no_sandbox_mode && memory_data_size_fixed
+        && memory_data_size > 0
+        && memory_data_alloc_size <= W2N_STATIC_MEMORY_MAX_SIZE
+        && !create_static_memory_data(comp_ctx, memory_data_alloc_size))
+        return false;
+
     if (!comp_ctx->no_sandbox_mode) {
         /* Create num_bytes_per_page global */
         initializer = I32_CONST(aot_memory->num_bytes_per_page);
@@ -137,6 +191,20 @@ create_wasm_globals(const AOTCompData *comp_data, AOTCompContext *comp_ctx)
             return false;
         }
 
+        /* Create memory_grow_count global */
+        if (!create_wasm_global(comp_ctx, I32_TYPE, "memory_grow_count",
+                                I32_ZERO, false)) {
+            return false;
+        }
+
+        /* Create alloc_call_site global, the index of the function which
+           calls the allocation import last, set if the alloc profiling
+           is enabled */
+        if (!create_wasm_global(comp_ctx, I32_TYPE, "alloc_call_site",
+                                I32_NEG_ONE, false)) {
+            return false;
+        }
+
         /* Create host_managed_heap_handle global */
         initializer = int8_null_ptr;
         if (!create_wasm_global(comp_ctx, INT8_PTR_TYPE,
@@ -189,6 +257,18 @@ create_wasm_globals(const AOTCompData *comp_data, AOTCompContext *comp_ctx)
                                 initializer, memory_data_size_fixed)) {
             return false;
         }
+
+        /* Create mem_addr_mask global, the power of two size of the
+           allocated linear memory minus one, excluding the guard bytes */
+        if (comp_ctx->enable_bounds_mask) {
+            initializer = I64_CONST(memory_data_alloc_size
+                                    - W2N_BOUNDS_MASK_GUARD_SIZE - 1);
+            CHECK_LLVM_CONST(initializer);
+            if (!create_wasm_global(comp_ctx, I64_TYPE, "mem_addr_mask",
+                                    initializer, memory_data_size_fixed)) {
+                return false;
+            }
+        }
     }
 
     if (comp_data->data_seg_count > 0) {
@@ -226,28 +306,11 @@ create_wasm_globals(const AOTCompData *comp_data, AOTCompContext *comp_ctx)
                 }
             }
 
-            total_size = (uint64)sizeof(LLVMValueRef) * data_seg->data_length;
-            if (total_size > 0
-                && !(values = wasm_runtime_malloc((uint32)total_size))) {
-                aot_set_last_error("allocate memory failed");
-                return false;
-            }
-
-            for (j = 0; j < data_seg->data_length; j++) {
-                values[j] = I8_CONST(data_seg->data[j]);
-                if (!values[j]) {
-                    aot_set_last_error("llvm build const failed");
-                    wasm_runtime_free(values);
-                    return false;
-                }
-            }
-
-            initializer =
-                LLVMConstArray(INT8_TYPE, values, data_seg->data_length);
-            if (values) {
-                wasm_runtime_free(values);
-                values = NULL;
-            }
+            /* Create the constant from the segment data directly, which
+               may refer to the mapped wasm file */
+            initializer = LLVMConstStringInContext(
+                comp_ctx->context, (const char *)data_seg->data,
+                data_seg->data_length, true);
             if (!initializer) {
                 aot_set_last_error("llvm build const failed");
                 return false;
@@ -466,9 +529,12 @@ create_wasm_globals(const AOTCompData *comp_data, AOTCompContext *comp_ctx)
         for (i = 0; i < comp_data->import_func_count; i++) {
             values[i] = int8_null_ptr;
         }
+        /* The internal functions can't be reached by call_indirect */
         for (i = 0; i < comp_data->func_count; i++) {
             values[comp_data->import_func_count + i] =
-                comp_ctx->func_ctxes[i]->func;
+                comp_ctx->func_ctxes[i]->is_internal
+                    ? int8_null_ptr
+                    : comp_ctx->func_ctxes[i]->func;
         }
 
         initializer = LLVMConstArray(INT8_PTR_TYPE, values,
@@ -954,6 +1020,65 @@ static NativeSymbol native_symbols_libc64_nosandbox[] = {
 };
 /* clang-format on */
 
+static bool
+build_clear_used_static_memory_data(AOTCompContext *comp_ctx,
+                                    LLVMValueRef memory_data_size)
+{
+    LLVMValueRef used_global, used, func;
+    LLVMBasicBlockRef clear_block, cleared_block;
+
+    used_global = LLVMGetNamedGlobal(comp_ctx->module, "memory_data_buf_used");
+    bh_assert(used_global);
+
+    if (!(used = LLVMBuildLoad2(comp_ctx->builder, INT8_TYPE, used_global,
+                                "memory_data_buf_used"))) {
+        aot_set_last_error("llvm build load failed.");
+        return false;
+    }
+
+    if (!(used = LLVMBuildICmp(comp_ctx->builder, LLVMIntNE, used, I8_ZERO,
+                               "is_used"))) {
+        aot_set_last_error("llvm build icmp failed.");
+        return false;
+    }
+
+    func = LLVMGetBasicBlockParent(LLVMGetInsertBlock(comp_ctx->builder));
+    if (!(clear_block = LLVMAppendBasicBlockInContext(comp_ctx->context, func,
+                                                      "clear_memory_data"))
+        || !(cleared_block = LLVMAppendBasicBlockInContext(
+                 comp_ctx->context, func, "memory_data_cleared"))) {
+        aot_set_last_error("add LLVM basic block failed.");
+        return false;
+    }
+    LLVMMoveBasicBlockAfter(clear_block, LLVMGetInsertBlock(comp_ctx->builder));
+    LLVMMoveBasicBlockAfter(cleared_block, clear_block);
+
+    if (!LLVMBuildCondBr(comp_ctx->builder, used, clear_block,
+                         cleared_block)) {
+        aot_set_last_error("llvm build cond br failed.");
+        return false;
+    }
+
+    LLVMPositionBuilderAtEnd(comp_ctx->builder, clear_block);
+    if (!LLVMBuildMemSet(comp_ctx->builder, comp_ctx->static_memory_data,
+                         I8_ZERO, memory_data_size, 4096)) {
+        aot_set_last_error("llvm build memset failed.");
+        return false;
+    }
+    if (!LLVMBuildBr(comp_ctx->builder, cleared_block)) {
+        aot_set_last_error("llvm build br failed.");
+        return false;
+    }
+
+    LLVMPositionBuilderAtEnd(comp_ctx->builder, cleared_block);
+    if (!LLVMBuildStore(comp_ctx->builder, I8_ONE, used_global)) {
+        aot_set_last_error("llvm build store failed.");
+        return false;
+    }
+
+    return true;
+}
+
 static bool
 create_wasm_instance_create_func(const AOTCompData *comp_data,
                                  AOTCompContext *comp_ctx)
@@ -969,9 +1094,8 @@ create_wasm_instance_create_func(const AOTCompData *comp_data,
     AOTMemory *aot_memory = &comp_data->memories[0];
     uint64 memory_data_size = (uint64)aot_memory->num_bytes_per_page
                               * aot_memory->mem_init_page_count;
-    bool memory_data_size_fixed = MEMORY_DATA_SIZE_FIXED(aot_memory),
-         has_post_instantiate_func = false;
-    uint64 total_size;
+    bool has_post_instantiate_func = false;
+    uint64 total_size, memory_data_alloc_size;
     uint32 i, j, n_native_symbols;
     char func_name[48], buf[128];
 
@@ -1333,23 +1457,33 @@ create_wasm_instance_create_func(const AOTCompData *comp_data,
         return false;
     }
 
-    /* Call malloc function to allocate memory for wasm linear memory */
-    snprintf(func_name, sizeof(func_name), "%s", "malloc");
-    if (!(func = LLVMGetNamedFunction(comp_ctx->module, func_name))
-        && !(func = LLVMAddFunction(comp_ctx->module, func_name, func_type))) {
-        aot_set_last_error("add LLVM function failed.");
-        return false;
-    }
-
+    memory_data_alloc_size =
+        aot_get_memory_data_alloc_size(comp_ctx, memory_data_size);
     param_values[0] = comp_ctx->pointer_size == sizeof(uint64)
-                          ? I64_CONST(memory_data_size)
-                          : I32_CONST((uint32)memory_data_size);
+                          ? I64_CONST(memory_data_alloc_size)
+                          : I32_CONST((uint32)memory_data_alloc_size);
     CHECK_LLVM_CONST(param_values[0]);
-    if (!(memory_data =
-              LLVMBuildCall2(comp_ctx->builder, func_type, func, param_values,
-                             1, "memory_data_allocated"))) {
-        aot_set_last_error("llvm build call failed.");
-        return false;
+
+    if (comp_ctx->static_memory_data) {
+        /* The linear memory is the static buffer, no need to allocate */
+        memory_data = comp_ctx->static_memory_data;
+    }
+    else {
+        /* Call malloc function to allocate memory for wasm linear memory */
+        snprintf(func_name, sizeof(func_name), "%s", "malloc");
+        if (!(func = LLVMGetNamedFunction(comp_ctx->module, func_name))
+            && !(func =
+                     LLVMAddFunction(comp_ctx->module, func_name, func_type))) {
+            aot_set_last_error("add LLVM function failed.");
+            return false;
+        }
+
+        if (!(memory_data = LLVMBuildCall2(comp_ctx->builder, func_type, func,
+                                           param_values, 1,
+                                           "memory_data_allocated"))) {
+            aot_set_last_error("llvm build call failed.");
+            return false;
+        }
     }
 
     /* Check the return value of malloc */
@@ -1388,8 +1522,15 @@ create_wasm_instance_create_func(const AOTCompData *comp_data,
     /* memset(memory_data, 0, memory_data_size) */
     LLVMPositionBuilderAtEnd(comp_ctx->builder, alloc_succ_block);
 
-    if (!LLVMBuildMemSet(comp_ctx->builder, memory_data, I8_ZERO,
-                         param_values[0], 8)) {
+    if (comp_ctx->static_memory_data) {
+        /* The static buffer is zeroed by the loader, only clear it when it
+           was used by a previous instance, so as not to touch all of its
+           pages at startup */
+        if (!build_clear_used_static_memory_data(comp_ctx, param_values[0]))
+            return false;
+    }
+    else if (!LLVMBuildMemSet(comp_ctx->builder, memory_data, I8_ZERO,
+                              param_values[0], 8)) {
         aot_set_last_error("llvm build memset failed.");
         return false;
     }
@@ -1709,91 +1850,86 @@ create_wasm_instance_create_func(const AOTCompData *comp_data,
         return false;
     }
 
-    if (memory_data_size_fixed) {
-        /* Create host managed heap */
-        if (aot_memory->host_managed_heap_offset > 0
-            && !comp_ctx->no_sandbox_mode) {
-            param_types[0] = INT8_PTR_TYPE;
-            param_types[1] = I32_TYPE;
+    /* Create host managed heap */
+    if (aot_memory->host_managed_heap_offset > 0
+        && !comp_ctx->no_sandbox_mode) {
+        param_types[0] = INT8_PTR_TYPE;
+        param_types[1] = I32_TYPE;
 
-            if (!(func_type =
-                      LLVMFunctionType(INT8_PTR_TYPE, param_types, 2, false))) {
-                aot_set_last_error("create LLVM function type failed.");
-                return false;
-            }
+        if (!(func_type =
+                  LLVMFunctionType(INT8_PTR_TYPE, param_types, 2, false))) {
+            aot_set_last_error("create LLVM function type failed.");
+            return false;
+        }
 
-            /* Add `void *mem_allocator_create(void *mem, uint32 size)` function
-             */
-            snprintf(func_name, sizeof(func_name), "%s",
-                     "mem_allocator_create");
-            if (!(func = LLVMGetNamedFunction(comp_ctx->module, func_name))
-                && !(func = LLVMAddFunction(comp_ctx->module, func_name,
-                                            func_type))) {
-                aot_set_last_error("add LLVM function failed.");
-                return false;
-            }
+        /* Add `void *mem_allocator_create(void *mem, uint32 size)` function */
+        snprintf(func_name, sizeof(func_name), "%s", "mem_allocator_create");
+        if (!(func = LLVMGetNamedFunction(comp_ctx->module, func_name))
+            && !(func = LLVMAddFunction(comp_ctx->module, func_name,
+                                        func_type))) {
+            aot_set_last_error("add LLVM function failed.");
+            return false;
+        }
 
-            LLVMValueRef heap_mem, heap_size, heap_handle, heap_handle_global;
+        LLVMValueRef heap_mem, heap_size, heap_handle, heap_handle_global;
 
-            heap_mem = I32_CONST(aot_memory->host_managed_heap_offset);
-            CHECK_LLVM_CONST(heap_mem);
-            heap_size = I32_CONST(memory_data_size
-                                  - aot_memory->host_managed_heap_offset);
-            CHECK_LLVM_CONST(heap_size);
+        heap_mem = I32_CONST(aot_memory->host_managed_heap_offset);
+        CHECK_LLVM_CONST(heap_mem);
+        heap_size = I32_CONST(memory_data_size
+                              - aot_memory->host_managed_heap_offset);
+        CHECK_LLVM_CONST(heap_size);
 
-            param_values[0] =
-                LLVMBuildInBoundsGEP2(comp_ctx->builder, INT8_TYPE, memory_data,
-                                      &heap_mem, 1, "app_heap_mem");
-            param_values[1] = heap_size;
+        param_values[0] =
+            LLVMBuildInBoundsGEP2(comp_ctx->builder, INT8_TYPE, memory_data,
+                                  &heap_mem, 1, "app_heap_mem");
+        param_values[1] = heap_size;
 
-            if (!param_values[0]) {
-                aot_set_last_error("llvm build inbounds gep failed.");
-                return false;
-            }
+        if (!param_values[0]) {
+            aot_set_last_error("llvm build inbounds gep failed.");
+            return false;
+        }
 
-            if (!(heap_handle =
-                      LLVMBuildCall2(comp_ctx->builder, func_type, func,
-                                     param_values, 2, "heap_handle"))) {
-                aot_set_last_error("llvm build call failed.");
-                return false;
-            }
+        if (!(heap_handle =
+                  LLVMBuildCall2(comp_ctx->builder, func_type, func,
+                                 param_values, 2, "heap_handle"))) {
+            aot_set_last_error("llvm build call failed.");
+            return false;
+        }
 
-            LLVMBasicBlockRef create_heap_succ_block;
+        LLVMBasicBlockRef create_heap_succ_block;
 
-            create_heap_succ_block = LLVMAppendBasicBlockInContext(
-                comp_ctx->context, func, "create_heap_succ");
-            if (!create_heap_succ_block) {
-                aot_set_last_error("llvm create basic block failed.");
-                return false;
-            }
+        create_heap_succ_block = LLVMAppendBasicBlockInContext(
+            comp_ctx->context, func, "create_heap_succ");
+        if (!create_heap_succ_block) {
+            aot_set_last_error("llvm create basic block failed.");
+            return false;
+        }
 
-            LLVMMoveBasicBlockAfter(create_heap_succ_block,
-                                    LLVMGetInsertBlock(comp_ctx->builder));
+        LLVMMoveBasicBlockAfter(create_heap_succ_block,
+                                LLVMGetInsertBlock(comp_ctx->builder));
 
-            cmp =
-                LLVMBuildIsNotNull(comp_ctx->builder, heap_handle, "not_null");
-            if (!cmp) {
-                aot_set_last_error("llvm build is not null failed.");
-                return false;
-            }
-            if (!LLVMBuildCondBr(comp_ctx->builder, cmp, create_heap_succ_block,
-                                 fail_block)) {
-                aot_set_last_error("llvm build condbr failed.");
-                return false;
-            }
-            exce_id = I32_CONST(EXCE_ALLOCATE_MEMORY_FAILED);
-            CHECK_LLVM_CONST(exce_id);
-            LLVMAddIncoming(exce_id_phi, &exce_id, &alloc_succ_block, 1);
-
-            LLVMPositionBuilderAtEnd(comp_ctx->builder, create_heap_succ_block);
-            heap_handle_global = LLVMGetNamedGlobal(comp_ctx->module,
-                                                    "host_managed_heap_handle");
-            bh_assert(heap_handle_global);
-            if (!LLVMBuildStore(comp_ctx->builder, heap_handle,
-                                heap_handle_global)) {
-                aot_set_last_error("llvm build store failed.");
-                return false;
-            }
+        cmp = LLVMBuildIsNotNull(comp_ctx->builder, heap_handle, "not_null");
+        if (!cmp) {
+            aot_set_last_error("llvm build is not null failed.");
+            return false;
+        }
+        if (!LLVMBuildCondBr(comp_ctx->builder, cmp, create_heap_succ_block,
+                             fail_block)) {
+            aot_set_last_error("llvm build condbr failed.");
+            return false;
+        }
+        exce_id = I32_CONST(EXCE_ALLOCATE_MEMORY_FAILED);
+        CHECK_LLVM_CONST(exce_id);
+        LLVMAddIncoming(exce_id_phi, &exce_id, &alloc_succ_block, 1);
+
+        LLVMPositionBuilderAtEnd(comp_ctx->builder, create_heap_succ_block);
+        heap_handle_global = LLVMGetNamedGlobal(comp_ctx->module,
+                                                "host_managed_heap_handle");
+        bh_assert(heap_handle_global);
+        if (!LLVMBuildStore(comp_ctx->builder, heap_handle,
+                            heap_handle_global)) {
+            aot_set_last_error("llvm build store failed.");
+            return false;
         }
     }
 
@@ -1813,7 +1949,10 @@ create_wasm_instance_create_func(const AOTCompData *comp_data,
         }
         func_idx =
             wasm_module->start_function - wasm_module->import_function_count;
-        func = comp_ctx->func_ctxes[func_idx]->func;
+        /* Call the wrapper in hw trap mode, a trap returns to it */
+        func = comp_ctx->func_ctxes[func_idx]->hw_trap_wrapper
+                   ? comp_ctx->func_ctxes[func_idx]->hw_trap_wrapper
+                   : comp_ctx->func_ctxes[func_idx]->func;
         func_type = comp_ctx->func_ctxes[func_idx]->func_type;
         if (!LLVMBuildCall2(comp_ctx->builder, func_type, func, NULL, 0, "")) {
             aot_set_last_error("llvm build call failed.");
@@ -1832,7 +1971,9 @@ create_wasm_instance_create_func(const AOTCompData *comp_data,
             aot_func_type = wasm_module->functions[func_idx]->func_type;
             if (aot_func_type->param_count == 0
                 && aot_func_type->result_count == 0) {
-                func = comp_ctx->func_ctxes[func_idx]->func;
+                func = comp_ctx->func_ctxes[func_idx]->hw_trap_wrapper
+                           ? comp_ctx->func_ctxes[func_idx]->hw_trap_wrapper
+                           : comp_ctx->func_ctxes[func_idx]->func;
                 func_type = comp_ctx->func_ctxes[func_idx]->func_type;
                 if (!LLVMBuildCall2(comp_ctx->builder, func_type, func, NULL, 0,
                                     "")) {
@@ -2047,25 +2188,30 @@ create_wasm_instance_destroy_func(const AOTCompData *comp_data,
 
     LLVMPositionBuilderAtEnd(comp_ctx->builder, check_succ_block);
 
-    param_types[0] = INT8_PTR_TYPE;
-    if (!(func_type = LLVMFunctionType(VOID_TYPE, param_types, 1, false))) {
-        aot_set_last_error("create LLVM function type failed.");
-        return false;
-    }
+    /* The static linear memory isn't freed */
+    if (!comp_ctx->static_memory_data) {
+        param_types[0] = INT8_PTR_TYPE;
+        if (!(func_type =
+                  LLVMFunctionType(VOID_TYPE, param_types, 1, false))) {
+            aot_set_last_error("create LLVM function type failed.");
+            return false;
+        }
 
-    /* Call free function */
-    snprintf(func_name, sizeof(func_name), "%s", "free");
-    if (!(func = LLVMGetNamedFunction(comp_ctx->module, func_name))
-        && !(func = LLVMAddFunction(comp_ctx->module, func_name, func_type))) {
-        aot_set_last_error("add LLVM function failed.");
-        return false;
-    }
+        /* Call free function */
+        snprintf(func_name, sizeof(func_name), "%s", "free");
+        if (!(func = LLVMGetNamedFunction(comp_ctx->module, func_name))
+            && !(func =
+                     LLVMAddFunction(comp_ctx->module, func_name, func_type))) {
+            aot_set_last_error("add LLVM function failed.");
+            return false;
+        }
 
-    param_values[0] = memory_data;
-    if (!LLVMBuildCall2(comp_ctx->builder, func_type, func, param_values, 1,
-                        "")) {
-        aot_set_last_error("llvm build call failed.");
-        return false;
+        param_values[0] = memory_data;
+        if (!LLVMBuildCall2(comp_ctx->builder, func_type, func, param_values,
+                            1, "")) {
+            aot_set_last_error("llvm build call failed.");
+            return false;
+        }
     }
 
     if (!LLVMBuildStore(comp_ctx->builder, I8_ZERO,
@@ -2291,7 +2437,7 @@ create_wasm_get_exception_func(AOTCompContext *comp_ctx)
 {
     LLVMTypeRef func_type;
     LLVMValueRef func, exce_id_global, exce_id_min, exce_id;
-    LLVMValueRef exce_msg_idx, exce_msgs_global, exce_msg;
+    LLVMValueRef exce_msg_idx, exce_msgs_global, exce_msg, is_no_exce;
     LLVMBasicBlockRef entry_block;
     char func_name[32];
 
@@ -2371,6 +2517,17 @@ create_wasm_get_exception_func(AOTCompContext *comp_ctx)
         return false;
     }
 
+    /* Return NULL if no exception was thrown, without reading the
+       message out of the exception_msgs array */
+    if (!(is_no_exce = LLVMBuildICmp(comp_ctx->builder, LLVMIntEQ, exce_id,
+                                     I32_ZERO, "is_no_exce"))
+        || !(exce_msg_idx = LLVMBuildSelect(comp_ctx->builder, is_no_exce,
+                                            I32_ZERO, exce_msg_idx,
+                                            "exce_msg_idx"))) {
+        aot_set_last_error("llvm build select failed.");
+        return false;
+    }
+
     exce_msgs_global = LLVMGetNamedGlobal(comp_ctx->module, "exception_msgs");
     bh_assert(exce_msgs_global);
     if (!(exce_msg = LLVMBuildInBoundsGEP2(comp_ctx->builder, INT8_PTR_TYPE,
@@ -2382,6 +2539,13 @@ create_wasm_get_exception_func(AOTCompContext *comp_ctx)
         return false;
     }
 
+    if (!(exce_msg = LLVMBuildSelect(comp_ctx->builder, is_no_exce,
+                                     LLVMConstPointerNull(INT8_PTR_TYPE),
+                                     exce_msg, "exce_msg"))) {
+        aot_set_last_error("llvm build select failed.");
+        return false;
+    }
+
     if (!LLVMBuildRet(comp_ctx->builder, exce_msg)) {
         aot_set_last_error("llvm build store failed.");
         return false;
@@ -2527,103 +2691,501 @@ fail:
     return false;
 }
 
+/**
+ * Create the `void wasm_throw_exception(int32 exception_id)` function
+ * called by the got_exception block of the wasm functions, it is cold and
+ * not inlined so that LLVM treats all the paths to it as unlikely and
+ * moves them out of the hot code. It has the wasm_ prefix of the runtime
+ * APIs so that it doesn't take the name of a wasm export.
+ */
 static bool
-create_wasm_get_memory_func(const AOTCompData *comp_data,
-                            AOTCompContext *comp_ctx)
+create_throw_exception_func(AOTCompContext *comp_ctx)
 {
-    LLVMTypeRef func_type;
-    LLVMValueRef func, memory_data, memory_data_global;
+    static const char *attr_names[] = { "cold", "noinline" };
+    LLVMTypeRef func_type, param_types[1];
+    LLVMValueRef func, exce_id_global, res;
+    LLVMAttributeRef attr;
     LLVMBasicBlockRef entry_block;
-    char func_name[32];
+    uint32 i, attr_kind;
 
     if (comp_ctx->no_sandbox_mode)
         return true;
 
-    if (!(func_type = LLVMFunctionType(INT8_PTR_TYPE, NULL, 0, false))) {
+    param_types[0] = I32_TYPE;
+    if (!(func_type = LLVMFunctionType(VOID_TYPE, param_types, 1, false))) {
         aot_set_last_error("create LLVM function type failed.");
         return false;
     }
 
-    /* Add `int8 *wasm_get_memory()` function */
-    snprintf(func_name, sizeof(func_name), "%s", "wasm_get_memory");
-    if (!(func = LLVMGetNamedFunction(comp_ctx->module, func_name))
-        && !(func = LLVMAddFunction(comp_ctx->module, func_name, func_type))) {
+    if (!(func = LLVMAddFunction(comp_ctx->module, "wasm_throw_exception",
+                                 func_type))) {
         aot_set_last_error("add LLVM function failed.");
         return false;
     }
+    LLVMSetLinkage(func, LLVMInternalLinkage);
+
+    for (i = 0; i < sizeof(attr_names) / sizeof(char *); i++) {
+        attr_kind = LLVMGetEnumAttributeKindForName(
+            attr_names[i], (uint32)strlen(attr_names[i]));
+        if (!(attr = LLVMCreateEnumAttribute(comp_ctx->context, attr_kind,
+                                             0))) {
+            aot_set_last_error("create LLVM attribute failed.");
+            return false;
+        }
+        LLVMAddAttributeAtIndex(func, LLVMAttributeFunctionIndex, attr);
+    }
 
-    /* Add function entry block */
     if (!(entry_block = LLVMAppendBasicBlockInContext(comp_ctx->context, func,
                                                       "func_begin"))) {
         aot_set_last_error("add LLVM basic block failed.");
         return false;
     }
-
-    /* Build entry block */
     LLVMPositionBuilderAtEnd(comp_ctx->builder, entry_block);
-    memory_data_global = LLVMGetNamedGlobal(comp_ctx->module, "memory_data");
-    bh_assert(memory_data_global);
 
-    if (!(memory_data = LLVMBuildLoad2(comp_ctx->builder, INT8_PTR_TYPE,
-                                       memory_data_global, "memory_data"))) {
-        aot_set_last_error("llvm build load failed.");
+    exce_id_global = LLVMGetNamedGlobal(comp_ctx->module, "exception_id");
+    bh_assert(exce_id_global);
+    if (!(res = LLVMBuildStore(comp_ctx->builder, LLVMGetParam(func, 0),
+                               exce_id_global))) {
+        aot_set_last_error("llvm build store failed.");
         return false;
     }
+    aot_set_memory_domain(comp_ctx, res, AOT_MEMORY_DOMAIN_RUNTIME_STATE);
 
-    if (!LLVMBuildRet(comp_ctx->builder, memory_data)) {
-        aot_set_last_error("llvm build ret failed.");
+    if (!LLVMBuildRetVoid(comp_ctx->builder)) {
+        aot_set_last_error("llvm build ret void failed.");
         return false;
     }
 
     return true;
 }
 
-static bool
-create_wasm_get_memory_size_func(const AOTCompData *comp_data,
-                                 AOTCompContext *comp_ctx)
+static LLVMValueRef
+add_hw_trap_runtime_func(AOTCompContext *comp_ctx, const char *name,
+                         LLVMTypeRef ret_type, const char *attr_name)
 {
-    LLVMTypeRef func_type;
-    LLVMValueRef func, memory_data_size, memory_data_size_global;
-    LLVMBasicBlockRef entry_block;
-    char func_name[32];
+    LLVMTypeRef func_type, param_types[1] = { INT8_PTR_TYPE };
+    LLVMValueRef func;
+    LLVMAttributeRef attr;
+    uint32 attr_kind;
 
-    if (comp_ctx->no_sandbox_mode)
-        return true;
+    if ((func = LLVMGetNamedFunction(comp_ctx->module, name)))
+        return func;
 
-    if (!(func_type = LLVMFunctionType(I64_TYPE, NULL, 0, false))) {
+    if (!(func_type = LLVMFunctionType(ret_type, param_types, 1, false))) {
         aot_set_last_error("create LLVM function type failed.");
-        return false;
+        return NULL;
     }
 
-    /* Add `uint64 wasm_get_memory_size()` function */
-    snprintf(func_name, sizeof(func_name), "%s", "wasm_get_memory_size");
-    if (!(func = LLVMGetNamedFunction(comp_ctx->module, func_name))
-        && !(func = LLVMAddFunction(comp_ctx->module, func_name, func_type))) {
+    if (!(func = LLVMAddFunction(comp_ctx->module, name, func_type))) {
         aot_set_last_error("add LLVM function failed.");
-        return false;
+        return NULL;
     }
 
-    /* Add function entry block */
-    if (!(entry_block = LLVMAppendBasicBlockInContext(comp_ctx->context, func,
-                                                      "func_begin"))) {
-        aot_set_last_error("add LLVM basic block failed.");
-        return false;
+    if (attr_name) {
+        attr_kind = LLVMGetEnumAttributeKindForName(attr_name,
+                                                    (uint32)strlen(attr_name));
+        if (!(attr = LLVMCreateEnumAttribute(comp_ctx->context, attr_kind,
+                                             0))) {
+            aot_set_last_error("create LLVM attribute failed.");
+            return NULL;
+        }
+        LLVMAddAttributeAtIndex(func, LLVMAttributeFunctionIndex, attr);
     }
 
-    /* Build entry block */
-    LLVMPositionBuilderAtEnd(comp_ctx->builder, entry_block);
-    memory_data_size_global =
-        LLVMGetNamedGlobal(comp_ctx->module, "memory_data_size");
-    bh_assert(memory_data_size_global);
+    return func;
+}
 
-    if (!(memory_data_size =
-              LLVMBuildLoad2(comp_ctx->builder, I64_TYPE,
-                             memory_data_size_global, "memory_size"))) {
-        aot_set_last_error("llvm build load failed.");
+/**
+ * Create the wrapper of an exported function in hw trap mode, which
+ * takes over the export name and calls the function under a jmp_buf
+ * registered to the vmlib, so that the SIGFPE handler can longjmp back
+ * to it after setting the exception, and the wrapper returns zero.
+ * The wrapper of a function not exported, e.g. the start function, is
+ * an internal function.
+ */
+static bool
+create_hw_trap_wrapper(AOTCompContext *comp_ctx, AOTFuncContext *func_ctx,
+                       uint32 func_index)
+{
+    const AOTCompData *comp_data = comp_ctx->comp_data;
+    uint32 aux_stack_global_idx = comp_data->aux_stack_top_global_index;
+    uint32 param_count = LLVMCountParams(func_ctx->func), i;
+    LLVMTypeRef ret_type = LLVMGetReturnType(func_ctx->func_type);
+    LLVMTypeRef jmpbuf_type, aux_stack_type = NULL;
+    LLVMValueRef wrapper, func_enter, func_leave, func_setjmp;
+    LLVMValueRef jmpbuf, jmpbuf_ptr, prev_jmpbuf, setjmp_ret, cmp, cond_br;
+    LLVMValueRef aux_stack_global = NULL, aux_stack_top = NULL, ret, res;
+    LLVMValueRef *param_values = NULL;
+    LLVMBasicBlockRef entry_block, call_block, trap_block;
+    const char *func_name;
+    char *export_name = NULL, buf[48];
+    size_t name_len;
+    uint64 total_size;
+    bool is_exported, ok = false;
+
+    if (!(func_enter = add_hw_trap_runtime_func(
+              comp_ctx, "wasm_hw_trap_enter", INT8_PTR_TYPE, "nounwind"))
+        || !(func_leave = add_hw_trap_runtime_func(
+                 comp_ctx, "wasm_hw_trap_leave", VOID_TYPE, "nounwind"))
+        || !(func_setjmp = add_hw_trap_runtime_func(comp_ctx, "_setjmp",
+                                                    I32_TYPE, "returns_twice")))
         return false;
-    }
 
-    if (!LLVMBuildRet(comp_ctx->builder, memory_data_size)) {
+    /* Move the export name from the function to the wrapper */
+    func_name = LLVMGetValueName2(func_ctx->func, &name_len);
+    if (!(export_name = wasm_runtime_malloc((uint32)name_len + 1))) {
+        aot_set_last_error("allocate memory failed.");
+        return false;
+    }
+    bh_memcpy_s(export_name, (uint32)name_len + 1, func_name,
+                (uint32)name_len + 1);
+    snprintf(buf, sizeof(buf), "%s%d", AOT_FUNC_PREFIX, func_index);
+    is_exported = strcmp(export_name, buf) ? true : false;
+    if (is_exported) {
+        LLVMSetValueName2(func_ctx->func, buf, strlen(buf));
+        LLVMSetLinkage(func_ctx->func, LLVMInternalLinkage);
+    }
+    else {
+        snprintf(buf, sizeof(buf), "%s%d_hw_trap_wrapper", AOT_FUNC_PREFIX,
+                 func_index);
+    }
+
+    if (!(wrapper = LLVMAddFunction(comp_ctx->module,
+                                    is_exported ? export_name : buf,
+                                    func_ctx->func_type))) {
+        aot_set_last_error("add LLVM function failed.");
+        goto fail;
+    }
+    if (!is_exported)
+        LLVMSetLinkage(wrapper, LLVMInternalLinkage);
+
+    if (param_count > 0) {
+        total_size = sizeof(LLVMValueRef) * (uint64)param_count;
+        if (!(param_values = wasm_runtime_malloc((uint32)total_size))) {
+            aot_set_last_error("allocate memory failed.");
+            goto fail;
+        }
+        for (i = 0; i < param_count; i++)
+            param_values[i] = LLVMGetParam(wrapper, i);
+    }
+
+    if (!(entry_block = LLVMAppendBasicBlockInContext(comp_ctx->context,
+                                                      wrapper, "func_begin"))
+        || !(call_block = LLVMAppendBasicBlockInContext(comp_ctx->context,
+                                                        wrapper, "call"))
+        || !(trap_block = LLVMAppendBasicBlockInContext(comp_ctx->context,
+                                                        wrapper, "trap"))) {
+        aot_set_last_error("add LLVM basic block failed.");
+        goto fail;
+    }
+    LLVMPositionBuilderAtEnd(comp_ctx->builder, entry_block);
+
+    if (!(jmpbuf_type = LLVMArrayType(I64_TYPE, WASM_HW_TRAP_JMPBUF_SIZE / 8))
+        || !(jmpbuf =
+                 LLVMBuildAlloca(comp_ctx->builder, jmpbuf_type, "jmpbuf"))) {
+        aot_set_last_error("llvm build alloca failed.");
+        goto fail;
+    }
+    LLVMSetAlignment(jmpbuf, 16);
+
+    if (!(jmpbuf_ptr = LLVMBuildBitCast(comp_ctx->builder, jmpbuf,
+                                        INT8_PTR_TYPE, "jmpbuf_ptr"))) {
+        aot_set_last_error("llvm build bitcast failed.");
+        goto fail;
+    }
+
+    /* Save the aux stack top, the trapped functions don't restore it */
+    if (aux_stack_global_idx != (uint32)-1) {
+        if (aux_stack_global_idx < comp_data->import_global_count) {
+            aux_stack_type = TO_LLVM_TYPE(
+                comp_data->import_globals[aux_stack_global_idx].type);
+            snprintf(buf, sizeof(buf), "%s%u", "wasm_import_global#",
+                     aux_stack_global_idx);
+        }
+        else {
+            aux_stack_global_idx -= comp_data->import_global_count;
+            aux_stack_type =
+                TO_LLVM_TYPE(comp_data->globals[aux_stack_global_idx].type);
+            snprintf(buf, sizeof(buf), "%s%u", "wasm_global#",
+                     aux_stack_global_idx);
+        }
+        aux_stack_global = LLVMGetNamedGlobal(comp_ctx->module, buf);
+        bh_assert(aux_stack_global);
+
+        if (!(aux_stack_top =
+                  LLVMBuildLoad2(comp_ctx->builder, aux_stack_type,
+                                 aux_stack_global, "aux_stack_top"))) {
+            aot_set_last_error("llvm build load failed.");
+            goto fail;
+        }
+        aot_set_memory_domain(comp_ctx, aux_stack_top,
+                              AOT_MEMORY_DOMAIN_WASM_GLOBAL);
+    }
+
+    if (!(prev_jmpbuf = LLVMBuildCall2(comp_ctx->builder,
+                                       LLVMGlobalGetValueType(func_enter),
+                                       func_enter, &jmpbuf_ptr, 1, "prev"))
+        || !(setjmp_ret = LLVMBuildCall2(comp_ctx->builder,
+                                         LLVMGlobalGetValueType(func_setjmp),
+                                         func_setjmp, &jmpbuf_ptr, 1,
+                                         "setjmp_ret"))) {
+        aot_set_last_error("llvm build call failed.");
+        goto fail;
+    }
+
+    if (!(cmp = LLVMBuildICmp(comp_ctx->builder, LLVMIntNE, setjmp_ret,
+                              I32_ZERO, "is_trapped"))) {
+        aot_set_last_error("llvm build icmp failed.");
+        goto fail;
+    }
+    if (!(cond_br = LLVMBuildCondBr(comp_ctx->builder, cmp, trap_block,
+                                    call_block))) {
+        aot_set_last_error("llvm build cond br failed.");
+        goto fail;
+    }
+    aot_set_unlikely_branch(comp_ctx, cond_br, true);
+
+    /* Call the function and return its result */
+    LLVMPositionBuilderAtEnd(comp_ctx->builder, call_block);
+    if (!(ret = LLVMBuildCall2(comp_ctx->builder, func_ctx->func_type,
+                               func_ctx->func, param_values, param_count,
+                               ret_type != VOID_TYPE ? "ret" : ""))
+        || !LLVMBuildCall2(comp_ctx->builder,
+                           LLVMGlobalGetValueType(func_leave), func_leave,
+                           &prev_jmpbuf, 1, "")) {
+        aot_set_last_error("llvm build call failed.");
+        goto fail;
+    }
+    if (!(ret_type != VOID_TYPE ? LLVMBuildRet(comp_ctx->builder, ret)
+                                : LLVMBuildRetVoid(comp_ctx->builder))) {
+        aot_set_last_error("llvm build ret failed.");
+        goto fail;
+    }
+
+    /* Restore the aux stack top and return zero after a trap */
+    LLVMPositionBuilderAtEnd(comp_ctx->builder, trap_block);
+    if (!LLVMBuildCall2(comp_ctx->builder, LLVMGlobalGetValueType(func_leave),
+                        func_leave, &prev_jmpbuf, 1, "")) {
+        aot_set_last_error("llvm build call failed.");
+        goto fail;
+    }
+    if (aux_stack_top) {
+        if (!(res = LLVMBuildStore(comp_ctx->builder, aux_stack_top,
+                                   aux_stack_global))) {
+            aot_set_last_error("llvm build store failed.");
+            goto fail;
+        }
+        aot_set_memory_domain(comp_ctx, res, AOT_MEMORY_DOMAIN_WASM_GLOBAL);
+    }
+    if (!(ret_type != VOID_TYPE
+              ? LLVMBuildRet(comp_ctx->builder, LLVMConstNull(ret_type))
+              : LLVMBuildRetVoid(comp_ctx->builder))) {
+        aot_set_last_error("llvm build ret failed.");
+        goto fail;
+    }
+
+    func_ctx->hw_trap_wrapper = wrapper;
+    ok = true;
+
+fail:
+    if (param_values)
+        wasm_runtime_free(param_values);
+    wasm_runtime_free(export_name);
+    return ok;
+}
+
+static bool
+create_hw_trap_wrappers(AOTCompData *comp_data, AOTCompContext *comp_ctx)
+{
+    AOTExport *aot_exports = comp_data->wasm_module->exports;
+    uint32 export_count = comp_data->wasm_module->export_count;
+    uint32 func_idx, i;
+
+    if (!comp_ctx->enable_hw_trap)
+        return true;
+
+    for (i = 0; i < export_count; i++) {
+        if (aot_exports[i].kind != EXPORT_KIND_FUNC
+            || aot_exports[i].index < comp_data->import_func_count)
+            continue;
+
+        func_idx = aot_exports[i].index - comp_data->import_func_count;
+        /* A function exported with several names is wrapped once */
+        if (comp_ctx->func_ctxes[func_idx]->hw_trap_wrapper)
+            continue;
+
+        if (!create_hw_trap_wrapper(comp_ctx, comp_ctx->func_ctxes[func_idx],
+                                    func_idx))
+            return false;
+    }
+
+    /* The start function is called by wasm_instance_create, which also
+       calls the wrapper of __wasm_call_ctors */
+    if (comp_data->wasm_module->start_function != (uint32)-1
+        && comp_data->wasm_module->start_function
+               >= comp_data->import_func_count) {
+        func_idx = comp_data->wasm_module->start_function
+                   - comp_data->import_func_count;
+        if (!comp_ctx->func_ctxes[func_idx]->hw_trap_wrapper
+            && !create_hw_trap_wrapper(comp_ctx,
+                                       comp_ctx->func_ctxes[func_idx],
+                                       func_idx))
+            return false;
+    }
+
+    return true;
+}
+
+static bool
+create_wasm_get_memory_func(const AOTCompData *comp_data,
+                            AOTCompContext *comp_ctx)
+{
+    LLVMTypeRef func_type;
+    LLVMValueRef func, memory_data, memory_data_global;
+    LLVMBasicBlockRef entry_block;
+    char func_name[32];
+
+    if (comp_ctx->no_sandbox_mode)
+        return true;
+
+    if (!(func_type = LLVMFunctionType(INT8_PTR_TYPE, NULL, 0, false))) {
+        aot_set_last_error("create LLVM function type failed.");
+        return false;
+    }
+
+    /* Add `int8 *wasm_get_memory()` function */
+    snprintf(func_name, sizeof(func_name), "%s", "wasm_get_memory");
+    if (!(func = LLVMGetNamedFunction(comp_ctx->module, func_name))
+        && !(func = LLVMAddFunction(comp_ctx->module, func_name, func_type))) {
+        aot_set_last_error("add LLVM function failed.");
+        return false;
+    }
+
+    /* Add function entry block */
+    if (!(entry_block = LLVMAppendBasicBlockInContext(comp_ctx->context, func,
+                                                      "func_begin"))) {
+        aot_set_last_error("add LLVM basic block failed.");
+        return false;
+    }
+
+    /* Build entry block */
+    LLVMPositionBuilderAtEnd(comp_ctx->builder, entry_block);
+    memory_data_global = LLVMGetNamedGlobal(comp_ctx->module, "memory_data");
+    bh_assert(memory_data_global);
+
+    if (!(memory_data = LLVMBuildLoad2(comp_ctx->builder, INT8_PTR_TYPE,
+                                       memory_data_global, "memory_data"))) {
+        aot_set_last_error("llvm build load failed.");
+        return false;
+    }
+
+    if (!LLVMBuildRet(comp_ctx->builder, memory_data)) {
+        aot_set_last_error("llvm build ret failed.");
+        return false;
+    }
+
+    return true;
+}
+
+static bool
+create_wasm_get_memory_size_func(const AOTCompData *comp_data,
+                                 AOTCompContext *comp_ctx)
+{
+    LLVMTypeRef func_type;
+    LLVMValueRef func, memory_data_size, memory_data_size_global;
+    LLVMBasicBlockRef entry_block;
+    char func_name[32];
+
+    if (comp_ctx->no_sandbox_mode)
+        return true;
+
+    if (!(func_type = LLVMFunctionType(I64_TYPE, NULL, 0, false))) {
+        aot_set_last_error("create LLVM function type failed.");
+        return false;
+    }
+
+    /* Add `uint64 wasm_get_memory_size()` function */
+    snprintf(func_name, sizeof(func_name), "%s", "wasm_get_memory_size");
+    if (!(func = LLVMGetNamedFunction(comp_ctx->module, func_name))
+        && !(func = LLVMAddFunction(comp_ctx->module, func_name, func_type))) {
+        aot_set_last_error("add LLVM function failed.");
+        return false;
+    }
+
+    /* Add function entry block */
+    if (!(entry_block = LLVMAppendBasicBlockInContext(comp_ctx->context, func,
+                                                      "func_begin"))) {
+        aot_set_last_error("add LLVM basic block failed.");
+        return false;
+    }
+
+    /* Build entry block */
+    LLVMPositionBuilderAtEnd(comp_ctx->builder, entry_block);
+    memory_data_size_global =
+        LLVMGetNamedGlobal(comp_ctx->module, "memory_data_size");
+    bh_assert(memory_data_size_global);
+
+    if (!(memory_data_size =
+              LLVMBuildLoad2(comp_ctx->builder, I64_TYPE,
+                             memory_data_size_global, "memory_size"))) {
+        aot_set_last_error("llvm build load failed.");
+        return false;
+    }
+
+    if (!LLVMBuildRet(comp_ctx->builder, memory_data_size)) {
+        aot_set_last_error("llvm build ret failed.");
+        return false;
+    }
+
+    return true;
+}
+
+/**
+ * Add `int32 func_name()` function which returns the value of the
+ * i32 global
+ */
+static bool
+create_wasm_get_i32_global_func(AOTCompContext *comp_ctx,
+                                const char *func_name,
+                                const char *global_name)
+{
+    LLVMTypeRef func_type;
+    LLVMValueRef func, value, global;
+    LLVMBasicBlockRef entry_block;
+
+    if (comp_ctx->no_sandbox_mode)
+        return true;
+
+    if (!(func_type = LLVMFunctionType(I32_TYPE, NULL, 0, false))) {
+        aot_set_last_error("create LLVM function type failed.");
+        return false;
+    }
+
+    if (!(func = LLVMGetNamedFunction(comp_ctx->module, func_name))
+        && !(func = LLVMAddFunction(comp_ctx->module, func_name, func_type))) {
+        aot_set_last_error("add LLVM function failed.");
+        return false;
+    }
+
+    /* Add function entry block */
+    if (!(entry_block = LLVMAppendBasicBlockInContext(comp_ctx->context, func,
+                                                      "func_begin"))) {
+        aot_set_last_error("add LLVM basic block failed.");
+        return false;
+    }
+
+    /* Build entry block */
+    LLVMPositionBuilderAtEnd(comp_ctx->builder, entry_block);
+    global = LLVMGetNamedGlobal(comp_ctx->module, global_name);
+    bh_assert(global);
+
+    if (!(value = LLVMBuildLoad2(comp_ctx->builder, I32_TYPE, global,
+                                 global_name))) {
+        aot_set_last_error("llvm build load failed.");
+        return false;
+    }
+
+    if (!LLVMBuildRet(comp_ctx->builder, value)) {
         aot_set_last_error("llvm build ret failed.");
         return false;
     }
@@ -2683,6 +3245,111 @@ create_wasm_get_heap_handle_func(const AOTCompData *comp_data,
     return true;
 }
 
+static bool
+create_wasm_enlarge_heap_func(const AOTCompData *comp_data,
+                              AOTCompContext *comp_ctx)
+{
+    AOTMemory *aot_memory = &comp_data->memories[0];
+    LLVMTypeRef func_type, param_types[1];
+    LLVMValueRef func, inc_size, num_bytes_per_page_global, num_bytes_per_page;
+    LLVMValueRef inc_page_count, ret, res;
+    LLVMBasicBlockRef entry_block;
+    char func_name[48];
+
+    if (comp_ctx->no_sandbox_mode)
+        return true;
+
+    param_types[0] = I32_TYPE;
+    if (!(func_type = LLVMFunctionType(INT8_TYPE, param_types, 1, false))) {
+        aot_set_last_error("create LLVM function type failed.");
+        return false;
+    }
+
+    /* Add `bool wasm_enlarge_heap(uint32 inc_size)` function */
+    snprintf(func_name, sizeof(func_name), "%s", "wasm_enlarge_heap");
+    if (!(func = LLVMGetNamedFunction(comp_ctx->module, func_name))
+        && !(func = LLVMAddFunction(comp_ctx->module, func_name, func_type))) {
+        aot_set_last_error("add LLVM function failed.");
+        return false;
+    }
+
+    /* Add function entry block */
+    if (!(entry_block = LLVMAppendBasicBlockInContext(comp_ctx->context, func,
+                                                      "func_begin"))) {
+        aot_set_last_error("add LLVM basic block failed.");
+        return false;
+    }
+
+    LLVMPositionBuilderAtEnd(comp_ctx->builder, entry_block);
+
+    if (aot_memory->host_managed_heap_offset == 0) {
+        /* no host managed heap to enlarge */
+        if (!LLVMBuildRet(comp_ctx->builder, I8_ZERO)) {
+            aot_set_last_error("llvm build ret failed.");
+            return false;
+        }
+        return true;
+    }
+
+    num_bytes_per_page_global =
+        LLVMGetNamedGlobal(comp_ctx->module, "num_bytes_per_page");
+    bh_assert(num_bytes_per_page_global);
+
+    if (!(num_bytes_per_page =
+              LLVMBuildLoad2(comp_ctx->builder, I32_TYPE,
+                             num_bytes_per_page_global, "num_bytes_per_page"))
+        || !(num_bytes_per_page =
+                 LLVMBuildZExt(comp_ctx->builder, num_bytes_per_page, I64_TYPE,
+                               "num_bytes_per_page_u64"))) {
+        aot_set_last_error("llvm build load or zext failed.");
+        return false;
+    }
+
+    /* Round up the size with the extra bytes of the chunk to allocate
+       to pages: (inc_size + extra_size + page_size - 1) / page_size */
+    inc_size = LLVMGetParam(func, 0);
+    if (!(inc_size = LLVMBuildZExt(comp_ctx->builder, inc_size, I64_TYPE,
+                                   "inc_size_u64"))
+        || !(inc_size = LLVMBuildAdd(comp_ctx->builder, inc_size,
+                                     I64_CONST(MEM_ALLOC_CHUNK_EXTRA_SIZE - 1),
+                                     "inc_size"))
+        || !(inc_size = LLVMBuildAdd(comp_ctx->builder, inc_size,
+                                     num_bytes_per_page, "inc_size"))
+        || !(inc_page_count =
+                 LLVMBuildUDiv(comp_ctx->builder, inc_size, num_bytes_per_page,
+                               "inc_page_count"))) {
+        aot_set_last_error("llvm build zext, add or udiv failed.");
+        return false;
+    }
+
+    /* the page count can't exceed the max page count, so no need to
+       check the overflow here, which fails to grow the memory anyway */
+    if (!(inc_page_count =
+              LLVMBuildTrunc(comp_ctx->builder, inc_page_count, I32_TYPE,
+                             "inc_page_count_i32"))) {
+        aot_set_last_error("llvm build trunc failed.");
+        return false;
+    }
+
+    if (!(ret = aot_build_memory_grow(comp_ctx, func, inc_page_count)))
+        return false;
+
+    if (!(res = LLVMBuildICmp(comp_ctx->builder, LLVMIntNE, ret, I32_NEG_ONE,
+                              "grow_succ"))
+        || !(res = LLVMBuildZExt(comp_ctx->builder, res, INT8_TYPE,
+                                 "grow_succ_i8"))) {
+        aot_set_last_error("llvm build icmp or zext failed.");
+        return false;
+    }
+
+    if (!LLVMBuildRet(comp_ctx->builder, res)) {
+        aot_set_last_error("llvm build ret failed.");
+        return false;
+    }
+
+    return true;
+}
+
 static bool
 create_wasm_get_export_apis_func(const AOTCompData *comp_data,
                                  AOTCompContext *comp_ctx)
@@ -2784,7 +3451,9 @@ create_wasm_get_export_apis_func(const AOTCompData *comp_data,
                     aot_set_last_error("llvm create global string failed.");
                     goto fail;
                 }
-                fields[2] = comp_ctx->func_ctxes[func_idx]->func;
+                fields[2] = comp_ctx->func_ctxes[func_idx]->hw_trap_wrapper
+                                ? comp_ctx->func_ctxes[func_idx]->hw_trap_wrapper
+                                : comp_ctx->func_ctxes[func_idx]->func;
 
                 if (!(struct_value = LLVMConstStruct(fields, 3, false))) {
                     aot_set_last_error("llvm create struct failed.");
@@ -2966,18 +3635,21 @@ add_llvm_func(const AOTCompContext *comp_ctx, LLVMModuleRef module,
 static LLVMValueRef
 aot_add_llvm_func(AOTCompContext *comp_ctx, LLVMModuleRef module,
                   const AOTFuncType *aot_func_type, uint32 func_index,
-                  LLVMTypeRef *p_func_type)
+                  bool is_internal, LLVMTypeRef *p_func_type)
 {
     LLVMValueRef func = NULL;
-    LLVMTypeRef *param_types = NULL, ret_type, func_type;
+    LLVMTypeRef *param_types = NULL, *result_types = NULL, ret_type, func_type;
     const char *prefix = AOT_FUNC_PREFIX;
     uint32 i, j = 0, param_count = (uint64)aot_func_type->param_count;
+    uint32 result_count = aot_func_type->result_count;
+    bool ret_in_regs = is_internal && result_count > 1;
     uint64 size;
 
     /* Extra wasm function results(except the first one)'s address are
-     * appended to aot function parameters. */
-    if (aot_func_type->result_count > 1)
-        param_count += aot_func_type->result_count - 1;
+     * appended to aot function parameters, unless the function is internal
+     * and returns all of them in a struct. */
+    if (result_count > 1 && !ret_in_regs)
+        param_count += result_count - 1;
 
     if (param_count) {
         /* Initialize parameter types of the LLVM function */
@@ -2991,7 +3663,7 @@ aot_add_llvm_func(AOTCompContext *comp_ctx, LLVMModuleRef module,
         for (i = 0; i < aot_func_type->param_count; i++)
             param_types[j++] = TO_LLVM_TYPE(aot_func_type->types[i]);
         /* Extra results' address */
-        for (i = 1; i < aot_func_type->result_count; i++, j++) {
+        for (i = 1; !ret_in_regs && i < result_count; i++, j++) {
             param_types[j] = TO_LLVM_TYPE(
                 aot_func_type->types[aot_func_type->param_count + i]);
             if (!(param_types[j] = LLVMPointerType(param_types[j], 0))) {
@@ -3002,7 +3674,22 @@ aot_add_llvm_func(AOTCompContext *comp_ctx, LLVMModuleRef module,
     }
 
     /* Resolve return type of the LLVM function */
-    if (aot_func_type->result_count)
+    if (ret_in_regs) {
+        size = sizeof(LLVMTypeRef) * (uint64)result_count;
+        if (!(result_types = wasm_runtime_malloc((uint32)size))) {
+            aot_set_last_error("allocate memory failed.");
+            goto fail;
+        }
+        for (i = 0; i < result_count; i++)
+            result_types[i] = TO_LLVM_TYPE(
+                aot_func_type->types[aot_func_type->param_count + i]);
+        if (!(ret_type = LLVMStructTypeInContext(
+                  comp_ctx->context, result_types, result_count, false))) {
+            aot_set_last_error("create LLVM struct type failed.");
+            goto fail;
+        }
+    }
+    else if (result_count)
         ret_type =
             TO_LLVM_TYPE(aot_func_type->types[aot_func_type->param_count]);
     else
@@ -3021,12 +3708,21 @@ aot_add_llvm_func(AOTCompContext *comp_ctx, LLVMModuleRef module,
                                aot_func_type->param_count, func_type, prefix)))
         goto fail;
 
+    if (is_internal) {
+        /* Nothing outside the module calls the function, let LLVM pick
+           the registers and drop it if all its callers are inlined */
+        LLVMSetLinkage(func, LLVMInternalLinkage);
+        LLVMSetFunctionCallConv(func, LLVMFastCallConv);
+    }
+
     if (p_func_type)
         *p_func_type = func_type;
 
 fail:
     if (param_types)
         wasm_runtime_free(param_types);
+    if (result_types)
+        wasm_runtime_free(result_types);
     return func;
 }
 
@@ -3170,7 +3866,7 @@ create_local_variables(const AOTCompData *comp_data,
  */
 static AOTFuncContext *
 aot_create_func_context(const AOTCompData *comp_data, AOTCompContext *comp_ctx,
-                        AOTFunc *func, uint32 func_index)
+                        AOTFunc *func, uint32 func_index, bool is_internal)
 {
     AOTFuncContext *func_ctx;
     AOTFuncType *aot_func_type = comp_data->func_types[func->func_type_index];
@@ -3188,13 +3884,15 @@ aot_create_func_context(const AOTCompData *comp_data, AOTCompContext *comp_ctx,
 
     memset(func_ctx, 0, (uint32)size);
     func_ctx->aot_func = func;
+    func_ctx->func_idx = comp_data->import_func_count + func_index;
 
     func_ctx->module = comp_ctx->module;
+    func_ctx->is_internal = is_internal;
 
     /* Add LLVM function */
-    if (!(func_ctx->func =
-              aot_add_llvm_func(comp_ctx, func_ctx->module, aot_func_type,
-                                func_index, &func_ctx->func_type))) {
+    if (!(func_ctx->func = aot_add_llvm_func(
+              comp_ctx, func_ctx->module, aot_func_type, func_index,
+              is_internal, &func_ctx->func_type))) {
         goto fail;
     }
 
@@ -3236,6 +3934,51 @@ aot_destroy_func_contexts(AOTFuncContext **func_ctxes, uint32 count)
     wasm_runtime_free(func_ctxes);
 }
 
+/**
+ * Mark the functions which may be called from outside of the module or
+ * through a table: the exported functions, the start function, the
+ * functions referenced by the element segments, including the declarative
+ * ones of ref.func, and the ones referenced by the global initializers.
+ */
+static void
+mark_external_funcs(const AOTCompData *comp_data, bool *is_external)
+{
+    WASMModule *wasm_module = comp_data->wasm_module;
+    uint32 import_func_count = comp_data->import_func_count;
+    uint32 func_idx, i, j;
+
+    for (i = 0; i < wasm_module->export_count; i++) {
+        func_idx = wasm_module->exports[i].index;
+        if (wasm_module->exports[i].kind == EXPORT_KIND_FUNC
+            && func_idx >= import_func_count)
+            is_external[func_idx - import_func_count] = true;
+    }
+
+    if (wasm_module->start_function != (uint32)-1
+        && wasm_module->start_function >= import_func_count)
+        is_external[wasm_module->start_function - import_func_count] = true;
+
+    for (i = 0; i < wasm_module->table_seg_count; i++) {
+        WASMTableSeg *table_seg = wasm_module->table_segments + i;
+        for (j = 0; j < table_seg->function_count; j++) {
+            func_idx = table_seg->func_indexes[j];
+            if (func_idx >= import_func_count
+                && func_idx - import_func_count < comp_data->func_count)
+                is_external[func_idx - import_func_count] = true;
+        }
+    }
+
+    for (i = 0; i < wasm_module->global_count; i++) {
+        InitializerExpression *init_expr = &wasm_module->globals[i].init_expr;
+        if (init_expr->init_expr_type == INIT_EXPR_TYPE_FUNCREF_CONST) {
+            func_idx = init_expr->u.ref_index;
+            if (func_idx >= import_func_count
+                && func_idx - import_func_count < comp_data->func_count)
+                is_external[func_idx - import_func_count] = true;
+        }
+    }
+}
+
 /**
  * Create function compiler contexts
  */
@@ -3243,6 +3986,7 @@ static AOTFuncContext **
 aot_create_func_contexts(const AOTCompData *comp_data, AOTCompContext *comp_ctx)
 {
     AOTFuncContext **func_ctxes;
+    bool *is_external = NULL;
     uint64 size;
     uint32 i;
 
@@ -3256,16 +4000,33 @@ aot_create_func_contexts(const AOTCompData *comp_data, AOTCompContext *comp_ctx)
 
     memset(func_ctxes, 0, size);
 
+    /* In the no-sandbox mode the functions are referenced by the
+       relocations and by name, keep the C calling convention for all */
+    if (!comp_ctx->no_sandbox_mode) {
+        size = sizeof(bool) * (uint64)comp_data->func_count;
+        if (!(is_external = wasm_runtime_malloc((uint32)size))) {
+            aot_set_last_error("allocate memory failed.");
+            wasm_runtime_free(func_ctxes);
+            return NULL;
+        }
+        memset(is_external, 0, (uint32)size);
+        mark_external_funcs(comp_data, is_external);
+    }
+
     /* Create each function context */
     for (i = 0; i < comp_data->func_count; i++) {
         AOTFunc *func = comp_data->funcs[i];
-        if (!(func_ctxes[i] =
-                  aot_create_func_context(comp_data, comp_ctx, func, i))) {
+        if (!(func_ctxes[i] = aot_create_func_context(
+                  comp_data, comp_ctx, func, i,
+                  is_external ? !is_external[i] : false))) {
             aot_destroy_func_contexts(func_ctxes, comp_data->func_count);
-            return NULL;
+            func_ctxes = NULL;
+            break;
         }
     }
 
+    if (is_external)
+        wasm_runtime_free(is_external);
     return func_ctxes;
 }
 
@@ -3611,6 +4372,8 @@ aot_compiler_init(void)
     LLVMInitializeAllTargets();
     LLVMInitializeAllTargetMCs();
     LLVMInitializeAllAsmPrinters();
+    /* For the inline asm emitted in hw trap mode */
+    LLVMInitializeAllAsmParsers();
 
     return true;
 }
@@ -3621,6 +4384,99 @@ aot_compiler_destroy(void)
     LLVMShutdown();
 }
 
+/**
+ * Create the TBAA access tags of the memory domains, the type node of
+ * each domain is a direct child of the root, so the domains don't
+ * alias each other
+ */
+static bool
+create_tbaa_tags(AOTCompContext *comp_ctx)
+{
+    static const char *domain_names[AOT_MEMORY_DOMAIN_COUNT] = {
+        "linear memory", "wasm global", "table", "runtime state"
+    };
+    const char *root_name = "wasm2native tbaa";
+    LLVMValueRef root, type_node, values[3], offset;
+    uint32 i;
+
+    comp_ctx->tbaa_kind_id = LLVMGetMDKindIDInContext(comp_ctx->context, "tbaa",
+                                                      (uint32)strlen("tbaa"));
+
+    if (!(offset = I64_CONST(0))
+        || !(values[0] = LLVMMDStringInContext(comp_ctx->context, root_name,
+                                               (uint32)strlen(root_name)))
+        || !(root = LLVMMDNodeInContext(comp_ctx->context, values, 1))) {
+        aot_set_last_error("create tbaa metadata failed.");
+        return false;
+    }
+
+    for (i = 0; i < AOT_MEMORY_DOMAIN_COUNT; i++) {
+        /* !{!"name", !root, i64 0} */
+        if (!(values[0] = LLVMMDStringInContext(
+                  comp_ctx->context, domain_names[i],
+                  (uint32)strlen(domain_names[i])))) {
+            aot_set_last_error("create tbaa metadata failed.");
+            return false;
+        }
+        values[1] = root;
+        values[2] = offset;
+        if (!(type_node = LLVMMDNodeInContext(comp_ctx->context, values, 3))) {
+            aot_set_last_error("create tbaa metadata failed.");
+            return false;
+        }
+
+        /* Access tag: !{!type_node, !type_node, i64 0} */
+        values[0] = values[1] = type_node;
+        if (!(comp_ctx->tbaa_tags[i] =
+                  LLVMMDNodeInContext(comp_ctx->context, values, 3))) {
+            aot_set_last_error("create tbaa metadata failed.");
+            return false;
+        }
+    }
+
+    return true;
+}
+
+/**
+ * Create the branch weights metadata of the unlikely branches, the
+ * weights are the same as what clang uses for __builtin_expect
+ */
+static bool
+create_branch_weights(AOTCompContext *comp_ctx)
+{
+    const char *name = "branch_weights";
+    LLVMValueRef values[3], likely_weight, unlikely_weight;
+
+    comp_ctx->prof_kind_id = LLVMGetMDKindIDInContext(comp_ctx->context, "prof",
+                                                      (uint32)strlen("prof"));
+
+    if (!(likely_weight = I32_CONST(2000))
+        || !(unlikely_weight = I32_CONST(1))
+        || !(values[0] = LLVMMDStringInContext(comp_ctx->context, name,
+                                               (uint32)strlen(name)))) {
+        aot_set_last_error("create branch weights metadata failed.");
+        return false;
+    }
+
+    values[1] = unlikely_weight;
+    values[2] = likely_weight;
+    if (!(comp_ctx->unlikely_true_weights =
+              LLVMMDNodeInContext(comp_ctx->context, values, 3))) {
+        aot_set_last_error("create branch weights metadata failed.");
+        return false;
+    }
+
+    values[1] = likely_weight;
+    values[2] = unlikely_weight;
+    if (!(comp_ctx->unlikely_false_weights =
+              LLVMMDNodeInContext(comp_ctx->context, values, 3))) {
+        aot_set_last_error("create branch weights metadata failed.");
+        return false;
+    }
+
+    return true;
+}
+
 AOTCompContext *
 aot_create_comp_context(AOTCompData *comp_data, aot_comp_option_t option)
 {
@@ -3680,6 +4536,26 @@ aot_create_comp_context(AOTCompData *comp_data, aot_comp_option_t option)
     if (option->disable_llvm_lto)
         comp_ctx->disable_llvm_lto = true;
 
+    /* The allocation imports are host managed heap APIs, which aren't
+       provided in no-sandbox mode */
+    if (option->enable_alloc_profiling && !option->no_sandbox_mode)
+        comp_ctx->enable_alloc_profiling = true;
+
+    if (option->trust_alignment_hints || option->check_alignment_hints)
+        comp_ctx->trust_alignment_hints = true;
+
+    if (option->check_alignment_hints)
+        comp_ctx->check_alignment_hints = true;
+
+    if (option->bounds_mode == AOT_BOUNDS_MODE_MASK) {
+        /* The wasm addresses are host addresses in no-sandbox mode */
+        if (!option->no_sandbox_mode)
+            comp_ctx->enable_bounds_mask = true;
+        else
+            LOG_WARNING("bounds mask mode isn't supported in no-sandbox "
+                        "mode, ignore --bounds-mode=mask");
+    }
+
     comp_ctx->opt_level = option->opt_level;
     comp_ctx->size_level = option->size_level;
 
@@ -3690,12 +4566,8 @@ aot_create_comp_context(AOTCompData *comp_data, aot_comp_option_t option)
                                   * aot_memory->mem_init_page_count;
         bool memory_data_size_fixed = MEMORY_DATA_SIZE_FIXED(aot_memory);
 
-        if (!memory_data_size_fixed) {
-            aot_set_last_error("cannot append host managed heap when "
-                               "wasm memory size isn't fixed.");
-            goto fail;
-        }
-        if (option->heap_size < 512) {
+        /* reserve space for the heap structure of the allocator */
+        if (option->heap_size < 2048) {
             aot_set_last_error("host managed heap size too small.");
             goto fail;
         }
@@ -3704,15 +4576,73 @@ aot_create_comp_context(AOTCompData *comp_data, aot_comp_option_t option)
             goto fail;
         }
 
-        aot_memory->host_managed_heap_offset = memory_data_size;
-        aot_memory->num_bytes_per_page =
-            (uint32)(memory_data_size + option->heap_size);
-        aot_memory->mem_init_page_count = aot_memory->mem_max_page_count = 1;
+        if (memory_data_size_fixed) {
+            /* append the heap to the linear memory which can't grow */
+            aot_memory->host_managed_heap_offset = memory_data_size;
+            aot_memory->num_bytes_per_page =
+                (uint32)(memory_data_size + option->heap_size);
+            aot_memory->mem_init_page_count = aot_memory->mem_max_page_count =
+                1;
+        }
+        else {
+            /* the heap spans the tail of the linear memory, it starts
+               with the pages appended to the initial memory and takes
+               the pages added by memory.grow later */
+            uint32 heap_page_count =
+                (uint32)((option->heap_size + aot_memory->num_bytes_per_page
+                          - 1)
+                         / aot_memory->num_bytes_per_page);
+
+            if (memory_data_size == 0) {
+                aot_set_last_error("cannot append host managed heap when "
+                                   "initial wasm memory size is zero.");
+                goto fail;
+            }
+            /* The pages grown by the module itself would be given to
+               the heap too, and be managed by both of them */
+            for (i = 0; i < comp_data->wasm_module->function_count; i++) {
+                if (comp_data->wasm_module->functions[i]->has_op_memory_grow)
+                    break;
+            }
+            if (i < comp_data->wasm_module->function_count) {
+                aot_set_last_error("cannot append growable host managed heap "
+                                   "when the module grows the memory, use "
+                                   "a fixed-size memory instead.");
+                goto fail;
+            }
+            if (heap_page_count > aot_memory->mem_max_page_count
+                                      - aot_memory->mem_init_page_count) {
+                aot_set_last_error("host managed heap size exceeds the "
+                                   "max wasm memory size.");
+                goto fail;
+            }
+
+            aot_memory->host_managed_heap_offset = (uint32)memory_data_size;
+            aot_memory->mem_init_page_count += heap_page_count;
+        }
     }
 
     comp_ctx->custom_sections_wp = option->custom_sections;
     comp_ctx->custom_sections_count = option->custom_sections_count;
 
+    /* Compile the functions in batches if their code takes more memory
+       than the limit, the objects of the batches are written to an
+       archive, which isn't supported by the LLVM IR output */
+    if (option->max_memory > 0) {
+        uint64 batch_code_size = (uint64)option->max_memory * BH_MB
+                                 / W2N_COMPILE_MEMORY_PER_CODE_BYTE;
+        uint64 code_size = 0;
+
+        for (i = 0; i < comp_data->func_count; i++)
+            code_size += comp_data->funcs[i]->code_size;
+
+        if (option->output_format != AOT_OBJECT_FILE)
+            LOG_WARNING("the LLVM IR output can't be compiled in batches, "
+                        "ignore --max-memory");
+        else if (code_size > batch_code_size)
+            comp_ctx->batch_code_size = batch_code_size;
+    }
+
     /* Create LLVM target machine */
     arch = option->target_arch;
     abi = option->target_abi;
@@ -3966,23 +4896,25 @@ aot_create_comp_context(AOTCompData *comp_data, aot_comp_option_t option)
     get_target_arch_from_triple(triple_norm, comp_ctx->target_arch,
                                 sizeof(comp_ctx->target_arch));
 
-    os_printf("Create AoT compiler with:\n");
-    os_printf("  target:        %s\n", comp_ctx->target_arch);
-    os_printf("  target cpu:    %s\n", cpu);
-    os_printf("  target triple: %s\n", triple_norm);
-    os_printf("  cpu features:  %s\n", features);
-    os_printf("  opt level:     %d\n", opt_level);
-    os_printf("  size level:    %d\n", size_level);
-    switch (option->output_format) {
-        case AOT_LLVMIR_UNOPT_FILE:
-            os_printf("  output format: unoptimized LLVM IR\n");
-            break;
-        case AOT_LLVMIR_OPT_FILE:
-            os_printf("  output format: optimized LLVM IR\n");
-            break;
-        case AOT_OBJECT_FILE:
-            os_printf("  output format: native object file\n");
-            break;
+    if (!option->quiet_mode) {
+        os_printf("Create AoT compiler with:\n");
+        os_printf("  target:        %s\n", comp_ctx->target_arch);
+        os_printf("  target cpu:    %s\n", cpu);
+        os_printf("  target triple: %s\n", triple_norm);
+        os_printf("  cpu features:  %s\n", features);
+        os_printf("  opt level:     %d\n", opt_level);
+        os_printf("  size level:    %d\n", size_level);
+        switch (option->output_format) {
+            case AOT_LLVMIR_UNOPT_FILE:
+                os_printf("  output format: unoptimized LLVM IR\n");
+                break;
+            case AOT_LLVMIR_OPT_FILE:
+                os_printf("  output format: optimized LLVM IR\n");
+                break;
+            case AOT_OBJECT_FILE:
+                os_printf("  output format: native object file\n");
+                break;
+        }
     }
 
     LLVMSetTarget(comp_ctx->module, triple_norm);
@@ -4012,8 +4944,14 @@ aot_create_comp_context(AOTCompData *comp_data, aot_comp_option_t option)
     else
         code_model = LLVMCodeModelSmall;
 
+    if (option->target_machine) {
+        /* Reuse the target machine created with the same options */
+        comp_ctx->target_machine =
+            (LLVMTargetMachineRef)option->target_machine;
+        comp_ctx->is_target_machine_borrowed = true;
+    }
     /* Create the target machine */
-    if (!(comp_ctx->target_machine = LLVMCreateTargetMachineWithOpts(
+    else if (!(comp_ctx->target_machine = LLVMCreateTargetMachineWithOpts(
               target, triple_norm, cpu, features, opt_level, LLVMRelocPIC,
               code_model))) {
         aot_set_last_error("create LLVM target machine failed.");
@@ -4057,6 +4995,18 @@ aot_create_comp_context(AOTCompData *comp_data, aot_comp_option_t option)
         }
     }
 
+    if (option->enable_hw_trap && !comp_ctx->no_sandbox_mode) {
+        /* The trap table and the SIGFPE handler of the vmlib are only
+           implemented for x86-64 Linux */
+        if (!strcmp(comp_ctx->target_arch, "x86_64")
+            && strstr(triple_norm, "linux"))
+            comp_ctx->enable_hw_trap = true;
+        else
+            LOG_WARNING("hw trap mode isn't supported by target %s, "
+                        "ignore --enable-hw-trap",
+                        triple_norm);
+    }
+
     if (!(target_data_ref =
               LLVMCreateTargetDataLayout(comp_ctx->target_machine))) {
         aot_set_last_error("create LLVM target data layout failed.");
@@ -4089,6 +5039,12 @@ aot_create_comp_context(AOTCompData *comp_data, aot_comp_option_t option)
         goto fail;
     }
 
+    if (!comp_ctx->no_sandbox_mode && !create_tbaa_tags(comp_ctx))
+        goto fail;
+
+    if (!create_branch_weights(comp_ctx))
+        goto fail;
+
     comp_ctx->import_func_count = comp_data->import_func_count;
     /* Create param values */
     total_size = sizeof(LLVMValueRef) * (uint64)comp_data->import_func_count;
@@ -4109,15 +5065,25 @@ aot_create_comp_context(AOTCompData *comp_data, aot_comp_option_t option)
                  aot_create_func_contexts(comp_data, comp_ctx)))
         goto fail;
 
+    /* The wrappers in hw trap mode are called by wasm_instance_create */
     if (!create_wasm_globals(comp_data, comp_ctx)
+        || !create_hw_trap_wrappers(comp_data, comp_ctx)
         || !create_wasm_instance_create_func(comp_data, comp_ctx)
         || !create_wasm_instance_destroy_func(comp_data, comp_ctx)
         || !create_wasm_instance_is_created_func(comp_data, comp_ctx)
         || !create_wasm_set_exception_func(comp_ctx)
+        || !create_throw_exception_func(comp_ctx)
         || !create_wasm_get_exception_func(comp_ctx)
         || !create_wasm_get_memory_func(comp_data, comp_ctx)
         || !create_wasm_get_memory_size_func(comp_data, comp_ctx)
+        || !create_wasm_get_i32_global_func(
+            comp_ctx, "wasm_get_memory_page_count", "cur_page_count")
+        || !create_wasm_get_i32_global_func(
+            comp_ctx, "wasm_get_memory_grow_count", "memory_grow_count")
+        || !create_wasm_get_i32_global_func(
+            comp_ctx, "wasm_get_alloc_call_site", "alloc_call_site")
         || !create_wasm_get_heap_handle_func(comp_data, comp_ctx)
+        || !create_wasm_enlarge_heap_func(comp_data, comp_ctx)
         || !create_wasm_get_export_apis_func(comp_data, comp_ctx))
         goto fail;
 
@@ -4138,13 +5104,18 @@ aot_create_comp_context(AOTCompData *comp_data, aot_comp_option_t option)
         AOTMemory *aot_memory = &comp_data->memories[0];
         bool memory_data_size_fixed = MEMORY_DATA_SIZE_FIXED(aot_memory);
 
-        if (memory_data_size_fixed) {
+        if (comp_ctx->static_memory_data) {
+            func_ctx->memory_data = comp_ctx->static_memory_data;
+        }
+        else if (memory_data_size_fixed) {
             if (!(func_ctx->memory_data =
                       LLVMBuildLoad2(comp_ctx->builder, INT8_PTR_TYPE,
                                      memory_data_global, "memory_data"))) {
                 aot_set_last_error("llvm build load failed");
                 goto fail;
             }
+            aot_set_memory_domain(comp_ctx, func_ctx->memory_data,
+                                  AOT_MEMORY_DOMAIN_RUNTIME_STATE);
         }
     }
 
@@ -4176,10 +5147,12 @@ fail:
 void
 aot_destroy_comp_context(AOTCompContext *comp_ctx)
 {
+    uint32 i;
+
     if (!comp_ctx)
         return;
 
-    if (comp_ctx->target_machine)
+    if (comp_ctx->target_machine && !comp_ctx->is_target_machine_borrowed)
         LLVMDisposeTargetMachine(comp_ctx->target_machine);
 
     if (comp_ctx->builder)
@@ -4201,9 +5174,29 @@ aot_destroy_comp_context(AOTCompContext *comp_ctx)
     if (comp_ctx->import_func_ptrs)
         wasm_runtime_free(comp_ctx->import_func_ptrs);
 
+    if (comp_ctx->batch_objs) {
+        for (i = 0; i < comp_ctx->batch_obj_count; i++)
+            LLVMDisposeMemoryBuffer(comp_ctx->batch_objs[i]);
+        wasm_runtime_free(comp_ctx->batch_objs);
+    }
+
     wasm_runtime_free(comp_ctx);
 }
 
+void *
+aot_take_target_machine(AOTCompContext *comp_ctx)
+{
+    comp_ctx->is_target_machine_borrowed = true;
+    return comp_ctx->target_machine;
+}
+
+void
+aot_destroy_target_machine(void *target_machine)
+{
+    if (target_machine)
+        LLVMDisposeTargetMachine((LLVMTargetMachineRef)target_machine);
+}
+
 void
 aot_value_stack_push(AOTValueStack *stack, AOTValue *value)
 {
@@ -4318,7 +5311,12 @@ aot_build_zero_function_ret(const AOTCompContext *comp_ctx,
 {
     LLVMValueRef ret = NULL;
 
-    if (func_type->result_count) {
+    if (aot_func_ret_in_regs(func_ctx)) {
+        ret = LLVMBuildRet(
+            comp_ctx->builder,
+            LLVMConstNull(LLVMGetReturnType(func_ctx->func_type)));
+    }
+    else if (func_type->result_count) {
         switch (func_type->types[func_type->param_count]) {
             case VALUE_TYPE_I32:
                 ret = LLVMBuildRet(comp_ctx->builder, I32_ZERO);
@@ -4452,11 +5450,31 @@ aot_call_llvm_intrinsic_v(const AOTCompContext *comp_ctx,
     return ret;
 }
 
+uint64
+aot_get_memory_data_alloc_size(const AOTCompContext *comp_ctx,
+                               uint64 memory_data_size)
+{
+    uint64 size = 1;
+
+    if (!comp_ctx->enable_bounds_mask)
+        return memory_data_size;
+
+    /* Round up to a power of two so that the address mask is size - 1,
+       and append the guard bytes for the accesses at the mask's end */
+    while (size < memory_data_size)
+        size <<= 1;
+    return size + W2N_BOUNDS_MASK_GUARD_SIZE;
+}
+
 LLVMValueRef
 aot_get_memory_base_addr(AOTCompContext *comp_ctx, AOTFuncContext *func_ctx)
 {
     LLVMValueRef memory_data_global, memory_data;
 
+    /* The address of the static linear memory is a link time constant */
+    if (comp_ctx->static_memory_data)
+        return comp_ctx->static_memory_data;
+
     memory_data_global = LLVMGetNamedGlobal(comp_ctx->module, "memory_data");
     bh_assert(memory_data_global);
 
@@ -4465,6 +5483,28 @@ aot_get_memory_base_addr(AOTCompContext *comp_ctx, AOTFuncContext *func_ctx)
         aot_set_last_error("llvm build load failed");
         return NULL;
     }
+    aot_set_memory_domain(comp_ctx, memory_data,
+                          AOT_MEMORY_DOMAIN_RUNTIME_STATE);
 
     return memory_data;
 }
+
+void
+aot_set_memory_domain(AOTCompContext *comp_ctx, LLVMValueRef inst,
+                      AOTMemoryDomain domain)
+{
+    bh_assert(domain < AOT_MEMORY_DOMAIN_COUNT);
+
+    if (comp_ctx->tbaa_tags[domain])
+        LLVMSetMetadata(inst, comp_ctx->tbaa_kind_id,
+                        comp_ctx->tbaa_tags[domain]);
+}
+
+void
+aot_set_unlikely_branch(AOTCompContext *comp_ctx, LLVMValueRef cond_br,
+                        bool is_true_unlikely)
+{
+    LLVMSetMetadata(cond_br, comp_ctx->prof_kind_id,
+                    is_true_unlikely ? comp_ctx->unlikely_true_weights
+                                     : comp_ctx->unlikely_false_weights);
+}
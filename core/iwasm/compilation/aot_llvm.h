@@ -121,6 +121,25 @@ typedef struct AOTBlockStack {
     uint32 block_index[3];
 } AOTBlockStack;
 
+/**
+ * Memory domains which are disjoint from each other, the loads and
+ * stores of them are attached with different TBAA tags, so that LLVM
+ * knows that a store to the linear memory doesn't clobber the wasm
+ * globals or the runtime states
+ */
+typedef enum AOTMemoryDomain {
+    /* The wasm linear memory */
+    AOT_MEMORY_DOMAIN_LINEAR_MEMORY = 0,
+    /* The wasm_global#N and wasm_import_global#N globals */
+    AOT_MEMORY_DOMAIN_WASM_GLOBAL,
+    /* The table_elems global */
+    AOT_MEMORY_DOMAIN_TABLE,
+    /* The runtime bookkeeping globals, e.g. memory_data,
+       mem_bound_check_Nbytes, exception_id and func_ptrs */
+    AOT_MEMORY_DOMAIN_RUNTIME_STATE,
+    AOT_MEMORY_DOMAIN_COUNT,
+} AOTMemoryDomain;
+
 typedef struct AOTCheckedAddr {
     struct AOTCheckedAddr *next;
     uint32 local_idx;
@@ -130,6 +149,8 @@ typedef struct AOTCheckedAddr {
 
 typedef struct AOTFuncContext {
     AOTFunc *aot_func;
+    /* function index, including the import functions */
+    uint32 func_idx;
     LLVMValueRef func;
     LLVMTypeRef func_type;
     LLVMModuleRef module;
@@ -141,6 +162,22 @@ typedef struct AOTFuncContext {
     LLVMBasicBlockRef func_return_block;
     LLVMValueRef exception_id_phi;
 
+    /* The aux stack top kept in the function, NULL if not promoted */
+    LLVMValueRef aux_stack_top;
+    /* Whether the aux stack top was checked in the function */
+    bool aux_stack_top_checked;
+    /* Whether the aux stack top was set after the last check */
+    bool aux_stack_top_dirty;
+
+    /* The export wrapper which catches the hardware traps, NULL if the
+       function isn't exported or the hw trap mode is disabled */
+    LLVMValueRef hw_trap_wrapper;
+
+    /* Whether the function is only reachable by direct calls, it then
+       uses the fast calling convention and returns all its results in
+       registers */
+    bool is_internal;
+
     LLVMValueRef locals[1];
 } AOTFuncContext;
 
@@ -236,6 +273,9 @@ typedef struct AOTCompContext {
     LLVMContextRef context;
     LLVMBuilderRef builder;
     LLVMTargetMachineRef target_machine;
+    /* The target machine is reused from option->target_machine or taken
+       by aot_take_target_machine, and isn't disposed with the context */
+    bool is_target_machine_borrowed;
     char *target_cpu;
     char target_arch[16];
     unsigned pointer_size;
@@ -254,6 +294,25 @@ typedef struct AOTCompContext {
     /* Disable LLVM link time optimization */
     bool disable_llvm_lto;
 
+    /* Record the index of the function which calls the allocation
+       imports in the alloc_call_site global */
+    bool enable_alloc_profiling;
+
+    /* Use the alignment immediates of the wasm memory accesses as the
+       alignment of the native loads and stores */
+    bool trust_alignment_hints;
+
+    /* Trap if the address doesn't meet the alignment immediate */
+    bool check_alignment_hints;
+
+    /* Let the integer division fault instead of checking the divisor,
+       the vmlib maps the SIGFPE to the wasm exception */
+    bool enable_hw_trap;
+
+    /* Wrap the wasm addresses into the linear memory by masking them
+       with mem_addr_mask instead of checking them against the bounds */
+    bool enable_bounds_mask;
+
     /* Whether optimize the machine code */
     bool optimize;
 
@@ -266,6 +325,21 @@ typedef struct AOTCompContext {
     /* LLVM floating-point exception behavior metadata */
     LLVMValueRef fp_exception_behavior;
 
+    /* TBAA access tag of each memory domain */
+    uint32 tbaa_kind_id;
+    LLVMValueRef tbaa_tags[AOT_MEMORY_DOMAIN_COUNT];
+
+    /* Branch weights of a conditional branch whose true or false edge
+       is unlikely taken, e.g. the edge to a trap block */
+    uint32 prof_kind_id;
+    LLVMValueRef unlikely_true_weights;
+    LLVMValueRef unlikely_false_weights;
+
+    /* Pointer to the static buffer of the linear memory if its size is
+       fixed, so that its address is a link time constant, NULL if the
+       memory is allocated by the instance create function */
+    LLVMValueRef static_memory_data;
+
     /* LLVM data types */
     AOTLLVMTypes basic_types;
 
@@ -280,6 +354,18 @@ typedef struct AOTCompContext {
     uint32 func_ctx_count;
     char **custom_sections_wp;
     uint32 custom_sections_count;
+
+    /* Max wasm code size of the functions compiled in a batch, which
+       is emitted to an object file of its own, 0 if all the functions
+       are compiled into one module */
+    uint64 batch_code_size;
+    /* The object files emitted for the batches, which are written to
+       an archive as the output */
+    LLVMMemoryBufferRef *batch_objs;
+    uint32 batch_obj_count;
+    /* The prefix of the symbols shared by the objects of the batches,
+       unique to the module */
+    char batch_symbol_prefix[24];
 } AOTCompContext;
 
 bool
@@ -294,6 +380,12 @@ aot_create_comp_context(AOTCompData *comp_data, aot_comp_option_t option);
 void
 aot_destroy_comp_context(AOTCompContext *comp_ctx);
 
+void *
+aot_take_target_machine(AOTCompContext *comp_ctx);
+
+void
+aot_destroy_target_machine(void *target_machine);
+
 bool
 aot_compile_wasm(AOTCompContext *comp_ctx);
 
@@ -343,6 +435,45 @@ aot_check_simd_compatibility(const char *arch_c_str, const char *cpu_c_str);
 void
 aot_apply_llvm_new_pass_manager(AOTCompContext *comp_ctx, LLVMModuleRef module);
 
+/**
+ * Give the local symbols of the module external linkage and hidden
+ * visibility, so that they can be referenced by the functions emitted
+ * to the other objects of the batches, and set the prefix of the symbols
+ * from a hash of the module
+ */
+void
+aot_externalize_local_symbols(AOTCompContext *comp_ctx);
+
+/**
+ * Move the functions [func_start, func_end) of the module to a new
+ * module, the other wasm functions are declared in it, and all the
+ * runtime globals and functions are moved to the module of the first
+ * batch. The bodies moved are deleted from the module of comp_ctx, and
+ * the symbols shared by the batches are prefixed in the new module.
+ *
+ * @param comp_ctx the compiler context
+ * @param func_start the index of the first function of the batch
+ * @param func_end the index after the last function of the batch
+ *
+ * @return the new module, NULL if failed
+ */
+LLVMModuleRef
+aot_split_module_batch(AOTCompContext *comp_ctx, uint32 func_start,
+                       uint32 func_end);
+
+/**
+ * Write the object files to an archive with a symbol table
+ *
+ * @param file_name the archive file name
+ * @param objs the object files
+ * @param obj_count the count of the object files
+ *
+ * @return true if success, false otherwise
+ */
+bool
+aot_write_object_archive(const char *file_name, LLVMMemoryBufferRef *objs,
+                         uint32 obj_count);
+
 /* This allow APIs to pass LLVMModule argument to CreateGlobalStringPtr */
 LLVMValueRef
 LLVMBuildGlobalStringPtr_v2(LLVMBuilderRef B, const char *Str, const char *Name,
@@ -354,6 +485,28 @@ aot_handle_llvm_errmsg(const char *string, LLVMErrorRef err);
 LLVMValueRef
 aot_get_memory_base_addr(AOTCompContext *comp_ctx, AOTFuncContext *func_ctx);
 
+uint64
+aot_get_memory_data_alloc_size(const AOTCompContext *comp_ctx,
+                               uint64 memory_data_size);
+
+/**
+ * Attach the TBAA tag of the memory domain to the load or store
+ * instruction, it does nothing in no-sandbox mode since the wasm
+ * loads and stores may access any native memory there
+ */
+void
+aot_set_memory_domain(AOTCompContext *comp_ctx, LLVMValueRef inst,
+                      AOTMemoryDomain domain);
+
+/**
+ * Attach the branch weights to the conditional branch, so that the true
+ * edge (if is_true_unlikely is true) or the false edge is laid out as
+ * the cold path
+ */
+void
+aot_set_unlikely_branch(AOTCompContext *comp_ctx, LLVMValueRef cond_br,
+                        bool is_true_unlikely);
+
 #ifdef __cplusplus
 } /* end of extern "C" */
 #endif
@@ -10,6 +10,7 @@
 #include <llvm/ADT/Optional.h>
 #include <llvm/ADT/Triple.h>
 #endif
+#include <llvm/ADT/DenseMap.h>
 #include <llvm/ADT/SmallVector.h>
 #include <llvm/ADT/Twine.h>
 #include <llvm/Analysis/TargetTransformInfo.h>
@@ -54,9 +55,18 @@
 #include <llvm/Analysis/AliasAnalysis.h>
 #endif
 #include <llvm/ProfileData/InstrProf.h>
+#include <llvm/ADT/StringExtras.h>
+#include <llvm/Object/ArchiveWriter.h>
+#include <llvm/Support/MemoryBuffer.h>
+#include <llvm/Support/FileSystem.h>
+#include <llvm/Support/SHA256.h>
+#include <llvm/Transforms/Utils/Cloning.h>
 
 #include <cstring>
+#include <string>
+#include <vector>
 #include "aot_llvm.h"
+#include "../../version.h"
 
 using namespace llvm;
 
@@ -242,6 +252,267 @@ aot_apply_llvm_new_pass_manager(AOTCompContext *comp_ctx, LLVMModuleRef module)
     MPM.run(*M, MAM);
 }
 
+void
+aot_externalize_local_symbols(AOTCompContext *comp_ctx)
+{
+    Module *M = reinterpret_cast<Module *>(comp_ctx->module);
+    WASMModule *wasm_module = comp_ctx->comp_data->wasm_module;
+    std::string skeleton;
+    raw_string_ostream os(skeleton);
+    SHA256 hasher;
+    uint32 i;
+
+    /* Identify the module by its runtime globals and function
+       declarations, which aren't compiled yet, and its function bodies */
+    M->print(os, nullptr);
+    hasher.update(os.str());
+    for (i = 0; i < wasm_module->function_count; i++) {
+        WASMFunction *func = wasm_module->functions[i];
+        hasher.update(ArrayRef<uint8_t>(func->code, func->code_size));
+    }
+    snprintf(comp_ctx->batch_symbol_prefix,
+             sizeof(comp_ctx->batch_symbol_prefix), "w2n_%.16s_",
+             toHex(hasher.final(), true).c_str());
+
+    for (GlobalValue &GV : M->global_values()) {
+        if (!GV.hasLocalLinkage())
+            continue;
+        /* The symbol must have a name to be referenced by the others */
+        if (!GV.hasName())
+            GV.setName("aot_local");
+        GV.setLinkage(GlobalValue::ExternalLinkage);
+        GV.setVisibility(GlobalValue::HiddenVisibility);
+    }
+}
+
+LLVMModuleRef
+aot_split_module_batch(AOTCompContext *comp_ctx, uint32 func_start,
+                       uint32 func_end)
+{
+    Module *M = reinterpret_cast<Module *>(comp_ctx->module);
+    DenseMap<const GlobalValue *, uint32> func_indexes;
+    ValueToValueMapTy VMap;
+    uint32 i;
+
+    for (i = 0; i < comp_ctx->func_ctx_count; i++)
+        func_indexes[unwrap<Function>(comp_ctx->func_ctxes[i]->func)] = i;
+
+    /* The runtime globals and functions go to the first batch */
+    auto is_in_batch = [&](const GlobalValue *GV) {
+        auto it = func_indexes.find(GV);
+        if (it == func_indexes.end())
+            return func_start == 0;
+        return it->second >= func_start && it->second < func_end;
+    };
+
+    std::unique_ptr<Module> BM = CloneModule(*M, VMap, is_in_batch);
+    if (!BM) {
+        aot_set_last_error("clone LLVM module failed.");
+        return NULL;
+    }
+
+    /* Drop the declarations which the batch doesn't refer to, e.g. the
+       ones of the functions in the other batches */
+    for (auto it = BM->global_begin(); it != BM->global_end();) {
+        GlobalVariable &GV = *it++;
+        GV.removeDeadConstantUsers();
+        if (GV.isDeclaration() && GV.use_empty())
+            GV.eraseFromParent();
+    }
+    for (auto it = BM->begin(); it != BM->end();) {
+        Function &F = *it++;
+        F.removeDeadConstantUsers();
+        if (F.isDeclaration() && F.use_empty())
+            F.eraseFromParent();
+    }
+
+    /* Keep the scalar constants defined in the first batch, e.g. the
+       bounds of a fixed size memory, foldable in the other batches */
+    for (GlobalVariable &GV : BM->globals()) {
+        const GlobalVariable *SrcGV;
+
+        if (!GV.isDeclaration() || !GV.isConstant())
+            continue;
+        SrcGV = M->getNamedGlobal(GV.getName());
+        if (SrcGV && SrcGV->hasInitializer()
+            && !SrcGV->getValueType()->isAggregateType()
+            && isa<ConstantData>(SrcGV->getInitializer())) {
+            GV.setInitializer(const_cast<Constant *>(SrcGV->getInitializer()));
+            GV.setLinkage(GlobalValue::AvailableExternallyLinkage);
+        }
+    }
+
+    /* Release the IR of the functions moved to the batch */
+    for (Function &F : *M) {
+        if (!F.isDeclaration() && is_in_batch(&F))
+            F.deleteBody();
+    }
+
+    /* Prefix the symbols externalized, so that they don't clash with the
+       ones of another module compiled in batches and linked into the same
+       binary, the names are kept in the main module as they are looked up
+       while the later batches are translated */
+    for (GlobalValue &GV : BM->global_values()) {
+        if (GV.getVisibility() == GlobalValue::HiddenVisibility)
+            GV.setName(Twine(comp_ctx->batch_symbol_prefix) + GV.getName());
+    }
+
+    return wrap(BM.release());
+}
+
+bool
+aot_write_object_archive(const char *file_name, LLVMMemoryBufferRef *objs,
+                         uint32 obj_count)
+{
+    std::vector<std::string> names;
+    std::vector<NewArchiveMember> members;
+    uint32 i;
+
+    for (i = 0; i < obj_count; i++)
+        names.push_back("batch" + std::to_string(i) + ".o");
+
+    for (i = 0; i < obj_count; i++) {
+        MemoryBufferRef buf(unwrap(objs[i])->getBuffer(), names[i]);
+        members.push_back(NewArchiveMember(buf));
+    }
+
+    /* The symbol table lets the linker pull the members in any order */
+    Error err = writeArchive(file_name, members,
+#if LLVM_VERSION_MAJOR >= 18
+                             SymtabWritingMode::NormalSymtab,
+#else
+                             true,
+#endif
+                             object::Archive::K_GNU, true, false);
+    if (err) {
+        aot_handle_llvm_errmsg("write archive failed", wrap(std::move(err)));
+        return false;
+    }
+
+    return true;
+}
+
+static void
+hash_cache_str(SHA256 &hasher, const char *str)
+{
+    /* Tell a NULL string from an empty one, and end each string so that
+       the adjacent strings can't be shifted into each other */
+    if (!str) {
+        hasher.update(StringRef("\x01", 1));
+        return;
+    }
+    hasher.update(StringRef(str));
+    hasher.update(StringRef("\0", 1));
+}
+
+static void
+hash_cache_int(SHA256 &hasher, uint64 value)
+{
+    uint8 buf[8];
+    uint32 i;
+
+    for (i = 0; i < 8; i++)
+        buf[i] = (uint8)(value >> (i * 8));
+    hasher.update(ArrayRef<uint8_t>(buf, sizeof(buf)));
+}
+
+/* Get the hash of the compiler binary, which identifies the build of it,
+   so that the output of a rebuilt compiler isn't taken from the cache.
+   It is got once for all the modules of --batch and the compile server */
+static const std::string &
+get_compiler_binary_hash()
+{
+    static const std::string binary_hash = []() -> std::string {
+        std::string path = sys::fs::getMainExecutable(
+            nullptr, (void *)(uintptr_t)get_compiler_binary_hash);
+        ErrorOr<std::unique_ptr<MemoryBuffer>> buffer =
+            MemoryBuffer::getFile(path, false, false);
+
+        if (path.empty() || !buffer)
+            return std::string();
+        return toHex(
+            SHA256::hash(arrayRefFromStringRef((*buffer)->getBuffer())), true);
+    }();
+    return binary_hash;
+}
+
+bool
+aot_get_cache_key(const uint8_t *wasm_file, uint32_t wasm_file_size,
+                  aot_comp_option_t option, char *key_buf,
+                  uint32_t key_buf_size)
+{
+    SHA256 hasher;
+    std::string key;
+    char *host_triple, *host_cpu;
+    uint32 i;
+
+    /* The compiler and LLVM versions, and the host target which is
+       the default of the target options */
+    hash_cache_int(hasher, W2N_VERSION_MAJOR);
+    hash_cache_int(hasher, W2N_VERSION_MINOR);
+    hash_cache_int(hasher, W2N_VERSION_PATCH);
+    hash_cache_str(hasher, LLVM_VERSION_STRING);
+
+    /* The build of the compiler, the cache can't be used without it */
+    if (get_compiler_binary_hash().empty()) {
+        aot_set_last_error("read the compiler binary failed.");
+        return false;
+    }
+    hash_cache_str(hasher, get_compiler_binary_hash().c_str());
+
+    /* The build time configs which change the generated code */
+    hash_cache_int(hasher, BH_DEBUG);
+    hash_cache_int(hasher, W2N_ENABLE_CUSTOM_NAME_SECTION);
+    hash_cache_int(hasher, W2N_STATIC_MEMORY_MAX_SIZE);
+    hash_cache_int(hasher, W2N_BOUNDS_MASK_GUARD_SIZE);
+    hash_cache_int(hasher, W2N_COMPILE_MEMORY_PER_CODE_BYTE);
+    hash_cache_int(hasher, WASM_HW_TRAP_JMPBUF_SIZE);
+
+    host_triple = LLVMGetDefaultTargetTriple();
+    host_cpu = LLVMGetHostCPUName();
+    hash_cache_str(hasher, host_triple);
+    hash_cache_str(hasher, host_cpu);
+    if (host_triple)
+        LLVMDisposeMessage(host_triple);
+    if (host_cpu)
+        LLVMDisposeMessage(host_cpu);
+
+    /* All the options as any of them may change the output */
+    hash_cache_str(hasher, option->target_arch);
+    hash_cache_str(hasher, option->target_abi);
+    hash_cache_str(hasher, option->target_cpu);
+    hash_cache_str(hasher, option->cpu_features);
+    hash_cache_int(hasher, option->no_sandbox_mode);
+    hash_cache_int(hasher, option->enable_simd);
+    hash_cache_int(hasher, option->enable_aux_stack_check);
+    hash_cache_int(hasher, option->disable_llvm_lto);
+    hash_cache_int(hasher, option->enable_alloc_profiling);
+    hash_cache_int(hasher, option->trust_alignment_hints);
+    hash_cache_int(hasher, option->check_alignment_hints);
+    hash_cache_int(hasher, option->enable_hw_trap);
+    hash_cache_int(hasher, option->opt_level);
+    hash_cache_int(hasher, option->size_level);
+    hash_cache_int(hasher, option->output_format);
+    hash_cache_int(hasher, option->bounds_mode);
+    hash_cache_int(hasher, option->heap_size);
+    hash_cache_int(hasher, option->max_memory);
+    hash_cache_int(hasher, option->custom_sections_count);
+    for (i = 0; i < option->custom_sections_count; i++)
+        hash_cache_str(hasher, option->custom_sections[i]);
+
+    hash_cache_int(hasher, wasm_file_size);
+    hasher.update(ArrayRef<uint8_t>(wasm_file, wasm_file_size));
+
+    key = toHex(hasher.final(), true);
+    if (key.size() >= key_buf_size) {
+        aot_set_last_error("buffer of the cache key is too small.");
+        return false;
+    }
+
+    bh_memcpy_s(key_buf, key_buf_size, key.c_str(), (uint32)key.size() + 1);
+    return true;
+}
+
 /* This allow APIs to pass LLVMModule argument to CreateGlobalStringPtr */
 LLVMValueRef
 LLVMBuildGlobalStringPtr_v2(LLVMBuilderRef B, const char *Str, const char *Name,
@@ -16,6 +16,7 @@ simd_load(AOTCompContext *comp_ctx, AOTFuncContext *func_ctx, uint32 align,
           LLVMTypeRef data_type, WASMRelocation *relocation)
 {
     LLVMValueRef maddr, data;
+    uint32 alignment;
 
     if (!(maddr = aot_check_memory_overflow(comp_ctx, func_ctx, offset,
                                             data_length, relocation))) {
@@ -29,12 +30,17 @@ simd_load(AOTCompContext *comp_ctx, AOTFuncContext *func_ctx, uint32 align,
         return NULL;
     }
 
+    if (!aot_get_access_alignment(comp_ctx, func_ctx, maddr, align,
+                                  &alignment))
+        return NULL;
+
     if (!(data = LLVMBuildLoad2(comp_ctx->builder, data_type, maddr, "data"))) {
         HANDLE_FAILURE("LLVMBuildLoad");
         return NULL;
     }
 
-    LLVMSetAlignment(data, 1);
+    LLVMSetAlignment(data, alignment);
+    aot_set_memory_domain(comp_ctx, data, AOT_MEMORY_DOMAIN_LINEAR_MEMORY);
 
     return data;
 }
@@ -268,6 +274,7 @@ simd_store(AOTCompContext *comp_ctx, AOTFuncContext *func_ctx, uint32 align,
            LLVMTypeRef value_ptr_type, WASMRelocation *relocation)
 {
     LLVMValueRef maddr, result;
+    uint32 alignment;
 
     if (!(maddr = aot_check_memory_overflow(comp_ctx, func_ctx, offset,
                                             data_length, relocation)))
@@ -279,12 +286,17 @@ simd_store(AOTCompContext *comp_ctx, AOTFuncContext *func_ctx, uint32 align,
         return false;
     }
 
+    if (!aot_get_access_alignment(comp_ctx, func_ctx, maddr, align,
+                                  &alignment))
+        return false;
+
     if (!(result = LLVMBuildStore(comp_ctx->builder, value, maddr))) {
         HANDLE_FAILURE("LLVMBuildStore");
         return false;
     }
 
-    LLVMSetAlignment(result, 1);
+    LLVMSetAlignment(result, alignment);
+    aot_set_memory_domain(comp_ctx, result, AOT_MEMORY_DOMAIN_LINEAR_MEMORY);
 
     return true;
 }
@@ -41,9 +41,10 @@ typedef enum WASMExceptionID {
     EXCE_HOST_MANAGED_HEAP_NOT_FOUND,
     EXCE_QUICK_CALL_ENTRY_NOT_FOUND,
     EXCE_UNKNOWN_ERROR,
+    EXCE_UNALIGNED_MEMORY_ACCESS,
 
     EXCE_ID_MIN = EXCE_UNREACHABLE,
-    EXCE_ID_MAX = EXCE_UNKNOWN_ERROR,
+    EXCE_ID_MAX = EXCE_UNALIGNED_MEMORY_ACCESS,
 } WASMExceptionID;
 
 typedef struct WASMExportApi {
@@ -52,6 +53,41 @@ typedef struct WASMExportApi {
     const void *func_ptr;
 } WASMExportApi;
 
+/* Number of the size classes of WASMMemoryStats::heap_alloc_counts */
+#define WASM_HEAP_SIZE_CLASS_NUM 16
+
+typedef struct WASMMemoryStats {
+    /* Current page count of the wasm linear memory */
+    uint32_t cur_page_count;
+    /* Times the wasm linear memory was grown successfully, including
+       the growing to enlarge the host-managed heap */
+    uint32_t memory_grow_count;
+
+    /* The fields below are 0 if there is no host-managed heap */
+    uint32_t heap_size;
+    uint32_t heap_free_size;
+    uint32_t heap_highmark_size;
+    uint32_t heap_largest_free_size;
+    /* 1 - heap_largest_free_size / heap_free_size, 0 means that all the
+       free memory is contiguous */
+    double heap_fragmentation;
+    uint64_t heap_alloc_count;
+    uint64_t heap_free_count;
+    /* Allocation count of each size class, class i counts the requests
+       of size in (2^(i+3), 2^(i+4)] bytes, the first class also counts
+       the smaller ones and the last class also counts the larger ones */
+    uint64_t heap_alloc_counts[WASM_HEAP_SIZE_CLASS_NUM];
+} WASMMemoryStats;
+
+typedef struct WASMAllocSite {
+    /* Index of the wasm function which calls malloc, calloc, realloc or
+       strdup, -1 if unknown, i.e. the native binary isn't emitted with
+       `--enable-alloc-profiling` */
+    int32_t func_idx;
+    uint32_t sample_count;
+    uint64_t sample_bytes;
+} WASMAllocSite;
+
 /**
  * Create the wasm instance, use wasm_instance_is_created() to
  * check whether it is created successfully. If not, developer
@@ -95,6 +131,83 @@ wasm_get_memory_size(void);
 void *
 wasm_get_heap_handle(void);
 
+/**
+ * Enlarge the host-managed heap by growing the wasm linear memory, the
+ * heap spans the tail of the linear memory when the wasm memory isn't
+ * fixed (the initial page count is less than the max page count), and
+ * the new pages are added to the heap. Developer can call it when
+ * mem_allocator_malloc() fails and then retry. The pages grown are all
+ * taken by the heap, so the growable heap isn't supported for a module
+ * which contains memory.grow, and wasm2native rejects it: build such a
+ * module with a fixed-size memory instead, then the heap is appended to
+ * the linear memory and this function always fails. Note that the linear
+ * memory and the heap may be moved, so wasm_get_memory() and
+ * wasm_get_heap_handle() should be called again after it succeeds.
+ * The growable heap isn't supported by the thread-safe heap of the
+ * vmlib (built with `-DW2N_BUILD_THREAD_SAFE_HEAP=1`), as the heap can't
+ * be moved while other threads are allocating from it, and the object
+ * file fails to link with `mem_allocator_migrate` undefined.
+ *
+ * @param inc_size the size needed to allocate from the heap
+ *
+ * @return true if success, false otherwise
+ */
+bool
+wasm_enlarge_heap(uint32_t inc_size);
+
+/**
+ * Get the current page count of the wasm linear memory
+ */
+uint32_t
+wasm_get_memory_page_count(void);
+
+/**
+ * Get the times the wasm linear memory was grown successfully
+ */
+uint32_t
+wasm_get_memory_grow_count(void);
+
+/**
+ * Get the memory and host-managed heap statistics, including the heap
+ * free size, high-water mark, largest free chunk, fragmentation ratio
+ * and allocation counts by size class. It doesn't walk the heap, so it
+ * is cheap enough to be called periodically.
+ *
+ * @return true if success, false if the wasm instance isn't created
+ */
+bool
+wasm_get_memory_stats(WASMMemoryStats *stats);
+
+/**
+ * Set the sampling interval of the allocation profiler, one of every
+ * interval allocations of the wasm app from the host-managed heap (by
+ * malloc, calloc, realloc and strdup) is recorded with its call site.
+ * The samples recorded before are cleared, and 0 disables the profiler,
+ * which is the default.
+ */
+void
+wasm_set_alloc_sample_interval(uint32_t interval);
+
+/**
+ * Get the call sites recorded by the allocation profiler, sorted by
+ * the sampled bytes in descending order
+ *
+ * @param sites the buffer to return the call sites
+ * @param max_count the max number of call sites the buffer can hold
+ *
+ * @return the number of call sites returned
+ */
+uint32_t
+wasm_get_alloc_sites(WASMAllocSite *sites, uint32_t max_count);
+
+/**
+ * Get the index of the wasm function which called malloc, calloc,
+ * realloc or strdup most recently, -1 if unknown. It is recorded only
+ * if `--enable-alloc-profiling` is specified for wasm2native tool.
+ */
+int32_t
+wasm_get_alloc_call_site(void);
+
 /**
  * Get the exception id, no exception was thrown if it is 0, otherwise
  * it is one of the values in enum WASMExceptionID
@@ -114,6 +227,16 @@ wasm_get_exception_msg(void);
 void
 wasm_set_exception(int32_t exception_id);
 
+/**
+ * Flush the stdout output of the wasm app which is buffered by the
+ * builtin libc (printf, puts, putchar and fwrite), developer should
+ * call it after calling the exported wasm function if the output is
+ * expected to be seen immediately. The buffer is also flushed when a
+ * newline is written, when it is full and when the process exits.
+ */
+void
+wasm_flush_output(void);
+
 /**
  * Allocate memory from the memory allocator
  *
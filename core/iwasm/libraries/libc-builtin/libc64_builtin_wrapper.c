@@ -5,6 +5,8 @@
 
 #include "bh_platform.h"
 #include "w2n_export.h"
+#include "libc_builtin_output.h"
+#include "libc_builtin_stats.h"
 #include "../common/wasm_runtime.h"
 
 #if defined(_WIN32) || defined(_WIN32_)
@@ -148,9 +150,17 @@ module_malloc(uint32 size, void **p_native_addr)
         return 0;
 
     mem = mem_allocator_malloc(heap_handle, size);
+    if (!mem && wasm_enlarge_heap(size)
+        && (heap_handle = wasm_get_heap_handle())) {
+        /* the memory may be moved after the heap is enlarged */
+        memory_data = wasm_get_memory();
+        mem = mem_allocator_malloc(heap_handle, size);
+    }
     if (!mem)
         return 0;
 
+    libc_builtin_sample_alloc(size);
+
     if (p_native_addr)
         *p_native_addr = mem;
     return (uint64)((uint8 *)mem - (uint8 *)memory_data);
@@ -169,9 +179,18 @@ module_realloc(uint64 ptr, uint32 new_size, void **p_native_addr)
 
     mem = (uint8 *)memory_data + ptr;
     mem = mem_allocator_realloc(heap_handle, mem, new_size);
+    if (!mem && wasm_enlarge_heap(new_size)
+        && (heap_handle = wasm_get_heap_handle())) {
+        /* the memory may be moved after the heap is enlarged */
+        memory_data = wasm_get_memory();
+        mem = (uint8 *)memory_data + ptr;
+        mem = mem_allocator_realloc(heap_handle, mem, new_size);
+    }
     if (!mem)
         return 0;
 
+    libc_builtin_sample_alloc(new_size);
+
     if (p_native_addr)
         *p_native_addr = mem;
     return (uint64)((uint8 *)mem - (uint8 *)memory_data);
@@ -201,6 +220,7 @@ align_ptr(const uint8 *p, uint32 b)
 }
 
 typedef int (*out_func_t)(int c, void *ctx);
+typedef void (*out_str_func_t)(const char *str, uint32 len, void *ctx);
 
 typedef char *_va_list;
 #define _va_arg(ap, t)                                   \
@@ -220,7 +240,7 @@ typedef char *_va_list;
 
 /* clang-format off */
 #define PREPARE_TEMP_FORMAT()                                \
-    char temp_fmt[32], *s, *fmt_buf = temp_fmt;              \
+    char temp_fmt[32], *fmt_buf = temp_fmt;                  \
     uint32 fmt_buf_len = (uint32)sizeof(temp_fmt);           \
     int32 n;                                                 \
                                                              \
@@ -241,17 +261,15 @@ typedef char *_va_list;
                 (uint32)(fmt - fmt_start_addr + 1));
 /* clang-format on */
 
-#define OUTPUT_TEMP_FORMAT()           \
-    do {                               \
-        if (n > 0) {                   \
-            s = buf;                   \
-            while (*s)                 \
-                out((int)(*s++), ctx); \
-        }                              \
-                                       \
-        if (fmt_buf != temp_fmt) {     \
-            runtime_free(fmt_buf);     \
-        }                              \
+#define OUTPUT_TEMP_FORMAT()                          \
+    do {                                              \
+        if (n > 0) {                                  \
+            out_str(buf, (uint32)strlen(buf), ctx);   \
+        }                                             \
+                                                      \
+        if (fmt_buf != temp_fmt) {                    \
+            runtime_free(fmt_buf);                    \
+        }                                             \
     } while (0)
 
 static void
@@ -263,7 +281,8 @@ print_err(out_func_t out, void *ctx)
 }
 
 static bool
-_vprintf_wa(out_func_t out, void *ctx, const char *fmt, _va_list ap)
+_vprintf_wa(out_func_t out, out_str_func_t out_str, void *ctx, const char *fmt,
+            _va_list ap)
 {
     int might_format = 0; /* 1 if encountered a '%' */
     bool long_argument = false;
@@ -282,7 +301,13 @@ _vprintf_wa(out_func_t out, void *ctx, const char *fmt, _va_list ap)
     while (*fmt) {
         if (!might_format) {
             if (*fmt != '%') {
-                out((int)*fmt, ctx);
+                /* Output the literal run in bulk rather than one char
+                   per callback */
+                const char *run_start = fmt;
+
+                while (fmt[1] && fmt[1] != '%')
+                    fmt++;
+                out_str(run_start, (uint32)(fmt - run_start + 1), ctx);
             }
             else {
                 might_format = 1;
@@ -372,7 +397,7 @@ _vprintf_wa(out_func_t out, void *ctx, const char *fmt, _va_list ap)
                         return false;
                     }
 
-                    s = start = addr_app_to_native(s_offset);
+                    start = addr_app_to_native(s_offset);
 
                     str_len = (uint32)strlen(start);
                     if (str_len >= UINT32_MAX - 64) {
@@ -484,14 +509,40 @@ sprintf_out(int c, struct str_context *ctx)
     return c;
 }
 
+static void
+sprintf_out_str(const char *str, uint32 len, struct str_context *ctx)
+{
+    if (ctx->str && ctx->count < ctx->max) {
+        uint32 copy_len = ctx->max - 1 - ctx->count;
+
+        if (copy_len > len)
+            copy_len = len;
+        bh_memcpy_s(ctx->str + ctx->count, ctx->max - ctx->count, str,
+                    copy_len);
+        if (copy_len < len) {
+            /* Same as sprintf_out(), the last byte is reserved for '\0' */
+            ctx->str[ctx->max - 1] = '\0';
+        }
+    }
+
+    ctx->count += len;
+}
+
 static int
 printf_out(int c, struct str_context *ctx)
 {
-    os_printf("%c", c);
+    libc_builtin_output_char(c);
     ctx->count++;
     return c;
 }
 
+static void
+printf_out_str(const char *str, uint32 len, struct str_context *ctx)
+{
+    libc_builtin_output_str(str, len);
+    ctx->count += len;
+}
+
 int
 printf64_wrapper(uint64 fmt_offset, uint64 va_args_offset)
 {
@@ -506,7 +557,8 @@ printf64_wrapper(uint64 fmt_offset, uint64 va_args_offset)
     format = addr_app_to_native(fmt_offset);
     va_args = addr_app_to_native(va_args_offset);
 
-    if (!_vprintf_wa((out_func_t)printf_out, &ctx, format, va_args))
+    if (!_vprintf_wa((out_func_t)printf_out,
+                     (out_str_func_t)printf_out_str, &ctx, format, va_args))
         return 0;
 
     return (int)ctx.count;
@@ -538,7 +590,8 @@ sprintf64_wrapper(uint64 str_offset, uint64 fmt_offset, uint64 va_args_offset)
     ctx.max = (uint32)(native_end_offset - (uint8 *)str);
     ctx.count = 0;
 
-    if (!_vprintf_wa((out_func_t)sprintf_out, &ctx, format, va_args))
+    if (!_vprintf_wa((out_func_t)sprintf_out,
+                     (out_str_func_t)sprintf_out_str, &ctx, format, va_args))
         return 0;
 
     if (ctx.count < ctx.max) {
@@ -575,7 +628,8 @@ snprintf64_wrapper(uint64 str_offset, uint64 size, uint64 fmt_offset,
     ctx.max = size;
     ctx.count = 0;
 
-    if (!_vprintf_wa((out_func_t)sprintf_out, &ctx, format, va_args))
+    if (!_vprintf_wa((out_func_t)sprintf_out,
+                     (out_str_func_t)sprintf_out_str, &ctx, format, va_args))
         return 0;
 
     if (ctx.count < ctx.max) {
@@ -590,16 +644,21 @@ puts64_wrapper(uint64 str_offset)
 {
     char *str = (char *)addr_app_to_native(str_offset);
 
+    uint32 len;
+
     if (!str)
         return 0;
 
-    return os_printf("%s\n", str);
+    len = (uint32)strlen(str);
+    libc_builtin_output_str(str, len);
+    libc_builtin_output_char('\n');
+    return (int)len + 1;
 }
 
 int
 putchar64_wrapper(int c)
 {
-    os_printf("%c", c);
+    libc_builtin_output_char(c);
     return 1;
 }
 
@@ -859,6 +918,7 @@ void
 exit64_wrapper(int32 status)
 {
     LOG_WARNING("wasm app exit with %d\n", status);
+    wasm_flush_output();
     wasm_set_exception(EXCE_UNREACHABLE);
 }
 
@@ -1070,7 +1130,8 @@ fwrite64_wrapper(uint64 buf_offset, uint64 size, uint64 nmemb,
     char *buf = addr_app_to_native(buf_offset);
 
     bh_assert(stream_offset == 0);
-    return fwrite(buf, size, nmemb, stdout);
+    libc_builtin_output_str(buf, (uint64)size * nmemb);
+    return nmemb;
 }
 
 uint64
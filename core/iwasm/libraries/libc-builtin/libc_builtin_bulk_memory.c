@@ -0,0 +1,126 @@
+/*
+ * Copyright (C) 2019 Intel Corporation.  All rights reserved.
+ * SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+ */
+
+#include "libc_builtin_bulk_memory.h"
+
+#if defined(__x86_64__)
+#include <emmintrin.h>
+
+/* The non-temporal stores are used for a head of up to 15 bytes and
+   then 64-byte blocks, the length must cover at least one of each */
+#define NT_STORE_MIN_LEN 80
+
+#if LIBC_BUILTIN_NT_STORE_THRESHOLD > 0 \
+    && LIBC_BUILTIN_NT_STORE_THRESHOLD < NT_STORE_MIN_LEN
+#error "Too small LIBC_BUILTIN_NT_STORE_THRESHOLD"
+#endif
+
+/* Length from which the non-temporal stores are used, 0 if not
+   initialized yet */
+static uint64 nt_store_threshold;
+
+static uint64
+get_nt_store_threshold(void)
+{
+    long l2_cache_size = 0;
+
+    if (nt_store_threshold > 0)
+        return nt_store_threshold;
+
+#if LIBC_BUILTIN_NT_STORE_THRESHOLD > 0
+    l2_cache_size = LIBC_BUILTIN_NT_STORE_THRESHOLD;
+#elif defined(_SC_LEVEL2_CACHE_SIZE)
+    l2_cache_size = sysconf(_SC_LEVEL2_CACHE_SIZE);
+#endif
+    if (l2_cache_size <= 0)
+        l2_cache_size = 1024 * 1024;
+    else if (l2_cache_size < NT_STORE_MIN_LEN)
+        l2_cache_size = NT_STORE_MIN_LEN;
+
+    nt_store_threshold = (uint64)l2_cache_size;
+    return nt_store_threshold;
+}
+
+/* Get the length of the head to store before dst is 16-byte aligned */
+static inline uint32
+get_head_len(const void *dst)
+{
+    return (uint32)((16 - ((uintptr_t)dst & 15)) & 15);
+}
+
+static void
+nt_store_copy(uint8 *dst, const uint8 *src, uint64 len)
+{
+    uint32 head_len = get_head_len(dst);
+    __m128i v0, v1, v2, v3;
+
+    memcpy(dst, src, head_len);
+    dst += head_len;
+    src += head_len;
+    len -= head_len;
+
+    for (; len >= 64; len -= 64, dst += 64, src += 64) {
+        v0 = _mm_loadu_si128((const __m128i *)src);
+        v1 = _mm_loadu_si128((const __m128i *)(src + 16));
+        v2 = _mm_loadu_si128((const __m128i *)(src + 32));
+        v3 = _mm_loadu_si128((const __m128i *)(src + 48));
+        _mm_stream_si128((__m128i *)dst, v0);
+        _mm_stream_si128((__m128i *)(dst + 16), v1);
+        _mm_stream_si128((__m128i *)(dst + 32), v2);
+        _mm_stream_si128((__m128i *)(dst + 48), v3);
+    }
+    /* Order the non-temporal stores before the following stores */
+    _mm_sfence();
+
+    memcpy(dst, src, (size_t)len);
+}
+
+static void
+nt_store_fill(uint8 *dst, int32 val, uint64 len)
+{
+    uint32 head_len = get_head_len(dst);
+    __m128i v = _mm_set1_epi8((char)val);
+
+    memset(dst, val, head_len);
+    dst += head_len;
+    len -= head_len;
+
+    for (; len >= 64; len -= 64, dst += 64) {
+        _mm_stream_si128((__m128i *)dst, v);
+        _mm_stream_si128((__m128i *)(dst + 16), v);
+        _mm_stream_si128((__m128i *)(dst + 32), v);
+        _mm_stream_si128((__m128i *)(dst + 48), v);
+    }
+    _mm_sfence();
+
+    memset(dst, val, (size_t)len);
+}
+#endif /* end of defined(__x86_64__) */
+
+void
+wasm_bulk_memory_copy(void *dst, const void *src, uint64 len)
+{
+#if defined(__x86_64__)
+    /* The forward copy is only correct if dst isn't in (src, src + len) */
+    if (len >= get_nt_store_threshold()
+        && (uint64)((uintptr_t)dst - (uintptr_t)src) >= len) {
+        nt_store_copy(dst, src, len);
+        return;
+    }
+#endif
+    memmove(dst, src, (size_t)len);
+}
+
+void
+wasm_bulk_memory_fill(void *dst, int32 val, uint64 len)
+{
+#if defined(__x86_64__)
+    if (len >= get_nt_store_threshold()) {
+        nt_store_fill(dst, val, len);
+        return;
+    }
+#endif
+    memset(dst, val, (size_t)len);
+}
@@ -0,0 +1,35 @@
+/*
+ * Copyright (C) 2019 Intel Corporation.  All rights reserved.
+ * SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+ */
+
+#ifndef _LIBC_BUILTIN_BULK_MEMORY_H
+#define _LIBC_BUILTIN_BULK_MEMORY_H
+
+#include "bh_platform.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Copy len bytes from src to dst for the wasm memory.copy opcode, the
+ * ranges may overlap. Called by the compiled code for non-constant or
+ * large lengths, it uses non-temporal stores if len is larger than
+ * the L2 cache, so that the copy doesn't evict the working set.
+ */
+void
+wasm_bulk_memory_copy(void *dst, const void *src, uint64 len);
+
+/**
+ * Fill len bytes of dst with the low byte of val for the wasm
+ * memory.fill opcode, with non-temporal stores for large lengths.
+ */
+void
+wasm_bulk_memory_fill(void *dst, int32 val, uint64 len);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* end of _LIBC_BUILTIN_BULK_MEMORY_H */
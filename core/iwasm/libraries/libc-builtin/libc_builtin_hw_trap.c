@@ -0,0 +1,120 @@
+/*
+ * Copyright (C) 2019 Intel Corporation.  All rights reserved.
+ * SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+ */
+
+#if defined(__linux__) && defined(__x86_64__)
+/* For REG_RIP and REG_RCX of ucontext_t */
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+#include <setjmp.h>
+#include <signal.h>
+#include <ucontext.h>
+#endif
+
+#include "libc_builtin_hw_trap.h"
+#include "w2n_export.h"
+
+#if defined(__linux__) && defined(__x86_64__)
+
+/* Entry of the trap table which the compiler emits to the w2n_hw_traps
+   section for each div/idiv with --enable-hw-trap */
+typedef struct HWTrapEntry {
+    /* Address of the instruction, relative to the entry */
+    int32 pc_offset;
+    /* 0 if the divisor is in ecx, 1 if it is in rcx */
+    uint32 kind;
+} HWTrapEntry;
+
+/* Defined by the linker if any object has the w2n_hw_traps section */
+extern HWTrapEntry __start_w2n_hw_traps[] __attribute__((weak));
+extern HWTrapEntry __stop_w2n_hw_traps[] __attribute__((weak));
+
+bh_static_assert(sizeof(jmp_buf) <= WASM_HW_TRAP_JMPBUF_SIZE);
+
+static __thread jmp_buf *cur_jmpbuf;
+static struct sigaction prev_sig_action;
+static pthread_once_t sig_handler_once = PTHREAD_ONCE_INIT;
+
+static const HWTrapEntry *
+lookup_trap_entry(uintptr_t pc)
+{
+    HWTrapEntry *entry;
+
+    if (!__start_w2n_hw_traps)
+        return NULL;
+
+    for (entry = __start_w2n_hw_traps; entry < __stop_w2n_hw_traps; entry++) {
+        if ((uintptr_t)entry + (intptr_t)entry->pc_offset == pc)
+            return entry;
+    }
+    return NULL;
+}
+
+static void
+sigfpe_handler(int sig_num, siginfo_t *sig_info, void *sig_ucontext)
+{
+    ucontext_t *uc = (ucontext_t *)sig_ucontext;
+    const HWTrapEntry *entry;
+    uint64 divisor;
+
+    entry = lookup_trap_entry((uintptr_t)uc->uc_mcontext.gregs[REG_RIP]);
+    if (!entry || !cur_jmpbuf) {
+        /* Not a fault of the wasm code, chain to the previous handler and
+           keep this one installed for the later wasm faults */
+        if (prev_sig_action.sa_flags & SA_SIGINFO)
+            prev_sig_action.sa_sigaction(sig_num, sig_info, sig_ucontext);
+        else if (prev_sig_action.sa_handler != SIG_DFL
+                 && prev_sig_action.sa_handler != SIG_IGN)
+            prev_sig_action.sa_handler(sig_num);
+        else {
+            /* The fault can't be ignored, restore the default action
+               which kills the process when the instruction is
+               restarted */
+            signal(SIGFPE, SIG_DFL);
+        }
+        return;
+    }
+
+    divisor = (uint64)uc->uc_mcontext.gregs[REG_RCX];
+    if (entry->kind == 0)
+        divisor = (uint32)divisor;
+
+    /* div/idiv only faults on divided by zero, or INT_MIN / -1 */
+    wasm_set_exception(divisor == 0 ? EXCE_INTEGER_DIVIDE_BY_ZERO
+                                    : EXCE_INTEGER_OVERFLOW);
+    /* SA_NODEFER keeps SIGFPE unblocked after leaving the handler */
+    longjmp(*cur_jmpbuf, 1);
+}
+
+static void
+install_sig_handler(void)
+{
+    struct sigaction sig_action;
+
+    memset(&sig_action, 0, sizeof(sig_action));
+    sigemptyset(&sig_action.sa_mask);
+    sig_action.sa_flags = SA_SIGINFO | SA_NODEFER;
+    sig_action.sa_sigaction = sigfpe_handler;
+    if (sigaction(SIGFPE, &sig_action, &prev_sig_action) != 0)
+        LOG_ERROR("install SIGFPE handler failed.");
+}
+
+void *
+wasm_hw_trap_enter(void *jmpbuf)
+{
+    jmp_buf *prev_jmpbuf = cur_jmpbuf;
+
+    pthread_once(&sig_handler_once, install_sig_handler);
+    cur_jmpbuf = (jmp_buf *)jmpbuf;
+    return prev_jmpbuf;
+}
+
+void
+wasm_hw_trap_leave(void *prev_jmpbuf)
+{
+    cur_jmpbuf = (jmp_buf *)prev_jmpbuf;
+}
+
+#endif /* end of defined(__linux__) && defined(__x86_64__) */
@@ -0,0 +1,38 @@
+/*
+ * Copyright (C) 2019 Intel Corporation.  All rights reserved.
+ * SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+ */
+
+#ifndef _LIBC_BUILTIN_HW_TRAP_H
+#define _LIBC_BUILTIN_HW_TRAP_H
+
+#include "bh_platform.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Register the jmp_buf of an export wrapper generated with
+ * --enable-hw-trap, the SIGFPE handler sets the wasm exception and
+ * longjmps to it if a division of the wasm code faults.
+ *
+ * @param jmpbuf the jmp_buf, WASM_HW_TRAP_JMPBUF_SIZE bytes
+ *
+ * @return the jmp_buf registered before, which must be passed to
+ *         wasm_hw_trap_leave() when the wrapper returns
+ */
+void *
+wasm_hw_trap_enter(void *jmpbuf);
+
+/**
+ * Restore the jmp_buf registered before wasm_hw_trap_enter().
+ */
+void
+wasm_hw_trap_leave(void *prev_jmpbuf);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* end of _LIBC_BUILTIN_HW_TRAP_H */
@@ -0,0 +1,95 @@
+/*
+ * Copyright (C) 2019 Intel Corporation.  All rights reserved.
+ * SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+ */
+
+#include "libc_builtin_output.h"
+#include "w2n_export.h"
+
+#if LIBC_BUILTIN_OUTPUT_BUF_SIZE > 0
+/* There is only one wasm instance in the native binary, so the buffer
+   is per-instance */
+static char output_buf[LIBC_BUILTIN_OUTPUT_BUF_SIZE];
+static uint32 output_buf_len;
+static bool flush_at_exit_registered;
+
+static void
+output_buf_flush(void)
+{
+    if (output_buf_len > 0) {
+        fwrite(output_buf, 1, output_buf_len, stdout);
+        output_buf_len = 0;
+    }
+}
+
+static void
+register_flush_at_exit(void)
+{
+    /* Don't lose the pending output if the host exits without
+       calling wasm_flush_output() */
+    if (!flush_at_exit_registered) {
+        atexit(output_buf_flush);
+        flush_at_exit_registered = true;
+    }
+}
+
+void
+libc_builtin_output_char(int c)
+{
+    if (output_buf_len == 0)
+        register_flush_at_exit();
+
+    output_buf[output_buf_len++] = (char)c;
+
+    if (c == '\n' || output_buf_len == sizeof(output_buf))
+        output_buf_flush();
+}
+
+void
+libc_builtin_output_str(const char *str, uint64 len)
+{
+    if (len == 0)
+        return;
+
+    if (len > sizeof(output_buf) - output_buf_len) {
+        output_buf_flush();
+        if (len >= sizeof(output_buf)) {
+            /* Too large to be buffered, write it directly */
+            fwrite(str, 1, (size_t)len, stdout);
+            return;
+        }
+    }
+
+    if (output_buf_len == 0)
+        register_flush_at_exit();
+
+    bh_memcpy_s(output_buf + output_buf_len,
+                (uint32)sizeof(output_buf) - output_buf_len, str, (uint32)len);
+    output_buf_len += (uint32)len;
+
+    if (memchr(str, '\n', (size_t)len) || output_buf_len == sizeof(output_buf))
+        output_buf_flush();
+}
+
+void
+wasm_flush_output(void)
+{
+    output_buf_flush();
+}
+#else  /* else of LIBC_BUILTIN_OUTPUT_BUF_SIZE > 0 */
+void
+libc_builtin_output_char(int c)
+{
+    putchar(c);
+}
+
+void
+libc_builtin_output_str(const char *str, uint64 len)
+{
+    fwrite(str, 1, (size_t)len, stdout);
+}
+
+void
+wasm_flush_output(void)
+{}
+#endif /* end of LIBC_BUILTIN_OUTPUT_BUF_SIZE > 0 */
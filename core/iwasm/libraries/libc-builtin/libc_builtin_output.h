@@ -0,0 +1,34 @@
+/*
+ * Copyright (C) 2019 Intel Corporation.  All rights reserved.
+ * SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+ */
+
+#ifndef _LIBC_BUILTIN_OUTPUT_H
+#define _LIBC_BUILTIN_OUTPUT_H
+
+#include "bh_platform.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Append a character to the stdout buffer shared by printf, puts,
+ * putchar and fwrite of libc-builtin, the buffer is flushed when a
+ * newline is written or it is full.
+ */
+void
+libc_builtin_output_char(int c);
+
+/**
+ * Append a string of len bytes to the stdout buffer, the string is
+ * copied in bulk and needn't be NULL-terminated.
+ */
+void
+libc_builtin_output_str(const char *str, uint64 len);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* end of _LIBC_BUILTIN_OUTPUT_H */
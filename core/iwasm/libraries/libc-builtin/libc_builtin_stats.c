@@ -0,0 +1,131 @@
+/*
+ * Copyright (C) 2019 Intel Corporation.  All rights reserved.
+ * SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+ */
+
+#include "libc_builtin_stats.h"
+#include "w2n_export.h"
+#include "mem_alloc.h"
+
+bh_static_assert(WASM_HEAP_SIZE_CLASS_NUM == MEM_ALLOC_SIZE_CLASS_NUM);
+bh_static_assert((LIBC_BUILTIN_ALLOC_SITE_NUM
+                  & (LIBC_BUILTIN_ALLOC_SITE_NUM - 1))
+                 == 0);
+
+/* There is only one wasm instance in the native binary, so the profile
+   is per-instance, it isn't protected by a lock since the libc-builtin
+   APIs are called by the wasm app in one thread */
+static uint32 alloc_sample_interval;
+static uint32 alloc_sample_countdown;
+/* Hash table of the call sites indexed by func_idx, an entry is unused
+   if its sample_count is 0 */
+static WASMAllocSite alloc_sites[LIBC_BUILTIN_ALLOC_SITE_NUM];
+
+bool
+wasm_get_memory_stats(WASMMemoryStats *stats)
+{
+    void *heap_handle;
+    mem_alloc_info_t info;
+    uint32 i;
+
+    if (!stats || !wasm_instance_is_created())
+        return false;
+
+    memset(stats, 0, sizeof(WASMMemoryStats));
+    stats->cur_page_count = wasm_get_memory_page_count();
+    stats->memory_grow_count = wasm_get_memory_grow_count();
+
+    if (!(heap_handle = wasm_get_heap_handle()))
+        return true;
+
+    if (!mem_allocator_get_alloc_info(heap_handle, &info))
+        return false;
+
+    stats->heap_size = info.total_size;
+    stats->heap_free_size = info.total_free_size;
+    stats->heap_highmark_size = info.highmark_size;
+    stats->heap_largest_free_size = info.largest_free_size;
+    if (info.total_free_size > 0)
+        stats->heap_fragmentation =
+            1.0 - (double)info.largest_free_size / info.total_free_size;
+    stats->heap_alloc_count = info.alloc_count;
+    stats->heap_free_count = info.free_count;
+    for (i = 0; i < WASM_HEAP_SIZE_CLASS_NUM; i++)
+        stats->heap_alloc_counts[i] = info.alloc_counts[i];
+    return true;
+}
+
+void
+wasm_set_alloc_sample_interval(uint32_t interval)
+{
+    memset(alloc_sites, 0, sizeof(alloc_sites));
+    alloc_sample_interval = alloc_sample_countdown = interval;
+}
+
+static WASMAllocSite *
+get_alloc_site(int32 func_idx)
+{
+    uint32 i = (uint32)func_idx & (LIBC_BUILTIN_ALLOC_SITE_NUM - 1), n;
+
+    for (n = 0; n < LIBC_BUILTIN_ALLOC_SITE_NUM; n++) {
+        if (alloc_sites[i].sample_count == 0) {
+            alloc_sites[i].func_idx = func_idx;
+            return &alloc_sites[i];
+        }
+        if (alloc_sites[i].func_idx == func_idx)
+            return &alloc_sites[i];
+        i = (i + 1) & (LIBC_BUILTIN_ALLOC_SITE_NUM - 1);
+    }
+
+    /* The table is full, drop the sample */
+    return NULL;
+}
+
+void
+libc_builtin_sample_alloc(uint32 size)
+{
+    WASMAllocSite *site;
+
+    if (alloc_sample_interval == 0 || --alloc_sample_countdown > 0)
+        return;
+
+    alloc_sample_countdown = alloc_sample_interval;
+
+    if ((site = get_alloc_site(wasm_get_alloc_call_site()))) {
+        site->sample_count++;
+        site->sample_bytes += size;
+    }
+}
+
+static int
+alloc_site_cmp(const void *a, const void *b)
+{
+    const WASMAllocSite *site_a = (const WASMAllocSite *)a;
+    const WASMAllocSite *site_b = (const WASMAllocSite *)b;
+
+    if (site_a->sample_bytes != site_b->sample_bytes)
+        return site_a->sample_bytes > site_b->sample_bytes ? -1 : 1;
+    return site_a->func_idx < site_b->func_idx
+               ? -1
+               : (site_a->func_idx > site_b->func_idx ? 1 : 0);
+}
+
+uint32_t
+wasm_get_alloc_sites(WASMAllocSite *sites, uint32_t max_count)
+{
+    WASMAllocSite sorted_sites[LIBC_BUILTIN_ALLOC_SITE_NUM];
+    uint32 i, count = 0;
+
+    for (i = 0; i < LIBC_BUILTIN_ALLOC_SITE_NUM; i++) {
+        if (alloc_sites[i].sample_count > 0)
+            sorted_sites[count++] = alloc_sites[i];
+    }
+
+    qsort(sorted_sites, count, sizeof(WASMAllocSite), alloc_site_cmp);
+
+    if (count > max_count)
+        count = max_count;
+    if (count > 0)
+        memcpy(sites, sorted_sites, sizeof(WASMAllocSite) * count);
+    return count;
+}
@@ -0,0 +1,27 @@
+/*
+ * Copyright (C) 2019 Intel Corporation.  All rights reserved.
+ * SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+ */
+
+#ifndef _LIBC_BUILTIN_STATS_H
+#define _LIBC_BUILTIN_STATS_H
+
+#include "bh_platform.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Notify the sampling allocation profiler that the wasm app allocated
+ * size bytes from the host managed heap with malloc, calloc, realloc
+ * or strdup, it does nothing if the profiler is disabled.
+ */
+void
+libc_builtin_sample_alloc(uint32 size);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* end of _LIBC_BUILTIN_STATS_H */
@@ -5,6 +5,8 @@
 
 #include "bh_platform.h"
 #include "w2n_export.h"
+#include "libc_builtin_output.h"
+#include "libc_builtin_stats.h"
 #include "../common/wasm_runtime.h"
 
 #if defined(_WIN32) || defined(_WIN32_)
@@ -148,9 +150,17 @@ module_malloc(uint32 size, void **p_native_addr)
         return 0;
 
     mem = mem_allocator_malloc(heap_handle, size);
+    if (!mem && wasm_enlarge_heap(size)
+        && (heap_handle = wasm_get_heap_handle())) {
+        /* the memory may be moved after the heap is enlarged */
+        memory_data = wasm_get_memory();
+        mem = mem_allocator_malloc(heap_handle, size);
+    }
     if (!mem)
         return 0;
 
+    libc_builtin_sample_alloc(size);
+
     if (p_native_addr)
         *p_native_addr = mem;
     return (uint32)((uint8 *)mem - (uint8 *)memory_data);
@@ -169,9 +179,18 @@ module_realloc(uint32 ptr, uint32 new_size, void **p_native_addr)
 
     mem = (uint8 *)memory_data + ptr;
     mem = mem_allocator_realloc(heap_handle, mem, new_size);
+    if (!mem && wasm_enlarge_heap(new_size)
+        && (heap_handle = wasm_get_heap_handle())) {
+        /* the memory may be moved after the heap is enlarged */
+        memory_data = wasm_get_memory();
+        mem = (uint8 *)memory_data + ptr;
+        mem = mem_allocator_realloc(heap_handle, mem, new_size);
+    }
     if (!mem)
         return 0;
 
+    libc_builtin_sample_alloc(new_size);
+
     if (p_native_addr)
         *p_native_addr = mem;
     return (uint32)((uint8 *)mem - (uint8 *)memory_data);
@@ -192,43 +211,65 @@ module_free(uint32 offset)
     mem_allocator_free(heap_handle, (uint8 *)memory_data + offset);
 }
 
+/* Write the spectest output through the output buffer of the wasm app,
+   so that it is in order with the output of printf and puts */
+static void
+spectest_print(const char *format, ...)
+{
+    /* Large enough for two doubles printed with %f */
+    char buf[1024];
+    va_list ap;
+    int len;
+
+    va_start(ap, format);
+    len = vsnprintf(buf, sizeof(buf), format, ap);
+    va_end(ap);
+
+    if (len < 0)
+        return;
+    if ((uint32)len >= sizeof(buf))
+        len = (int)sizeof(buf) - 1;
+    libc_builtin_output_str(buf, (uint64)len);
+}
+
 void
 print_wrapper()
 {
-    os_printf("spectestprint()\n");
+    spectest_print("spectestprint()\n");
 }
 
 void
 print_i32_wrapper(int32 i32)
 {
-    os_printf("spectestprint_i32(%d)\n", i32);
+    spectest_print("spectestprint_i32(%d)\n", i32);
 }
 
 void
 print_i32_f32_wrapper(int32 i32, float f32)
 {
-    os_printf("spectestprint_i32_f32(%d, %f)\n", i32, f32);
+    spectest_print("spectestprint_i32_f32(%d, %f)\n", i32, f32);
 }
 
 void
 print_f64_f64_wrapper(double f64_1, double f64_2)
 {
-    os_printf("spectestprint_f64_f64(%f, %f)\n", f64_1, f64_2);
+    spectest_print("spectestprint_f64_f64(%f, %f)\n", f64_1, f64_2);
 }
 
 void
 print_f32_wrapper(float f32)
 {
-    os_printf("spectestprint_f32(%f)\n", f32);
+    spectest_print("spectestprint_f32(%f)\n", f32);
 }
 
 void
 print_f64_wrapper(double f64)
 {
-    os_printf("spectestprint_f64(%f)\n", f64);
+    spectest_print("spectestprint_f64(%f)\n", f64);
 }
 
 typedef int (*out_func_t)(int c, void *ctx);
+typedef void (*out_str_func_t)(const char *str, uint32 len, void *ctx);
 
 typedef char *_va_list;
 #define _INTSIZEOF(n) (((uint32)sizeof(n) + 3) & (uint32)~3)
@@ -246,7 +287,7 @@ typedef char *_va_list;
 
 /* clang-format off */
 #define PREPARE_TEMP_FORMAT()                                \
-    char temp_fmt[32], *s, *fmt_buf = temp_fmt;              \
+    char temp_fmt[32], *fmt_buf = temp_fmt;                  \
     uint32 fmt_buf_len = (uint32)sizeof(temp_fmt);           \
     int32 n;                                                 \
                                                              \
@@ -267,17 +308,15 @@ typedef char *_va_list;
                 (uint32)(fmt - fmt_start_addr + 1));
 /* clang-format on */
 
-#define OUTPUT_TEMP_FORMAT()           \
-    do {                               \
-        if (n > 0) {                   \
-            s = buf;                   \
-            while (*s)                 \
-                out((int)(*s++), ctx); \
-        }                              \
-                                       \
-        if (fmt_buf != temp_fmt) {     \
-            runtime_free(fmt_buf);     \
-        }                              \
+#define OUTPUT_TEMP_FORMAT()                          \
+    do {                                              \
+        if (n > 0) {                                  \
+            out_str(buf, (uint32)strlen(buf), ctx);   \
+        }                                             \
+                                                      \
+        if (fmt_buf != temp_fmt) {                    \
+            runtime_free(fmt_buf);                    \
+        }                                             \
     } while (0)
 
 static void
@@ -289,7 +328,8 @@ print_err(out_func_t out, void *ctx)
 }
 
 static bool
-_vprintf_wa(out_func_t out, void *ctx, const char *fmt, _va_list ap)
+_vprintf_wa(out_func_t out, out_str_func_t out_str, void *ctx, const char *fmt,
+            _va_list ap)
 {
     int might_format = 0; /* 1 if encountered a '%' */
     int long_ctr = 0;
@@ -310,7 +350,13 @@ _vprintf_wa(out_func_t out, void *ctx, const char *fmt, _va_list ap)
     while (*fmt) {
         if (!might_format) {
             if (*fmt != '%') {
-                out((int)*fmt, ctx);
+                /* Output the literal run in bulk rather than one char
+                   per callback */
+                const char *run_start = fmt;
+
+                while (fmt[1] && fmt[1] != '%')
+                    fmt++;
+                out_str(run_start, (uint32)(fmt - run_start + 1), ctx);
             }
             else {
                 might_format = 1;
@@ -419,7 +465,7 @@ _vprintf_wa(out_func_t out, void *ctx, const char *fmt, _va_list ap)
                         return false;
                     }
 
-                    s = start = addr_app_to_native(s_offset);
+                    start = addr_app_to_native(s_offset);
 
                     str_len = (uint32)strlen(start);
                     if (str_len >= UINT32_MAX - 64) {
@@ -531,14 +577,40 @@ sprintf_out(int c, struct str_context *ctx)
     return c;
 }
 
+static void
+sprintf_out_str(const char *str, uint32 len, struct str_context *ctx)
+{
+    if (ctx->str && ctx->count < ctx->max) {
+        uint32 copy_len = ctx->max - 1 - ctx->count;
+
+        if (copy_len > len)
+            copy_len = len;
+        bh_memcpy_s(ctx->str + ctx->count, ctx->max - ctx->count, str,
+                    copy_len);
+        if (copy_len < len) {
+            /* Same as sprintf_out(), the last byte is reserved for '\0' */
+            ctx->str[ctx->max - 1] = '\0';
+        }
+    }
+
+    ctx->count += len;
+}
+
 int
 printf_out(int c, struct str_context *ctx)
 {
-    os_printf("%c", c);
+    libc_builtin_output_char(c);
     ctx->count++;
     return c;
 }
 
+static void
+printf_out_str(const char *str, uint32 len, struct str_context *ctx)
+{
+    libc_builtin_output_str(str, len);
+    ctx->count += len;
+}
+
 int
 printf_wrapper(uint32 fmt_offset, uint32 va_args_offset)
 {
@@ -553,7 +625,8 @@ printf_wrapper(uint32 fmt_offset, uint32 va_args_offset)
     format = addr_app_to_native(fmt_offset);
     va_args = addr_app_to_native(va_args_offset);
 
-    if (!_vprintf_wa((out_func_t)printf_out, &ctx, format, va_args))
+    if (!_vprintf_wa((out_func_t)printf_out,
+                     (out_str_func_t)printf_out_str, &ctx, format, va_args))
         return 0;
 
     return (int)ctx.count;
@@ -585,7 +658,8 @@ sprintf_wrapper(uint32 str_offset, uint32 fmt_offset, uint32 va_args_offset)
     ctx.max = (uint32)(native_end_offset - (uint8 *)str);
     ctx.count = 0;
 
-    if (!_vprintf_wa((out_func_t)sprintf_out, &ctx, format, va_args))
+    if (!_vprintf_wa((out_func_t)sprintf_out,
+                     (out_str_func_t)sprintf_out_str, &ctx, format, va_args))
         return 0;
 
     if (ctx.count < ctx.max) {
@@ -622,7 +696,8 @@ snprintf_wrapper(uint32 str_offset, uint32 size, uint32 fmt_offset,
     ctx.max = size;
     ctx.count = 0;
 
-    if (!_vprintf_wa((out_func_t)sprintf_out, &ctx, format, va_args))
+    if (!_vprintf_wa((out_func_t)sprintf_out,
+                     (out_str_func_t)sprintf_out_str, &ctx, format, va_args))
         return 0;
 
     if (ctx.count < ctx.max) {
@@ -637,16 +712,21 @@ puts_wrapper(uint32 str_offset)
 {
     char *str = (char *)addr_app_to_native(str_offset);
 
+    uint32 len;
+
     if (!str)
         return 0;
 
-    return os_printf("%s\n", str);
+    len = (uint32)strlen(str);
+    libc_builtin_output_str(str, len);
+    libc_builtin_output_char('\n');
+    return (int)len + 1;
 }
 
 int
 putchar_wrapper(int c)
 {
-    os_printf("%c", c);
+    libc_builtin_output_char(c);
     return 1;
 }
 
@@ -902,6 +982,7 @@ void
 exit_wrapper(int32 status)
 {
     LOG_WARNING("wasm app exit with %d\n", status);
+    wasm_flush_output();
     wasm_set_exception(EXCE_UNREACHABLE);
 }
 
@@ -1114,7 +1195,8 @@ fwrite_wrapper(uint32 buf_offset, uint32 size, uint32 nmemb,
     char *buf = addr_app_to_native(buf_offset);
 
     bh_assert(stream_offset == 0);
-    return fwrite(buf, size, nmemb, stdout);
+    libc_builtin_output_str(buf, (uint64)size * nmemb);
+    return nmemb;
 }
 
 uint64
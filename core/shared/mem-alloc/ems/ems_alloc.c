@@ -5,6 +5,14 @@
 
 #include "ems_gc_internal.h"
 
+#if W2N_ENABLE_THREAD_SAFE_HEAP != 0
+#define LOCK_HEAP(heap) os_mutex_lock(&(heap)->lock)
+#define UNLOCK_HEAP(heap) os_mutex_unlock(&(heap)->lock)
+#else
+#define LOCK_HEAP(heap) (void)0
+#define UNLOCK_HEAP(heap) (void)0
+#endif
+
 static inline bool
 hmu_is_in_heap(void *hmu, gc_uint8 *heap_base_addr, gc_uint8 *heap_end_addr)
 {
@@ -12,94 +20,187 @@ hmu_is_in_heap(void *hmu, gc_uint8 *heap_base_addr, gc_uint8 *heap_end_addr)
     return (addr >= heap_base_addr && addr < heap_end_addr) ? true : false;
 }
 
+/* Index of the highest set bit, v should not be 0 */
+static inline uint32
+bit_scan_msb(uint32 v)
+{
+#if defined(__GNUC__) || defined(__clang__)
+    return 31 - (uint32)__builtin_clz(v);
+#else
+    uint32 n = 0;
+    while (v >>= 1)
+        n++;
+    return n;
+#endif
+}
+
+/* Index of the lowest set bit, v should not be 0 */
+static inline uint32
+bit_scan_lsb(uint32 v)
+{
+#if defined(__GNUC__) || defined(__clang__)
+    return (uint32)__builtin_ctz(v);
+#else
+    uint32 n = 0;
+    while (!(v & 1)) {
+        v >>= 1;
+        n++;
+    }
+    return n;
+#endif
+}
+
+/* Get the size class to count an allocation request, see
+   GC_SIZE_CLASS_NUM */
+static inline uint32
+get_size_class(gc_size_t size)
+{
+    uint32 idx;
+
+    if (size <= 16)
+        return 0;
+
+    idx = bit_scan_msb(size - 1) - 3;
+    return idx < GC_SIZE_CLASS_NUM ? idx : GC_SIZE_CLASS_NUM - 1;
+}
+
 /**
- * Remove a node from the tree it belongs to
+ * Get the bin of a big free chunk
  *
- * @param p the node to remove, can not be NULL, can not be the ROOT node
- *        the node will be removed from the tree, and the left, right and
- *        parent pointers of the node @p will be set to be NULL. Other fields
- *        won't be touched. The tree will be re-organized so that the order
- *        conditions are still satisified.
+ * @param size the size of the chunk, should not be smaller than
+ *        (1 << HMU_FC_BIN_FL_MIN)
+ * @param p_fl_idx [out] the first level index, starts from 0
+ * @param p_sl [out] the second level index
  */
-static bool
-remove_tree_node(gc_heap_t *heap, hmu_tree_node_t *p)
+static inline void
+get_bin_index(gc_size_t size, uint32 *p_fl_idx, uint32 *p_sl)
 {
-    hmu_tree_node_t *q = NULL, **slot = NULL;
+    uint32 fl = bit_scan_msb(size);
 
-    bh_assert(p);
+    bh_assert(fl >= HMU_FC_BIN_FL_MIN);
 
-    /* get the slot which holds pointer to node p */
-    if (p == p->parent->right) {
-        /* Don't use `slot = &p->parent->right` to avoid compiler warning */
-        slot = (hmu_tree_node_t **)((uint8 *)p->parent
-                                    + offsetof(hmu_tree_node_t, right));
+    if (fl > HMU_FC_BIN_FL_MAX) {
+        *p_fl_idx = HMU_FC_BIN_FL_CNT - 1;
+        *p_sl = HMU_FC_BIN_SL_CNT - 1;
+        return;
     }
-    else if (p == p->parent->left) {
-        /* p should be a child of its parent */
-        /* Don't use `slot = &p->parent->left` to avoid compiler warning */
-        slot = (hmu_tree_node_t **)((uint8 *)p->parent
-                                    + offsetof(hmu_tree_node_t, left));
+
+    *p_fl_idx = fl - HMU_FC_BIN_FL_MIN;
+    *p_sl = (size >> (fl - HMU_FC_BIN_SL_SHIFT)) & (HMU_FC_BIN_SL_CNT - 1);
+}
+
+static void
+insert_bin_node(gc_heap_t *heap, hmu_bin_node_t *node)
+{
+    uint32 fl_idx, sl, bin_idx;
+
+    get_bin_index(node->size, &fl_idx, &sl);
+    bin_idx = fl_idx * HMU_FC_BIN_SL_CNT + sl;
+
+    node->prev = NULL;
+    node->next = heap->kfc_bins[bin_idx];
+    if (node->next)
+        node->next->prev = node;
+    heap->kfc_bins[bin_idx] = node;
+
+    heap->kfc_bin_fl_bitmap |= (uint32)1 << fl_idx;
+    heap->kfc_bin_sl_bitmap[fl_idx] |= (uint32)1 << sl;
+}
+
+/**
+ * Remove a node from the bin it belongs to
+ *
+ * @param p the node to remove, can not be NULL, the prev and next
+ *        pointers of the node @p will be set to be NULL. Other fields
+ *        won't be touched.
+ */
+static void
+remove_bin_node(gc_heap_t *heap, hmu_bin_node_t *p)
+{
+    uint32 fl_idx, sl, bin_idx;
+
+    bh_assert(p);
+
+    get_bin_index(p->size, &fl_idx, &sl);
+    bin_idx = fl_idx * HMU_FC_BIN_SL_CNT + sl;
+
+    if (p->prev) {
+        p->prev->next = p->next;
     }
     else {
-        goto fail;
-    }
-
-    /**
-     * algorithms used to remove node p
-     * case 1: if p has no left child, replace p with its right child
-     * case 2: if p has no right child, replace p with its left child
-     * case 3: otherwise, find p's predecessor, remove it from the tree
-     *         and replace p with it.
-     * use predecessor can keep the left <= root < right condition.
-     */
-
-    if (!p->left) {
-        /* move right child up*/
-        *slot = p->right;
-        if (p->right) {
-            p->right->parent = p->parent;
+        bh_assert(heap->kfc_bins[bin_idx] == p);
+        heap->kfc_bins[bin_idx] = p->next;
+        if (!p->next) {
+            heap->kfc_bin_sl_bitmap[fl_idx] &= ~((uint32)1 << sl);
+            if (!heap->kfc_bin_sl_bitmap[fl_idx])
+                heap->kfc_bin_fl_bitmap &= ~((uint32)1 << fl_idx);
         }
-
-        p->left = p->right = p->parent = NULL;
-        return true;
+    }
+    if (p->next) {
+        p->next->prev = p->prev;
     }
 
-    if (!p->right) {
-        /* move left child up*/
-        *slot = p->left;
-        /* p->left can never be NULL unless it is corrupted. */
-        p->left->parent = p->parent;
+    p->prev = p->next = NULL;
+}
 
-        p->left = p->right = p->parent = NULL;
-        return true;
+/**
+ * Find a big free chunk for the required size
+ *
+ * The size is rounded up to the next bin at first, so that any chunk
+ * in the first non-empty bin found by the bitmaps meets the request.
+ * If there is no such bin, do best-fit in the bin of the size itself.
+ *
+ * @return the node found, NULL if no chunk is large enough
+ */
+static hmu_bin_node_t *
+find_bin_node(gc_heap_t *heap, gc_size_t size)
+{
+    hmu_bin_node_t *node, *best = NULL;
+    uint32 fl_idx = 0, sl = 0, sl_bitmap, fl_bitmap;
+    uint64 size_round;
+
+    if (size >= ((gc_size_t)1 << HMU_FC_BIN_FL_MIN)) {
+        size_round = (uint64)size
+                     + ((uint64)1 << (bit_scan_msb(size) - HMU_FC_BIN_SL_SHIFT))
+                     - 1;
+        if (size_round >= ((uint64)1 << (HMU_FC_BIN_FL_MAX + 1)))
+            goto search_own_bin;
+        get_bin_index((gc_size_t)size_round, &fl_idx, &sl);
     }
 
-    /* both left & right exist, find p's predecessor at first*/
-    q = p->left;
-    while (q->right) {
-        q = q->right;
+    sl_bitmap = heap->kfc_bin_sl_bitmap[fl_idx] & (~(uint32)0 << sl);
+    if (!sl_bitmap) {
+        fl_bitmap = fl_idx + 1 < HMU_FC_BIN_FL_CNT
+                        ? heap->kfc_bin_fl_bitmap & (~(uint32)0 << (fl_idx + 1))
+                        : 0;
+        if (!fl_bitmap)
+            goto search_own_bin;
+
+        fl_idx = bit_scan_lsb(fl_bitmap);
+        sl_bitmap = heap->kfc_bin_sl_bitmap[fl_idx];
+        bh_assert(sl_bitmap);
     }
 
-    /* remove from the tree*/
-    if (!remove_tree_node(heap, q))
-        return false;
+    sl = bit_scan_lsb(sl_bitmap);
+    node = heap->kfc_bins[fl_idx * HMU_FC_BIN_SL_CNT + sl];
+    bh_assert(node && node->size >= size);
+    return node;
 
-    *slot = q;
-    q->parent = p->parent;
-    q->left = p->left;
-    q->right = p->right;
-    if (q->left) {
-        q->left->parent = q;
-    }
-    if (q->right) {
-        q->right->parent = q;
-    }
-
-    p->left = p->right = p->parent = NULL;
+search_own_bin:
+    if (size < ((gc_size_t)1 << HMU_FC_BIN_FL_MIN))
+        return NULL;
 
-    return true;
-fail:
-    return false;
+    get_bin_index(size, &fl_idx, &sl);
+    node = heap->kfc_bins[fl_idx * HMU_FC_BIN_SL_CNT + sl];
+    while (node) {
+        if (node->size >= size && (!best || node->size < best->size)) {
+            best = node;
+            if (best->size == size)
+                break;
+        }
+        node = node->next;
+    }
+    return best;
 }
 
 static bool
@@ -136,8 +237,7 @@ unlink_hmu(gc_heap_t *heap, hmu_t *hmu)
         }
     }
     else {
-        if (!remove_tree_node(heap, (hmu_tree_node_t *)hmu))
-            return false;
+        remove_bin_node(heap, (hmu_bin_node_t *)hmu);
     }
     return true;
 }
@@ -165,7 +265,7 @@ bool
 gci_add_fc(gc_heap_t *heap, hmu_t *hmu, gc_size_t size)
 {
     hmu_normal_node_t *np = NULL;
-    hmu_tree_node_t *root = NULL, *tp = NULL, *node = NULL;
+    hmu_bin_node_t *node = NULL;
     uint32 node_idx;
 
     bh_assert(gci_is_heap_valid(heap));
@@ -191,32 +291,10 @@ gci_add_fc(gc_heap_t *heap, hmu_t *hmu, gc_size_t size)
     }
 
     /* big block */
-    node = (hmu_tree_node_t *)hmu;
+    node = (hmu_bin_node_t *)hmu;
+    ASSERT_BIN_NODE_ALIGNED_ACCESS(node);
     node->size = size;
-    node->left = node->right = node->parent = NULL;
-
-    /* find proper node to link this new node to */
-    root = heap->kfc_tree_root;
-    tp = root;
-    bh_assert(tp->size < size);
-    while (1) {
-        if (tp->size < size) {
-            if (!tp->right) {
-                tp->right = node;
-                node->parent = tp;
-                break;
-            }
-            tp = tp->right;
-        }
-        else { /* tp->size >= size */
-            if (!tp->left) {
-                tp->left = node;
-                node->parent = tp;
-                break;
-            }
-            tp = tp->left;
-        }
-    }
+    insert_bin_node(heap, node);
     return true;
 }
 
@@ -238,9 +316,8 @@ alloc_hmu(gc_heap_t *heap, gc_size_t size)
     hmu_normal_list_t *normal_head = NULL;
     hmu_normal_node_t *p = NULL;
     uint32 node_idx = 0, init_node_idx = 0;
-    hmu_tree_node_t *root = NULL, *tp = NULL, *last_tp = NULL;
+    hmu_bin_node_t *node = NULL;
     hmu_t *next, *rest;
-    uintptr_t tp_ret;
 
     bh_assert(gci_is_heap_valid(heap));
     bh_assert(size > 0 && !(size & 7));
@@ -297,41 +374,24 @@ alloc_hmu(gc_heap_t *heap, gc_size_t size)
         }
     }
 
-    /* need to find a node in tree*/
-    root = heap->kfc_tree_root;
-
-    /* find the best node*/
-    bh_assert(root);
-    tp = root->right;
-    while (tp) {
-        if (tp->size < size) {
-            tp = tp->right;
-            continue;
-        }
-
-        /* record the last node with size equal to or bigger than given size*/
-        last_tp = tp;
-        tp = tp->left;
-    }
-
-    if (last_tp) {
-        bh_assert(last_tp->size >= size);
+    /* need to find a node in the bins */
+    node = find_bin_node(heap, size);
 
-        /* alloc in last_p*/
+    if (node) {
+        bh_assert(node->size >= size);
 
-        /* remove node last_p from tree*/
-        if (!remove_tree_node(heap, last_tp))
-            return NULL;
+        /* remove the node from its bin and alloc in it */
+        remove_bin_node(heap, node);
 
-        if (last_tp->size >= size + GC_SMALLEST_SIZE) {
-            rest = (hmu_t *)((char *)last_tp + size);
-            if (!gci_add_fc(heap, rest, last_tp->size - size))
+        if (node->size >= size + GC_SMALLEST_SIZE) {
+            rest = (hmu_t *)((char *)node + size);
+            if (!gci_add_fc(heap, rest, node->size - size))
                 return NULL;
             hmu_mark_pinuse(rest);
         }
         else {
-            size = last_tp->size;
-            next = (hmu_t *)((char *)last_tp + size);
+            size = node->size;
+            next = (hmu_t *)((char *)node + size);
             if (hmu_is_in_heap(next, base_addr, end_addr))
                 hmu_mark_pinuse(next);
         }
@@ -340,9 +400,8 @@ alloc_hmu(gc_heap_t *heap, gc_size_t size)
         if ((heap->current_size - heap->total_free_size) > heap->highmark_size)
             heap->highmark_size = heap->current_size - heap->total_free_size;
 
-        hmu_set_size((hmu_t *)last_tp, size);
-        tp_ret = (uintptr_t)last_tp;
-        return (hmu_t *)tp_ret;
+        hmu_set_size((hmu_t *)node, size);
+        return (hmu_t *)node;
     }
 
     return NULL;
@@ -375,6 +434,365 @@ alloc_hmu_ex(gc_heap_t *heap, gc_size_t size)
 static unsigned long g_total_malloc = 0;
 static unsigned long g_total_free = 0;
 
+/**
+ * Allocate a VO chunk from the heap, the heap lock should be held
+ *
+ * @return the hmu allocated, its size may be larger than @size
+ */
+static hmu_t *
+alloc_vo_hmu(gc_heap_t *heap, gc_size_t size)
+{
+    hmu_t *hmu = alloc_hmu_ex(heap, size);
+
+    if (hmu) {
+        bh_assert(hmu_get_size(hmu) >= size);
+        g_total_malloc += hmu_get_size(hmu);
+        hmu_set_ut(hmu, HMU_VO);
+        hmu_unfree_vo(hmu);
+    }
+    return hmu;
+}
+
+/**
+ * Return a VO chunk to the heap and merge it with the adjacent free
+ * chunks, the heap lock should be held
+ */
+static int
+free_vo_hmu(gc_heap_t *heap, hmu_t *hmu)
+{
+    gc_uint8 *base_addr = heap->base_addr;
+    gc_uint8 *end_addr = base_addr + heap->current_size;
+    hmu_t *prev = NULL, *next = NULL;
+    gc_size_t size = hmu_get_size(hmu);
+
+    g_total_free += size;
+
+    heap->total_free_size += size;
+
+    if (!hmu_get_pinuse(hmu)) {
+        prev = (hmu_t *)((char *)hmu - *((int *)hmu - 1));
+
+        if (hmu_is_in_heap(prev, base_addr, end_addr)
+            && hmu_get_ut(prev) == HMU_FC) {
+            size += hmu_get_size(prev);
+            hmu = prev;
+            if (!unlink_hmu(heap, prev))
+                return GC_ERROR;
+        }
+    }
+
+    next = (hmu_t *)((char *)hmu + size);
+    if (hmu_is_in_heap(next, base_addr, end_addr)) {
+        if (hmu_get_ut(next) == HMU_FC) {
+            size += hmu_get_size(next);
+            if (!unlink_hmu(heap, next))
+                return GC_ERROR;
+            next = (hmu_t *)((char *)hmu + size);
+        }
+    }
+
+    if (!gci_add_fc(heap, hmu, size))
+        return GC_ERROR;
+
+    if (hmu_is_in_heap(next, base_addr, end_addr)) {
+        hmu_unmark_pinuse(next);
+    }
+    return GC_SUCCESS;
+}
+
+#if GC_THREAD_CACHE_NUM > 0
+/**
+ * Get the cache of current thread, create it if not found
+ *
+ * @return the cache, or NULL if all caches are owned by other threads
+ */
+static gc_thread_cache_t *
+get_thread_cache(gc_heap_t *heap)
+{
+    gc_thread_cache_owner_t *owner;
+    gc_thread_cache_t *cache = NULL;
+    hmu_t *hmu;
+    gc_size_t size;
+    uint32 i;
+
+    if (!heap->thread_cache_key_created)
+        return NULL;
+
+    /* Only current thread sets its own owner, so no lock is needed to
+       find the cache created before */
+    if ((owner = os_thread_getspecific(&heap->thread_cache_key)))
+        return heap->thread_caches[owner->slot];
+
+    /* The slots are set and cleared with the lock held, check whether one
+       is free before allocating the owner and taking the lock */
+    for (i = 0; i < GC_THREAD_CACHE_NUM; i++) {
+        if (!__atomic_load_n(&heap->thread_caches[i], __ATOMIC_RELAXED))
+            break;
+    }
+
+    if (i == GC_THREAD_CACHE_NUM)
+        return NULL;
+
+    if (!(owner = os_malloc(sizeof(gc_thread_cache_owner_t))))
+        return NULL;
+
+    LOCK_HEAP(heap);
+
+    /* The slot may be taken by another thread in the meantime */
+    for (i = 0; i < GC_THREAD_CACHE_NUM; i++) {
+        if (!heap->thread_caches[i])
+            break;
+    }
+
+    size = GC_ALIGN_8(OBJ_EXTRA_SIZE + sizeof(gc_thread_cache_t));
+    if (i < GC_THREAD_CACHE_NUM && (hmu = alloc_vo_hmu(heap, size))) {
+#if BH_ENABLE_GC_VERIFY != 0
+        hmu_init_prefix_and_suffix(hmu, hmu_get_size(hmu), __FILE__,
+                                   __LINE__);
+#endif
+        owner->heap = heap;
+        owner->slot = i;
+        if (os_thread_setspecific(&heap->thread_cache_key, owner) == BHT_OK) {
+            cache = (gc_thread_cache_t *)hmu_to_obj(hmu);
+            memset(cache, 0, sizeof(gc_thread_cache_t));
+            __atomic_store_n(&heap->thread_caches[i], cache,
+                             __ATOMIC_RELAXED);
+            heap->thread_cache_owners[i] = owner;
+        }
+        else {
+            free_vo_hmu(heap, hmu);
+        }
+    }
+
+    UNLOCK_HEAP(heap);
+
+    if (!cache)
+        os_free(owner);
+    return cache;
+}
+
+/* Note that the hmu header mustn't be modified without the lock, since
+   the pinuse bit of it may be updated when the previous chunk is
+   allocated or freed by other threads */
+static inline void
+thread_cache_push(gc_thread_cache_t *cache, uint32 idx, hmu_t *hmu)
+{
+    *(hmu_t **)hmu_to_obj(hmu) = cache->chunks[idx];
+    cache->chunks[idx] = hmu;
+    cache->chunk_counts[idx]++;
+}
+
+static inline hmu_t *
+thread_cache_pop(gc_thread_cache_t *cache, uint32 idx)
+{
+    hmu_t *hmu = cache->chunks[idx];
+
+    if (hmu) {
+        cache->chunks[idx] = *(hmu_t **)hmu_to_obj(hmu);
+        cache->chunk_counts[idx]--;
+    }
+    return hmu;
+}
+
+/**
+ * Return the chunks of a cache and the cache itself to the heap, and
+ * release the slot, the lock should be held
+ */
+static void
+release_thread_cache(gc_heap_t *heap, uint32 slot)
+{
+    gc_thread_cache_t *cache = heap->thread_caches[slot];
+    hmu_t *hmu;
+    uint32 i;
+
+    for (i = 0; i < HMU_NORMAL_NODE_CNT; i++) {
+        while ((hmu = thread_cache_pop(cache, i)))
+            free_vo_hmu(heap, hmu);
+    }
+
+    /* keep the allocation counts of the cache */
+    for (i = 0; i < GC_SIZE_CLASS_NUM; i++)
+        heap->alloc_counts[i] += cache->alloc_counts[i];
+    heap->free_count += cache->free_count;
+
+    free_vo_hmu(heap, obj_to_hmu(cache));
+    __atomic_store_n(&heap->thread_caches[slot], NULL, __ATOMIC_RELAXED);
+
+    os_free(heap->thread_cache_owners[slot]);
+    heap->thread_cache_owners[slot] = NULL;
+}
+
+/* The destructor of the thread-specific owner, called when the thread
+   exits */
+static void
+thread_cache_owner_destroy(void *data)
+{
+    gc_thread_cache_owner_t *owner = (gc_thread_cache_owner_t *)data;
+    gc_heap_t *heap = owner->heap;
+
+    LOCK_HEAP(heap);
+    release_thread_cache(heap, owner->slot);
+    UNLOCK_HEAP(heap);
+}
+
+void
+gci_init_thread_caches(gc_heap_t *heap)
+{
+    if (os_thread_key_create(&heap->thread_cache_key,
+                             thread_cache_owner_destroy)
+        == BHT_OK)
+        heap->thread_cache_key_created = true;
+}
+
+/* Whether the chunk is in the size class of the cache, the chunks cached
+   aren't marked freed so a double free is told by looking them up */
+static bool
+thread_cache_contains(gc_thread_cache_t *cache, uint32 idx, hmu_t *hmu)
+{
+    hmu_t *cur;
+
+    for (cur = cache->chunks[idx]; cur; cur = *(hmu_t **)hmu_to_obj(cur)) {
+        if (cur == hmu)
+            return true;
+    }
+    return false;
+}
+
+/**
+ * Allocate a small VO chunk from the cache of current thread, refill
+ * the size class in a batch if it is empty
+ *
+ * @param size should be the real size of a normal chunk
+ */
+static hmu_t *
+thread_cache_alloc(gc_heap_t *heap, gc_thread_cache_t *cache, gc_size_t size)
+{
+    uint32 idx = size >> 3, i;
+    hmu_t *hmu, *hmu_more;
+
+    if ((hmu = thread_cache_pop(cache, idx)))
+        return hmu;
+
+    LOCK_HEAP(heap);
+
+    hmu = alloc_vo_hmu(heap, size);
+    for (i = 1; hmu && i < GC_THREAD_CACHE_BATCH_CHUNKS; i++) {
+        if (!(hmu_more = alloc_vo_hmu(heap, size)))
+            break;
+        if (hmu_get_size(hmu_more) != size) {
+            /* the rest of the heap can't be split exactly */
+            free_vo_hmu(heap, hmu_more);
+            break;
+        }
+        thread_cache_push(cache, idx, hmu_more);
+    }
+
+    UNLOCK_HEAP(heap);
+    return hmu;
+}
+
+/**
+ * Put a small VO chunk into the cache of current thread, return half
+ * of the chunks of the size class to the heap if it is full
+ */
+static int
+thread_cache_free(gc_heap_t *heap, gc_thread_cache_t *cache, hmu_t *hmu)
+{
+    uint32 idx = hmu_get_size(hmu) >> 3, i;
+    int ret = GC_SUCCESS;
+
+    if (thread_cache_contains(cache, idx, hmu)) {
+        bh_assert(0);
+        return GC_ERROR;
+    }
+
+    thread_cache_push(cache, idx, hmu);
+
+    if (cache->chunk_counts[idx] <= GC_THREAD_CACHE_MAX_CHUNKS)
+        return GC_SUCCESS;
+
+    LOCK_HEAP(heap);
+    for (i = 0; i < GC_THREAD_CACHE_BATCH_CHUNKS; i++) {
+        hmu = thread_cache_pop(cache, idx);
+        bh_assert(hmu);
+        if (free_vo_hmu(heap, hmu) != GC_SUCCESS) {
+            ret = GC_ERROR;
+            break;
+        }
+    }
+    UNLOCK_HEAP(heap);
+    return ret;
+}
+
+void
+gci_flush_thread_caches(gc_heap_t *heap)
+{
+    uint32 i;
+
+    /* No destructor is called after the key is deleted, except the ones
+       called for the threads alive on some platforms in the meantime */
+    if (heap->thread_cache_key_created) {
+        os_thread_key_delete(&heap->thread_cache_key);
+        heap->thread_cache_key_created = false;
+    }
+
+    for (i = 0; i < GC_THREAD_CACHE_NUM; i++) {
+        if (heap->thread_caches[i])
+            release_thread_cache(heap, i);
+    }
+}
+#endif /* end of GC_THREAD_CACHE_NUM > 0 */
+
+bool
+gci_extend_heap(gc_heap_t *heap, gc_size_t new_size)
+{
+    gc_uint8 *base_addr = heap->base_addr;
+    gc_uint8 *end_addr = base_addr + heap->current_size;
+    hmu_t *cur = (hmu_t *)base_addr, *last = NULL, *hmu;
+    gc_size_t inc_size, size;
+
+    bh_assert(new_size > heap->current_size && !(new_size & 7));
+
+    LOCK_HEAP(heap);
+
+    /* The chunks don't record whether the last one is free, walk
+       through the heap to find it, the heap is seldom extended */
+    while ((gc_uint8 *)cur < end_addr) {
+        last = cur;
+        cur = (hmu_t *)((gc_uint8 *)cur + hmu_get_size(cur));
+    }
+    bh_assert((gc_uint8 *)cur == end_addr);
+
+    inc_size = new_size - heap->current_size;
+
+    if (last && hmu_get_ut(last) == HMU_FC) {
+        /* merge the new region into the last free chunk */
+        if (!unlink_hmu(heap, last)) {
+            UNLOCK_HEAP(heap);
+            return false;
+        }
+        hmu = last;
+        size = hmu_get_size(last) + inc_size;
+    }
+    else {
+        hmu = (hmu_t *)end_addr;
+        size = inc_size;
+        memset(hmu, 0, sizeof(hmu_t));
+        hmu_mark_pinuse(hmu);
+    }
+
+    heap->current_size = new_size;
+    heap->total_free_size += inc_size;
+
+    if (!gci_add_fc(heap, hmu, size)) {
+        UNLOCK_HEAP(heap);
+        return false;
+    }
+
+    UNLOCK_HEAP(heap);
+    return true;
+}
+
 #if BH_ENABLE_GC_VERIFY == 0
 gc_object_t
 gc_alloc_vo(void *vheap, gc_size_t size)
@@ -387,6 +805,9 @@ gc_alloc_vo_internal(void *vheap, gc_size_t size, const char *file, int line)
     hmu_t *hmu = NULL;
     gc_object_t ret = (gc_object_t)NULL;
     gc_size_t tot_size = 0, tot_size_unaligned;
+#if GC_THREAD_CACHE_NUM > 0
+    gc_thread_cache_t *cache;
+#endif
 
     /* hmu header + prefix + obj + suffix */
     tot_size_unaligned = HMU_SIZE + OBJ_PREFIX_SIZE + size + OBJ_SUFFIX_SIZE;
@@ -396,9 +817,23 @@ gc_alloc_vo_internal(void *vheap, gc_size_t size, const char *file, int line)
         /* integer overflow */
         return NULL;
 
-    // os_mutex_lock(&heap->lock);
+#if GC_THREAD_CACHE_NUM > 0
+    if (tot_size < GC_SMALLEST_SIZE)
+        tot_size = GC_SMALLEST_SIZE;
+
+    if (HMU_IS_FC_NORMAL(tot_size) && (cache = get_thread_cache(heap))) {
+        if ((hmu = thread_cache_alloc(heap, cache, tot_size)))
+            GC_CACHE_COUNTER_INC(cache->alloc_counts[get_size_class(size)]);
+    }
+    else
+#endif
+    {
+        LOCK_HEAP(heap);
+        if ((hmu = alloc_vo_hmu(heap, tot_size)))
+            heap->alloc_counts[get_size_class(size)]++;
+        UNLOCK_HEAP(heap);
+    }
 
-    hmu = alloc_hmu_ex(heap, tot_size);
     if (!hmu)
         goto finish;
 
@@ -407,11 +842,6 @@ gc_alloc_vo_internal(void *vheap, gc_size_t size, const char *file, int line)
        the required size, reset it here */
     tot_size = hmu_get_size(hmu);
 
-    g_total_malloc += tot_size;
-
-    hmu_set_ut(hmu, HMU_VO);
-    hmu_unfree_vo(hmu);
-
 #if BH_ENABLE_GC_VERIFY != 0
     hmu_init_prefix_and_suffix(hmu, tot_size, file, line);
 #endif
@@ -422,7 +852,6 @@ gc_alloc_vo_internal(void *vheap, gc_size_t size, const char *file, int line)
         memset((uint8 *)ret + size, 0, tot_size - tot_size_unaligned);
 
 finish:
-    // os_mutex_unlock(&heap->lock);
     return ret;
 }
 
@@ -462,7 +891,7 @@ gc_realloc_vo_internal(void *vheap, void *ptr, gc_size_t size, const char *file,
     base_addr = heap->base_addr;
     end_addr = base_addr + heap->current_size;
 
-    // os_mutex_lock(&heap->lock);
+    LOCK_HEAP(heap);
 
     if (hmu_old) {
         hmu_next = (hmu_t *)((char *)hmu_old + tot_size_old);
@@ -472,10 +901,25 @@ gc_realloc_vo_internal(void *vheap, void *ptr, gc_size_t size, const char *file,
             if (ut == HMU_FC && tot_size <= tot_size_old + tot_size_next) {
                 /* current node and next node meets requirement */
                 if (!unlink_hmu(heap, hmu_next)) {
-                    // os_mutex_unlock(&heap->lock);
+                    UNLOCK_HEAP(heap);
                     return NULL;
                 }
+                if (tot_size_old + tot_size_next - tot_size
+                    < GC_SMALLEST_SIZE) {
+                    /* take the whole next node, and the node after it
+                       now has an in-use previous node */
+                    tot_size = tot_size_old + tot_size_next;
+                    hmu_next = (hmu_t *)((char *)hmu_old + tot_size);
+                    if (hmu_is_in_heap(hmu_next, base_addr, end_addr))
+                        hmu_mark_pinuse(hmu_next);
+                }
                 hmu_set_size(hmu_old, tot_size);
+                g_total_malloc += tot_size - tot_size_old;
+                heap->total_free_size -= tot_size - tot_size_old;
+                if ((heap->current_size - heap->total_free_size)
+                    > heap->highmark_size)
+                    heap->highmark_size =
+                        heap->current_size - heap->total_free_size;
                 memset((char *)hmu_old + tot_size_old, 0,
                        tot_size - tot_size_old);
 #if BH_ENABLE_GC_VERIFY != 0
@@ -485,29 +929,27 @@ gc_realloc_vo_internal(void *vheap, void *ptr, gc_size_t size, const char *file,
                     hmu_next = (hmu_t *)((char *)hmu_old + tot_size);
                     tot_size_next = tot_size_old + tot_size_next - tot_size;
                     if (!gci_add_fc(heap, hmu_next, tot_size_next)) {
-                        // os_mutex_unlock(&heap->lock);
+                        UNLOCK_HEAP(heap);
                         return NULL;
                     }
                     hmu_mark_pinuse(hmu_next);
                 }
-                // os_mutex_unlock(&heap->lock);
+                UNLOCK_HEAP(heap);
                 return obj_old;
             }
         }
     }
 
-    hmu = alloc_hmu_ex(heap, tot_size);
+    if ((hmu = alloc_vo_hmu(heap, tot_size)))
+        heap->alloc_counts[get_size_class(size)]++;
+    UNLOCK_HEAP(heap);
+
     if (!hmu)
         goto finish;
 
-    bh_assert(hmu_get_size(hmu) >= tot_size);
     /* the total size allocated may be larger than
        the required size, reset it here */
     tot_size = hmu_get_size(hmu);
-    g_total_malloc += tot_size;
-
-    hmu_set_ut(hmu, HMU_VO);
-    hmu_unfree_vo(hmu);
 
 #if BH_ENABLE_GC_VERIFY != 0
     hmu_init_prefix_and_suffix(hmu, tot_size, file, line);
@@ -527,8 +969,6 @@ finish:
         }
     }
 
-    // os_mutex_unlock(&heap->lock);
-
     if (ret && obj_old)
         gc_free_vo(vheap, obj_old);
 
@@ -561,11 +1001,10 @@ gc_free_vo_internal(void *vheap, gc_object_t obj, const char *file, int line)
     gc_heap_t *heap = (gc_heap_t *)vheap;
     gc_uint8 *base_addr, *end_addr;
     hmu_t *hmu = NULL;
-    hmu_t *prev = NULL;
-    hmu_t *next = NULL;
-    gc_size_t size = 0;
-    hmu_type_t ut;
     int ret = GC_SUCCESS;
+#if GC_THREAD_CACHE_NUM > 0
+    gc_thread_cache_t *cache;
+#endif
 
     if (!obj) {
         return GC_SUCCESS;
@@ -576,71 +1015,33 @@ gc_free_vo_internal(void *vheap, gc_object_t obj, const char *file, int line)
     base_addr = heap->base_addr;
     end_addr = base_addr + heap->current_size;
 
-    // os_mutex_lock(&heap->lock);
+    if (!hmu_is_in_heap(hmu, base_addr, end_addr))
+        return GC_SUCCESS;
 
-    if (hmu_is_in_heap(hmu, base_addr, end_addr)) {
 #if BH_ENABLE_GC_VERIFY != 0
-        hmu_verify(heap, hmu);
+    hmu_verify(heap, hmu);
 #endif
-        ut = hmu_get_ut(hmu);
-        if (ut == HMU_VO) {
-            if (hmu_is_vo_freed(hmu)) {
-                bh_assert(0);
-                ret = GC_ERROR;
-                goto out;
-            }
-
-            size = hmu_get_size(hmu);
 
-            g_total_free += size;
-
-            heap->total_free_size += size;
-
-            if (!hmu_get_pinuse(hmu)) {
-                prev = (hmu_t *)((char *)hmu - *((int *)hmu - 1));
-
-                if (hmu_is_in_heap(prev, base_addr, end_addr)
-                    && hmu_get_ut(prev) == HMU_FC) {
-                    size += hmu_get_size(prev);
-                    hmu = prev;
-                    if (!unlink_hmu(heap, prev)) {
-                        ret = GC_ERROR;
-                        goto out;
-                    }
-                }
-            }
-
-            next = (hmu_t *)((char *)hmu + size);
-            if (hmu_is_in_heap(next, base_addr, end_addr)) {
-                if (hmu_get_ut(next) == HMU_FC) {
-                    size += hmu_get_size(next);
-                    if (!unlink_hmu(heap, next)) {
-                        ret = GC_ERROR;
-                        goto out;
-                    }
-                    next = (hmu_t *)((char *)hmu + size);
-                }
-            }
+    if (hmu_get_ut(hmu) != HMU_VO)
+        return GC_ERROR;
 
-            if (!gci_add_fc(heap, hmu, size)) {
-                ret = GC_ERROR;
-                goto out;
-            }
+    if (hmu_is_vo_freed(hmu)) {
+        bh_assert(0);
+        return GC_ERROR;
+    }
 
-            if (hmu_is_in_heap(next, base_addr, end_addr)) {
-                hmu_unmark_pinuse(next);
-            }
-        }
-        else {
-            ret = GC_ERROR;
-            goto out;
-        }
-        ret = GC_SUCCESS;
-        goto out;
+#if GC_THREAD_CACHE_NUM > 0
+    if (HMU_IS_FC_NORMAL(hmu_get_size(hmu))
+        && (cache = get_thread_cache(heap))) {
+        GC_CACHE_COUNTER_INC(cache->free_count);
+        return thread_cache_free(heap, cache, hmu);
     }
+#endif
 
-out:
-    // os_mutex_unlock(&heap->lock);
+    LOCK_HEAP(heap);
+    heap->free_count++;
+    ret = free_vo_hmu(heap, hmu);
+    UNLOCK_HEAP(heap);
     return ret;
 }
 
@@ -661,6 +1062,68 @@ gc_get_heap_highmark_size(gc_heap_t *heap)
     return heap->highmark_size;
 }
 
+gc_size_t
+gci_get_largest_free_size(gc_heap_t *heap)
+{
+    hmu_bin_node_t *node;
+    gc_size_t largest = 0;
+    uint32 fl_idx, sl;
+    int32 i;
+
+    LOCK_HEAP(heap);
+
+    if (heap->kfc_bin_fl_bitmap) {
+        /* the largest chunk is in the highest non-empty bin */
+        fl_idx = bit_scan_msb(heap->kfc_bin_fl_bitmap);
+        sl = bit_scan_msb(heap->kfc_bin_sl_bitmap[fl_idx]);
+        node = heap->kfc_bins[fl_idx * HMU_FC_BIN_SL_CNT + sl];
+        for (; node; node = node->next) {
+            if (node->size > largest)
+                largest = node->size;
+        }
+    }
+    else {
+        for (i = HMU_NORMAL_NODE_CNT - 1; i > 0; i--) {
+            if (heap->kfc_normal_list[i].next) {
+                largest = (gc_size_t)i << 3;
+                break;
+            }
+        }
+    }
+
+    UNLOCK_HEAP(heap);
+    return largest;
+}
+
+void
+gc_get_alloc_counts(void *vheap, uint64 *alloc_counts, uint64 *p_free_count)
+{
+    gc_heap_t *heap = (gc_heap_t *)vheap;
+    uint32 i;
+#if GC_THREAD_CACHE_NUM > 0
+    gc_thread_cache_t *cache;
+    uint32 j;
+#endif
+
+    LOCK_HEAP(heap);
+
+    for (i = 0; i < GC_SIZE_CLASS_NUM; i++)
+        alloc_counts[i] = heap->alloc_counts[i];
+    *p_free_count = heap->free_count;
+
+#if GC_THREAD_CACHE_NUM > 0
+    for (i = 0; i < GC_THREAD_CACHE_NUM; i++) {
+        if (!(cache = heap->thread_caches[i]))
+            continue;
+        for (j = 0; j < GC_SIZE_CLASS_NUM; j++)
+            alloc_counts[j] += GC_CACHE_COUNTER_GET(cache->alloc_counts[j]);
+        *p_free_count += GC_CACHE_COUNTER_GET(cache->free_count);
+    }
+#endif
+
+    UNLOCK_HEAP(heap);
+}
+
 void
 gci_dump(gc_heap_t *heap)
 {
@@ -46,8 +46,16 @@ typedef enum {
     GC_STAT_TOTAL = 0,
     GC_STAT_FREE,
     GC_STAT_HIGHMARK,
+    GC_STAT_LARGEST_FREE,
 } GC_STAT_INDEX;
 
+/**
+ * Number of the size classes to count the allocations, class i counts
+ * the requests of size in (2^(i+3), 2^(i+4)], the first class also
+ * counts the smaller ones and the last class also counts the larger ones
+ */
+#define GC_SIZE_CLASS_NUM 16
+
 /**
  * GC initialization from a buffer, which is separated into
  * two parts: the beginning of the buffer is used to create
@@ -73,6 +81,23 @@ gc_init_with_pool(char *buf, gc_size_t buf_size);
 int
 gc_destroy_with_pool(gc_handle_t handle);
 
+#if W2N_ENABLE_THREAD_SAFE_HEAP == 0
+/* The heap can't be migrated while other threads may be allocating from
+   it, so there is no migration for the thread-safe heap */
+/**
+ * Migrate the heap after the buffer was moved (e.g. by realloc) with its
+ * content kept, and extend the heap if the buffer is enlarged
+ *
+ * @param buf the new address of the buffer
+ * @param buf_size the new size of the buffer, it shouldn't be smaller
+ *        than before
+ *
+ * @return the new gc handle if success, NULL otherwise
+ */
+gc_handle_t
+gc_migrate_with_pool(char *buf, gc_size_t buf_size);
+#endif
+
 /**
  * Get Heap Stats
  *
@@ -83,6 +108,22 @@ gc_destroy_with_pool(gc_handle_t handle);
 void *
 gc_heap_stats(void *heap, uint32 *stats, int size);
 
+/**
+ * Get the allocation counts of the heap
+ *
+ * A realloc which moves the object is counted as an allocation of the
+ * new size plus a free of the old object, a realloc done in place isn't
+ * counted. The counts of the thread caches are read without their owner
+ * threads being stopped, so they are approximate if the heap is in use.
+ *
+ * @param heap the heap
+ * @param alloc_counts [out] the allocation counts of each size class,
+ *        with GC_SIZE_CLASS_NUM elements
+ * @param p_free_count [out] the free count
+ */
+void
+gc_get_alloc_counts(void *heap, uint64 *alloc_counts, uint64 *p_free_count);
+
 #if BH_ENABLE_GC_VERIFY == 0
 
 gc_object_t
@@ -116,12 +116,25 @@ hmu_verify(void *vheap, hmu_t *hmu);
 #define hmu_to_obj(hmu) (gc_object_t)(SKIP_OBJ_PREFIX((hmu_t *)(hmu) + 1))
 #define obj_to_hmu(obj) ((hmu_t *)((gc_uint8 *)(obj)-OBJ_PREFIX_SIZE) - 1)
 
+/* In the thread-safe heap, the header of a chunk in use is read without
+   the lock by the thread owning the chunk, while the lock holder may
+   update its pinuse bit when the previous chunk is allocated or freed,
+   so the header is loaded and the pinuse bit is updated atomically */
+#if W2N_ENABLE_THREAD_SAFE_HEAP != 0
+#if !defined(__GNUC__) && !defined(__clang__)
+#error "The thread-safe heap requires the GCC atomic builtins"
+#endif
+#define hmu_header(hmu) __atomic_load_n(&(hmu)->header, __ATOMIC_RELAXED)
+#else
+#define hmu_header(hmu) ((hmu)->header)
+#endif
+
 #define HMU_UT_SIZE 2
 #define HMU_UT_OFFSET 30
 
 /* clang-format off */
 #define hmu_get_ut(hmu) \
-    GETBITS((hmu)->header, HMU_UT_OFFSET, HMU_UT_SIZE)
+    GETBITS(hmu_header(hmu), HMU_UT_OFFSET, HMU_UT_SIZE)
 #define hmu_set_ut(hmu, type) \
     SETBITS((hmu)->header, HMU_UT_OFFSET, HMU_UT_SIZE, type)
 #define hmu_is_ut_valid(tp) \
@@ -131,9 +144,18 @@ hmu_verify(void *vheap, hmu_t *hmu);
 /* P in use bit means the previous chunk is in use */
 #define HMU_P_OFFSET 29
 
+#if W2N_ENABLE_THREAD_SAFE_HEAP != 0
+#define hmu_mark_pinuse(hmu)                                           \
+    (void)__atomic_fetch_or(&(hmu)->header, (uint32)1 << HMU_P_OFFSET, \
+                            __ATOMIC_RELAXED)
+#define hmu_unmark_pinuse(hmu)                                            \
+    (void)__atomic_fetch_and(&(hmu)->header, ~((uint32)1 << HMU_P_OFFSET), \
+                             __ATOMIC_RELAXED)
+#else
 #define hmu_mark_pinuse(hmu) SETBIT((hmu)->header, HMU_P_OFFSET)
 #define hmu_unmark_pinuse(hmu) CLRBIT((hmu)->header, HMU_P_OFFSET)
-#define hmu_get_pinuse(hmu) GETBIT((hmu)->header, HMU_P_OFFSET)
+#endif
+#define hmu_get_pinuse(hmu) GETBIT(hmu_header(hmu), HMU_P_OFFSET)
 
 #define HMU_JO_VT_SIZE 27
 #define HMU_JO_VT_OFFSET 0
@@ -141,7 +163,7 @@ hmu_verify(void *vheap, hmu_t *hmu);
 
 #define hmu_mark_jo(hmu) SETBIT((hmu)->header, HMU_JO_MB_OFFSET)
 #define hmu_unmark_jo(hmu) CLRBIT((hmu)->header, HMU_JO_MB_OFFSET)
-#define hmu_is_jo_marked(hmu) GETBIT((hmu)->header, HMU_JO_MB_OFFSET)
+#define hmu_is_jo_marked(hmu) GETBIT(hmu_header(hmu), HMU_JO_MB_OFFSET)
 
 /**
  * The hmu size is divisible by 8, its lowest 3 bits are 0, so we only
@@ -154,11 +176,11 @@ hmu_verify(void *vheap, hmu_t *hmu);
 
 #define HMU_VO_FB_OFFSET 28
 
-#define hmu_is_vo_freed(hmu) GETBIT((hmu)->header, HMU_VO_FB_OFFSET)
+#define hmu_is_vo_freed(hmu) GETBIT(hmu_header(hmu), HMU_VO_FB_OFFSET)
 #define hmu_unfree_vo(hmu) CLRBIT((hmu)->header, HMU_VO_FB_OFFSET)
 
 #define hmu_get_size(hmu) \
-    (GETBITS((hmu)->header, HMU_SIZE_OFFSET, HMU_SIZE_SIZE) << 3)
+    (GETBITS(hmu_header(hmu), HMU_SIZE_OFFSET, HMU_SIZE_SIZE) << 3)
 #define hmu_set_size(hmu, size) \
     SETBITS((hmu)->header, HMU_SIZE_OFFSET, HMU_SIZE_SIZE, ((size) >> 3))
 
@@ -205,10 +227,37 @@ set_hmu_normal_node_next(hmu_normal_node_t *node, hmu_normal_node_t *next)
 }
 
 /**
- * Define hmu_tree_node as a packed struct, since it is at the 4-byte
+ * The free chunks not smaller than HMU_FC_NORMAL_MAX_SIZE are kept in
+ * segregated bins: the first level is the index of the highest bit of
+ * the chunk size, and each first level range [2^fl, 2^(fl+1)) is split
+ * into HMU_FC_BIN_SL_CNT second level bins of equal width. A bitmap of
+ * non-empty bins is kept for each level so that a bin whose chunks all
+ * meet the request can be found in O(1).
+ */
+#ifndef HMU_FC_BIN_SL_SHIFT
+#define HMU_FC_BIN_SL_SHIFT 2
+#endif
+#define HMU_FC_BIN_SL_CNT (1 << HMU_FC_BIN_SL_SHIFT)
+/* The highest bit of the smallest big free chunk */
+#ifndef HMU_FC_BIN_FL_MIN
+#define HMU_FC_BIN_FL_MIN 7
+#endif
+/* The highest bit of the largest hmu size, see HMU_SIZE_SIZE */
+#define HMU_FC_BIN_FL_MAX 29
+#define HMU_FC_BIN_FL_CNT (HMU_FC_BIN_FL_MAX - HMU_FC_BIN_FL_MIN + 1)
+#define HMU_FC_BIN_CNT (HMU_FC_BIN_FL_CNT * HMU_FC_BIN_SL_CNT)
+#if HMU_FC_NORMAL_MAX_SIZE < (1 << HMU_FC_BIN_FL_MIN)
+#error "Too large HMU_FC_BIN_FL_MIN"
+#endif
+#if HMU_FC_BIN_FL_MIN <= HMU_FC_BIN_SL_SHIFT
+#error "Too large HMU_FC_BIN_SL_SHIFT"
+#endif
+
+/**
+ * Define hmu_bin_node as a packed struct, since it is at the 4-byte
  * aligned address and the size of hmu_head is 4, so in 64-bit target,
- * the left/right/parent fields will be at 8-byte aligned address,
- * we can access them directly.
+ * the prev/next fields will be at 8-byte aligned address, we can
+ * access them directly.
  */
 #if UINTPTR_MAX == UINT64_MAX
 #if defined(_MSC_VER)
@@ -219,20 +268,19 @@ __pragma(pack(push, 1));
 #define __attr_packed __attribute__((packed))
 #define __attr_aligned(a) __attribute__((aligned(a)))
 #else
-#error "packed attribute isn't used to define struct hmu_tree_node"
+#error "packed attribute isn't used to define struct hmu_bin_node"
 #endif
 #else /* else of UINTPTR_MAX == UINT64_MAX */
 #define __attr_packed
 #define __attr_aligned(a)
 #endif
 
-typedef struct hmu_tree_node {
+typedef struct hmu_bin_node {
     hmu_t hmu_header;
-    struct hmu_tree_node *left;
-    struct hmu_tree_node *right;
-    struct hmu_tree_node *parent;
+    struct hmu_bin_node *prev;
+    struct hmu_bin_node *next;
     gc_size_t size;
-} __attr_packed __attr_aligned(4) hmu_tree_node_t;
+} __attr_packed __attr_aligned(4) hmu_bin_node_t;
 
 #if UINTPTR_MAX == UINT64_MAX
 #if defined(_MSC_VER)
@@ -240,15 +288,73 @@ __pragma(pack(pop));
 #endif
 #endif
 
-bh_static_assert(sizeof(hmu_tree_node_t) == 8 + 3 * sizeof(void *));
-bh_static_assert(offsetof(hmu_tree_node_t, left) == 4);
+bh_static_assert(sizeof(hmu_bin_node_t) == 8 + 2 * sizeof(void *));
+bh_static_assert(offsetof(hmu_bin_node_t, prev) == 4);
 
-#define ASSERT_TREE_NODE_ALIGNED_ACCESS(tree_node)                          \
+#define ASSERT_BIN_NODE_ALIGNED_ACCESS(bin_node)                            \
     do {                                                                    \
-        bh_assert((((uintptr_t)&tree_node->left) & (sizeof(uintptr_t) - 1)) \
+        bh_assert((((uintptr_t)&bin_node->prev) & (sizeof(uintptr_t) - 1)) \
                   == 0);                                                    \
     } while (0)
 
+/**
+ * Per-thread small-object caches of the thread-safe heap
+ */
+
+#if W2N_ENABLE_THREAD_SAFE_HEAP != 0
+/* Max number of threads which own a cache, the threads beyond it
+   allocate from the heap with the lock held directly */
+#ifndef GC_THREAD_CACHE_NUM
+#define GC_THREAD_CACHE_NUM 8
+#endif
+#else
+#undef GC_THREAD_CACHE_NUM
+#define GC_THREAD_CACHE_NUM 0
+#endif
+
+#if GC_THREAD_CACHE_NUM > 0
+/* Max number of chunks cached for each size class */
+#ifndef GC_THREAD_CACHE_MAX_CHUNKS
+#define GC_THREAD_CACHE_MAX_CHUNKS 32
+#endif
+/* Number of chunks allocated from the heap in a batch when the size class
+   of the cache is empty, and returned to the heap when it is full */
+#ifndef GC_THREAD_CACHE_BATCH_CHUNKS
+#define GC_THREAD_CACHE_BATCH_CHUNKS 16
+#endif
+
+/**
+ * The chunks cached are still HMU_VO chunks in the view of the heap,
+ * they are linked in a list of each size class (the same as
+ * kfc_normal_list), with the next pointer stored in the object body.
+ */
+typedef struct gc_thread_cache {
+    hmu_t *chunks[HMU_NORMAL_NODE_CNT];
+    gc_uint32 chunk_counts[HMU_NORMAL_NODE_CNT];
+    /* allocation counts of the requests served by the cache, updated by
+       the owner only and read by the other threads atomically */
+    uint64 alloc_counts[GC_SIZE_CLASS_NUM];
+    uint64 free_count;
+} gc_thread_cache_t;
+
+/* Only the owner of the cache increases the counters, so a store after
+   the load is enough */
+#define GC_CACHE_COUNTER_INC(v) \
+    __atomic_store_n(&(v), __atomic_load_n(&(v), __ATOMIC_RELAXED) + 1, \
+                     __ATOMIC_RELAXED)
+#define GC_CACHE_COUNTER_GET(v) __atomic_load_n(&(v), __ATOMIC_RELAXED)
+
+/**
+ * The thread-specific data of the thread owning a cache, it is allocated
+ * outside of the heap, and the cache is returned to the heap when the
+ * thread exits.
+ */
+typedef struct gc_thread_cache_owner {
+    struct gc_heap_struct *heap;
+    uint32 slot;
+} gc_thread_cache_owner_t;
+#endif /* end of GC_THREAD_CACHE_NUM > 0 */
+
 typedef struct gc_heap_struct {
     /* for double checking*/
     gc_handle_t heap_id;
@@ -256,24 +362,38 @@ typedef struct gc_heap_struct {
     gc_uint8 *base_addr;
     gc_size_t current_size;
 
-    // korp_mutex lock;
-
     hmu_normal_list_t kfc_normal_list[HMU_NORMAL_NODE_CNT];
 
-#if UINTPTR_MAX == UINT64_MAX
-    /* make kfc_tree_root_buf 4-byte aligned and not 8-byte aligned,
-       so kfc_tree_root's left/right/parent fields are 8-byte aligned
-       and we can access them directly */
-    uint32 __padding;
-#endif
-    uint8 kfc_tree_root_buf[sizeof(hmu_tree_node_t)];
-    /* point to kfc_tree_root_buf, the order in kfc_tree is:
-         size[left] <= size[cur] < size[right] */
-    hmu_tree_node_t *kfc_tree_root;
+    /* bit fl is set if any bin of first level fl is non-empty */
+    gc_uint32 kfc_bin_fl_bitmap;
+    /* bit sl of [fl] is set if bin (fl, sl) is non-empty */
+    gc_uint32 kfc_bin_sl_bitmap[HMU_FC_BIN_FL_CNT];
+    /* the head of the doubly linked list of each bin */
+    hmu_bin_node_t *kfc_bins[HMU_FC_BIN_CNT];
 
     gc_size_t init_size;
     gc_size_t highmark_size;
     gc_size_t total_free_size;
+
+    /* allocation counts of the requests served with the lock held */
+    uint64 alloc_counts[GC_SIZE_CLASS_NUM];
+    uint64 free_count;
+
+#if W2N_ENABLE_THREAD_SAFE_HEAP != 0
+    korp_mutex lock;
+#endif
+
+#if GC_THREAD_CACHE_NUM > 0
+    /* The key of the thread-specific owner of the caches, the caches
+       are disabled if it fails to be created */
+    korp_key thread_cache_key;
+    bool thread_cache_key_created;
+    /* The caches are created and released with the lock held, and each
+       is only accessed by its owner thread without the lock, a slot
+       released is NULL and may be reused */
+    gc_thread_cache_owner_t *thread_cache_owners[GC_THREAD_CACHE_NUM];
+    gc_thread_cache_t *thread_caches[GC_THREAD_CACHE_NUM];
+#endif
 } gc_heap_t;
 
 /**
@@ -283,9 +403,38 @@ typedef struct gc_heap_struct {
 bool
 gci_add_fc(gc_heap_t *heap, hmu_t *hmu, gc_size_t size);
 
+/**
+ * Extend the heap to new_size, the memory after the current end of the
+ * heap should be available, it is added to the heap as a free chunk
+ * (merged with the last chunk if it is free)
+ */
+bool
+gci_extend_heap(gc_heap_t *heap, gc_size_t new_size);
+
 int
 gci_is_heap_valid(gc_heap_t *heap);
 
+/**
+ * Get the size of the largest free chunk of the heap
+ */
+gc_size_t
+gci_get_largest_free_size(gc_heap_t *heap);
+
+#if GC_THREAD_CACHE_NUM > 0
+/**
+ * Create the key of the thread-specific owner of the caches
+ */
+void
+gci_init_thread_caches(gc_heap_t *heap);
+
+/**
+ * Return the chunks cached by all threads to the heap, it is called
+ * when the heap is destroyed and no other thread is accessing it
+ */
+void
+gci_flush_thread_caches(gc_heap_t *heap);
+#endif
+
 /**
  * Verify heap integrity
  */
@@ -8,14 +8,12 @@
 static gc_handle_t
 gc_init_internal(gc_heap_t *heap, char *base_addr, gc_size_t heap_max_size)
 {
-    hmu_tree_node_t *root = NULL, *q = NULL;
-    //int ret;
+    hmu_bin_node_t *q = NULL;
 
     memset(heap, 0, sizeof *heap);
 
-#if 0
-    ret = os_mutex_init(&heap->lock);
-    if (ret != BHT_OK) {
+#if W2N_ENABLE_THREAD_SAFE_HEAP != 0
+    if (os_mutex_init(&heap->lock) != BHT_OK) {
         os_printf("[GC_ERROR]failed to init lock\n");
         return NULL;
     }
@@ -29,26 +27,18 @@ gc_init_internal(gc_heap_t *heap, char *base_addr, gc_size_t heap_max_size)
     heap->total_free_size = heap->current_size;
     heap->highmark_size = 0;
 
-    root = heap->kfc_tree_root = (hmu_tree_node_t *)heap->kfc_tree_root_buf;
-    memset(root, 0, sizeof *root);
-    root->size = sizeof *root;
-    hmu_set_ut(&root->hmu_header, HMU_FC);
-    hmu_set_size(&root->hmu_header, sizeof *root);
-
-    q = (hmu_tree_node_t *)heap->base_addr;
+    q = (hmu_bin_node_t *)heap->base_addr;
     memset(q, 0, sizeof *q);
-    hmu_set_ut(&q->hmu_header, HMU_FC);
-    hmu_set_size(&q->hmu_header, heap->current_size);
-
-    ASSERT_TREE_NODE_ALIGNED_ACCESS(q);
-    ASSERT_TREE_NODE_ALIGNED_ACCESS(root);
+    ASSERT_BIN_NODE_ALIGNED_ACCESS(q);
 
+    /* the whole pool is a big free chunk at first */
     hmu_mark_pinuse(&q->hmu_header);
-    root->right = q;
-    q->parent = root;
-    q->size = heap->current_size;
+    if (!gci_add_fc(heap, &q->hmu_header, heap->current_size))
+        return NULL;
 
-    bh_assert(root->size <= HMU_FC_NORMAL_MAX_SIZE);
+#if GC_THREAD_CACHE_NUM > 0
+    gci_init_thread_caches(heap);
+#endif
 
     return heap;
 }
@@ -62,9 +52,10 @@ gc_init_with_pool(char *buf, gc_size_t buf_size)
     gc_heap_t *heap = (gc_heap_t *)buf_aligned;
     gc_size_t heap_max_size;
 
-    if (buf_size < APP_HEAP_SIZE_MIN) {
+    /* the heap structure also resides in the buffer */
+    if (buf_size < sizeof(gc_heap_t) + APP_HEAP_SIZE_MIN) {
         os_printf("[GC_ERROR]heap init buf size (%" PRIu32 ") < %" PRIu32 "\n",
-                  buf_size, (uint32)APP_HEAP_SIZE_MIN);
+                  buf_size, (uint32)(sizeof(gc_heap_t) + APP_HEAP_SIZE_MIN));
         return NULL;
     }
 
@@ -82,12 +73,72 @@ gc_init_with_pool(char *buf, gc_size_t buf_size)
     return gc_init_internal(heap, base_addr, heap_max_size);
 }
 
+#if W2N_ENABLE_THREAD_SAFE_HEAP == 0
+#define ADJUST_PTR(p, offset) \
+    ((p) ? (void *)((gc_uint8 *)(p) + (offset)) : NULL)
+
+gc_handle_t
+gc_migrate_with_pool(char *buf, gc_size_t buf_size)
+{
+    char *buf_end = buf + buf_size;
+    char *buf_aligned = (char *)(((uintptr_t)buf + 7) & (uintptr_t)~7);
+    gc_heap_t *heap = (gc_heap_t *)buf_aligned;
+    hmu_bin_node_t *node;
+    intptr_t offset;
+    gc_size_t heap_max_size;
+    uint32 i;
+
+    if (buf_size < sizeof(gc_heap_t) + APP_HEAP_SIZE_MIN || !heap->heap_id) {
+        os_printf("[GC_ERROR]invalid heap to migrate\n");
+        return NULL;
+    }
+
+    /* heap_id still records the old address of the heap structure */
+    offset = (gc_uint8 *)heap - (gc_uint8 *)heap->heap_id;
+
+    if (offset != 0) {
+        heap->heap_id = (gc_handle_t)heap;
+        heap->base_addr += offset;
+
+        /* the next node of normal list is stored as relative offset,
+           only the list heads need to be adjusted */
+        for (i = 0; i < HMU_NORMAL_NODE_CNT; i++)
+            heap->kfc_normal_list[i].next =
+                ADJUST_PTR(heap->kfc_normal_list[i].next, offset);
+
+        for (i = 0; i < HMU_FC_BIN_CNT; i++) {
+            heap->kfc_bins[i] = ADJUST_PTR(heap->kfc_bins[i], offset);
+            for (node = heap->kfc_bins[i]; node; node = node->next) {
+                node->prev = ADJUST_PTR(node->prev, offset);
+                node->next = ADJUST_PTR(node->next, offset);
+            }
+        }
+    }
+
+    heap_max_size = (uint32)(buf_end - (char *)heap->base_addr) & (uint32)~7;
+    if (heap_max_size < heap->current_size) {
+        os_printf("[GC_ERROR]heap can't be shrunk\n");
+        return NULL;
+    }
+
+    if (heap_max_size > heap->current_size
+        && !gci_extend_heap(heap, heap_max_size))
+        return NULL;
+
+    return heap;
+}
+#endif /* end of W2N_ENABLE_THREAD_SAFE_HEAP == 0 */
+
 int
 gc_destroy_with_pool(gc_handle_t handle)
 {
     gc_heap_t *heap = (gc_heap_t *)handle;
     int ret = GC_SUCCESS;
 
+#if GC_THREAD_CACHE_NUM > 0
+    gci_flush_thread_caches(heap);
+#endif
+
 #if BH_ENABLE_GC_VERIFY != 0
     hmu_t *cur = (hmu_t *)heap->base_addr;
     hmu_t *end = (hmu_t *)((char *)heap->base_addr + heap->current_size);
@@ -99,7 +150,9 @@ gc_destroy_with_pool(gc_handle_t handle)
     }
 #endif
 
-    // os_mutex_destroy(&heap->lock);
+#if W2N_ENABLE_THREAD_SAFE_HEAP != 0
+    os_mutex_destroy(&heap->lock);
+#endif
     memset(heap, 0, sizeof(gc_heap_t));
     return ret;
 }
@@ -138,6 +191,9 @@ gc_heap_stats(void *heap_arg, uint32 *stats, int size)
             case GC_STAT_HIGHMARK:
                 stats[i] = heap->highmark_size;
                 break;
+            case GC_STAT_LARGEST_FREE:
+                stats[i] = gci_get_largest_free_size(heap);
+                break;
             default:
                 break;
         }
@@ -4,7 +4,10 @@
  */
 
 #include "mem_alloc.h"
-#include "ems/ems_gc.h"
+#include "ems/ems_gc_internal.h"
+
+bh_static_assert(MEM_ALLOC_SIZE_CLASS_NUM == GC_SIZE_CLASS_NUM);
+bh_static_assert(MEM_ALLOC_CHUNK_EXTRA_SIZE >= OBJ_EXTRA_SIZE + 7);
 
 mem_allocator_t
 mem_allocator_create(void *mem, uint32 size)
@@ -12,6 +15,14 @@ mem_allocator_create(void *mem, uint32 size)
     return gc_init_with_pool((char *)mem, size);
 }
 
+#if W2N_ENABLE_THREAD_SAFE_HEAP == 0
+mem_allocator_t
+mem_allocator_migrate(void *mem, uint32 size)
+{
+    return gc_migrate_with_pool((char *)mem, size);
+}
+#endif
+
 int
 mem_allocator_destroy(mem_allocator_t allocator)
 {
@@ -36,3 +47,24 @@ mem_allocator_free(mem_allocator_t allocator, void *ptr)
     if (ptr)
         gc_free_vo((gc_handle_t)allocator, ptr);
 }
+
+bool
+mem_allocator_get_alloc_info(mem_allocator_t allocator,
+                             mem_alloc_info_t *mem_alloc_info)
+{
+    uint32 stats[GC_STAT_LARGEST_FREE + 1];
+    uint32 i;
+
+    gc_heap_stats((gc_handle_t)allocator, stats, GC_STAT_LARGEST_FREE + 1);
+    mem_alloc_info->total_size = stats[GC_STAT_TOTAL];
+    mem_alloc_info->total_free_size = stats[GC_STAT_FREE];
+    mem_alloc_info->highmark_size = stats[GC_STAT_HIGHMARK];
+    mem_alloc_info->largest_free_size = stats[GC_STAT_LARGEST_FREE];
+
+    gc_get_alloc_counts((gc_handle_t)allocator, mem_alloc_info->alloc_counts,
+                        &mem_alloc_info->free_count);
+    mem_alloc_info->alloc_count = 0;
+    for (i = 0; i < MEM_ALLOC_SIZE_CLASS_NUM; i++)
+        mem_alloc_info->alloc_count += mem_alloc_info->alloc_counts[i];
+    return true;
+}
@@ -10,6 +10,10 @@ if (W2N_BUILD_GC_VERIFY EQUAL 1)
     add_definitions (-DBH_ENABLE_GC_VERIFY=1)
 endif ()
 
+if (W2N_BUILD_THREAD_SAFE_HEAP EQUAL 1)
+    add_definitions (-DW2N_ENABLE_THREAD_SAFE_HEAP=1)
+endif ()
+
 file (GLOB_RECURSE source_all
       ${MEM_ALLOC_DIR}/ems/*.c
       ${MEM_ALLOC_DIR}/tlsf/*.c
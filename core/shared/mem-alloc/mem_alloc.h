@@ -14,9 +14,44 @@ extern "C" {
 
 typedef void *mem_allocator_t;
 
+/* Max bytes a chunk takes besides the object allocated, i.e. the chunk
+   header, the prefix and suffix of the verify mode, and the padding to
+   align the chunk size */
+#define MEM_ALLOC_CHUNK_EXTRA_SIZE 56
+
+/* Number of the size classes of mem_alloc_info_t::alloc_counts */
+#define MEM_ALLOC_SIZE_CLASS_NUM 16
+
+typedef struct mem_alloc_info_t {
+    uint32 total_size;
+    uint32 total_free_size;
+    uint32 highmark_size;
+    uint32 largest_free_size;
+    uint64 alloc_count;
+    uint64 free_count;
+    /* allocation count of the requests of size in (2^(i+3), 2^(i+4)],
+       the first class also counts the smaller ones and the last class
+       also counts the larger ones */
+    uint64 alloc_counts[MEM_ALLOC_SIZE_CLASS_NUM];
+} mem_alloc_info_t;
+
 mem_allocator_t
 mem_allocator_create(void *mem, uint32 size);
 
+#if W2N_ENABLE_THREAD_SAFE_HEAP == 0
+/**
+ * Migrate the allocator after its memory was moved with the content
+ * kept (e.g. by realloc), and enlarge it to the new size if the memory
+ * is enlarged. It isn't provided by the thread-safe heap, as the other
+ * threads may be allocating from the memory being moved, so an object
+ * file emitted with a growable host managed heap fails to link with it.
+ *
+ * @return the new allocator if success, NULL otherwise
+ */
+mem_allocator_t
+mem_allocator_migrate(void *mem, uint32 size);
+#endif
+
 int
 mem_allocator_destroy(mem_allocator_t allocator);
 
@@ -29,6 +64,10 @@ mem_allocator_realloc(mem_allocator_t allocator, void *ptr, uint32 size);
 void
 mem_allocator_free(mem_allocator_t allocator, void *ptr);
 
+bool
+mem_allocator_get_alloc_info(mem_allocator_t allocator,
+                             mem_alloc_info_t *mem_alloc_info);
+
 #ifdef __cplusplus
 }
 #endif
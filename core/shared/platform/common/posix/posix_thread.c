@@ -144,6 +144,34 @@ os_mutex_unlock(korp_mutex *mutex)
     return ret == 0 ? BHT_OK : BHT_ERROR;
 }
 
+int
+os_thread_key_create(korp_key *key, void (*destructor)(void *))
+{
+    assert(key);
+    return pthread_key_create(key, destructor) == 0 ? BHT_OK : BHT_ERROR;
+}
+
+int
+os_thread_key_delete(korp_key *key)
+{
+    assert(key);
+    return pthread_key_delete(*key) == 0 ? BHT_OK : BHT_ERROR;
+}
+
+void *
+os_thread_getspecific(korp_key *key)
+{
+    assert(key);
+    return pthread_getspecific(*key);
+}
+
+int
+os_thread_setspecific(korp_key *key, void *value)
+{
+    assert(key);
+    return pthread_setspecific(*key, value) == 0 ? BHT_OK : BHT_ERROR;
+}
+
 int
 os_cond_init(korp_cond *cond)
 {
@@ -53,6 +53,7 @@ extern "C" {
 
 typedef pthread_t korp_tid;
 typedef pthread_mutex_t korp_mutex;
+typedef pthread_key_t korp_key;
 typedef pthread_cond_t korp_cond;
 typedef pthread_t korp_thread;
 
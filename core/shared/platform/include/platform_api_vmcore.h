@@ -78,6 +78,29 @@ os_mutex_lock(korp_mutex *mutex);
 int
 os_mutex_unlock(korp_mutex *mutex);
 
+/**
+ ************** thread-specific data APIs ***********
+ *  vmcore:  Required by the thread-safe heap
+ */
+
+/**
+ * Create a key of the thread-specific data, the destructor is called
+ * with the value of a thread when the thread exits if it isn't NULL.
+ * On some platforms the destructor is also called for the values
+ * of all threads when the key is deleted.
+ */
+int
+os_thread_key_create(korp_key *key, void (*destructor)(void *));
+
+int
+os_thread_key_delete(korp_key *key);
+
+void *
+os_thread_getspecific(korp_key *key);
+
+int
+os_thread_setspecific(korp_key *key, void *value);
+
 #ifdef __cplusplus
 }
 #endif
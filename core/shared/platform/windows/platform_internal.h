@@ -57,6 +57,13 @@ typedef void *korp_thread;
 typedef void *korp_tid;
 typedef void *korp_mutex;
 
+/* The FLS callback only gets the value, so the value of each thread is
+   wrapped together with the destructor */
+typedef struct korp_key {
+    DWORD index;
+    void (*destructor)(void *);
+} korp_key;
+
 /**
  * Create the mutex when os_mutex_lock is called, and no need to
  * CloseHandle() for the static lock's lifetime, since
@@ -537,6 +537,79 @@ os_mutex_unlock(korp_mutex *mutex)
     return ReleaseMutex(*mutex) ? BHT_OK : BHT_ERROR;
 }
 
+/* The value of a thread set with os_thread_setspecific */
+typedef struct os_thread_key_value {
+    void (*destructor)(void *);
+    void *value;
+} os_thread_key_value;
+
+static VOID WINAPI
+os_thread_key_callback(PVOID data)
+{
+    os_thread_key_value *key_value = (os_thread_key_value *)data;
+
+    if (!key_value)
+        return;
+    if (key_value->value && key_value->destructor)
+        key_value->destructor(key_value->value);
+    BH_FREE(key_value);
+}
+
+int
+os_thread_key_create(korp_key *key, void (*destructor)(void *))
+{
+    bh_assert(key);
+    /* Unlike TLS, the FLS callback is called when the thread exits */
+    if ((key->index = FlsAlloc(os_thread_key_callback)) == FLS_OUT_OF_INDEXES)
+        return BHT_ERROR;
+    key->destructor = destructor;
+    return BHT_OK;
+}
+
+int
+os_thread_key_delete(korp_key *key)
+{
+    bh_assert(key);
+    /* The callback is also called for the values of all threads */
+    return FlsFree(key->index) ? BHT_OK : BHT_ERROR;
+}
+
+void *
+os_thread_getspecific(korp_key *key)
+{
+    os_thread_key_value *key_value;
+
+    bh_assert(key);
+    key_value = (os_thread_key_value *)FlsGetValue(key->index);
+    return key_value ? key_value->value : NULL;
+}
+
+int
+os_thread_setspecific(korp_key *key, void *value)
+{
+    os_thread_key_value *key_value;
+
+    bh_assert(key);
+    if ((key_value = (os_thread_key_value *)FlsGetValue(key->index))) {
+        key_value->value = value;
+        return BHT_OK;
+    }
+
+    if (!value)
+        return BHT_OK;
+
+    if (!(key_value = BH_MALLOC(sizeof(os_thread_key_value))))
+        return BHT_ERROR;
+    key_value->destructor = key->destructor;
+    key_value->value = value;
+
+    if (!FlsSetValue(key->index, key_value)) {
+        BH_FREE(key_value);
+        return BHT_ERROR;
+    }
+    return BHT_OK;
+}
+
 int
 os_cond_init(korp_cond *cond)
 {
@@ -6,6 +6,8 @@
 #include <io.h>
 #else
 #include <unistd.h>
+#include <errno.h>
+#include <sys/mman.h>
 #endif
 
 #if defined(_WIN32) || defined(_WIN32_)
@@ -109,3 +111,206 @@ bh_read_file_to_buffer(const char *filename, uint32 *ret_size)
     return buffer;
 }
 #endif /* end of defined(_WIN32) || defined(_WIN32_) */
+
+/* Size of each read from a stream */
+#define STREAM_READ_SIZE (1024 * 1024)
+/* Address space reserved for a stream on 32-bit hosts */
+#define STREAM_RESERVE_SIZE_32 (1024 * 1024 * 1024)
+
+#if defined(_WIN32) || defined(_WIN32_)
+char *
+bh_map_file(const char *filename, uint32 *ret_size)
+{
+    return bh_read_file_to_buffer(filename, ret_size);
+}
+
+char *
+bh_read_stream_to_buffer(int fd, uint32 *ret_size)
+{
+    char *buffer = NULL, *new_buffer;
+    uint32 size = 0, buf_size = 0;
+    int read_size;
+
+    if (!ret_size) {
+        printf("Read stream to buffer failed: invalid ret size.\n");
+        return NULL;
+    }
+
+    _setmode(fd, _O_BINARY);
+
+    while (true) {
+        if (size == buf_size) {
+            if (buf_size > UINT32_MAX / 2) {
+                printf("Read stream to buffer failed: stream too large.\n");
+                goto fail;
+            }
+            buf_size = buf_size > 0 ? buf_size * 2 : STREAM_READ_SIZE;
+            if (!(new_buffer = os_realloc(buffer, buf_size))) {
+                printf("Read stream to buffer failed: alloc memory failed.\n");
+                goto fail;
+            }
+            buffer = new_buffer;
+        }
+
+        read_size = _read(fd, buffer + size, buf_size - size);
+        if (read_size < 0) {
+            printf("Read stream to buffer failed: read stream failed.\n");
+            goto fail;
+        }
+        if (read_size == 0)
+            break;
+        size += (uint32)read_size;
+    }
+
+    *ret_size = size;
+    return buffer;
+fail:
+    if (buffer)
+        BH_FREE(buffer);
+    return NULL;
+}
+
+void
+bh_unmap_file(char *buffer, uint32 size)
+{
+    (void)size;
+    BH_FREE(buffer);
+}
+#else  /* else of defined(_WIN32) || defined(_WIN32_) */
+char *
+bh_map_file(const char *filename, uint32 *ret_size)
+{
+    char *buffer;
+    int file;
+    uint32 file_size;
+    struct stat stat_buf;
+
+    if (!filename || !ret_size) {
+        printf("Map file failed: invalid filename or ret size.\n");
+        return NULL;
+    }
+
+    if ((file = open(filename, O_RDONLY, 0)) == -1) {
+        printf("Map file failed: open file %s failed.\n", filename);
+        return NULL;
+    }
+
+    if (fstat(file, &stat_buf) != 0) {
+        printf("Map file failed: fstat file %s failed.\n", filename);
+        close(file);
+        return NULL;
+    }
+
+    if (stat_buf.st_size == 0) {
+        /* An empty file can't be mapped */
+        close(file);
+        return bh_read_file_to_buffer(filename, ret_size);
+    }
+
+    if ((uint64)stat_buf.st_size > UINT32_MAX) {
+        printf("Map file failed: file %s is too large.\n", filename);
+        close(file);
+        return NULL;
+    }
+
+    file_size = (uint32)stat_buf.st_size;
+
+    /* The mapping is private and writable since the loader patches the
+       bytecode in place, only the patched pages are copied and the others
+       are backed by the file */
+    buffer = mmap(NULL, file_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, file,
+                  0);
+    close(file);
+
+    if (buffer == MAP_FAILED) {
+        printf("Map file failed: mmap file %s failed.\n", filename);
+        return NULL;
+    }
+
+    *ret_size = file_size;
+    return buffer;
+}
+
+char *
+bh_read_stream_to_buffer(int fd, uint32 *ret_size)
+{
+    char *buffer;
+    uint64 reserve_size =
+        sizeof(void *) == sizeof(uint64) ? UINT32_MAX : STREAM_RESERVE_SIZE_32;
+    uint64 size = 0, used_size, page_size;
+    ssize_t read_size;
+    int map_flags = MAP_PRIVATE | MAP_ANONYMOUS;
+
+    if (!ret_size) {
+        printf("Read stream to buffer failed: invalid ret size.\n");
+        return NULL;
+    }
+
+#ifdef MAP_NORESERVE
+    map_flags |= MAP_NORESERVE;
+#endif
+    /* Reserve the address space of the largest module, the pages are only
+       allocated when the stream content is read into them, and the content
+       is never moved or copied while the stream grows */
+    buffer = mmap(NULL, (size_t)reserve_size, PROT_READ | PROT_WRITE,
+                  map_flags, -1, 0);
+    if (buffer == MAP_FAILED) {
+        printf("Read stream to buffer failed: mmap failed.\n");
+        return NULL;
+    }
+
+    while (size < reserve_size) {
+        read_size = read(fd, buffer + size,
+                         (size_t)(reserve_size - size < STREAM_READ_SIZE
+                                      ? reserve_size - size
+                                      : STREAM_READ_SIZE));
+        if (read_size < 0) {
+            if (errno == EINTR)
+                continue;
+            printf("Read stream to buffer failed: read stream failed.\n");
+            munmap(buffer, (size_t)reserve_size);
+            return NULL;
+        }
+        if (read_size == 0)
+            break;
+        size += (uint64)read_size;
+    }
+
+    if (size == reserve_size) {
+        printf("Read stream to buffer failed: stream too large.\n");
+        munmap(buffer, (size_t)reserve_size);
+        return NULL;
+    }
+
+    if (size == 0) {
+        munmap(buffer, (size_t)reserve_size);
+        /* At lease alloc 1 byte like bh_read_file_to_buffer, it is freed
+           by bh_unmap_file with size 0 */
+        if (!(buffer = BH_MALLOC(1))) {
+            printf("Read stream to buffer failed: alloc memory failed.\n");
+            return NULL;
+        }
+        *ret_size = 0;
+        return buffer;
+    }
+
+    /* Release the address space which isn't used, so that the buffer can
+       be unmapped by bh_unmap_file with its size */
+    page_size = (uint64)getpagesize();
+    used_size = (size + page_size - 1) & ~(page_size - 1);
+    if (used_size < reserve_size)
+        munmap(buffer + used_size, (size_t)(reserve_size - used_size));
+
+    *ret_size = (uint32)size;
+    return buffer;
+}
+
+void
+bh_unmap_file(char *buffer, uint32 size)
+{
+    if (size == 0)
+        BH_FREE(buffer);
+    else
+        munmap(buffer, size);
+}
+#endif /* end of defined(_WIN32) || defined(_WIN32_) */
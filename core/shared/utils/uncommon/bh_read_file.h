@@ -15,6 +15,41 @@ extern "C" {
 char *
 bh_read_file_to_buffer(const char *filename, uint32 *ret_size);
 
+/**
+ * Map a file into memory, the returned buffer is writable but the changes
+ * aren't written back to the file. It falls back to reading the file into
+ * an allocated buffer if the platform doesn't support file mapping.
+ *
+ * @param filename the file to map
+ * @param ret_size return the size of the file
+ *
+ * @return the buffer of the file content, NULL if failed
+ */
+char *
+bh_map_file(const char *filename, uint32 *ret_size);
+
+/**
+ * Read a stream, e.g. a pipe, until its end. The content is read into a
+ * buffer which doesn't move while it grows, so it isn't copied.
+ *
+ * @param fd the file descriptor of the stream
+ * @param ret_size return the size of the content read
+ *
+ * @return the buffer of the content, which is released by bh_unmap_file,
+ *         NULL if failed
+ */
+char *
+bh_read_stream_to_buffer(int fd, uint32 *ret_size);
+
+/**
+ * Unmap a buffer returned by bh_map_file or bh_read_stream_to_buffer.
+ *
+ * @param buffer the buffer to unmap
+ * @param size the size returned with the buffer
+ */
+void
+bh_unmap_file(char *buffer, uint32 size);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,35 @@
+#!/bin/bash
+
+# Copyright (C) 2019 Intel Corporation.  All rights reserved.
+# SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+if [[ -z ${WASM2NATIVE_DIR} ]]; then
+    WASM2NATIVE_DIR=$PWD/../../..
+fi
+
+WORK_DIR=$PWD
+OUT_DIR=$PWD/out
+
+# "<function count>:<calls per function>" of the generated modules
+MODULES="2000:20 20000:20"
+
+rm -fr ${OUT_DIR} && mkdir -p ${OUT_DIR}
+
+echo "Build wasm2native compiler .."
+rm -fr build && mkdir -p build
+cd build
+cmake ${WASM2NATIVE_DIR}/wasm2native-compiler $@
+make -j
+
+cd ${WORK_DIR}
+
+for m in $MODULES
+do
+    func_count=${m%:*}
+    call_count=${m#*:}
+    echo "Generate reloc_${func_count}.wasm .."
+    python3 gen_reloc_module.py ${OUT_DIR}/reloc_${func_count}.wasm \
+        ${func_count} ${call_count}
+done
+
+echo "Done"
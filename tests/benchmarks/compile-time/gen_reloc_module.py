@@ -0,0 +1,125 @@
+#!/usr/bin/env python3
+#
+# Copyright (C) 2019 Intel Corporation.  All rights reserved.
+# SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+#
+
+"""
+Generate a large relocatable wasm module, like the ones emitted by
+`wasm-ld --emit-relocs`: every function calls several other functions,
+and each call has an R_WASM_FUNCTION_INDEX_LEB relocation in the
+"reloc.CODE" section, whose symbols are given by the "linking" section.
+
+Usage: gen_reloc_module.py <output.wasm> <function count> <calls per function>
+"""
+
+import sys
+
+R_WASM_FUNCTION_INDEX_LEB = 0
+WASM_SYMBOL_TABLE = 8
+SYMTAB_FUNCTION = 0
+
+
+def uleb(n):
+    out = bytearray()
+    while True:
+        b = n & 0x7F
+        n >>= 7
+        if n:
+            out.append(b | 0x80)
+        else:
+            out.append(b)
+            return bytes(out)
+
+
+def padded_uleb(n):
+    # The linker pads the relocated immediates to 5 bytes
+    out = bytearray()
+    for i in range(5):
+        b = n & 0x7F
+        n >>= 7
+        out.append(b | 0x80 if i < 4 else b)
+    return bytes(out)
+
+
+def vec(items):
+    return uleb(len(items)) + b"".join(items)
+
+
+def name(s):
+    return uleb(len(s)) + s.encode()
+
+
+def section(section_id, data):
+    return bytes([section_id]) + uleb(len(data)) + data
+
+
+def custom_section(section_name, data):
+    return section(0, name(section_name) + data)
+
+
+def main():
+    if len(sys.argv) != 4:
+        print(__doc__)
+        sys.exit(1)
+
+    output, func_count, call_count = sys.argv[1], int(sys.argv[2]), int(sys.argv[3])
+
+    # Sections in order: type, function, memory, export, code
+    code_section_index = 4
+    type_section = section(1, vec([b"\x60\x01\x7f\x01\x7f"]))
+    func_section = section(3, vec([b"\x00"] * func_count))
+    memory_section = section(5, vec([b"\x00\x01"]))
+    export_section = section(7, vec([name("run") + b"\x00" + uleb(0)]))
+
+    bodies = []
+    relocs = []
+    code_offset = len(uleb(func_count))
+    for i in range(func_count):
+        # No locals, local.get 0, then a chain of calls
+        body = bytearray(b"\x00\x20\x00")
+        call_offsets = []
+        for k in range(call_count):
+            callee = (i * 7 + k * 13 + 1) % func_count
+            body += b"\x10"
+            call_offsets.append((len(body), callee))
+            body += padded_uleb(callee)
+        body += b"\x0b"
+        size = uleb(len(body))
+        for offset, callee in call_offsets:
+            relocs.append((code_offset + len(size) + offset, callee))
+        bodies.append(size + bytes(body))
+        code_offset += len(size) + len(body)
+    code_section = section(10, uleb(func_count) + b"".join(bodies))
+
+    symbols = [
+        bytes([SYMTAB_FUNCTION]) + uleb(0) + uleb(i) + name("func%d" % i)
+        for i in range(func_count)
+    ]
+    symbol_table = vec(symbols)
+    linking_section = custom_section(
+        "linking",
+        uleb(2) + uleb(WASM_SYMBOL_TABLE) + uleb(len(symbol_table)) + symbol_table,
+    )
+
+    reloc_entries = [
+        uleb(R_WASM_FUNCTION_INDEX_LEB) + uleb(offset) + uleb(callee)
+        for offset, callee in relocs
+    ]
+    reloc_section = custom_section(
+        "reloc.CODE", uleb(code_section_index) + vec(reloc_entries)
+    )
+
+    with open(output, "wb") as f:
+        f.write(b"\x00asm\x01\x00\x00\x00")
+        f.write(type_section + func_section + memory_section + export_section)
+        f.write(code_section + linking_section + reloc_section)
+
+    print(
+        "%s: %d functions, %d code relocations"
+        % (output, func_count, len(relocs))
+    )
+
+
+if __name__ == "__main__":
+    main()
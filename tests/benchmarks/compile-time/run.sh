@@ -0,0 +1,29 @@
+#!/bin/bash
+
+# Copyright (C) 2019 Intel Corporation.  All rights reserved.
+# SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+CUR_DIR=$PWD
+OUT_DIR=$CUR_DIR/out
+REPORT=$CUR_DIR/report.txt
+WASM2NATIVE_CMD=$CUR_DIR/build/wasm2native
+
+rm -f $REPORT
+touch $REPORT
+
+echo "Start to run cases, the result is written to report.txt"
+
+cd $OUT_DIR
+
+# Only the unoptimized LLVM IR is emitted, so that the time is spent in
+# loading the module and translating the opcodes
+for wasm in reloc_*.wasm
+do
+    echo "compile ${wasm} .."
+    echo "${wasm}:" >> $REPORT
+    { time ${WASM2NATIVE_CMD} --format=llvmir-unopt $@ \
+          -o ${wasm%.wasm}.ll ${wasm} > /dev/null ; } 2>> $REPORT
+    echo "" >> $REPORT
+done
+
+cat $REPORT
@@ -0,0 +1,32 @@
+#!/bin/bash
+
+# Copyright (C) 2019 Intel Corporation.  All rights reserved.
+# SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+if [[ -z ${WASM2NATIVE_DIR} ]]; then
+    WASM2NATIVE_DIR=$PWD/../../..
+fi
+
+WORK_DIR=$PWD
+
+rm -fr out && mkdir -p out
+
+echo "Build wasm2native-vmlib .."
+rm -fr build && mkdir -p build
+cd build
+cmake ${WASM2NATIVE_DIR}/wasm2native-vmlib $@
+make -j
+
+cd ${WORK_DIR}
+
+echo "Build mem_alloc_bench .."
+gcc -O3 -o out/mem_alloc_bench src/mem_alloc_bench.c \
+    -I ${WASM2NATIVE_DIR}/core/shared/mem-alloc \
+    -I ${WASM2NATIVE_DIR}/core/shared/utils \
+    -I ${WASM2NATIVE_DIR}/core/shared/platform/linux \
+    -I ${WASM2NATIVE_DIR}/core/shared/platform/include \
+    -I ${WASM2NATIVE_DIR}/core \
+    -DBH_PLATFORM_LINUX \
+    -L build -lvmlib -lpthread -lm
+
+echo "Done"
@@ -0,0 +1,42 @@
+#!/bin/bash
+
+# Copyright (C) 2019 Intel Corporation.  All rights reserved.
+# SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+CUR_DIR=$PWD
+OUT_DIR=$CUR_DIR/out
+REPORT=$CUR_DIR/report.txt
+
+WORKLOADS="small large mixed realloc"
+
+rm -f $REPORT
+touch $REPORT
+
+echo "Start to run cases, the result is written to report.txt"
+
+# The trace files given are replayed after the workloads, the relative
+# paths are resolved before entering the output directory,
+# e.g. ./run.sh app.trace
+TRACES=""
+for t in "$@"
+do
+    TRACES="$TRACES $(realpath "$t")"
+done
+
+cd $OUT_DIR
+
+for w in $WORKLOADS
+do
+    echo "run workload $w .."
+    ./mem_alloc_bench --workload=$w >> $REPORT
+    echo "" >> $REPORT
+done
+
+for t in $TRACES
+do
+    echo "replay trace $t .."
+    ./mem_alloc_bench --trace=$t >> $REPORT
+    echo "" >> $REPORT
+done
+
+cat $REPORT
@@ -0,0 +1,346 @@
+/*
+ * Copyright (C) 2019 Intel Corporation.  All rights reserved.
+ * SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+ */
+
+/*
+ * Microbenchmark of the EMS allocator of the host-managed heap, it replays
+ * an allocation trace and reports the p50/p99 latency of malloc/free and
+ * the fragmentation of the heap.
+ *
+ * The trace is either read from a file with one operation per line:
+ *   a <id> <size>    allocate <size> bytes and name the object <id>
+ *   r <id> <size>    re-allocate object <id> to <size> bytes
+ *   f <id>           free object <id>
+ * or generated by one of the built-in workloads.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <time.h>
+
+#include "mem_alloc.h"
+#include "ems/ems_gc.h"
+
+typedef enum { OP_ALLOC = 0, OP_REALLOC, OP_FREE } TraceOpType;
+
+typedef struct TraceOp {
+    uint8_t type;
+    uint32_t id;
+    uint32_t size;
+} TraceOp;
+
+typedef struct Trace {
+    TraceOp *ops;
+    uint32_t op_count;
+    uint32_t op_capacity;
+    uint32_t max_id;
+} Trace;
+
+static uint32_t rand_state = 1;
+
+static uint32_t
+next_rand(void)
+{
+    /* xorshift32, for reproducible traces on all platforms */
+    rand_state ^= rand_state << 13;
+    rand_state ^= rand_state >> 17;
+    rand_state ^= rand_state << 5;
+    return rand_state;
+}
+
+static void
+trace_add(Trace *trace, uint8_t type, uint32_t id, uint32_t size)
+{
+    if (trace->op_count == trace->op_capacity) {
+        trace->op_capacity = trace->op_capacity ? trace->op_capacity * 2 : 4096;
+        trace->ops =
+            realloc(trace->ops, sizeof(TraceOp) * (size_t)trace->op_capacity);
+        if (!trace->ops) {
+            printf("Allocate memory failed\n");
+            exit(1);
+        }
+    }
+    trace->ops[trace->op_count].type = type;
+    trace->ops[trace->op_count].id = id;
+    trace->ops[trace->op_count].size = size;
+    trace->op_count++;
+    if (id + 1 > trace->max_id)
+        trace->max_id = id + 1;
+}
+
+static bool
+trace_load(Trace *trace, const char *file)
+{
+    FILE *fp = fopen(file, "r");
+    char type;
+    unsigned id, size;
+    int n;
+
+    if (!fp) {
+        printf("Open trace file %s failed\n", file);
+        return false;
+    }
+
+    while ((n = fscanf(fp, " %c %u", &type, &id)) == 2) {
+        if (type == 'f') {
+            trace_add(trace, OP_FREE, id, 0);
+            continue;
+        }
+        if (fscanf(fp, " %u", &size) != 1 || (type != 'a' && type != 'r')) {
+            printf("Invalid trace record at op %u\n", trace->op_count);
+            fclose(fp);
+            return false;
+        }
+        trace_add(trace, type == 'a' ? OP_ALLOC : OP_REALLOC, id, size);
+    }
+
+    fclose(fp);
+    return true;
+}
+
+static uint32_t
+random_size(uint32_t min, uint32_t max)
+{
+    return min + next_rand() % (max - min + 1);
+}
+
+/**
+ * Generate a trace of op_count operations, the objects live in slots
+ * and the live set is kept around live_count objects
+ */
+static void
+trace_generate(Trace *trace, const char *workload, uint32_t op_count,
+               uint32_t live_count)
+{
+    uint32_t *slots = calloc(live_count, sizeof(uint32_t));
+    uint32_t next_id = 1, i, k, size;
+
+    if (!slots) {
+        printf("Allocate memory failed\n");
+        exit(1);
+    }
+
+    for (i = 0; i < op_count; i++) {
+        k = next_rand() % live_count;
+
+        if (slots[k]) {
+            if (!strcmp(workload, "realloc") && next_rand() % 2) {
+                trace_add(trace, OP_REALLOC, slots[k], random_size(16, 8192));
+                continue;
+            }
+            trace_add(trace, OP_FREE, slots[k], 0);
+            slots[k] = 0;
+            continue;
+        }
+
+        if (!strcmp(workload, "small")) {
+            size = random_size(8, 256);
+        }
+        else if (!strcmp(workload, "large")) {
+            size = random_size(256, 64 * 1024);
+        }
+        else {
+            /* "mixed" and "realloc": mostly small objects with some
+               large buffers, which is the typical pattern that makes
+               the free chunks of many different sizes */
+            size = next_rand() % 10 ? random_size(8, 512)
+                                    : random_size(1024, 32 * 1024);
+        }
+        slots[k] = next_id++;
+        trace_add(trace, OP_ALLOC, slots[k], size);
+    }
+
+    free(slots);
+}
+
+static uint64_t
+time_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+static int
+compare_u32(const void *a, const void *b)
+{
+    uint32_t x = *(const uint32_t *)a, y = *(const uint32_t *)b;
+    return x < y ? -1 : (x > y ? 1 : 0);
+}
+
+static void
+print_latency(const char *name, uint32_t *lat, uint32_t count)
+{
+    if (count == 0)
+        return;
+    qsort(lat, count, sizeof(uint32_t), compare_u32);
+    printf("%-8s count: %-10u p50: %-6u ns  p99: %-6u ns  max: %u ns\n", name,
+           count, lat[count / 2], lat[(uint32_t)((uint64_t)count * 99 / 100)],
+           lat[count - 1]);
+}
+
+/* Find the largest block that can be allocated now by binary search */
+static uint32_t
+largest_allocatable(mem_allocator_t allocator, uint32_t max)
+{
+    uint32_t lo = 0, hi = max, mid;
+    void *p;
+
+    while (lo < hi) {
+        mid = lo + (hi - lo + 1) / 2;
+        if ((p = mem_allocator_malloc(allocator, mid))) {
+            mem_allocator_free(allocator, p);
+            lo = mid;
+        }
+        else {
+            hi = mid - 1;
+        }
+    }
+    return lo;
+}
+
+static void
+print_help(const char *app)
+{
+    printf("Usage: %s [options]\n", app);
+    printf("options:\n");
+    printf("  --trace=file         Replay the allocation trace in the file\n");
+    printf("  --workload=name      Generate the trace with a built-in workload:\n");
+    printf("                       small, large, mixed (default) or realloc\n");
+    printf("  --ops=n              Number of operations to generate, default is 1000000\n");
+    printf("  --live=n             Number of live objects to keep, default is 4096\n");
+    printf("  --heap-size=n        Heap size in bytes, default is 64MB\n");
+    printf("  --seed=n             Seed of the generated trace, default is 1\n");
+}
+
+int
+main(int argc, char *argv[])
+{
+    const char *trace_file = NULL, *workload = "mixed";
+    uint32_t op_count = 1000000, live_count = 4096;
+    uint32_t heap_size = 64 * 1024 * 1024;
+    uint32_t alloc_cnt = 0, free_cnt = 0, fail_cnt = 0, i;
+    uint32_t *alloc_lat, *free_lat, stats[3], largest;
+    uint64_t t, total_ns = 0;
+    Trace trace = { 0 };
+    mem_allocator_t allocator;
+    void **objs, *p;
+    char *heap_buf;
+
+    for (argc--, argv++; argc > 0; argc--, argv++) {
+        if (!strncmp(argv[0], "--trace=", 8))
+            trace_file = argv[0] + 8;
+        else if (!strncmp(argv[0], "--workload=", 11))
+            workload = argv[0] + 11;
+        else if (!strncmp(argv[0], "--ops=", 6))
+            op_count = (uint32_t)atoi(argv[0] + 6);
+        else if (!strncmp(argv[0], "--live=", 7))
+            live_count = (uint32_t)atoi(argv[0] + 7);
+        else if (!strncmp(argv[0], "--heap-size=", 12))
+            heap_size = (uint32_t)atoi(argv[0] + 12);
+        else if (!strncmp(argv[0], "--seed=", 7))
+            rand_state = (uint32_t)atoi(argv[0] + 7);
+        else {
+            print_help("mem_alloc_bench");
+            return 1;
+        }
+    }
+
+    if (trace_file) {
+        if (!trace_load(&trace, trace_file))
+            return 1;
+    }
+    else {
+        if (live_count == 0 || rand_state == 0) {
+            print_help("mem_alloc_bench");
+            return 1;
+        }
+        trace_generate(&trace, workload, op_count, live_count);
+    }
+
+    heap_buf = malloc(heap_size);
+    objs = calloc(trace.max_id + 1, sizeof(void *));
+    alloc_lat = malloc(sizeof(uint32_t) * ((size_t)trace.op_count + 1));
+    free_lat = malloc(sizeof(uint32_t) * ((size_t)trace.op_count + 1));
+    if (!heap_buf || !objs || !alloc_lat || !free_lat) {
+        printf("Allocate memory failed\n");
+        return 1;
+    }
+
+    if (!(allocator = mem_allocator_create(heap_buf, heap_size))) {
+        printf("Create allocator failed\n");
+        return 1;
+    }
+
+    for (i = 0; i < trace.op_count; i++) {
+        TraceOp *op = &trace.ops[i];
+
+        switch (op->type) {
+            case OP_ALLOC:
+                t = time_ns();
+                p = mem_allocator_malloc(allocator, op->size);
+                t = time_ns() - t;
+                alloc_lat[alloc_cnt++] = (uint32_t)t;
+                break;
+            case OP_REALLOC:
+                t = time_ns();
+                p = mem_allocator_realloc(allocator, objs[op->id], op->size);
+                t = time_ns() - t;
+                alloc_lat[alloc_cnt++] = (uint32_t)t;
+                break;
+            default:
+                t = time_ns();
+                mem_allocator_free(allocator, objs[op->id]);
+                t = time_ns() - t;
+                free_lat[free_cnt++] = (uint32_t)t;
+                p = NULL;
+                break;
+        }
+
+        total_ns += t;
+        if (op->type != OP_FREE) {
+            if (p) {
+                /* touch the object like a real app */
+                memset(p, 0, op->size < 64 ? op->size : 64);
+                objs[op->id] = p;
+            }
+            else {
+                fail_cnt++;
+            }
+        }
+        else {
+            objs[op->id] = NULL;
+        }
+    }
+
+    gc_heap_stats(allocator, stats, 3);
+    largest = largest_allocatable(allocator, stats[GC_STAT_FREE]);
+
+    printf("Trace: %s, %u ops, %u failed\n",
+           trace_file ? trace_file : workload, trace.op_count, fail_cnt);
+    print_latency("malloc", alloc_lat, alloc_cnt);
+    print_latency("free", free_lat, free_cnt);
+    printf("Total time: %.3f ms\n", (double)total_ns / 1000000.0);
+    printf("Heap total: %u, free: %u, highmark: %u\n", stats[GC_STAT_TOTAL],
+           stats[GC_STAT_FREE], stats[GC_STAT_HIGHMARK]);
+    printf("Largest allocatable: %u, fragmentation: %.2f%%\n", largest,
+           stats[GC_STAT_FREE]
+               ? 100.0 * (1.0 - (double)largest / stats[GC_STAT_FREE])
+               : 0.0);
+
+    for (i = 0; i <= trace.max_id; i++) {
+        if (objs[i])
+            mem_allocator_free(allocator, objs[i]);
+    }
+    mem_allocator_destroy(allocator);
+
+    free(free_lat);
+    free(alloc_lat);
+    free(objs);
+    free(heap_buf);
+    free(trace.ops);
+    return 0;
+}
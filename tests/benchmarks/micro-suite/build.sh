@@ -29,6 +29,8 @@ if [ -z "${WASM_NDK_ROOT}" ]; then
 fi
 
 C_CASES="conditionals corrections64 corrections fannkuch ifs memops primes"
+# The cases under src, e.g. the interpreter dispatch loop
+LOCAL_C_CASES="dispatch"
 CPP_CASES="copy fasta skinning"
 
 rm -fr ${OUT_DIR} && mkdir -p ${OUT_DIR}
@@ -44,7 +46,12 @@ if [ ! -d benchmarks ]; then
     git clone https://github.com/AndroidWasm/benchmarks.git
 fi
 
-for bench in $C_CASES
+for bench in $LOCAL_C_CASES
+do
+    cp ${WORK_DIR}/src/${bench}.c ${WORK_DIR}/benchmarks/micro-suite
+done
+
+for bench in $C_CASES $LOCAL_C_CASES
 do
     cd ${WORK_DIR}/benchmarks/micro-suite
 
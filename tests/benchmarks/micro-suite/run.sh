@@ -11,7 +11,7 @@ TIME=/usr/bin/time
 BENCH_NAME_MAX_LEN=20
 
 MICRO_SUITE_CASES="conditionals corrections64 corrections fannkuch ifs \
-                   memops primes copy fasta skinning"
+                   memops primes copy fasta skinning dispatch"
 
 rm -f $REPORT
 touch $REPORT
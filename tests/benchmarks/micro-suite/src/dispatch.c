@@ -0,0 +1,85 @@
+/*
+ * Copyright (C) 2019 Intel Corporation.  All rights reserved.
+ * SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+ */
+
+/*
+ * Interpreter dispatch loop: a bytecode VM with 256 opcodes dispatched by
+ * a dense switch, which is compiled to a large wasm br_table, to track the
+ * cost of the br_table lowering.
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+
+#define CODE_SIZE 4096
+#define REG_NUM 8
+
+static uint8_t code[CODE_SIZE];
+
+/* clang-format off */
+#define OP(n)                                                        \
+    case n:                                                          \
+        acc = (acc ^ ((uint32_t)(n) * 0x9e3779b9u)) + regs[(n) & 7]; \
+        regs[((n) + 1) & 7] += acc >> ((n) % 13);                    \
+        break;
+
+#define OP8(n) OP(n) OP(n + 1) OP(n + 2) OP(n + 3) \
+               OP(n + 4) OP(n + 5) OP(n + 6) OP(n + 7)
+#define OP64(n) OP8(n) OP8(n + 8) OP8(n + 16) OP8(n + 24) \
+                OP8(n + 32) OP8(n + 40) OP8(n + 48) OP8(n + 56)
+/* clang-format on */
+
+static uint32_t
+run(uint32_t iterations)
+{
+    uint32_t regs[REG_NUM] = { 1, 2, 3, 4, 5, 6, 7, 8 };
+    uint32_t acc = 0, pc, i;
+
+    for (i = 0; i < iterations; i++) {
+        for (pc = 0; pc < CODE_SIZE; pc++) {
+            switch (code[pc]) {
+                OP64(0)
+                OP64(64)
+                OP64(128)
+                /* The last opcodes jump, so that the dispatch isn't a
+                   straight sequence */
+                OP8(192)
+                OP8(200)
+                OP8(208)
+                OP8(216)
+                OP8(224)
+                OP8(232)
+                OP8(240)
+                case 248:
+                case 249:
+                case 250:
+                case 251:
+                case 252:
+                case 253:
+                case 254:
+                case 255:
+                    if (acc & 1)
+                        pc += code[pc] & 7;
+                    acc += regs[acc & 7];
+                    break;
+            }
+        }
+    }
+
+    return acc ^ regs[0] ^ regs[7];
+}
+
+int
+main(int argc, char **argv)
+{
+    uint32_t seed = 12345, i;
+
+    for (i = 0; i < CODE_SIZE; i++) {
+        seed = seed * 1103515245u + 12345u;
+        code[i] = (uint8_t)(seed >> 16);
+    }
+
+    printf("dispatch result: %u\n", run(20000));
+    return 0;
+}
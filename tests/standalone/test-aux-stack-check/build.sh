@@ -0,0 +1,46 @@
+#!/bin/bash
+
+# Copyright (C) 2019 Intel Corporation.  All rights reserved.
+# SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+if [[ -z ${WASM2NATIVE_DIR} ]]; then
+    WASM2NATIVE_DIR=$PWD/../../..
+fi
+
+WORK_DIR=$PWD
+WASM2NATIVE_CMD=${WASM2NATIVE_DIR}/wasm2native-compiler/build/wasm2native
+
+if [ -z "${WABT_HOME}" ]; then
+  echo "WABT_HOME is not set"
+  exit 1
+fi
+
+rm -fr out && mkdir -p out
+
+echo "Build wasm2native-vmlib .."
+rm -fr build && mkdir -p build
+cd build
+cmake ${WASM2NATIVE_DIR}/wasm2native-vmlib
+make -j
+
+cd ${WORK_DIR}
+
+echo "Build wrong_global.wasm with wabt .."
+${WABT_HOME}/bin/wat2wasm -o out/wrong_global.wasm wrong_global.wat
+
+cd ${WORK_DIR}/out
+
+echo "Compile wrong_global.wasm into test_default.o"
+${WASM2NATIVE_CMD} --format=object -o test_default.o wrong_global.wasm
+
+echo "Compile wrong_global.wasm into test_checked.o"
+${WASM2NATIVE_CMD} --format=object --enable-aux-stack-check \
+        -o test_checked.o wrong_global.wasm
+
+for test in test_default test_checked; do
+    echo "Generate ${test} binary"
+    gcc -O3 -I ${WASM2NATIVE_DIR}/core/iwasm/include -o ${test} \
+        ../main.c ${test}.o -L ../build -lvmlib -lm
+done
+
+echo "Done"
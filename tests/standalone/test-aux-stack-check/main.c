@@ -0,0 +1,52 @@
+/*
+ * Copyright (C) 2019 Intel Corporation.  All rights reserved.
+ * SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "w2n_export.h"
+
+static void *
+lookup_func(const char *name)
+{
+    WASMExportApi *export_apis = wasm_get_export_apis();
+    uint32_t i;
+
+    for (i = 0; i < wasm_get_export_api_num(); i++) {
+        if (!strcmp(export_apis[i].func_name, name))
+            return (void *)export_apis[i].func_ptr;
+    }
+    return NULL;
+}
+
+int
+main(void)
+{
+    int32_t (*count)(int32_t), (*frame)(int32_t);
+    int32_t result;
+
+    wasm_instance_create();
+    if (!wasm_instance_is_created()) {
+        printf("Create wasm instance failed\n");
+        return 1;
+    }
+
+    if (!(count = lookup_func("count")) || !(frame = lookup_func("frame"))) {
+        printf("Lookup the wasm functions failed\n");
+        return 1;
+    }
+
+    result = count(5);
+    result += count(7) + frame(100);
+    if (wasm_get_exception()) {
+        printf("Exception: %s\n", wasm_get_exception_msg());
+        wasm_instance_destroy();
+        return 1;
+    }
+
+    printf("Result: %d\n", (int)result);
+    wasm_instance_destroy();
+    return 0;
+}
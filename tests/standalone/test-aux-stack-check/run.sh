@@ -0,0 +1,29 @@
+#!/bin/bash
+
+# Copyright (C) 2019 Intel Corporation.  All rights reserved.
+# SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+OUT_DIR=$PWD/out
+
+cd $OUT_DIR
+
+# The aux stack pointer is guessed wrong for the module, which must run
+# as is without the aux stack check, as the check is disabled by default
+echo "Run test_default .."
+./test_default | tee test_default.log
+if ! grep -q "Result: 8309" test_default.log; then
+    echo "test_default failed"
+    exit 1
+fi
+
+# With the check enabled, the sets of the global guessed trap
+echo ""
+echo "Run test_checked .."
+./test_checked | tee test_checked.log
+if ! grep -q "Exception: wasm auxiliary stack underflow" test_checked.log; then
+    echo "test_checked didn't report the wrong guess"
+    exit 1
+fi
+
+echo ""
+echo "Passed"
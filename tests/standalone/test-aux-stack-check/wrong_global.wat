@@ -0,0 +1,28 @@
+;; Copyright (C) 2019 Intel Corporation.  All rights reserved.
+;; SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+;; The loader guesses the aux stack pointer as the first mutable i32
+;; global whose initial value isn't larger than __heap_base, which is
+;; the counter here instead of the real stack pointer, and takes the
+;; range from __data_end to the initial value as the aux stack
+(module
+  (memory (export "memory") 2)
+  (global $counter (mut i32) (i32.const 4096))
+  (global $__stack_pointer (mut i32) (i32.const 66560))
+  (global (export "__data_end") i32 (i32.const 1024))
+  (global (export "__heap_base") i32 (i32.const 66560))
+
+  (func (export "count") (param $n i32) (result i32)
+    (global.set $counter
+      (i32.add (global.get $counter) (local.get $n)))
+    (global.get $counter))
+
+  ;; Store the argument in a frame of the real aux stack and load it back
+  (func (export "frame") (param $n i32) (result i32)
+    (local $sp i32)
+    (global.set $__stack_pointer
+      (local.tee $sp (i32.sub (global.get $__stack_pointer) (i32.const 16))))
+    (i32.store (local.get $sp) (local.get $n))
+    (global.set $__stack_pointer (i32.add (local.get $sp) (i32.const 16)))
+    (i32.load (local.get $sp)))
+)
@@ -0,0 +1,177 @@
+/*
+ * Copyright (C) 2019 Intel Corporation.  All rights reserved.
+ * SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+ */
+
+/*
+ * Checks the accesses of mask.wasm compiled with --bounds-mode=mask: the
+ * addresses wrap at the power of two size of the memory instead of
+ * trapping, the accesses at the end may extend into the guard bytes, and
+ * the generic bulk operations are cut at the end without wrapping.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <inttypes.h>
+
+#include "w2n_export.h"
+
+#define POW2_SIZE 0x40000
+#define GROWN_POW2_SIZE 0x80000
+
+static int32_t (*load32)(int32_t);
+static void (*store32)(int32_t, int32_t);
+static int32_t (*load32_offset)(int32_t);
+static int64_t (*load64)(int32_t);
+static void (*store64)(int32_t, int64_t);
+static void (*fill)(int32_t, int32_t, int32_t);
+static void (*copy)(int32_t, int32_t, int32_t);
+static void (*fill16)(int32_t, int32_t);
+static void (*copy16)(int32_t, int32_t);
+static int32_t (*grow)(int32_t);
+static int32_t (*size)(void);
+
+static int failed;
+
+static void *
+lookup_func(const char *name)
+{
+    WASMExportApi *export_apis = wasm_get_export_apis();
+    uint32_t i;
+
+    for (i = 0; i < wasm_get_export_api_num(); i++) {
+        if (!strcmp(export_apis[i].func_name, name))
+            return (void *)export_apis[i].func_ptr;
+    }
+    return NULL;
+}
+
+static void
+check(const char *what, int64_t result, int64_t expected)
+{
+    if (wasm_get_exception()) {
+        printf("%s: unexpected exception: %s\n", what,
+               wasm_get_exception_msg());
+        failed = 1;
+        return;
+    }
+    if (result != expected) {
+        printf("%s: got 0x%" PRIx64 ", expected 0x%" PRIx64 "\n", what,
+               (uint64_t)result, (uint64_t)expected);
+        failed = 1;
+    }
+}
+
+static void
+test_load_store(void)
+{
+    /* between the memory size 0x30000 and the power of two size */
+    store32(0x3fff0, 0x11223344);
+    check("store beyond the memory size", load32(0x3fff0), 0x11223344);
+
+    /* wraps at the power of two size */
+    store32(POW2_SIZE + 8, (int32_t)0xaabbccdd);
+    check("store wrapped at the mask end", load32(8), (int32_t)0xaabbccdd);
+    check("load wrapped at the mask end", load32(-POW2_SIZE + 8),
+          (int32_t)0xaabbccdd);
+
+    /* 0x30008 + 0x10000 wraps to 8 */
+    check("load with the offset wrapped", load32_offset(0x30008),
+          (int32_t)0xaabbccdd);
+
+    /* the last 4 bytes are stored into the guard, not at address 0 */
+    store64(POW2_SIZE - 4, 0x0102030405060708);
+    check("store into the guard", load64(POW2_SIZE - 4), 0x0102030405060708);
+    check("store into the guard wrapped", load32(0), 0);
+}
+
+static void
+test_generic_bulk(void)
+{
+    /* cut after 8 bytes at the mask end, the guard and address 0 are
+       left alone */
+    fill(POW2_SIZE - 8, 0x5a, 32);
+    check("fill cut at the mask end", load64(POW2_SIZE - 4),
+          0x010203045a5a5a5a);
+    check("fill cut at the mask end wrapped", load32(0), 0);
+
+    /* the destination is masked too */
+    fill(POW2_SIZE + 0x400, 0x33, 4);
+    check("fill wrapped", load32(0x400), 0x33333333);
+
+    /* the source is cut after 8 bytes too */
+    copy(0x100, POW2_SIZE - 8, 32);
+    check("copy cut at the mask end", load64(0x100), 0x5a5a5a5a5a5a5a5a);
+    check("copy cut at the mask end after", load32(0x108), 0);
+}
+
+static void
+test_inline_bulk(void)
+{
+    /* the 16 bytes are stored into the guard, not at address 0 */
+    fill16(POW2_SIZE - 8, 0x77);
+    check("inline fill into the guard", load64(POW2_SIZE - 4),
+          0x7777777777777777);
+    check("inline fill into the guard wrapped", load32(0), 0);
+
+    /* the 16 bytes are loaded from the guard */
+    copy16(0x200, POW2_SIZE - 8);
+    check("inline copy from the guard", load64(0x208), 0x7777777777777777);
+
+    copy16(POW2_SIZE + 0x300, 0x200);
+    check("inline copy wrapped", load64(0x308), 0x7777777777777777);
+}
+
+static void
+test_grow(void)
+{
+    store32(0x30000, 0x12345678);
+    check("grow to 4 pages", grow(1), 3);
+    check("memory size after grow", size(), 4);
+    check("grow zeroes after the old size", load32(0x30000), 0);
+
+    /* the mask is 0x7ffff with 5 pages */
+    check("grow to 5 pages", grow(1), 4);
+    store32(POW2_SIZE + 8, 1);
+    check("store not wrapped after grow", load32(POW2_SIZE + 8), 1);
+    check("old data kept after grow", load32(8), (int32_t)0xaabbccdd);
+    store32(GROWN_POW2_SIZE + 0x10, 5);
+    check("store wrapped after grow", load32(0x10), 5);
+
+    check("grow beyond the max pages", grow(4), -1);
+}
+
+int
+main(void)
+{
+    wasm_instance_create();
+    if (!wasm_instance_is_created()) {
+        printf("Create wasm instance failed\n");
+        return 1;
+    }
+
+    if (!(load32 = lookup_func("load32"))
+        || !(store32 = lookup_func("store32"))
+        || !(load32_offset = lookup_func("load32_offset"))
+        || !(load64 = lookup_func("load64"))
+        || !(store64 = lookup_func("store64"))
+        || !(fill = lookup_func("fill")) || !(copy = lookup_func("copy"))
+        || !(fill16 = lookup_func("fill16"))
+        || !(copy16 = lookup_func("copy16"))
+        || !(grow = lookup_func("grow")) || !(size = lookup_func("size"))) {
+        printf("Lookup the wasm functions failed\n");
+        return 1;
+    }
+
+    test_load_store();
+    test_generic_bulk();
+    test_inline_bulk();
+    test_grow();
+
+    wasm_instance_destroy();
+    if (failed)
+        return 1;
+
+    printf("All checks passed\n");
+    return 0;
+}
@@ -0,0 +1,46 @@
+;; Copyright (C) 2019 Intel Corporation.  All rights reserved.
+;; SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+;; With --bounds-mode=mask, the 3 pages of the memory are allocated as
+;; 0x40000 bytes plus the guard bytes, and the addresses are masked with
+;; 0x3ffff instead of being checked
+(module
+  (memory (export "memory") 3 8)
+
+  (func (export "load32") (param $addr i32) (result i32)
+    (i32.load (local.get $addr)))
+
+  (func (export "store32") (param $addr i32) (param $v i32)
+    (i32.store (local.get $addr) (local.get $v)))
+
+  ;; The offset immediate is added before the address is masked
+  (func (export "load32_offset") (param $addr i32) (result i32)
+    (i32.load offset=0x10000 (local.get $addr)))
+
+  (func (export "load64") (param $addr i32) (result i64)
+    (i64.load (local.get $addr)))
+
+  (func (export "store64") (param $addr i32) (param $v i64)
+    (i64.store (local.get $addr) (local.get $v)))
+
+  ;; The lengths aren't constant, so that the generic bulk operations are
+  ;; emitted
+  (func (export "fill") (param $d i32) (param $v i32) (param $n i32)
+    (memory.fill (local.get $d) (local.get $v) (local.get $n)))
+
+  (func (export "copy") (param $d i32) (param $s i32) (param $n i32)
+    (memory.copy (local.get $d) (local.get $s) (local.get $n)))
+
+  ;; The small constant lengths are inlined as plain loads and stores
+  (func (export "fill16") (param $d i32) (param $v i32)
+    (memory.fill (local.get $d) (local.get $v) (i32.const 16)))
+
+  (func (export "copy16") (param $d i32) (param $s i32)
+    (memory.copy (local.get $d) (local.get $s) (i32.const 16)))
+
+  (func (export "grow") (param $n i32) (result i32)
+    (memory.grow (local.get $n)))
+
+  (func (export "size") (result i32)
+    (memory.size))
+)
@@ -0,0 +1,19 @@
+#!/bin/bash
+
+# Copyright (C) 2019 Intel Corporation.  All rights reserved.
+# SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+OUT_DIR=$PWD/out
+
+cd $OUT_DIR
+
+for test in test_mask test_mask_O0; do
+    echo "Run ${test} .."
+    if ! ./${test}; then
+        echo "${test} failed"
+        exit 1
+    fi
+    echo ""
+done
+
+echo "Passed"
@@ -0,0 +1,87 @@
+;; Copyright (C) 2019 Intel Corporation.  All rights reserved.
+;; SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+;; The br_table indices aren't constant, so that a switch is emitted. The
+;; entries of the same target share one edge to it, through a
+;; br_table_case block if the target takes values and has several entries
+(module
+  ;; Targets taking a value with several entries each, the default is
+  ;; one of them too
+  (func (export "dispatch") (param $i i32) (result i32)
+    (block $b3 (result i32)
+      (block $b2 (result i32)
+        (block $b1 (result i32)
+          (block $b0 (result i32)
+            (i32.mul (local.get $i) (i32.const 10))
+            (br_table $b0 $b1 $b0 $b2 $b1 $b1 $b3 $b0
+                      $b2 $b2 $b0 $b1 $b3 $b3 $b0 $b2 $b1
+                      (local.get $i)))
+          (return (i32.add (i32.const 1000))))
+        (return (i32.add (i32.const 2000))))
+      (return (i32.add (i32.const 3000))))
+    (i32.add (i32.const 4000)))
+
+  ;; Targets taking two values, $b2 has a single entry and the default
+  ;; $b3 has no other entry
+  (func (export "dispatch_pair") (param $i i32) (result i64)
+    (local $a i32)
+    (local $b i64)
+    (block $b3 (result i32 i64)
+      (block $b2 (result i32 i64)
+        (block $b1 (result i32 i64)
+          (block $b0 (result i32 i64)
+            (i32.add (local.get $i) (i32.const 7))
+            (i64.mul (i64.extend_i32_s (local.get $i)) (i64.const 3))
+            (br_table $b1 $b0 $b1 $b0 $b0 $b2 $b1 $b0 $b3
+                      (local.get $i)))
+          (local.set $b)
+          (local.set $a)
+          (return (i64.add (i64.mul (i64.extend_i32_s (local.get $a))
+                                    (i64.const 100000))
+                           (i64.add (local.get $b) (i64.const 1)))))
+        (local.set $b)
+        (local.set $a)
+        (return (i64.add (i64.mul (i64.extend_i32_s (local.get $a))
+                                  (i64.const 100000))
+                         (i64.add (local.get $b) (i64.const 2)))))
+      (local.set $b)
+      (local.set $a)
+      (return (i64.add (i64.mul (i64.extend_i32_s (local.get $a))
+                                (i64.const 100000))
+                       (i64.add (local.get $b) (i64.const 3)))))
+    (local.set $b)
+    (local.set $a)
+    (i64.add (i64.mul (i64.extend_i32_s (local.get $a)) (i64.const 100000))
+             (i64.add (local.get $b) (i64.const 4))))
+
+  ;; The loop takes the sum as its param, all the entries but the default
+  ;; continue it, returns 1 + 2 + ... + n
+  (func (export "loop_sum") (param $n i32) (result i32)
+    (local $i i32)
+    (i32.const 0)
+    (loop $l (param i32) (result i32)
+      (local.set $i (i32.add (local.get $i) (i32.const 1)))
+      (i32.add (local.get $i))
+      (block $exit (param i32) (result i32)
+        (br_table $l $l $l $l $exit
+                  (select (i32.and (local.get $i) (i32.const 3))
+                          (i32.const 4)
+                          (i32.lt_s (local.get $i) (local.get $n)))))))
+
+  ;; Targets without values with several entries each
+  (func (export "no_values") (param $i i32) (result i32)
+    (block $c
+      (block $b
+        (block $a
+          (br_table $a $b $a $a $c $b $a (local.get $i)))
+        (return (i32.const 10)))
+      (return (i32.const 20)))
+    (i32.const 30))
+
+  ;; All the entries are the default
+  (func (export "all_default") (param $i i32) (result i32)
+    (block $b (result i32)
+      (local.get $i)
+      (br_table $b $b $b $b (local.get $i)))
+    (i32.add (i32.const 5)))
+)
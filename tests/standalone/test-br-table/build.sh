@@ -0,0 +1,49 @@
+#!/bin/bash
+
+# Copyright (C) 2019 Intel Corporation.  All rights reserved.
+# SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+if [[ -z ${WASM2NATIVE_DIR} ]]; then
+    WASM2NATIVE_DIR=$PWD/../../..
+fi
+
+WORK_DIR=$PWD
+WASM2NATIVE_CMD=${WASM2NATIVE_DIR}/wasm2native-compiler/build/wasm2native
+
+if [ -z "${WABT_HOME}" ]; then
+  echo "WABT_HOME is not set"
+  exit 1
+fi
+
+rm -fr out && mkdir -p out
+
+echo "Build wasm2native-vmlib .."
+rm -fr build && mkdir -p build
+cd build
+cmake ${WASM2NATIVE_DIR}/wasm2native-vmlib
+make -j
+
+cd ${WORK_DIR}
+
+echo "Build br_table.wasm with wabt .."
+${WABT_HOME}/bin/wat2wasm -o out/br_table.wasm br_table.wat
+
+cd ${WORK_DIR}/out
+
+echo "Compile br_table.wasm into test_br_table.o"
+${WASM2NATIVE_CMD} --format=object \
+        -o test_br_table.o br_table.wasm
+
+# The switches and the br_table_case blocks are kept as emitted without
+# the optimizations
+echo "Compile br_table.wasm into test_br_table_O0.o"
+${WASM2NATIVE_CMD} --format=object --opt-level=0 \
+        -o test_br_table_O0.o br_table.wasm
+
+for test in test_br_table test_br_table_O0; do
+    echo "Generate ${test} binary"
+    gcc -O3 -I ${WASM2NATIVE_DIR}/core/iwasm/include -o ${test} \
+        ../main.c ${test}.o -L ../build -lvmlib -lm
+done
+
+echo "Done"
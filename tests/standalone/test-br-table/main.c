@@ -0,0 +1,130 @@
+/*
+ * Copyright (C) 2019 Intel Corporation.  All rights reserved.
+ * SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+ */
+
+/*
+ * Checks the br_tables of br_table.wasm against the targets taken by
+ * the indices in C: the indices in the table, the ones beyond it, which
+ * take the default target, and the negative ones, which are beyond it
+ * as unsigned.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <inttypes.h>
+
+#include "w2n_export.h"
+
+#define ARRAY_SIZE(array) (sizeof(array) / sizeof(array[0]))
+
+/* The depths of the entries and the default of each br_table */
+static const uint32_t dispatch_depths[] = { 0, 1, 0, 2, 1, 1, 3, 0,
+                                            2, 2, 0, 1, 3, 3, 0, 2 };
+#define DISPATCH_DEFAULT 1
+
+static const uint32_t dispatch_pair_depths[] = { 1, 0, 1, 0, 0, 2, 1, 0 };
+#define DISPATCH_PAIR_DEFAULT 3
+
+static const uint32_t no_values_depths[] = { 0, 1, 0, 0, 2, 1 };
+#define NO_VALUES_DEFAULT 0
+
+static const int32_t args[] = { 0,  1,  2,  3,  4,   5,          6,
+                                7,  8,  9,  10, 11,  12,         13,
+                                14, 15, 16, 17, 100, 0x7fffffff, -1,
+                                -2, (int32_t)0x80000000 };
+
+static int failed;
+
+static void *
+lookup_func(const char *name)
+{
+    WASMExportApi *export_apis = wasm_get_export_apis();
+    uint32_t i;
+
+    for (i = 0; i < wasm_get_export_api_num(); i++) {
+        if (!strcmp(export_apis[i].func_name, name))
+            return (void *)export_apis[i].func_ptr;
+    }
+    return NULL;
+}
+
+static uint32_t
+get_depth(const uint32_t *depths, uint32_t count, uint32_t default_depth,
+          int32_t index)
+{
+    return (uint32_t)index < count ? depths[(uint32_t)index] : default_depth;
+}
+
+static void
+check(const char *what, int32_t arg, int64_t result, int64_t expected)
+{
+    if (wasm_get_exception()) {
+        printf("%s(%d): unexpected exception: %s\n", what, (int)arg,
+               wasm_get_exception_msg());
+        failed = 1;
+    }
+    else if (result != expected) {
+        printf("%s(%d): got %" PRId64 ", expected %" PRId64 "\n", what,
+               (int)arg, result, expected);
+        failed = 1;
+    }
+}
+
+int
+main(void)
+{
+    int32_t (*dispatch)(int32_t), (*loop_sum)(int32_t);
+    int32_t (*no_values)(int32_t), (*all_default)(int32_t);
+    int64_t (*dispatch_pair)(int32_t);
+    int32_t arg, n;
+    uint32_t depth, i;
+
+    wasm_instance_create();
+    if (!wasm_instance_is_created()) {
+        printf("Create wasm instance failed\n");
+        return 1;
+    }
+
+    if (!(dispatch = lookup_func("dispatch"))
+        || !(dispatch_pair = lookup_func("dispatch_pair"))
+        || !(loop_sum = lookup_func("loop_sum"))
+        || !(no_values = lookup_func("no_values"))
+        || !(all_default = lookup_func("all_default"))) {
+        printf("Lookup the wasm functions failed\n");
+        return 1;
+    }
+
+    for (i = 0; i < ARRAY_SIZE(args); i++) {
+        arg = args[i];
+
+        depth = get_depth(dispatch_depths, ARRAY_SIZE(dispatch_depths),
+                          DISPATCH_DEFAULT, arg);
+        check("dispatch", arg, dispatch(arg),
+              (int32_t)((uint32_t)arg * 10 + 1000 * (depth + 1)));
+
+        depth = get_depth(dispatch_pair_depths,
+                          ARRAY_SIZE(dispatch_pair_depths),
+                          DISPATCH_PAIR_DEFAULT, arg);
+        check("dispatch_pair", arg, dispatch_pair(arg),
+              (int64_t)(int32_t)((uint32_t)arg + 7) * 100000
+                  + (int64_t)arg * 3 + depth + 1);
+
+        depth = get_depth(no_values_depths, ARRAY_SIZE(no_values_depths),
+                          NO_VALUES_DEFAULT, arg);
+        check("no_values", arg, no_values(arg), 10 * (depth + 1));
+
+        check("all_default", arg, all_default(arg),
+              (int32_t)((uint32_t)arg + 5));
+    }
+
+    for (n = -1; n <= 100; n++)
+        check("loop_sum", n, loop_sum(n), n > 1 ? n * (n + 1) / 2 : 1);
+
+    wasm_instance_destroy();
+    if (failed)
+        return 1;
+
+    printf("All checks passed\n");
+    return 0;
+}
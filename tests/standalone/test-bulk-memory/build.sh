@@ -0,0 +1,49 @@
+#!/bin/bash
+
+# Copyright (C) 2019 Intel Corporation.  All rights reserved.
+# SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+if [[ -z ${WASM2NATIVE_DIR} ]]; then
+    WASM2NATIVE_DIR=$PWD/../../..
+fi
+
+WORK_DIR=$PWD
+WASM2NATIVE_CMD=${WASM2NATIVE_DIR}/wasm2native-compiler/build/wasm2native
+
+if [ -z "${WABT_HOME}" ]; then
+  echo "WABT_HOME is not set"
+  exit 1
+fi
+
+rm -fr out && mkdir -p out
+
+echo "Build wasm2native-vmlib .."
+rm -fr build && mkdir -p build
+cd build
+cmake ${WASM2NATIVE_DIR}/wasm2native-vmlib
+make -j
+
+cd ${WORK_DIR}
+
+echo "Build bulk_memory.wasm with wabt .."
+${WABT_HOME}/bin/wat2wasm -o out/bulk_memory.wasm bulk_memory.wat
+
+cd ${WORK_DIR}/out
+
+echo "Compile bulk_memory.wasm into test_bulk_memory.o"
+${WASM2NATIVE_CMD} --format=object \
+        -o test_bulk_memory.o bulk_memory.wasm
+
+# The loads and stores of the inline copies aren't merged or reordered
+# without the optimizations
+echo "Compile bulk_memory.wasm into test_bulk_memory_O0.o"
+${WASM2NATIVE_CMD} --format=object --opt-level=0 \
+        -o test_bulk_memory_O0.o bulk_memory.wasm
+
+for test in test_bulk_memory test_bulk_memory_O0; do
+    echo "Generate ${test} binary"
+    gcc -O3 -I ${WASM2NATIVE_DIR}/core/iwasm/include -o ${test} \
+        ../main.c ${test}.o -L ../build -lvmlib -lm
+done
+
+echo "Done"
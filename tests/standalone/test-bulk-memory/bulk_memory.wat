@@ -0,0 +1,109 @@
+;; Copyright (C) 2019 Intel Corporation.  All rights reserved.
+;; SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+;; memory.copy and memory.fill with a constant length of up to 64 bytes
+;; are expanded inline, the longer ones and the ones whose length isn't
+;; constant call the bulk memory functions of the vmlib, and the copies
+;; with constant offsets whose ranges don't overlap are emitted as memcpy
+(module
+  (memory (export "memory") 1)
+
+  ;; The lengths around the chunk sizes 16, 8, 4, 2 and 1, the last chunk
+  ;; overlaps with the previous one if the length isn't a multiple of the
+  ;; chunk size, and 65 is beyond the inline size
+  (func (export "copy_0") (param $d i32) (param $s i32)
+    (memory.copy (local.get $d) (local.get $s) (i32.const 0)))
+  (func (export "copy_1") (param $d i32) (param $s i32)
+    (memory.copy (local.get $d) (local.get $s) (i32.const 1)))
+  (func (export "copy_2") (param $d i32) (param $s i32)
+    (memory.copy (local.get $d) (local.get $s) (i32.const 2)))
+  (func (export "copy_3") (param $d i32) (param $s i32)
+    (memory.copy (local.get $d) (local.get $s) (i32.const 3)))
+  (func (export "copy_4") (param $d i32) (param $s i32)
+    (memory.copy (local.get $d) (local.get $s) (i32.const 4)))
+  (func (export "copy_5") (param $d i32) (param $s i32)
+    (memory.copy (local.get $d) (local.get $s) (i32.const 5)))
+  (func (export "copy_7") (param $d i32) (param $s i32)
+    (memory.copy (local.get $d) (local.get $s) (i32.const 7)))
+  (func (export "copy_8") (param $d i32) (param $s i32)
+    (memory.copy (local.get $d) (local.get $s) (i32.const 8)))
+  (func (export "copy_9") (param $d i32) (param $s i32)
+    (memory.copy (local.get $d) (local.get $s) (i32.const 9)))
+  (func (export "copy_15") (param $d i32) (param $s i32)
+    (memory.copy (local.get $d) (local.get $s) (i32.const 15)))
+  (func (export "copy_16") (param $d i32) (param $s i32)
+    (memory.copy (local.get $d) (local.get $s) (i32.const 16)))
+  (func (export "copy_17") (param $d i32) (param $s i32)
+    (memory.copy (local.get $d) (local.get $s) (i32.const 17)))
+  (func (export "copy_31") (param $d i32) (param $s i32)
+    (memory.copy (local.get $d) (local.get $s) (i32.const 31)))
+  (func (export "copy_32") (param $d i32) (param $s i32)
+    (memory.copy (local.get $d) (local.get $s) (i32.const 32)))
+  (func (export "copy_33") (param $d i32) (param $s i32)
+    (memory.copy (local.get $d) (local.get $s) (i32.const 33)))
+  (func (export "copy_47") (param $d i32) (param $s i32)
+    (memory.copy (local.get $d) (local.get $s) (i32.const 47)))
+  (func (export "copy_63") (param $d i32) (param $s i32)
+    (memory.copy (local.get $d) (local.get $s) (i32.const 63)))
+  (func (export "copy_64") (param $d i32) (param $s i32)
+    (memory.copy (local.get $d) (local.get $s) (i32.const 64)))
+  (func (export "copy_65") (param $d i32) (param $s i32)
+    (memory.copy (local.get $d) (local.get $s) (i32.const 65)))
+
+  (func (export "fill_0") (param $d i32) (param $v i32)
+    (memory.fill (local.get $d) (local.get $v) (i32.const 0)))
+  (func (export "fill_1") (param $d i32) (param $v i32)
+    (memory.fill (local.get $d) (local.get $v) (i32.const 1)))
+  (func (export "fill_2") (param $d i32) (param $v i32)
+    (memory.fill (local.get $d) (local.get $v) (i32.const 2)))
+  (func (export "fill_3") (param $d i32) (param $v i32)
+    (memory.fill (local.get $d) (local.get $v) (i32.const 3)))
+  (func (export "fill_4") (param $d i32) (param $v i32)
+    (memory.fill (local.get $d) (local.get $v) (i32.const 4)))
+  (func (export "fill_5") (param $d i32) (param $v i32)
+    (memory.fill (local.get $d) (local.get $v) (i32.const 5)))
+  (func (export "fill_7") (param $d i32) (param $v i32)
+    (memory.fill (local.get $d) (local.get $v) (i32.const 7)))
+  (func (export "fill_8") (param $d i32) (param $v i32)
+    (memory.fill (local.get $d) (local.get $v) (i32.const 8)))
+  (func (export "fill_9") (param $d i32) (param $v i32)
+    (memory.fill (local.get $d) (local.get $v) (i32.const 9)))
+  (func (export "fill_15") (param $d i32) (param $v i32)
+    (memory.fill (local.get $d) (local.get $v) (i32.const 15)))
+  (func (export "fill_16") (param $d i32) (param $v i32)
+    (memory.fill (local.get $d) (local.get $v) (i32.const 16)))
+  (func (export "fill_17") (param $d i32) (param $v i32)
+    (memory.fill (local.get $d) (local.get $v) (i32.const 17)))
+  (func (export "fill_31") (param $d i32) (param $v i32)
+    (memory.fill (local.get $d) (local.get $v) (i32.const 31)))
+  (func (export "fill_32") (param $d i32) (param $v i32)
+    (memory.fill (local.get $d) (local.get $v) (i32.const 32)))
+  (func (export "fill_33") (param $d i32) (param $v i32)
+    (memory.fill (local.get $d) (local.get $v) (i32.const 33)))
+  (func (export "fill_47") (param $d i32) (param $v i32)
+    (memory.fill (local.get $d) (local.get $v) (i32.const 47)))
+  (func (export "fill_63") (param $d i32) (param $v i32)
+    (memory.fill (local.get $d) (local.get $v) (i32.const 63)))
+  (func (export "fill_64") (param $d i32) (param $v i32)
+    (memory.fill (local.get $d) (local.get $v) (i32.const 64)))
+  (func (export "fill_65") (param $d i32) (param $v i32)
+    (memory.fill (local.get $d) (local.get $v) (i32.const 65)))
+
+  ;; The lengths aren't constant
+  (func (export "copy") (param $d i32) (param $s i32) (param $n i32)
+    (memory.copy (local.get $d) (local.get $s) (local.get $n)))
+
+  (func (export "fill") (param $d i32) (param $v i32) (param $n i32)
+    (memory.fill (local.get $d) (local.get $v) (local.get $n)))
+
+  ;; The offsets are constant too, the ranges of the first one don't
+  ;; overlap
+  (func (export "copy_const")
+    (memory.copy (i32.const 0x3000) (i32.const 0x2000) (i32.const 100)))
+
+  (func (export "copy_const_overlap")
+    (memory.copy (i32.const 0x2010) (i32.const 0x2000) (i32.const 100)))
+
+  (func (export "copy_const_small")
+    (memory.copy (i32.const 0x2000) (i32.const 0x2008) (i32.const 40)))
+)
@@ -0,0 +1,278 @@
+/*
+ * Copyright (C) 2019 Intel Corporation.  All rights reserved.
+ * SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+ */
+
+/*
+ * Checks memory.copy and memory.fill of bulk_memory.wasm against memmove
+ * and memset on a copy of the memory: the source and destination
+ * overlapping in both directions at each distance, the zero lengths, and
+ * the ranges ending at or just beyond the end of the memory, which should
+ * trap before any byte is written.
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "w2n_export.h"
+
+#define ARRAY_SIZE(array) (sizeof(array) / sizeof(array[0]))
+
+/* The window of the memory compared after each operation */
+#define WINDOW_BEGIN 0x1000
+#define WINDOW_SIZE 0x400
+#define BASE 0x1100
+
+typedef void (*CopyFunc)(int32_t, int32_t);
+typedef void (*FillFunc)(int32_t, int32_t);
+
+static const uint32_t lens[] = { 0,  1,  2,  3,  4,  5,  7,  8,  9, 15,
+                                 16, 17, 31, 32, 33, 47, 63, 64, 65 };
+
+static CopyFunc copy_funcs[ARRAY_SIZE(lens)];
+static FillFunc fill_funcs[ARRAY_SIZE(lens)];
+static void (*copy)(int32_t, int32_t, int32_t);
+static void (*fill)(int32_t, int32_t, int32_t);
+static void (*copy_const)(void), (*copy_const_overlap)(void);
+static void (*copy_const_small)(void);
+
+static uint8_t *memory;
+static uint32_t memory_size;
+static uint8_t expected[0x10000];
+static uint32_t seed = 1;
+static int failed;
+
+static void *
+lookup_func(const char *name)
+{
+    WASMExportApi *export_apis = wasm_get_export_apis();
+    uint32_t i;
+
+    for (i = 0; i < wasm_get_export_api_num(); i++) {
+        if (!strcmp(export_apis[i].func_name, name))
+            return (void *)export_apis[i].func_ptr;
+    }
+    return NULL;
+}
+
+/* Fill the range with a new pattern and save the memory as expected */
+static void
+reset_memory(uint32_t begin, uint32_t size)
+{
+    uint32_t i;
+
+    for (i = 0; i < size; i++) {
+        seed = seed * 1103515245 + 12345;
+        memory[begin + i] = (uint8_t)(seed >> 16);
+    }
+    memcpy(expected, memory, memory_size);
+}
+
+static void
+check_memory(const char *what, uint32_t len, int64_t arg)
+{
+    uint32_t i;
+
+    if (wasm_get_exception()) {
+        printf("%s %u (%lld): unexpected exception: %s\n", what, len,
+               (long long)arg, wasm_get_exception_msg());
+        wasm_set_exception(0);
+        failed = 1;
+        return;
+    }
+
+    if (!memcmp(memory, expected, memory_size))
+        return;
+
+    for (i = 0; i < memory_size; i++) {
+        if (memory[i] != expected[i]) {
+            printf("%s %u (%lld): byte 0x%x is 0x%02x, expected 0x%02x\n",
+                   what, len, (long long)arg, i, memory[i], expected[i]);
+            failed = 1;
+            return;
+        }
+    }
+}
+
+static void
+check_trap(const char *what, uint32_t len, int64_t arg)
+{
+    const char *msg = wasm_get_exception_msg();
+
+    if (!wasm_get_exception()) {
+        printf("%s %u (%lld): didn't trap\n", what, len, (long long)arg);
+        failed = 1;
+        return;
+    }
+    if (!msg || !strstr(msg, "out of bounds memory access")) {
+        printf("%s %u (%lld): unexpected exception: %s\n", what, len,
+               (long long)arg, msg ? msg : "");
+        failed = 1;
+    }
+    wasm_set_exception(0);
+
+    /* nothing is written before the trap */
+    check_memory(what, len, arg);
+}
+
+static void
+test_copy_overlap(void)
+{
+    uint32_t i, len;
+    int32_t dist;
+
+    for (i = 0; i < ARRAY_SIZE(lens); i++) {
+        len = lens[i];
+        /* the destination before and after the source, with the ranges
+           overlapping at each distance and then apart */
+        for (dist = -(int32_t)len - 2; dist <= (int32_t)len + 2; dist++) {
+            reset_memory(WINDOW_BEGIN, WINDOW_SIZE);
+            memmove(expected + BASE + dist, expected + BASE, len);
+            copy_funcs[i](BASE + dist, BASE);
+            check_memory("copy overlapping", len, dist);
+
+            reset_memory(WINDOW_BEGIN, WINDOW_SIZE);
+            memmove(expected + BASE + dist, expected + BASE, len);
+            copy(BASE + dist, BASE, (int32_t)len);
+            check_memory("generic copy overlapping", len, dist);
+        }
+    }
+}
+
+static void
+test_fill(void)
+{
+    uint32_t i, len, align;
+
+    for (i = 0; i < ARRAY_SIZE(lens); i++) {
+        len = lens[i];
+        for (align = 0; align < 16; align++) {
+            /* only the low byte of the value is stored */
+            reset_memory(WINDOW_BEGIN, WINDOW_SIZE);
+            memset(expected + BASE + align, 0xa5, len);
+            fill_funcs[i](BASE + align, 0x1a5);
+            check_memory("fill", len, align);
+
+            reset_memory(WINDOW_BEGIN, WINDOW_SIZE);
+            memset(expected + BASE + align, 0x3c, len);
+            fill(BASE + align, 0x3c, (int32_t)len);
+            check_memory("generic fill", len, align);
+        }
+    }
+}
+
+static void
+test_bounds(void)
+{
+    uint32_t i, len, end = memory_size;
+
+    for (i = 0; i < ARRAY_SIZE(lens); i++) {
+        len = lens[i];
+
+        /* the ranges ending at the end of the memory are in bounds, also
+           the zero length ones starting there */
+        reset_memory(end - 0x100, 0x100);
+        memmove(expected + end - len, expected + end - 0x80, len);
+        copy_funcs[i](end - len, end - 0x80);
+        check_memory("copy to the end", len, end - len);
+
+        reset_memory(end - 0x100, 0x100);
+        memmove(expected + end - 0x80, expected + end - len, len);
+        copy_funcs[i](end - 0x80, end - len);
+        check_memory("copy from the end", len, end - len);
+
+        reset_memory(end - 0x100, 0x100);
+        memset(expected + end - len, 0x77, len);
+        fill_funcs[i](end - len, 0x77);
+        check_memory("fill to the end", len, end - len);
+
+        /* one byte beyond the end traps, the zero length ones too */
+        reset_memory(end - 0x100, 0x100);
+        copy_funcs[i](end - len + 1, end - 0x80);
+        check_trap("copy beyond the end", len, end - len + 1);
+
+        copy_funcs[i](end - 0x80, end - len + 1);
+        check_trap("copy from beyond the end", len, end - len + 1);
+
+        fill_funcs[i](end - len + 1, 0x77);
+        check_trap("fill beyond the end", len, end - len + 1);
+
+        /* the offsets are unsigned */
+        copy_funcs[i](-1, 0);
+        check_trap("copy to a negative offset", len, -1);
+
+        copy_funcs[i](0, -1);
+        check_trap("copy from a negative offset", len, -1);
+
+        fill_funcs[i](-1, 0x77);
+        check_trap("fill at a negative offset", len, -1);
+    }
+}
+
+static void
+test_const_offsets(void)
+{
+    reset_memory(0x2000, 0x1100);
+    memmove(expected + 0x3000, expected + 0x2000, 100);
+    copy_const();
+    check_memory("copy with the constant offsets", 100, 0x3000);
+
+    reset_memory(0x2000, 0x1100);
+    memmove(expected + 0x2010, expected + 0x2000, 100);
+    copy_const_overlap();
+    check_memory("copy with the constant offsets overlapping", 100, 0x2010);
+
+    reset_memory(0x2000, 0x1100);
+    memmove(expected + 0x2000, expected + 0x2008, 40);
+    copy_const_small();
+    check_memory("inline copy with the constant offsets", 40, 0x2000);
+}
+
+int
+main(void)
+{
+    char name[32];
+    uint32_t i;
+
+    wasm_instance_create();
+    if (!wasm_instance_is_created()) {
+        printf("Create wasm instance failed\n");
+        return 1;
+    }
+
+    for (i = 0; i < ARRAY_SIZE(lens); i++) {
+        snprintf(name, sizeof(name), "copy_%u", lens[i]);
+        if (!(copy_funcs[i] = (CopyFunc)lookup_func(name)))
+            break;
+        snprintf(name, sizeof(name), "fill_%u", lens[i]);
+        if (!(fill_funcs[i] = (FillFunc)lookup_func(name)))
+            break;
+    }
+    if (i < ARRAY_SIZE(lens) || !(copy = lookup_func("copy"))
+        || !(fill = lookup_func("fill"))
+        || !(copy_const = lookup_func("copy_const"))
+        || !(copy_const_overlap = lookup_func("copy_const_overlap"))
+        || !(copy_const_small = lookup_func("copy_const_small"))) {
+        printf("Lookup the wasm functions failed\n");
+        return 1;
+    }
+
+    memory = wasm_get_memory();
+    memory_size = (uint32_t)wasm_get_memory_size();
+    if (memory_size != sizeof(expected)) {
+        printf("Unexpected memory size %u\n", memory_size);
+        return 1;
+    }
+
+    test_copy_overlap();
+    test_fill();
+    test_bounds();
+    test_const_offsets();
+
+    wasm_instance_destroy();
+    if (failed)
+        return 1;
+
+    printf("All checks passed\n");
+    return 0;
+}
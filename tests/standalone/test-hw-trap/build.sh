@@ -0,0 +1,51 @@
+#!/bin/bash
+
+# Copyright (C) 2019 Intel Corporation.  All rights reserved.
+# SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+if [[ -z ${WASM2NATIVE_DIR} ]]; then
+    WASM2NATIVE_DIR=$PWD/../../..
+fi
+
+WORK_DIR=$PWD
+WASM2NATIVE_CMD=${WASM2NATIVE_DIR}/wasm2native-compiler/build/wasm2native
+
+rm -fr out && mkdir -p out
+
+echo "Build wasm2native-vmlib .."
+rm -fr build && mkdir -p build
+cd build
+cmake ${WASM2NATIVE_DIR}/wasm2native-vmlib -DW2N_BUILD_WASM_APPLICATION=1
+make -j
+
+cd ${WORK_DIR}
+
+echo "Build test_main.wasm with wasi-sdk .."
+/opt/wasi-sdk/bin/clang -O3 \
+        -nostdlib -Wl,--no-entry -Wl,--export=__main_void \
+        -Wl,--export=__wasm_call_ctors -Wl,--allow-undefined \
+        -o out/test_main.wasm \
+        main.c
+
+echo "Build test_ctor.wasm with wasi-sdk .."
+/opt/wasi-sdk/bin/clang -O3 -DTRAP_IN_CTOR \
+        -nostdlib -Wl,--no-entry -Wl,--export=__main_void \
+        -Wl,--export=__wasm_call_ctors -Wl,--allow-undefined \
+        -o out/test_ctor.wasm \
+        main.c
+
+cd ${WORK_DIR}/out
+
+echo "Compile test_main.wasm into test_main.o"
+${WASM2NATIVE_CMD} --format=object --enable-hw-trap -o test_main.o test_main.wasm
+
+echo "Compile test_ctor.wasm into test_ctor.o"
+${WASM2NATIVE_CMD} --format=object --enable-hw-trap -o test_ctor.o test_ctor.wasm
+
+echo "Generate test_main binary"
+gcc -O3 -o test_main test_main.o -L ../build -lvmlib -lm
+
+echo "Generate test_ctor binary"
+gcc -O3 -o test_ctor test_ctor.o -L ../build -lvmlib -lm
+
+echo "Done"
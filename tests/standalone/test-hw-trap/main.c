@@ -0,0 +1,24 @@
+/*
+ * Copyright (C) 2019 Intel Corporation.  All rights reserved.
+ * SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+ */
+
+#include <stdio.h>
+
+/* Not a constant, so that the division isn't folded or checked */
+volatile int zero = 0;
+
+#ifdef TRAP_IN_CTOR
+__attribute__((constructor)) static void
+init(void)
+{
+    printf("ctor: %d\n", 1 / zero);
+}
+#endif
+
+int
+main(void)
+{
+    printf("main: %d\n", 100 / zero);
+    return 0;
+}
@@ -0,0 +1,32 @@
+#!/bin/bash
+
+# Copyright (C) 2019 Intel Corporation.  All rights reserved.
+# SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+OUT_DIR=$PWD/out
+
+cd $OUT_DIR
+
+# The division by zero traps with SIGFPE, which should be reported as
+# the exception instead of killing the process, also in the constructor
+# called when the instance is created
+for test in test_main test_ctor; do
+    echo ""
+    echo "Run ${test} .."
+    ./${test} > ${test}.log 2>&1
+    ret=$?
+    cat ${test}.log
+
+    # A failure exits with 1 or 255, and a signal with 128 + signum
+    if [ ${ret} -gt 128 ] && [ ${ret} -lt 255 ]; then
+        echo "${test} was killed by signal $((ret - 128))"
+        exit 1
+    fi
+    if ! grep -q "Exception: integer divide by zero" ${test}.log; then
+        echo "${test} didn't report the trap"
+        exit 1
+    fi
+done
+
+echo ""
+echo "Passed"
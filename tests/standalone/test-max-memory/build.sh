@@ -0,0 +1,85 @@
+#!/bin/bash
+
+# Copyright (C) 2019 Intel Corporation.  All rights reserved.
+# SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+if [[ -z ${WASM2NATIVE_DIR} ]]; then
+    WASM2NATIVE_DIR=$PWD/../../..
+fi
+
+WORK_DIR=$PWD
+WASM2NATIVE_CMD=${WASM2NATIVE_DIR}/wasm2native-compiler/build/wasm2native
+
+if [ -z "${WABT_HOME}" ]; then
+  echo "WABT_HOME is not set"
+  exit 1
+fi
+
+# Generate a module of $1 functions calling each other in a chain, which
+# is large enough to be compiled in several batches with --max-memory=1,
+# $2 is mixed into the constants so that two modules generated differ.
+# Only every 50th function is in the table, the others are internal
+function gen_wat()
+{
+    local func_num=$1 seed=$2 i
+
+    echo "(module"
+    echo "  (memory 1)"
+    echo "  (global \$g (mut i32) (i32.const ${seed}))"
+    echo "  (table $(((func_num + 49) / 50)) funcref)"
+    echo -n "  (elem (i32.const 0)"
+    for ((i = 0; i < func_num; i += 50)); do
+        echo -n " \$f${i}"
+    done
+    echo ")"
+    echo "  (data (i32.const 0) \"\\01\\02\\03\\04\\05\\06\\07\\08\")"
+    echo "  (func \$f0 (param i32) (result i32) (local.get 0))"
+    for ((i = 1; i < func_num; i++)); do
+        echo "  (func \$f${i} (param i32) (result i32)"
+        echo "    (global.set \$g (i32.add (global.get \$g) (i32.const $((i * seed)))))"
+        echo "    (i32.store (i32.const $((i * 4))) (local.get 0))"
+        echo "    (i32.add (call \$f$((i - 1)) (i32.xor (local.get 0) (i32.const ${i})))"
+        echo "             (i32.load (i32.const $(((i - 1) * 4))))))"
+    done
+    echo "  (func (export \"run\") (param i32) (result i32)"
+    echo "    (call \$f$((func_num - 1)) (local.get 0)))"
+    echo "  (func (export \"get_global\") (result i32) (global.get \$g))"
+    echo "  (func (export \"indirect\") (param i32 i32) (result i32)"
+    echo "    (call_indirect (param i32) (result i32) (local.get 1) (local.get 0)))"
+    echo ")"
+}
+
+rm -fr out && mkdir -p out
+
+echo "Build wasm2native-vmlib .."
+rm -fr build && mkdir -p build
+cd build
+cmake ${WASM2NATIVE_DIR}/wasm2native-vmlib
+make -j
+
+cd ${WORK_DIR}/out
+
+echo "Build chain_a.wasm and chain_b.wasm with wabt .."
+gen_wat 400 3 > chain_a.wat
+gen_wat 300 5 > chain_b.wat
+${WABT_HOME}/bin/wat2wasm -o chain_a.wasm chain_a.wat
+${WABT_HOME}/bin/wat2wasm -o chain_b.wasm chain_b.wat
+
+echo "Compile chain_a.wasm into test_whole.o"
+${WASM2NATIVE_CMD} --format=object -o test_whole.o chain_a.wasm
+
+echo "Compile chain_a.wasm and chain_b.wasm in batches"
+${WASM2NATIVE_CMD} --format=object --max-memory=1 \
+        -o test_batch.a chain_a.wasm
+${WASM2NATIVE_CMD} --format=object --max-memory=1 \
+        -o test_batch_b.a chain_b.wasm
+
+echo "Generate test_whole binary"
+gcc -O3 -I ${WASM2NATIVE_DIR}/core/iwasm/include -o test_whole \
+    ../main.c test_whole.o -L ../build -lvmlib -lm
+
+echo "Generate test_batch binary"
+gcc -O3 -I ${WASM2NATIVE_DIR}/core/iwasm/include -o test_batch \
+    ../main.c test_batch.a -L ../build -lvmlib -lm
+
+echo "Done"
@@ -0,0 +1,59 @@
+/*
+ * Copyright (C) 2019 Intel Corporation.  All rights reserved.
+ * SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "w2n_export.h"
+
+static void *
+lookup_func(const char *name)
+{
+    WASMExportApi *export_apis = wasm_get_export_apis();
+    uint32_t i;
+
+    for (i = 0; i < wasm_get_export_api_num(); i++) {
+        if (!strcmp(export_apis[i].func_name, name))
+            return (void *)export_apis[i].func_ptr;
+    }
+    return NULL;
+}
+
+int
+main(void)
+{
+    int32_t (*run)(int32_t), (*get_global)(void);
+    int32_t (*indirect)(int32_t, int32_t);
+    int32_t i;
+
+    wasm_instance_create();
+    if (!wasm_instance_is_created()) {
+        printf("Create wasm instance failed\n");
+        return 1;
+    }
+
+    if (!(run = lookup_func("run")) || !(get_global = lookup_func("get_global"))
+        || !(indirect = lookup_func("indirect"))) {
+        printf("Lookup the wasm functions failed\n");
+        return 1;
+    }
+
+    for (i = 0; i < 5; i++)
+        printf("run(%d): %d\n", (int)(i * 1000), (int)run(i * 1000));
+    printf("global: %d\n", (int)get_global());
+
+    /* call the functions of the batches through the table */
+    for (i = 0; i < 8; i++)
+        printf("indirect(%d): %d\n", (int)i, (int)indirect(i, i * 1000));
+
+    if (wasm_get_exception()) {
+        printf("Exception: %s\n", wasm_get_exception_msg());
+        wasm_instance_destroy();
+        return 1;
+    }
+
+    wasm_instance_destroy();
+    return 0;
+}
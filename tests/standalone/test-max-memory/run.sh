@@ -0,0 +1,42 @@
+#!/bin/bash
+
+# Copyright (C) 2019 Intel Corporation.  All rights reserved.
+# SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+OUT_DIR=$PWD/out
+
+cd $OUT_DIR
+
+member_num=$(ar t test_batch.a | wc -l)
+echo "test_batch.a has ${member_num} members"
+if [ ${member_num} -lt 2 ]; then
+    echo "the module wasn't compiled in batches"
+    exit 1
+fi
+
+# The symbols shared by the batches are hidden, they must be unique to
+# each module so that two modules compiled in batches can be linked
+# together
+for lib in test_batch test_batch_b; do
+    readelf -sW ${lib}.a | awk '$5 == "GLOBAL" && $6 == "HIDDEN" \
+        && $7 != "UND" { print $8 }' | sort -u > ${lib}.syms
+done
+if [ -n "$(comm -12 test_batch.syms test_batch_b.syms)" ]; then
+    echo "the hidden symbols of the two modules clash:"
+    comm -12 test_batch.syms test_batch_b.syms | head
+    exit 1
+fi
+
+echo "Run test_whole .."
+./test_whole | tee test_whole.log || exit 1
+echo ""
+echo "Run test_batch .."
+./test_batch | tee test_batch.log || exit 1
+
+if ! cmp -s test_whole.log test_batch.log; then
+    echo "the results compiled in batches differ"
+    exit 1
+fi
+
+echo ""
+echo "Passed"
@@ -0,0 +1,111 @@
+/*
+ * Copyright (C) 2019 Intel Corporation.  All rights reserved.
+ * SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <inttypes.h>
+
+#include "w2n_export.h"
+
+static int failed;
+
+static void *
+lookup_func(const char *name)
+{
+    WASMExportApi *export_apis = wasm_get_export_apis();
+    uint32_t i;
+
+    for (i = 0; i < wasm_get_export_api_num(); i++) {
+        if (!strcmp(export_apis[i].func_name, name))
+            return (void *)export_apis[i].func_ptr;
+    }
+    return NULL;
+}
+
+static int64_t
+combine(int32_t a, int64_t b, double c)
+{
+    return (int64_t)a * 1000000 + b * 1000 + (int64_t)(c * 10);
+}
+
+static int64_t
+expect_internal(int32_t x)
+{
+    return combine(x, (int64_t)(x * 3), (double)(x - 1) + 0.5);
+}
+
+static int64_t
+expect_in_table(int32_t x)
+{
+    return combine(x + 7, (int64_t)(x * x), (double)x * 2.5);
+}
+
+static int64_t
+expect_fib(int32_t n)
+{
+    int64_t a = 0, b = 1, t;
+
+    while (n-- > 0) {
+        t = a + b;
+        a = b;
+        b = t;
+    }
+    return a;
+}
+
+static void
+check(const char *what, int32_t arg, int64_t result, int64_t expected)
+{
+    if (wasm_get_exception()) {
+        printf("%s(%d): unexpected exception: %s\n", what, (int)arg,
+               wasm_get_exception_msg());
+        failed = 1;
+    }
+    else if (result != expected) {
+        printf("%s(%d): got %" PRId64 ", expected %" PRId64 "\n", what,
+               (int)arg, result, expected);
+        failed = 1;
+    }
+}
+
+int
+main(void)
+{
+    static const int32_t args[] = { 0, 1, -5, 42, 1000 };
+    int64_t (*direct)(int32_t), (*direct_table)(int32_t);
+    int64_t (*indirect)(int32_t), (*fib)(int32_t);
+    uint32_t i;
+
+    wasm_instance_create();
+    if (!wasm_instance_is_created()) {
+        printf("Create wasm instance failed\n");
+        return 1;
+    }
+
+    if (!(direct = lookup_func("direct"))
+        || !(direct_table = lookup_func("direct_table"))
+        || !(indirect = lookup_func("indirect"))
+        || !(fib = lookup_func("fib"))) {
+        printf("Lookup the wasm functions failed\n");
+        return 1;
+    }
+
+    for (i = 0; i < sizeof(args) / sizeof(args[0]); i++) {
+        check("direct", args[i], direct(args[i]), expect_internal(args[i]));
+        check("direct_table", args[i], direct_table(args[i]),
+              expect_in_table(args[i]));
+        check("indirect", args[i], indirect(args[i]),
+              expect_in_table(args[i]));
+    }
+    for (i = 0; i <= 90; i += 15)
+        check("fib", (int32_t)i, fib((int32_t)i), expect_fib((int32_t)i));
+
+    wasm_instance_destroy();
+    if (failed)
+        return 1;
+
+    printf("All checks passed\n");
+    return 0;
+}
@@ -0,0 +1,55 @@
+;; Copyright (C) 2019 Intel Corporation.  All rights reserved.
+;; SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+;; $internal and $fib_pair are only called directly, so they use the fast
+;; calling convention and return all their results in a struct, while
+;; $in_table may be called through the table and keeps the C convention,
+;; which returns the extra results through pointers
+(module
+  (type $t (func (param i32) (result i32 i64 f64)))
+  (table 1 funcref)
+  (elem (i32.const 0) $in_table)
+
+  (func $internal (type $t)
+    (local.get 0)
+    (i64.extend_i32_s (i32.mul (local.get 0) (i32.const 3)))
+    (f64.add (f64.convert_i32_s (i32.sub (local.get 0) (i32.const 1)))
+             (f64.const 0.5)))
+
+  (func $in_table (type $t)
+    (i32.add (local.get 0) (i32.const 7))
+    (i64.extend_i32_s (i32.mul (local.get 0) (local.get 0)))
+    (f64.mul (f64.convert_i32_s (local.get 0)) (f64.const 2.5)))
+
+  ;; Returns fib(n) and fib(n + 1), recursively
+  (func $fib_pair (param $n i32) (result i64 i64)
+    (local $a i64)
+    (local $b i64)
+    (if (result i64 i64) (i32.eqz (local.get $n))
+      (then (i64.const 0) (i64.const 1))
+      (else
+        (call $fib_pair (i32.sub (local.get $n) (i32.const 1)))
+        (local.set $b)
+        (local.set $a)
+        (local.get $b)
+        (i64.add (local.get $a) (local.get $b)))))
+
+  (func $combine (param i32 i64 f64) (result i64)
+    (i64.add
+      (i64.add (i64.mul (i64.extend_i32_s (local.get 0))
+                        (i64.const 1000000))
+               (i64.mul (local.get 1) (i64.const 1000)))
+      (i64.trunc_f64_s (f64.mul (local.get 2) (f64.const 10)))))
+
+  (func (export "direct") (param i32) (result i64)
+    (call $combine (call $internal (local.get 0))))
+
+  (func (export "direct_table") (param i32) (result i64)
+    (call $combine (call $in_table (local.get 0))))
+
+  (func (export "indirect") (param i32) (result i64)
+    (call $combine (call_indirect (type $t) (local.get 0) (i32.const 0))))
+
+  (func (export "fib") (param i32) (result i64)
+    (drop (call $fib_pair (local.get 0))))
+)
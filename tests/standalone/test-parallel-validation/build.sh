@@ -0,0 +1,109 @@
+#!/bin/bash
+
+# Copyright (C) 2019 Intel Corporation.  All rights reserved.
+# SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+if [[ -z ${WASM2NATIVE_DIR} ]]; then
+    WASM2NATIVE_DIR=$PWD/../../..
+fi
+
+WORK_DIR=$PWD
+WASM2NATIVE_CMD=${WASM2NATIVE_DIR}/wasm2native-compiler/build/wasm2native
+SERIAL_CMD=${WORK_DIR}/build_serial/wasm2native
+
+if [ -z "${WABT_HOME}" ]; then
+  echo "WABT_HOME is not set"
+  exit 1
+fi
+
+# Generate a module of $1 functions, which are validated in several chunks
+# by the loader threads. Each function has a br_table and calls the
+# previous one, and only the last one grows the memory. The function $2
+# has a type mismatch and the function $3 gets an unknown local, -1 for
+# none
+function gen_wat()
+{
+    local func_num=$1 mismatch=$2 unknown_local=$3 i
+
+    echo "(module"
+    echo "  (memory 1 4)"
+    echo "  (func \$f0 (param i32) (result i32) (local.get 0))"
+    for ((i = 1; i < func_num; i++)); do
+        echo "  (func \$f${i} (param i32) (result i32)"
+        if [ ${i} -eq ${mismatch} ]; then
+            echo "    (drop (i32.add (local.get 0) (i64.const ${i})))"
+        fi
+        if [ ${i} -eq ${unknown_local} ]; then
+            echo "    (drop (local.get 5))"
+        fi
+        echo "    (block \$b2"
+        echo "      (block \$b1"
+        echo "        (block \$b0"
+        echo "          (br_table \$b0 \$b1 \$b2 \$b1"
+        echo "            (i32.and (local.get 0) (i32.const 3))))"
+        echo "        (return (i32.add (local.get 0) (i32.const ${i}))))"
+        echo "      (return (call \$f$((i - 1))"
+        echo "                (i32.add (local.get 0) (i32.const 1)))))"
+        echo "    (i32.mul (call \$f$((i - 1))"
+        echo "               (i32.shr_u (local.get 0) (i32.const 1)))"
+        echo "             (i32.const 3)))"
+    done
+    echo "  (func (export \"run\") (param i32) (result i32)"
+    echo "    (call \$f$((func_num - 1)) (local.get 0)))"
+    echo "  (func (export \"grow\") (param i32) (result i32)"
+    echo "    (if (local.get 0)"
+    echo "      (then (drop (memory.grow (local.get 0)))))"
+    echo "    (memory.size))"
+    echo ")"
+}
+
+rm -fr out && mkdir -p out
+
+echo "Build wasm2native-vmlib .."
+rm -fr build && mkdir -p build
+cd build
+cmake ${WASM2NATIVE_DIR}/wasm2native-vmlib
+make -j
+
+cd ${WORK_DIR}
+
+# The reference of the differential test validates the functions in the
+# loading thread only
+echo "Build wasm2native with the serial validation .."
+rm -fr build_serial && mkdir -p build_serial
+cd build_serial
+cmake ${WASM2NATIVE_DIR}/wasm2native-compiler \
+      -DCMAKE_C_FLAGS="-DW2N_LOADER_THREAD_NUM=1"
+make -j
+
+cd ${WORK_DIR}/out
+
+echo "Build the wasm modules with wabt .."
+gen_wat 600 -1 -1 > valid.wat
+# Several functions fail in different chunks, the error of the lowest
+# function index should be reported whichever thread finds it first
+gen_wat 600 100 500 > invalid_a.wat
+gen_wat 600 500 100 > invalid_b.wat
+for module in valid invalid_a invalid_b; do
+    ${WABT_HOME}/bin/wat2wasm --no-check -o ${module}.wasm ${module}.wat
+done
+
+echo "Compile valid.wasm with the parallel and the serial validation"
+${WASM2NATIVE_CMD} --format=object -o test_parallel.o valid.wasm
+${SERIAL_CMD} --format=object -o test_serial.o valid.wasm
+
+echo "Compile the invalid modules with the parallel and the serial validation"
+for module in invalid_a invalid_b; do
+    ${WASM2NATIVE_CMD} --format=object -o ${module}.o ${module}.wasm \
+            > ${module}_parallel.log 2>&1
+    ${SERIAL_CMD} --format=object -o ${module}.o ${module}.wasm \
+            > ${module}_serial.log 2>&1
+done
+
+for test in test_parallel test_serial; do
+    echo "Generate ${test} binary"
+    gcc -O3 -I ${WASM2NATIVE_DIR}/core/iwasm/include -o ${test} \
+        ../main.c ${test}.o -L ../build -lvmlib -lm
+done
+
+echo "Done"
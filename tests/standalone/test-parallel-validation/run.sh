@@ -0,0 +1,45 @@
+#!/bin/bash
+
+# Copyright (C) 2019 Intel Corporation.  All rights reserved.
+# SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+OUT_DIR=$PWD/out
+
+cd $OUT_DIR
+
+# The loader derives the same module from the parallel validation, e.g.
+# the br_table caches and whether the memory may grow, so the objects
+# generated should be the same
+if ! cmp -s test_parallel.o test_serial.o; then
+    echo "the objects compiled with the parallel validation differ"
+    exit 1
+fi
+
+echo "Run test_parallel .."
+./test_parallel | tee test_parallel.log || exit 1
+echo ""
+echo "Run test_serial .."
+./test_serial | tee test_serial.log || exit 1
+
+if ! cmp -s test_parallel.log test_serial.log; then
+    echo "the results with the parallel validation differ"
+    exit 1
+fi
+
+for module in invalid_a invalid_b; do
+    echo ""
+    echo "Errors of ${module}.wasm:"
+    cat ${module}_parallel.log
+    if ! grep -q "load failed" ${module}_parallel.log; then
+        echo "${module}.wasm wasn't rejected"
+        exit 1
+    fi
+    if ! cmp -s ${module}_parallel.log ${module}_serial.log; then
+        echo "the serial validation reports:"
+        cat ${module}_serial.log
+        exit 1
+    fi
+done
+
+echo ""
+echo "Passed"
@@ -0,0 +1,32 @@
+#!/bin/bash
+
+# Copyright (C) 2019 Intel Corporation.  All rights reserved.
+# SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+if [[ -z ${WASM2NATIVE_DIR} ]]; then
+    WASM2NATIVE_DIR=$PWD/../../..
+fi
+
+WORK_DIR=$PWD
+
+rm -fr out && mkdir -p out
+
+echo "Build wasm2native-vmlib with the thread-safe heap .."
+rm -fr build && mkdir -p build
+cd build
+cmake ${WASM2NATIVE_DIR}/wasm2native-vmlib -DW2N_BUILD_THREAD_SAFE_HEAP=1
+make -j
+
+cd ${WORK_DIR}
+
+echo "Build test_heap .."
+gcc -O2 -o out/test_heap main.c \
+    -I ${WASM2NATIVE_DIR}/core/shared/mem-alloc \
+    -I ${WASM2NATIVE_DIR}/core/shared/utils \
+    -I ${WASM2NATIVE_DIR}/core/shared/platform/linux \
+    -I ${WASM2NATIVE_DIR}/core/shared/platform/include \
+    -I ${WASM2NATIVE_DIR}/core \
+    -DBH_PLATFORM_LINUX -DW2N_ENABLE_THREAD_SAFE_HEAP=1 \
+    -L build -lvmlib -lpthread -lm
+
+echo "Done"
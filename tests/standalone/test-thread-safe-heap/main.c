@@ -0,0 +1,186 @@
+/*
+ * Copyright (C) 2019 Intel Corporation.  All rights reserved.
+ * SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+ */
+
+/*
+ * Stress test of the thread-safe host-managed heap: several generations of
+ * threads allocate, fill and free objects concurrently, and hand some of
+ * them over to other threads to free. The content of each object is
+ * checked before it is freed, and all the memory should be returned to
+ * the heap after the threads exit.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <pthread.h>
+
+#include "mem_alloc.h"
+
+#define HEAP_SIZE (8 * 1024 * 1024)
+#define THREAD_NUM 8
+#define ROUND_NUM 20
+#define OP_NUM 20000
+#define LIVE_NUM 64
+#define SHARED_NUM 256
+
+typedef struct Object {
+    uint32_t size;
+    uint8_t tag;
+} Object;
+
+static mem_allocator_t heap;
+static Object *shared_objs[SHARED_NUM];
+static pthread_mutex_t shared_lock = PTHREAD_MUTEX_INITIALIZER;
+static volatile int failed;
+
+static uint32_t
+next_rand(uint32_t *state)
+{
+    *state ^= *state << 13;
+    *state ^= *state >> 17;
+    *state ^= *state << 5;
+    return *state;
+}
+
+static Object *
+alloc_object(uint32_t *state)
+{
+    /* mostly small objects served by the thread caches */
+    uint32_t size = next_rand(state) % 8 == 0 ? 256 + next_rand(state) % 4096
+                                               : 8 + next_rand(state) % 248;
+    Object *obj = mem_allocator_malloc(heap, size);
+
+    if (!obj)
+        return NULL;
+    obj->size = size;
+    obj->tag = (uint8_t)next_rand(state);
+    memset((uint8_t *)obj + sizeof(Object), obj->tag, size - sizeof(Object));
+    return obj;
+}
+
+static void
+free_object(Object *obj)
+{
+    uint8_t *p = (uint8_t *)obj + sizeof(Object);
+    uint32_t i;
+
+    for (i = 0; i < obj->size - sizeof(Object); i++) {
+        if (p[i] != obj->tag) {
+            printf("object %p of size %u was overwritten\n", (void *)obj,
+                   obj->size);
+            failed = 1;
+            break;
+        }
+    }
+    mem_allocator_free(heap, obj);
+}
+
+static void *
+worker(void *arg)
+{
+    Object *live[LIVE_NUM] = { 0 }, *obj;
+    uint32_t state = (uint32_t)(uintptr_t)arg * 2654435761u + 1;
+    uint32_t i, j;
+
+    for (i = 0; i < OP_NUM && !failed; i++) {
+        j = next_rand(&state) % LIVE_NUM;
+        if (live[j]) {
+            if (next_rand(&state) % 4 == 0) {
+                /* swap it with the one in the shared slot, which was
+                   likely allocated by another thread */
+                uint32_t k = next_rand(&state) % SHARED_NUM;
+
+                pthread_mutex_lock(&shared_lock);
+                obj = shared_objs[k];
+                shared_objs[k] = live[j];
+                pthread_mutex_unlock(&shared_lock);
+                live[j] = obj;
+            }
+            if (live[j])
+                free_object(live[j]);
+            live[j] = NULL;
+        }
+        else if (!(live[j] = alloc_object(&state))) {
+            printf("failed to allocate memory\n");
+            failed = 1;
+        }
+    }
+
+    for (j = 0; j < LIVE_NUM; j++) {
+        if (live[j])
+            free_object(live[j]);
+    }
+    return NULL;
+}
+
+static void *
+free_shared_objects(void *arg)
+{
+    uint32_t i;
+
+    for (i = 0; i < SHARED_NUM; i++) {
+        if (shared_objs[i])
+            free_object(shared_objs[i]);
+    }
+    return NULL;
+}
+
+int
+main(void)
+{
+    static uint8_t heap_buf[HEAP_SIZE];
+    pthread_t threads[THREAD_NUM];
+    mem_alloc_info_t info_before, info_after;
+    uint32_t round, i;
+
+    if (!(heap = mem_allocator_create(heap_buf, sizeof(heap_buf)))) {
+        printf("failed to create the heap\n");
+        return 1;
+    }
+    mem_allocator_get_alloc_info(heap, &info_before);
+
+    /* short-lived threads, so that the caches are released and taken
+       by the later threads */
+    for (round = 0; round < ROUND_NUM && !failed; round++) {
+        for (i = 0; i < THREAD_NUM; i++) {
+            if (pthread_create(&threads[i], NULL, worker,
+                               (void *)(uintptr_t)(round * THREAD_NUM + i))) {
+                printf("failed to create thread\n");
+                return 1;
+            }
+        }
+        for (i = 0; i < THREAD_NUM; i++)
+            pthread_join(threads[i], NULL);
+    }
+
+    /* free the objects left in a thread too, as the cache of the main
+       thread won't be released before the check below */
+    if (pthread_create(&threads[0], NULL, free_shared_objects, NULL)) {
+        printf("failed to create thread\n");
+        return 1;
+    }
+    pthread_join(threads[0], NULL);
+
+    if (failed)
+        return 1;
+
+    mem_allocator_get_alloc_info(heap, &info_after);
+    printf("alloc count: %llu, free count: %llu\n",
+           (unsigned long long)info_after.alloc_count,
+           (unsigned long long)info_after.free_count);
+    if (info_after.alloc_count != info_after.free_count
+        || info_after.total_free_size != info_before.total_free_size) {
+        printf("memory leaked, free size %u, expected %u\n",
+               info_after.total_free_size, info_before.total_free_size);
+        return 1;
+    }
+
+    if (mem_allocator_destroy(heap) != 0) {
+        printf("failed to destroy the heap\n");
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,25 @@
+#!/bin/bash
+
+# Copyright (C) 2019 Intel Corporation.  All rights reserved.
+# SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+WORK_DIR=$PWD
+OUT_DIR=$PWD/out
+
+# The thread-safe heap can't be migrated, so an object file emitted with
+# a growable host managed heap must fail to link with it
+if nm ${WORK_DIR}/build/libvmlib.a | grep -q " T mem_allocator_migrate$"; then
+    echo "mem_allocator_migrate is provided by the thread-safe heap"
+    exit 1
+fi
+
+cd $OUT_DIR
+
+echo "Run test_heap .."
+if ! ./test_heap; then
+    echo "test_heap failed"
+    exit 1
+fi
+
+echo ""
+echo "Passed"
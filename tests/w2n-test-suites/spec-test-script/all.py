@@ -141,7 +141,8 @@ def test_case(
     qemu_flag=False,
     qemu_firmware="",
     log="",
-    no_pty=False
+    no_pty=False,
+    bounds_mask_flag=False,
 ):
     CMD = [sys.executable, "runtest.py"]
     CMD.append("--wast2wasm")
@@ -170,6 +171,9 @@ def test_case(
     if memory64_flag:
         CMD.append("--memory64")
 
+    if bounds_mask_flag:
+        CMD.append("--bounds-mask")
+
     if log != "":
         CMD.append("--log-dir")
         CMD.append(log)
@@ -235,6 +239,7 @@ def test_suite(
     qemu_firmware="",
     log="",
     no_pty=False,
+    bounds_mask_flag=False,
 ):
     suite_path = pathlib.Path(SPEC_TEST_DIR).resolve()
     if not suite_path.exists():
@@ -285,6 +290,7 @@ def test_suite(
                         qemu_firmware,
                         log,
                         no_pty,
+                        bounds_mask_flag,
                     ],
                 )
 
@@ -319,6 +325,7 @@ def test_suite(
                     qemu_firmware,
                     log,
                     no_pty,
+                    bounds_mask_flag,
                 )
                 successful_case += 1
             except Exception as e:
@@ -397,6 +404,13 @@ def main():
         dest="memory64_flag",
         help="Running with memory64 feature",
     )
+    parser.add_argument(
+        "--bounds-mask",
+        action="store_true",
+        default=False,
+        dest="bounds_mask_flag",
+        help="Compile with --bounds-mode=mask and skip the out of bounds trap asserts",
+    )
     parser.add_argument(
         "cases",
         metavar="path_to__case",
@@ -438,7 +452,8 @@ def main():
             options.qemu_flag,
             options.qemu_firmware,
             options.log,
-            options.no_pty
+            options.no_pty,
+            options.bounds_mask_flag,
         )
         end = time.time_ns()
         print(
@@ -458,6 +473,7 @@ def main():
                     options.qemu_firmware,
                     options.log,
                     options.no_pty,
+                    options.bounds_mask_flag,
                 )
             else:
                 ret = True
@@ -294,6 +294,10 @@ parser.add_argument('--simd', default=False, action='store_true',
 parser.add_argument('--memory64', default=False, action='store_true',
         help='Test with Memory64')
 
+parser.add_argument('--bounds-mask', default=False, action='store_true',
+        help="Compile with --bounds-mode=mask, where the out of bounds "
+             "accesses wrap instead of trapping")
+
 parser.add_argument('--qemu', default=False, action='store_true',
         help="Enable QEMU")
 
@@ -1044,6 +1048,14 @@ def skip_test(form, skip_list):
             return True
     return False
 
+# In the bounds mask mode the out of bounds accesses wrap instead of
+# trapping, skip the invokes expected to trap so that their side effects
+# don't break the following asserts
+def skip_bounds_mask_trap(form, opts):
+    return opts.bounds_mask and re.match(
+        '^\(assert_trap\s+\(invoke\b.*"out of bounds memory access"\s*\)\s*$',
+        form, re.S)
+
 def compile_wast_to_wasm(form, wast_tempfile, wasm_tempfile, opts):
     log("Writing WAST module to '%s'" % wast_tempfile)
     with open(wast_tempfile, 'w') as file:
@@ -1083,6 +1095,9 @@ def compile_wasm_to_object(wasm_tempfile, native_tempfile, runner, opts, r, outp
     if output == 'ir':
         cmd.append("--format=llvmir-unopt")
 
+    if opts.bounds_mask:
+        cmd.append("--bounds-mode=mask")
+
     # disable llvm link time optimization as it might convert
     # code of tail call into code of dead loop, and stack overflow
     # exception isn't thrown in several cases
@@ -1250,6 +1265,9 @@ if __name__ == "__main__":
                 log(form)
             elif skip_test(form, C_SKIP_TESTS):
                 log("Skipping test: %s" % form[0:60])
+            elif skip_bounds_mask_trap(form, opts):
+                log("Skipping out of bounds trap in bounds mask mode: %s"
+                    % form[0:60])
             elif re.match("^\(assert_trap\s+\(module", form):
                 test_assert_with_exception(form, wast_tempfile, wasm_tempfile, native_tempfile, opts, r)
             elif re.match("^\(assert_exhaustion\\b.*", form):
@@ -20,6 +20,7 @@ function help()
     echo "                                       riscv64_lp64f|riscv64_lp64d|aarch64|aarch64_vfp)"
     echo "-S enable SIMD feature"
     echo "-W enable memory64 feature"
+    echo "-B compile with --bounds-mode=mask, and skip the out of bounds trap asserts"
     echo "-b use the wabt binary release package instead of compiling from the source code"
     echo "-P run the spec test parallelly"
     echo "-Q enable qemu"
@@ -36,6 +37,7 @@ TARGET="X86_64"
 COLLECT_CODE_COVERAGE=0
 ENABLE_SIMD=0
 ENABLE_MEMORY64=0
+ENABLE_BOUNDS_MASK=0
 # test case array
 TEST_CASE_ARR=()
 if [[ "$OSTYPE" == "msys" || "$OSTYPE" == "cygwin" ]]; then
@@ -51,7 +53,7 @@ QEMU_FIRMWARE=""
 TARGET_LIST=("AARCH64" "AARCH64_VFP" "ARMV7" "ARMV7_VFP" "THUMBV7" "THUMBV7_VFP" \
              "RISCV32" "RISCV32_ILP32F" "RISCV32_ILP32D" "RISCV64" "RISCV64_LP64F" "RISCV64_LP64D")
 
-while getopts ":s:cbm:CSWPQF:j:T:" opt
+while getopts ":s:cbm:CSWBPQF:j:T:" opt
 do
     OPT_PARSED="TRUE"
     case $opt in
@@ -90,6 +92,10 @@ do
         echo "enable wasm64(memory64) feature"
         ENABLE_MEMORY64=1
         ;;
+        B)
+        echo "enable bounds mask mode"
+        ENABLE_BOUNDS_MASK=1
+        ;;
         C)
         echo "enable code coverage"
         COLLECT_CODE_COVERAGE=1
@@ -261,6 +267,10 @@ function spec_test()
         ARGS_FOR_SPEC_TEST+="--memory64 "
     fi
 
+    if [[ 1 == ${ENABLE_BOUNDS_MASK} ]]; then
+        ARGS_FOR_SPEC_TEST+="--bounds-mask "
+    fi
+
     if [[ ${ENABLE_QEMU} == 1 ]]; then
         ARGS_FOR_SPEC_TEST+="--qemu "
         ARGS_FOR_SPEC_TEST+="--qemu-firmware ${QEMU_FIRMWARE} "
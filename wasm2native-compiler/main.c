@@ -4,6 +4,21 @@
  */
 
 #include <stdlib.h>
+#if defined(_WIN32) || defined(_WIN32_)
+#include <direct.h>
+#include <process.h>
+#define mkdir(path, mode) _mkdir(path)
+#define getpid _getpid
+#else
+#include <signal.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#include <unistd.h>
+/* The compile server listens on a Unix domain socket */
+#define ENABLE_COMPILE_SERVER 1
+#endif
 #include "bh_platform.h"
 #include "bh_read_file.h"
 #include "wasm_export.h"
@@ -13,6 +28,9 @@ static void
 print_help()
 {
     printf("Usage: wasm2native [options] -o output_file wasm_file\n");
+    printf("       wasm2native [options] --batch=<manifest>\n");
+    printf("       wasm2native [--cache-dir=<dir>] --server=<socket>\n");
+    printf("  wasm_file                 The wasm file to compile, or - to read it from stdin\n");
     printf("  --target=<arch-name>      Set the target arch, which has the general format: <arch><sub>\n");
     printf("                            <arch> = x86_64, i386, aarch64, arm, thumb, xtensa, mips,\n");
     printf("                                     riscv64, riscv32.\n");
@@ -40,15 +58,59 @@ print_help()
     printf("                            native host loads and stores without any bounds checking, and allows\n");
     printf("                            pointers to be shared between wasm and the host\n");
     printf("  --heap-size=n             Set host managed heap size in bytes, only supported when no-sandbox\n");
-    printf("                            mode is disabled, default is 0 KB\n");
+    printf("                            mode is disabled, default is 0 KB. If the wasm memory can grow, the\n");
+    printf("                            heap spans the tail of linear memory and grows when it runs out.\n");
+    printf("                            NOTE: the growable heap takes all the pages grown, so a module which\n");
+    printf("                            contains memory.grow is rejected, build it with a fixed-size memory\n");
+    printf("                            (initial pages equal to max pages) to append the heap instead\n");
+    printf("  --bounds-mode=<mode>      Set how the wasm memory accesses are kept in the linear memory:\n");
+    printf("                              check   Check the address and trap if out of bounds (default)\n");
+    printf("                              mask    Round the memory size up to a power of two and mask the\n");
+    printf("                                      address, out of bounds accesses wrap without trapping\n");
+    printf("  --max-memory=n            Compile the functions in batches which take about n MB of memory each\n");
+    printf("                            to bound the peak memory of huge modules, the output is then an archive\n");
+    printf("                            with an object file per batch, and the calls across batches aren't\n");
+    printf("                            inlined. Only for the object format, default is 0 (no batches)\n");
+    printf("  --cache-dir=<dir>         Keep the output files in the directory, and reuse the one compiled from\n");
+    printf("                            the same wasm file with the same options instead of compiling again\n");
+    printf("  --batch=<manifest>        Compile the modules listed in the manifest file with the options, a\n");
+    printf("                            line per module with the wasm file and the output file separated by\n");
+    printf("                            spaces, in a thread per host CPU, and report the time or the error of\n");
+    printf("                            each module without stopping at the failed ones\n");
+    printf("  --server=<socket>         Run as a compile server listening on the Unix domain socket, which\n");
+    printf("                            compiles the requests of the clients with a thread per host CPU, and\n");
+    printf("                            queues the requests when all the threads are busy\n");
+    printf("  --connect=<socket>        Send the wasm file and the options to the compile server listening on\n");
+    printf("                            the socket, and write the output it returns, the cache directory of\n");
+    printf("                            the server is used instead of the one of --cache-dir\n");
     printf("  --disable-simd            Disable the post-MVP 128-bit SIMD feature:\n");
     printf("                              currently 128-bit SIMD is supported for x86-64 and aarch64 targets,\n");
     printf("                              and by default it is enabled in them and disabled in other targets\n");
     printf("  --disable-llvm-lto        Disable the LLVM link time optimization\n");
+    printf("  --enable-aux-stack-check  Enable the auxiliary stack overflow/underflow check, the stack pointer\n");
+    printf("                            is guessed from the globals exported by the linker, e.g. __heap_base,\n");
+    printf("                            and a wrong guess makes the sets of another global trap\n");
+    printf("  --disable-aux-stack-check Disable the auxiliary stack overflow/underflow check (default)\n");
+    printf("  --trust-alignment-hints   Use the alignment immediates of wasm loads and stores as the alignment\n");
+    printf("                            of the native accesses, which may fault or be slow on strict-alignment\n");
+    printf("                            targets if the wasm app doesn't honor them\n");
+    printf("  --check-alignment-hints   Same as --trust-alignment-hints, and trap with \"unaligned memory access\"\n");
+    printf("                            if an address doesn't meet its alignment immediate, to validate them\n");
+    printf("  --enable-hw-trap          Let integer division by zero or overflow fault and map the SIGFPE to the\n");
+    printf("                            wasm exception instead of checking the divisor, and check the float to\n");
+    printf("                            integer conversions after converting, only for x86-64 Linux targets\n");
+    printf("  --enable-alloc-profiling  Record the index of the function calling malloc, calloc, realloc or\n");
+    printf("                            strdup, so the sampling allocation profiler can report call sites\n");
     printf("  -v=n                      Set log verbose level (0 to 5, default is 2), larger with more log\n");
     printf("  --version                 Show version information\n");
     printf("Examples: wasm2native -o test.aot test.wasm\n");
     printf("          wasm2native --target=i386 --format=object -o test.o test.wasm\n");
+    printf("          wasm-ld ... -o - | wasm2native -o test.o -\n");
+    printf("          wasm2native --max-memory=4096 -o test.a test.wasm\n");
+    printf("          wasm2native --cache-dir=$HOME/.cache/wasm2native -o test.o test.wasm\n");
+    printf("          wasm2native --opt-level=2 --batch=plugins.txt\n");
+    printf("          wasm2native --server=/tmp/w2n.sock &\n");
+    printf("          wasm2native --connect=/tmp/w2n.sock -o test.o test.wasm\n");
     printf("          wasm2native --target-abi=help\n");
     printf("          wasm2native --target=x86_64 --cpu=help\n");
 }
@@ -60,133 +122,765 @@ print_help()
         goto fail1;           \
     } while (0)
 
+/* Length of the cache key, the hex string of a SHA-256 hash */
+#define CACHE_KEY_LEN 64
+
+static bool
+copy_file(const char *src_name, const char *dst_name)
+{
+    FILE *src, *dst;
+    char buf[64 * 1024];
+    size_t size;
+    bool ret = true;
+
+    if (!(src = fopen(src_name, "rb")))
+        return false;
+
+    if (!(dst = fopen(dst_name, "wb"))) {
+        fclose(src);
+        return false;
+    }
+
+    while ((size = fread(buf, 1, sizeof(buf), src)) > 0) {
+        if (fwrite(buf, 1, size, dst) != size) {
+            ret = false;
+            break;
+        }
+    }
+
+    if (ferror(src))
+        ret = false;
+    fclose(src);
+    if (fclose(dst) != 0)
+        ret = false;
+    return ret;
+}
+
+/* Create the directory and its missing parents, the errors are ignored
+   as storing into the directory reports them */
+static void
+make_dirs(const char *dir)
+{
+    char path[512], sep;
+    char *p;
+
+    if (dir[0] == '\0' || strlen(dir) >= sizeof(path))
+        return;
+    strcpy(path, dir);
+
+    /* Skip the root, and create each parent in turn */
+    for (p = path + 1; *p != '\0'; p++) {
+        if (*p == '/' || *p == '\\') {
+            sep = *p;
+            *p = '\0';
+            mkdir(path, 0755);
+            *p = sep;
+        }
+    }
+    mkdir(path, 0755);
+}
+
+/* Store the output file into the cache, it is written to a temporary file
+   which is renamed at last, so that the compilers running in parallel never
+   see a partial file */
+static void
+store_cache_file(const char *cache_dir, const char *cache_file_name,
+                 const char *out_file_name)
+{
+    char tmp_file_name[512];
+
+    make_dirs(cache_dir);
+
+    /* The threads of --batch may store the same file at the same time */
+    if (snprintf(tmp_file_name, sizeof(tmp_file_name), "%s.%d.%lx.tmp",
+                 cache_file_name, (int)getpid(),
+                 (unsigned long)(uintptr_t)os_self_thread())
+        >= (int)sizeof(tmp_file_name)) {
+        LOG_WARNING("The cache directory %s is too long", cache_dir);
+        return;
+    }
+
+    if (!copy_file(out_file_name, tmp_file_name)) {
+        LOG_WARNING("Store the output to the cache %s failed", cache_dir);
+        remove(tmp_file_name);
+        return;
+    }
+
+    if (rename(tmp_file_name, cache_file_name) != 0) {
+        /* e.g. on Windows the cache file was just stored by another
+           compiler, whose output is the same */
+        remove(tmp_file_name);
+    }
+}
+
+/* Compile a wasm module in the buffer to the output file. If
+   reuse_target_machine is true, the target machine created is kept in
+   option->target_machine for the next modules compiled with the option */
+static bool
+compile_wasm_buffer(uint8 *wasm_file, uint32 wasm_file_size,
+                    const char *out_file_name, AOTCompOption *option,
+                    bool reuse_target_machine, char *error_buf,
+                    uint32 error_buf_size)
+{
+    wasm_module_t wasm_module = NULL;
+    aot_comp_data_t comp_data = NULL;
+    aot_comp_context_t comp_ctx = NULL;
+    bool ret = false;
+
+    if (wasm_file_size >= 4 /* length of MAGIC NUMBER */
+        && !(wasm_file[0] == '\0' && wasm_file[1] == 'a' && wasm_file[2] == 's'
+             && wasm_file[3] == 'm')) {
+        snprintf(error_buf, error_buf_size,
+                 "Invalid wasm file: magic header not detected");
+        return false;
+    }
+
+    /* load WASM module */
+    if (!(wasm_module = wasm_runtime_load(wasm_file, wasm_file_size, error_buf,
+                                          error_buf_size))) {
+        return false;
+    }
+
+    if (!(comp_data = aot_create_comp_data(wasm_module, option))) {
+        snprintf(error_buf, error_buf_size, "%s", aot_get_last_error());
+        goto fail1;
+    }
+
+    bh_print_time("Begin to create compile context");
+
+    if (!(comp_ctx = aot_create_comp_context(comp_data, option))) {
+        snprintf(error_buf, error_buf_size, "%s", aot_get_last_error());
+        goto fail2;
+    }
+
+    if (reuse_target_machine && !option->target_machine)
+        option->target_machine = aot_take_target_machine(comp_ctx);
+
+    bh_print_time("Begin to compile");
+
+    if (!aot_compile_wasm(comp_ctx)) {
+        snprintf(error_buf, error_buf_size, "%s", aot_get_last_error());
+        goto fail3;
+    }
+
+    switch (option->output_format) {
+        case AOT_LLVMIR_UNOPT_FILE:
+        case AOT_LLVMIR_OPT_FILE:
+            if (!aot_emit_llvm_file(comp_ctx, out_file_name)) {
+                snprintf(error_buf, error_buf_size, "%s",
+                         aot_get_last_error());
+                goto fail3;
+            }
+            break;
+        case AOT_OBJECT_FILE:
+            if (!aot_emit_object_file(comp_ctx, out_file_name)) {
+                snprintf(error_buf, error_buf_size, "%s",
+                         aot_get_last_error());
+                goto fail3;
+            }
+            break;
+        default:
+            break;
+    }
+
+    ret = true;
+
+fail3:
+    /* Destroy compiler context */
+    aot_destroy_comp_context(comp_ctx);
+
+fail2:
+    /* Destroy compile data */
+    aot_destroy_comp_data(comp_data);
+
+fail1:
+    /* Unload WASM module */
+    wasm_runtime_unload(wasm_module);
+
+    return ret;
+}
+
+/* Compile a wasm module in the buffer to the output file, and reuse or store
+   the output in the cache directory if it isn't NULL */
+static bool
+compile_wasm_cached(uint8 *wasm_file, uint32 wasm_file_size,
+                    const char *out_file_name, AOTCompOption *option,
+                    bool reuse_target_machine, const char *cache_dir,
+                    char *error_buf, uint32 error_buf_size)
+{
+    char cache_file_name[512] = { 0 };
+
+    /* Look up the output in the cache, the key is got before loading the
+       module as the loader may change the wasm file buffer */
+    if (cache_dir) {
+        char cache_key[CACHE_KEY_LEN + 1];
+
+        if (!aot_get_cache_key(wasm_file, wasm_file_size, option, cache_key,
+                               sizeof(cache_key))) {
+            snprintf(error_buf, error_buf_size, "%s", aot_get_last_error());
+            return false;
+        }
+
+        if (snprintf(cache_file_name, sizeof(cache_file_name), "%s/%s",
+                     cache_dir, cache_key)
+            >= (int)sizeof(cache_file_name)) {
+            snprintf(error_buf, error_buf_size,
+                     "The path of the cache directory is too long");
+            return false;
+        }
+
+        if (copy_file(cache_file_name, out_file_name)) {
+            LOG_VERBOSE("Reuse the output cached in %s", cache_file_name);
+            return true;
+        }
+    }
+
+    if (!compile_wasm_buffer(wasm_file, wasm_file_size, out_file_name, option,
+                             reuse_target_machine, error_buf, error_buf_size))
+        return false;
+
+    if (cache_file_name[0] != '\0')
+        store_cache_file(cache_dir, cache_file_name, out_file_name);
+
+    return true;
+}
+
+/* Read a wasm file, or stdin if the file name is -, the buffer is released
+   by bh_unmap_file */
+static uint8 *
+read_wasm_file(const char *wasm_file_name, uint32 *p_wasm_file_size,
+               char *error_buf, uint32 error_buf_size)
+{
+    uint8 *wasm_file;
+
+    if (!strcmp(wasm_file_name, "-")) {
+        /* read the WASM bin file from stdin, e.g. piped from the linker.
+           The whole stream is read before loading, functions aren't
+           compiled while the code section is still arriving: the loader
+           splits the module into sections before loading any of them,
+           and the data and custom sections after the code section are
+           needed to create the compile data, e.g. the data segments
+           and the relocations of the functions */
+        wasm_file = (uint8 *)bh_read_stream_to_buffer(fileno(stdin),
+                                                      p_wasm_file_size);
+    }
+    else {
+        /* map the WASM bin file, the module loaded keeps referring to the
+           sections in it, e.g. the code and data segments, so that they
+           needn't be read into memory as a whole */
+        wasm_file = (uint8 *)bh_map_file(wasm_file_name, p_wasm_file_size);
+    }
+
+    if (!wasm_file)
+        snprintf(error_buf, error_buf_size, "Read wasm file %s failed",
+                 wasm_file_name);
+    return wasm_file;
+}
+
+/* Compile a wasm file, or stdin if the file name is -, to the output file */
+static bool
+compile_wasm_file(const char *wasm_file_name, const char *out_file_name,
+                  AOTCompOption *option, const char *cache_dir,
+                  char *error_buf, uint32 error_buf_size)
+{
+    uint8 *wasm_file;
+    uint32 wasm_file_size;
+    bool ret;
+
+    if (!strcmp(wasm_file_name, out_file_name)) {
+        snprintf(error_buf, error_buf_size,
+                 "Error: input file and output file are the same");
+        return false;
+    }
+
+    bh_print_time("Begin to load wasm file");
+
+    if (!(wasm_file = read_wasm_file(wasm_file_name, &wasm_file_size,
+                                     error_buf, error_buf_size)))
+        return false;
+
+    ret = compile_wasm_cached(wasm_file, wasm_file_size, out_file_name, option,
+                              false, cache_dir, error_buf, error_buf_size);
+
+    /* unmap the file buffer */
+    bh_unmap_file((char *)wasm_file, wasm_file_size);
+    return ret;
+}
+
+#if W2N_ENABLE_PTHREAD != 0
+/* The stack of a batch or server thread, which runs the LLVM passes */
+#define COMPILE_THREAD_STACK_SIZE (8 * 1024 * 1024)
+#endif
+
+typedef struct BatchEntry {
+    char *wasm_file_name;
+    char *out_file_name;
+} BatchEntry;
+
+typedef struct BatchTask {
+    BatchEntry *entries;
+    uint32 entry_count;
+    AOTCompOption *option;
+    const char *cache_dir;
+    /* Protect next_entry, failed_count and the report */
+    korp_mutex lock;
+    uint32 next_entry;
+    uint32 failed_count;
+} BatchTask;
+
+static uint32
+get_host_cpu_count()
+{
+#if defined(_WIN32) || defined(_WIN32_)
+    SYSTEM_INFO sys_info;
+    GetNativeSystemInfo(&sys_info);
+    return (uint32)sys_info.dwNumberOfProcessors;
+#else
+    long count = sysconf(_SC_NPROCESSORS_ONLN);
+    return count > 0 ? (uint32)count : 1;
+#endif
+}
+
+static void *
+batch_thread(void *arg)
+{
+    BatchTask *task = (BatchTask *)arg;
+    /* A copy of the options for the target machine of the thread: it
+       doesn't depend on the LLVM context of each module, but it isn't
+       thread safe, so each thread creates one and reuses it */
+    AOTCompOption option = *task->option;
+    BatchEntry *entry;
+    char error_buf[128];
+    uint8 *wasm_file;
+    uint32 wasm_file_size, time_ms;
+    uint64 begin_us;
+    bool ret;
+
+    while (true) {
+        os_mutex_lock(&task->lock);
+        if (task->next_entry == task->entry_count) {
+            os_mutex_unlock(&task->lock);
+            break;
+        }
+        entry = task->entries + task->next_entry++;
+
+        /* Read the file under the lock, bh_map_file prints its errors,
+           which would interleave with the report lines */
+        begin_us = os_time_get_boot_us();
+        wasm_file = read_wasm_file(entry->wasm_file_name, &wasm_file_size,
+                                   error_buf, sizeof(error_buf));
+        os_mutex_unlock(&task->lock);
+
+        ret = false;
+        if (wasm_file) {
+            ret = compile_wasm_cached(wasm_file, wasm_file_size,
+                                      entry->out_file_name, &option, true,
+                                      task->cache_dir, error_buf,
+                                      sizeof(error_buf));
+            bh_unmap_file((char *)wasm_file, wasm_file_size);
+        }
+        time_ms = (uint32)((os_time_get_boot_us() - begin_us) / 1000);
+
+        os_mutex_lock(&task->lock);
+        if (ret) {
+            printf("ok     %6" PRIu32 " ms  %s -> %s\n", time_ms,
+                   entry->wasm_file_name, entry->out_file_name);
+        }
+        else {
+            printf("FAILED %6" PRIu32 " ms  %s: %s\n", time_ms,
+                   entry->wasm_file_name, error_buf);
+            task->failed_count++;
+        }
+        fflush(stdout);
+        os_mutex_unlock(&task->lock);
+    }
+
+    aot_destroy_target_machine(option.target_machine);
+    return NULL;
+}
+
+/* Parse the manifest in place, which ends with a NUL, each line is the wasm
+   file and the output file separated by spaces, the empty lines and the lines
+   starting with # are skipped */
+static BatchEntry *
+parse_batch_manifest(const char *manifest_name, char *manifest,
+                     uint32 manifest_size, uint32 *p_entry_count)
+{
+    BatchEntry *entries;
+    char *p = manifest, *p_end = manifest + manifest_size, *line, *tokens[3];
+    uint32 line_count = 1, entry_count = 0, line_no = 0, token_count;
+    uint64 size;
+
+    for (p = manifest; p < p_end; p++)
+        if (*p == '\n')
+            line_count++;
+
+    size = sizeof(BatchEntry) * (uint64)line_count;
+    if (size >= UINT32_MAX
+        || !(entries = BH_MALLOC((uint32)size))) {
+        printf("Allocate memory for the manifest failed.\n");
+        return NULL;
+    }
+
+    p = manifest;
+    while (p < p_end) {
+        line = p;
+        while (p < p_end && *p != '\n')
+            p++;
+        *p++ = '\0';
+        line_no++;
+
+        token_count = 0;
+        while (token_count < 3) {
+            while (*line == ' ' || *line == '\t' || *line == '\r')
+                line++;
+            if (*line == '\0' || (token_count == 0 && *line == '#'))
+                break;
+            tokens[token_count++] = line;
+            while (*line != '\0' && *line != ' ' && *line != '\t'
+                   && *line != '\r')
+                line++;
+            if (*line != '\0')
+                *line++ = '\0';
+        }
+
+        if (token_count == 0)
+            continue;
+        if (token_count != 2) {
+            printf("Invalid line %" PRIu32 " in %s, which should be the wasm "
+                   "file and the output file.\n",
+                   line_no, manifest_name);
+            BH_FREE(entries);
+            return NULL;
+        }
+
+        if (!strcmp(tokens[0], tokens[1])) {
+            printf("Invalid line %" PRIu32 " in %s, the input file and the "
+                   "output file are the same.\n",
+                   line_no, manifest_name);
+            BH_FREE(entries);
+            return NULL;
+        }
+
+        entries[entry_count].wasm_file_name = tokens[0];
+        entries[entry_count].out_file_name = tokens[1];
+        entry_count++;
+    }
+
+    *p_entry_count = entry_count;
+    return entries;
+}
+
+/* Compile the modules listed in the manifest with a thread per host CPU,
+   return the number of the modules failed, or -1 if the manifest is
+   invalid */
+static int
+compile_batch(const char *manifest_name, AOTCompOption *option,
+              const char *cache_dir)
+{
+    BatchTask task = { 0 };
+    char *content, *manifest;
+    uint32 manifest_size, thread_num = 0, i;
+    uint64 begin_us;
+#if W2N_ENABLE_PTHREAD != 0
+    korp_tid *tids = NULL;
+    uint64 size;
+#endif
+    int ret = -1;
+
+    if (!(content = bh_read_file_to_buffer(manifest_name, &manifest_size)))
+        return -1;
+
+    /* Copy the content with a NUL after it, which ends the last line */
+    if (manifest_size == UINT32_MAX
+        || !(manifest = BH_MALLOC(manifest_size + 1))) {
+        printf("Allocate memory for the manifest failed.\n");
+        BH_FREE(content);
+        return -1;
+    }
+    bh_memcpy_s(manifest, manifest_size + 1, content, manifest_size);
+    manifest[manifest_size] = '\0';
+    BH_FREE(content);
+
+    if (!(task.entries = parse_batch_manifest(manifest_name, manifest,
+                                              manifest_size,
+                                              &task.entry_count)))
+        goto fail1;
+
+    /* The settings printed by the threads would interleave, and they are
+       the same for all the modules */
+    option->quiet_mode = true;
+    task.option = option;
+    task.cache_dir = cache_dir;
+    if (os_mutex_init(&task.lock) != 0) {
+        printf("Init mutex failed.\n");
+        goto fail2;
+    }
+
+    begin_us = os_time_get_boot_us();
+
+#if W2N_ENABLE_PTHREAD != 0
+    thread_num = get_host_cpu_count();
+    if (thread_num > task.entry_count)
+        thread_num = task.entry_count;
+    /* The current thread is a worker too */
+    if (thread_num > 0)
+        thread_num--;
+
+    size = sizeof(korp_tid) * (uint64)thread_num;
+    if (thread_num > 0 && size < UINT32_MAX
+        && (tids = BH_MALLOC((uint32)size))) {
+        /* Compile with fewer threads if some of them can't be created */
+        for (i = 0; i < thread_num; i++) {
+            if (os_thread_create(&tids[i], batch_thread, &task,
+                                 COMPILE_THREAD_STACK_SIZE)
+                != 0)
+                break;
+        }
+        thread_num = i;
+    }
+    else {
+        thread_num = 0;
+    }
+#endif
+
+    batch_thread(&task);
+
+#if W2N_ENABLE_PTHREAD != 0
+    for (i = 0; i < thread_num; i++)
+        os_thread_join(tids[i], NULL);
+    if (tids)
+        BH_FREE(tids);
+#endif
+
+    printf("Compiled %" PRIu32 " modules with %" PRIu32 " threads in %" PRIu32
+           " ms, %" PRIu32 " failed.\n",
+           task.entry_count, thread_num + 1,
+           (uint32)((os_time_get_boot_us() - begin_us) / 1000),
+           task.failed_count);
+    ret = (int)task.failed_count;
+
+    os_mutex_destroy(&task.lock);
+fail2:
+    BH_FREE(task.entries);
+fail1:
+    BH_FREE(manifest);
+    return ret;
+}
+
 /* When print help info for target/cpu/target-abi/cpu-features, load this dummy
  * wasm file content rather than from an input file, the dummy wasm file content
  * is: magic header + version number */
 static unsigned char dummy_wasm_file[8] = { 0x00, 0x61, 0x73, 0x6D,
                                             0x01, 0x00, 0x00, 0x00 };
 
-int
-main(int argc, char *argv[])
+/* The options of the command line */
+typedef struct CommandArgs {
+    AOTCompOption option;
+    char *wasm_file_name;
+    char *out_file_name;
+    char *cache_dir;
+    char *batch_file_name;
+    char *server_path;
+    char *connect_path;
+    int log_verbose_level;
+    bool use_dummy_wasm;
+    bool show_version;
+} CommandArgs;
+
+/* Parse the options of the command line without the program name, the
+   arguments are referred to by the args. Return false if they are invalid */
+static bool
+parse_args(int argc, char *argv[], CommandArgs *args)
 {
-    char *wasm_file_name = NULL, *out_file_name = NULL;
-    uint8 *wasm_file = NULL;
-    uint32 wasm_file_size;
-    wasm_module_t wasm_module = NULL;
-    aot_comp_data_t comp_data = NULL;
-    aot_comp_context_t comp_ctx = NULL;
-    AOTCompOption option = { 0 };
-    char error_buf[128];
-    int log_verbose_level = 2;
-    bool size_level_set = false, use_dummy_wasm = false;
-    int exit_status = EXIT_FAILURE;
+    bool size_level_set = false;
 
-    option.opt_level = 3;
-    option.size_level = 3;
-    option.output_format = AOT_OBJECT_FILE;
-    option.enable_simd = true;
-    option.enable_aux_stack_check = true;
+    memset(args, 0, sizeof(CommandArgs));
+    args->log_verbose_level = 2;
+    args->option.opt_level = 3;
+    args->option.size_level = 3;
+    args->option.output_format = AOT_OBJECT_FILE;
+    args->option.bounds_mode = AOT_BOUNDS_MODE_CHECK;
+    args->option.enable_simd = true;
 
-    /* Process options */
-    for (argc--, argv++; argc > 0 && argv[0][0] == '-'; argc--, argv++) {
+    /* Process options, a single - is the input file of stdin */
+    for (; argc > 0 && argv[0][0] == '-' && argv[0][1] != '\0';
+         argc--, argv++) {
         if (!strcmp(argv[0], "-o")) {
             argc--, argv++;
             if (argc < 2)
-                PRINT_HELP_AND_EXIT();
-            out_file_name = argv[0];
+                return false;
+            args->out_file_name = argv[0];
         }
         else if (!strncmp(argv[0], "--target=", 9)) {
             if (argv[0][9] == '\0')
-                PRINT_HELP_AND_EXIT();
-            option.target_arch = argv[0] + 9;
-            if (!strcmp(option.target_arch, "help")) {
-                use_dummy_wasm = true;
+                return false;
+            args->option.target_arch = argv[0] + 9;
+            if (!strcmp(args->option.target_arch, "help")) {
+                args->use_dummy_wasm = true;
             }
         }
         else if (!strncmp(argv[0], "--target-abi=", 13)) {
             if (argv[0][13] == '\0')
-                PRINT_HELP_AND_EXIT();
-            option.target_abi = argv[0] + 13;
-            if (!strcmp(option.target_abi, "help")) {
-                use_dummy_wasm = true;
+                return false;
+            args->option.target_abi = argv[0] + 13;
+            if (!strcmp(args->option.target_abi, "help")) {
+                args->use_dummy_wasm = true;
             }
         }
         else if (!strncmp(argv[0], "--cpu=", 6)) {
             if (argv[0][6] == '\0')
-                PRINT_HELP_AND_EXIT();
-            option.target_cpu = argv[0] + 6;
-            if (!strcmp(option.target_cpu, "help")) {
-                use_dummy_wasm = true;
+                return false;
+            args->option.target_cpu = argv[0] + 6;
+            if (!strcmp(args->option.target_cpu, "help")) {
+                args->use_dummy_wasm = true;
             }
         }
         else if (!strncmp(argv[0], "--cpu-features=", 15)) {
             if (argv[0][15] == '\0')
-                PRINT_HELP_AND_EXIT();
-            option.cpu_features = argv[0] + 15;
-            if (!strcmp(option.cpu_features, "+help")) {
-                use_dummy_wasm = true;
+                return false;
+            args->option.cpu_features = argv[0] + 15;
+            if (!strcmp(args->option.cpu_features, "+help")) {
+                args->use_dummy_wasm = true;
             }
         }
         else if (!strncmp(argv[0], "--opt-level=", 12)) {
             if (argv[0][12] == '\0')
-                PRINT_HELP_AND_EXIT();
-            option.opt_level = (uint32)atoi(argv[0] + 12);
-            if (option.opt_level > 3)
-                option.opt_level = 3;
+                return false;
+            args->option.opt_level = (uint32)atoi(argv[0] + 12);
+            if (args->option.opt_level > 3)
+                args->option.opt_level = 3;
         }
         else if (!strncmp(argv[0], "--size-level=", 13)) {
             if (argv[0][13] == '\0')
-                PRINT_HELP_AND_EXIT();
-            option.size_level = (uint32)atoi(argv[0] + 13);
-            if (option.size_level > 3)
-                option.size_level = 3;
+                return false;
+            args->option.size_level = (uint32)atoi(argv[0] + 13);
+            if (args->option.size_level > 3)
+                args->option.size_level = 3;
             size_level_set = true;
         }
         else if (!strncmp(argv[0], "--format=", 9)) {
             if (argv[0][9] == '\0')
-                PRINT_HELP_AND_EXIT();
+                return false;
             else if (!strcmp(argv[0] + 9, "object"))
-                option.output_format = AOT_OBJECT_FILE;
+                args->option.output_format = AOT_OBJECT_FILE;
             else if (!strcmp(argv[0] + 9, "llvmir-unopt"))
-                option.output_format = AOT_LLVMIR_UNOPT_FILE;
+                args->option.output_format = AOT_LLVMIR_UNOPT_FILE;
             else if (!strcmp(argv[0] + 9, "llvmir-opt"))
-                option.output_format = AOT_LLVMIR_OPT_FILE;
+                args->option.output_format = AOT_LLVMIR_OPT_FILE;
             else {
                 printf("Invalid format %s.\n", argv[0] + 9);
-                PRINT_HELP_AND_EXIT();
+                return false;
             }
         }
         else if (!strncmp(argv[0], "-v=", 3)) {
-            log_verbose_level = atoi(argv[0] + 3);
-            if (log_verbose_level < 0 || log_verbose_level > 5)
-                PRINT_HELP_AND_EXIT();
+            args->log_verbose_level = atoi(argv[0] + 3);
+            if (args->log_verbose_level < 0 || args->log_verbose_level > 5)
+                return false;
         }
         else if (!strcmp(argv[0], "--no-sandbox-mode")) {
-            option.no_sandbox_mode = true;
+            args->option.no_sandbox_mode = true;
         }
         else if (!strncmp(argv[0], "--heap-size=", 12)) {
             if (argv[0][12] == '\0')
-                PRINT_HELP_AND_EXIT();
-            option.heap_size = atoi(argv[0] + 12);
+                return false;
+            args->option.heap_size = atoi(argv[0] + 12);
         }
+        else if (!strncmp(argv[0], "--bounds-mode=", 14)) {
+            if (argv[0][14] == '\0')
+                return false;
+            else if (!strcmp(argv[0] + 14, "check"))
+                args->option.bounds_mode = AOT_BOUNDS_MODE_CHECK;
+            else if (!strcmp(argv[0] + 14, "mask"))
+                args->option.bounds_mode = AOT_BOUNDS_MODE_MASK;
+            else {
+                printf("Invalid bounds mode %s.\n", argv[0] + 14);
+                return false;
+            }
+        }
+        else if (!strncmp(argv[0], "--max-memory=", 13)) {
+            char *end;
+            unsigned long max_memory;
+
+            if (argv[0][13] == '\0')
+                return false;
+            max_memory = strtoul(argv[0] + 13, &end, 10);
+            if (*end != '\0' || !isdigit((unsigned char)argv[0][13])
+                || max_memory == 0 || max_memory > UINT32_MAX) {
+                printf("Invalid max memory %s.\n", argv[0] + 13);
+                return false;
+            }
+            args->option.max_memory = (uint32)max_memory;
+        }
+        else if (!strncmp(argv[0], "--cache-dir=", 12)) {
+            if (argv[0][12] == '\0')
+                return false;
+            args->cache_dir = argv[0] + 12;
+        }
+        else if (!strncmp(argv[0], "--batch=", 8)) {
+            if (argv[0][8] == '\0')
+                return false;
+            args->batch_file_name = argv[0] + 8;
+        }
+#ifdef ENABLE_COMPILE_SERVER
+        else if (!strncmp(argv[0], "--server=", 9)) {
+            if (argv[0][9] == '\0')
+                return false;
+            args->server_path = argv[0] + 9;
+        }
+        else if (!strncmp(argv[0], "--connect=", 10)) {
+            if (argv[0][10] == '\0')
+                return false;
+            args->connect_path = argv[0] + 10;
+        }
+#endif
         else if (!strcmp(argv[0], "--disable-simd")) {
-            option.enable_simd = false;
+            args->option.enable_simd = false;
         }
         else if (!strcmp(argv[0], "--disable-llvm-lto")) {
-            option.disable_llvm_lto = true;
+            args->option.disable_llvm_lto = true;
+        }
+        else if (!strcmp(argv[0], "--enable-aux-stack-check")) {
+            args->option.enable_aux_stack_check = true;
+        }
+        else if (!strcmp(argv[0], "--disable-aux-stack-check")) {
+            args->option.enable_aux_stack_check = false;
+        }
+        else if (!strcmp(argv[0], "--trust-alignment-hints")) {
+            args->option.trust_alignment_hints = true;
+        }
+        else if (!strcmp(argv[0], "--check-alignment-hints")) {
+            args->option.check_alignment_hints = true;
+        }
+        else if (!strcmp(argv[0], "--enable-hw-trap")) {
+            args->option.enable_hw_trap = true;
+        }
+        else if (!strcmp(argv[0], "--enable-alloc-profiling")) {
+            args->option.enable_alloc_profiling = true;
         }
         else if (!strcmp(argv[0], "--version")) {
-            uint32 major, minor, patch;
-            wasm_runtime_get_version(&major, &minor, &patch);
-            printf("wasm2native %u.%u.%u\n", major, minor, patch);
-            return 0;
+            args->show_version = true;
+            return true;
         }
         else
-            PRINT_HELP_AND_EXIT();
+            return false;
     }
 
-    if (!use_dummy_wasm && (argc == 0 || !out_file_name))
-        PRINT_HELP_AND_EXIT();
+    if (args->server_path) {
+        if (argc > 0 || args->out_file_name || args->batch_file_name
+            || args->connect_path || args->use_dummy_wasm)
+            return false;
+    }
+    else if (args->batch_file_name) {
+        if (argc > 0 || args->out_file_name || args->connect_path
+            || args->use_dummy_wasm)
+            return false;
+    }
+    else if (!args->use_dummy_wasm && (argc == 0 || !args->out_file_name))
+        return false;
+
+    if (argc > 0)
+        args->wasm_file_name = argv[0];
 
     if (!size_level_set) {
         /**
@@ -195,125 +889,560 @@ main(int argc, char *argv[])
          * be able to meet the requirements of some AOT relocation
          * operations.
          */
-        if (option.target_abi && !strcmp(option.target_abi, "msvc")) {
+        if (args->option.target_abi
+            && !strcmp(args->option.target_abi, "msvc")) {
             LOG_VERBOSE("Set size level to 1 for Windows AOT file");
-            option.size_level = 1;
+            args->option.size_level = 1;
         }
 #if defined(_WIN32) || defined(_WIN32_) || defined(__APPLE__) \
     || defined(__MACH__)
-        if (!option.target_abi) {
+        if (!args->option.target_abi) {
             LOG_VERBOSE("Set size level to 1 for Windows or MacOS AOT file");
-            option.size_level = 1;
+            args->option.size_level = 1;
         }
 #endif
     }
 
-    if (!use_dummy_wasm) {
-        wasm_file_name = argv[0];
+    return true;
+}
 
-        if (!strcmp(wasm_file_name, out_file_name)) {
-            printf("Error: input file and output file are the same");
-            return -1;
+#ifdef ENABLE_COMPILE_SERVER
+/**
+ * The protocol of the compile server, the integers are 32-bit in the byte
+ * order of the host, as the client and the server run on the same host:
+ *   request:  magic, argument count, the arguments each with its length,
+ *             wasm file size, wasm file
+ *   response: status (0 if success), message length, message,
+ *             output file size, output file
+ * The arguments are the ones of the client's command line, which are
+ * parsed by the server as its own, except that the input and output files
+ * are replaced with the wasm file and the output file sent.
+ */
+#define SERVER_MAGIC 0x53324e57 /* "W2NS" */
+#define SERVER_MAX_ARG_NUM 256
+#define SERVER_MAX_ARG_LEN 4096
+#define SERVER_MAX_WASM_SIZE (1024 * 1024 * 1024)
+/* Timeout in seconds of each read and write of a connection, so that a
+   stalled client can't hold a server thread */
+#define SERVER_IO_TIMEOUT 30
+
+static bool
+send_all(int fd, const void *buf, uint32 size)
+{
+    const uint8 *p = (const uint8 *)buf;
+    ssize_t n;
+
+    while (size > 0) {
+        if ((n = write(fd, p, size)) < 0) {
+            if (errno == EINTR)
+                continue;
+            return false;
         }
+        p += n;
+        size -= (uint32)n;
     }
+    return true;
+}
 
-    /* initialize runtime environment */
-    if (!wasm_runtime_init()) {
-        printf("Init runtime environment failed.\n");
-        return -1;
+static bool
+recv_all(int fd, void *buf, uint32 size)
+{
+    uint8 *p = (uint8 *)buf;
+    ssize_t n;
+
+    while (size > 0) {
+        if ((n = read(fd, p, size)) <= 0) {
+            if (n < 0 && errno == EINTR)
+                continue;
+            return false;
+        }
+        p += n;
+        size -= (uint32)n;
     }
+    return true;
+}
 
-    bh_log_set_verbose_level(log_verbose_level);
+static bool
+send_uint32(int fd, uint32 value)
+{
+    return send_all(fd, &value, sizeof(uint32));
+}
 
-    bh_print_time("Begin to load wasm file");
+static bool
+recv_uint32(int fd, uint32 *p_value)
+{
+    return recv_all(fd, p_value, sizeof(uint32));
+}
+
+/* Receive a buffer with its size, the buffer has a NUL after the content */
+static uint8 *
+recv_buffer(int fd, uint32 max_size, uint32 *p_size)
+{
+    uint8 *buf;
+    uint32 size;
+
+    if (!recv_uint32(fd, &size) || size > max_size)
+        return NULL;
+
+    if (!(buf = BH_MALLOC(size + 1)))
+        return NULL;
+
+    if (!recv_all(fd, buf, size)) {
+        BH_FREE(buf);
+        return NULL;
+    }
 
-    if (use_dummy_wasm) {
-        /* load WASM byte buffer from dummy buffer */
-        wasm_file_size = sizeof(dummy_wasm_file);
-        wasm_file = dummy_wasm_file;
+    buf[size] = '\0';
+    *p_size = size;
+    return buf;
+}
+
+static bool
+send_response(int fd, bool success, const char *message, const uint8 *out,
+              uint32 out_size)
+{
+    uint32 len = (uint32)strlen(message);
+
+    return send_uint32(fd, success ? 0 : 1) && send_uint32(fd, len)
+           && send_all(fd, message, len) && send_uint32(fd, out_size)
+           && send_all(fd, out, out_size);
+}
+
+typedef struct ServerTask {
+    int listen_fd;
+    const char *server_path;
+    const char *cache_dir;
+    /* Protect the report */
+    korp_mutex lock;
+} ServerTask;
+
+/* Serve a compile request, return false if the request is invalid */
+static bool
+serve_request(ServerTask *task, int fd)
+{
+    CommandArgs args;
+    char *argv[SERVER_MAX_ARG_NUM] = { 0 };
+    char out_file_name[512], error_buf[128] = { 0 };
+    uint8 *wasm_file = NULL, *out = NULL;
+    uint32 magic, argc = 0, wasm_file_size, out_size = 0, size, i;
+    uint64 begin_us;
+    bool success = false, ret = false;
+
+    if (!recv_uint32(fd, &magic) || magic != SERVER_MAGIC
+        || !recv_uint32(fd, &argc) || argc > SERVER_MAX_ARG_NUM)
+        return false;
+
+    for (i = 0; i < argc; i++) {
+        if (!(argv[i] = (char *)recv_buffer(fd, SERVER_MAX_ARG_LEN, &size)))
+            goto fail;
+    }
+
+    if (!(wasm_file = recv_buffer(fd, SERVER_MAX_WASM_SIZE, &wasm_file_size)))
+        goto fail;
+
+    ret = true;
+    begin_us = os_time_get_boot_us();
+
+    /* The output is written to a file of the thread, then sent */
+    snprintf(out_file_name, sizeof(out_file_name), "%s.%lx.out",
+             task->server_path, (unsigned long)(uintptr_t)os_self_thread());
+
+    if (!parse_args((int)argc, argv, &args) || args.server_path
+        || args.batch_file_name || args.use_dummy_wasm || args.show_version) {
+        snprintf(error_buf, sizeof(error_buf),
+                 "Invalid options for the compile server");
     }
     else {
-        /* load WASM byte buffer from WASM bin file */
-        if (!(wasm_file = (uint8 *)bh_read_file_to_buffer(wasm_file_name,
-                                                          &wasm_file_size)))
-            goto fail2;
+        /* The requests are served in parallel, only the result of each
+           is reported */
+        args.option.quiet_mode = true;
+
+        /* The cache directory of the server is used, the relative path of
+           the client's may not be found by the server */
+        if (compile_wasm_cached(wasm_file, wasm_file_size, out_file_name,
+                                &args.option, false, task->cache_dir,
+                                error_buf, sizeof(error_buf))) {
+            if ((out = (uint8 *)bh_read_file_to_buffer(out_file_name,
+                                                       &out_size)))
+                success = true;
+            else
+                snprintf(error_buf, sizeof(error_buf),
+                         "Read the output file failed");
+        }
     }
+    remove(out_file_name);
 
-    if (wasm_file_size >= 4 /* length of MAGIC NUMBER */
-        && !(wasm_file[0] == '\0' && wasm_file[1] == 'a' && wasm_file[2] == 's'
-             && wasm_file[3] == 'm')) {
-        printf("Invalid wasm file: magic header not detected\n");
-        goto fail2;
+    os_mutex_lock(&task->lock);
+    if (success)
+        printf("ok     %6" PRIu32 " ms  %" PRIu32 " bytes\n",
+               (uint32)((os_time_get_boot_us() - begin_us) / 1000), out_size);
+    else
+        printf("FAILED %6" PRIu32 " ms  %s\n",
+               (uint32)((os_time_get_boot_us() - begin_us) / 1000), error_buf);
+    fflush(stdout);
+    os_mutex_unlock(&task->lock);
+
+    send_response(fd, success, error_buf, out, out_size);
+
+fail:
+    if (out)
+        BH_FREE(out);
+    if (wasm_file)
+        BH_FREE(wasm_file);
+    for (i = 0; i < argc; i++) {
+        if (argv[i])
+            BH_FREE(argv[i]);
     }
+    return ret;
+}
 
-    /* load WASM module */
-    if (!(wasm_module = wasm_runtime_load(wasm_file, wasm_file_size, error_buf,
-                                          sizeof(error_buf)))) {
-        printf("%s\n", error_buf);
-        goto fail3;
+static void *
+server_thread(void *arg)
+{
+    ServerTask *task = (ServerTask *)arg;
+    struct timeval timeout = { SERVER_IO_TIMEOUT, 0 };
+    int fd;
+
+    /* The threads accept the connections in turn, a connection waits in
+       the backlog until a thread is free, which limits the compilations
+       running at a time to the number of threads */
+    while (true) {
+        if ((fd = accept(task->listen_fd, NULL, NULL)) < 0) {
+            if (errno == EINTR || errno == ECONNABORTED)
+                continue;
+            break;
+        }
+        if (setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout,
+                       sizeof(timeout))
+                != 0
+            || setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &timeout,
+                          sizeof(timeout))
+                   != 0)
+            LOG_WARNING("Set the timeout of a connection failed");
+        else if (!serve_request(task, fd))
+            LOG_WARNING("Drop an invalid request to the compile server");
+        close(fd);
     }
 
-    if (!(comp_data = aot_create_comp_data(wasm_module, &option))) {
-        printf("%s\n", aot_get_last_error());
-        goto fail4;
+    return NULL;
+}
+
+/* Run the compile server until it is killed, with a thread per host CPU */
+/* Remove the socket left by a server killed before, fail if the path
+   isn't a socket or a server is still listening on it */
+static bool
+remove_stale_socket(const char *server_path, const struct sockaddr_un *addr)
+{
+    struct stat stat_buf;
+    int fd, ret;
+
+    if (lstat(server_path, &stat_buf) != 0) {
+        if (errno == ENOENT)
+            return true;
+        printf("Check the socket %s failed.\n", server_path);
+        return false;
     }
 
-    bh_print_time("Begin to create compile context");
+    if (!S_ISSOCK(stat_buf.st_mode)) {
+        printf("%s exists and isn't a socket.\n", server_path);
+        return false;
+    }
 
-    if (!(comp_ctx = aot_create_comp_context(comp_data, &option))) {
-        printf("%s\n", aot_get_last_error());
-        goto fail5;
+    if ((fd = socket(AF_UNIX, SOCK_STREAM, 0)) < 0) {
+        printf("Create socket failed.\n");
+        return false;
     }
+    ret = connect(fd, (const struct sockaddr *)addr, sizeof(*addr));
+    close(fd);
 
-    bh_print_time("Begin to compile");
+    if (ret == 0) {
+        printf("A compile server is already listening on %s.\n",
+               server_path);
+        return false;
+    }
+    /* Only the socket which refuses connections is left by a server */
+    if (errno != ECONNREFUSED) {
+        printf("Check the socket %s failed.\n", server_path);
+        return false;
+    }
+    if (unlink(server_path) != 0) {
+        printf("Remove the stale socket %s failed.\n", server_path);
+        return false;
+    }
+    return true;
+}
 
-    if (!aot_compile_wasm(comp_ctx)) {
-        printf("%s\n", aot_get_last_error());
-        goto fail6;
+static void
+run_compile_server(const char *server_path, const char *cache_dir)
+{
+    ServerTask task = { 0 };
+    struct sockaddr_un addr = { 0 };
+    uint32 thread_num = 0, i;
+#if W2N_ENABLE_PTHREAD != 0
+    korp_tid *tids = NULL;
+    uint64 size;
+#endif
+
+    if (strlen(server_path) >= sizeof(addr.sun_path)) {
+        printf("The socket path %s is too long.\n", server_path);
+        return;
     }
 
-    switch (option.output_format) {
-        case AOT_LLVMIR_UNOPT_FILE:
-        case AOT_LLVMIR_OPT_FILE:
-            if (!aot_emit_llvm_file(comp_ctx, out_file_name)) {
-                printf("%s\n", aot_get_last_error());
-                goto fail6;
-            }
-            break;
-        case AOT_OBJECT_FILE:
-            if (!aot_emit_object_file(comp_ctx, out_file_name)) {
-                printf("%s\n", aot_get_last_error());
-                goto fail6;
-            }
-            break;
-        default:
-            break;
+    addr.sun_family = AF_UNIX;
+    bh_memcpy_s(addr.sun_path, (uint32)sizeof(addr.sun_path), server_path,
+                (uint32)strlen(server_path));
+
+    if (!remove_stale_socket(server_path, &addr))
+        return;
+
+    if ((task.listen_fd = socket(AF_UNIX, SOCK_STREAM, 0)) < 0) {
+        printf("Create socket failed.\n");
+        return;
     }
 
-    bh_print_time("Compile end");
+    if (bind(task.listen_fd, (struct sockaddr *)&addr, sizeof(addr)) != 0
+        || listen(task.listen_fd, SOMAXCONN) != 0) {
+        printf("Listen on %s failed.\n", server_path);
+        goto fail1;
+    }
 
-    printf("Compile success, file %s was generated.\n", out_file_name);
-    exit_status = EXIT_SUCCESS;
+    /* A client may leave before the response is sent */
+    signal(SIGPIPE, SIG_IGN);
 
-fail6:
-    /* Destroy compiler context */
-    aot_destroy_comp_context(comp_ctx);
+    task.server_path = server_path;
+    task.cache_dir = cache_dir;
+    if (os_mutex_init(&task.lock) != 0) {
+        printf("Init mutex failed.\n");
+        goto fail2;
+    }
 
-fail5:
-    /* Destroy compile data */
-    aot_destroy_comp_data(comp_data);
+#if W2N_ENABLE_PTHREAD != 0
+    /* The current thread is a server thread too */
+    thread_num = get_host_cpu_count() - 1;
 
-fail4:
-    /* Unload WASM module */
-    wasm_runtime_unload(wasm_module);
+    size = sizeof(korp_tid) * (uint64)thread_num;
+    if (thread_num > 0 && size < UINT32_MAX
+        && (tids = BH_MALLOC((uint32)size))) {
+        /* Serve with fewer threads if some of them can't be created */
+        for (i = 0; i < thread_num; i++) {
+            if (os_thread_create(&tids[i], server_thread, &task,
+                                 COMPILE_THREAD_STACK_SIZE)
+                != 0)
+                break;
+        }
+        thread_num = i;
+    }
+    else {
+        thread_num = 0;
+    }
+#endif
 
-fail3:
-    /* free the file buffer */
-    if (!use_dummy_wasm) {
-        wasm_runtime_free(wasm_file);
+    printf("Compile server listening on %s with %" PRIu32 " threads.\n",
+           server_path, thread_num + 1);
+    fflush(stdout);
+
+    server_thread(&task);
+
+    /* Wake up the other threads waiting in accept */
+    shutdown(task.listen_fd, SHUT_RDWR);
+#if W2N_ENABLE_PTHREAD != 0
+    for (i = 0; i < thread_num; i++)
+        os_thread_join(tids[i], NULL);
+    if (tids)
+        BH_FREE(tids);
+#endif
+
+    os_mutex_destroy(&task.lock);
+fail2:
+    unlink(server_path);
+fail1:
+    if (task.listen_fd >= 0)
+        close(task.listen_fd);
+}
+
+/* Send the wasm file and the command line to the compile server, and write
+   the output file it sends back */
+static bool
+compile_on_server(const char *server_path, int argc, char *argv[],
+                  const char *wasm_file_name, const char *out_file_name,
+                  char *error_buf, uint32 error_buf_size)
+{
+    struct sockaddr_un addr = { 0 };
+    uint8 *wasm_file, *message = NULL, *out = NULL;
+    uint32 wasm_file_size, status, size, out_size, arg_count = 0;
+    FILE *file;
+    int fd = -1, i;
+    bool ret = false;
+
+    if (!strcmp(wasm_file_name, out_file_name)) {
+        snprintf(error_buf, error_buf_size,
+                 "Error: input file and output file are the same");
+        return false;
+    }
+
+    if (strlen(server_path) >= sizeof(addr.sun_path)) {
+        snprintf(error_buf, error_buf_size, "The socket path %s is too long",
+                 server_path);
+        return false;
+    }
+
+    if (!(wasm_file = read_wasm_file(wasm_file_name, &wasm_file_size,
+                                     error_buf, error_buf_size)))
+        return false;
+
+    if (wasm_file_size > SERVER_MAX_WASM_SIZE) {
+        snprintf(error_buf, error_buf_size,
+                 "The wasm file is too large for the compile server");
+        goto fail1;
+    }
+
+    addr.sun_family = AF_UNIX;
+    bh_memcpy_s(addr.sun_path, (uint32)sizeof(addr.sun_path), server_path,
+                (uint32)strlen(server_path));
+
+    if ((fd = socket(AF_UNIX, SOCK_STREAM, 0)) < 0
+        || connect(fd, (struct sockaddr *)&addr, sizeof(addr)) != 0) {
+        snprintf(error_buf, error_buf_size,
+                 "Connect to the compile server %s failed", server_path);
+        goto fail1;
+    }
+
+    /* Send the command line without --connect, which the server can't
+       parse */
+    for (i = 0; i < argc; i++) {
+        if (strncmp(argv[i], "--connect=", 10))
+            arg_count++;
+    }
+
+    snprintf(error_buf, error_buf_size,
+             "Communicate with the compile server %s failed", server_path);
+
+    if (!send_uint32(fd, SERVER_MAGIC) || !send_uint32(fd, arg_count))
+        goto fail2;
+    for (i = 0; i < argc; i++) {
+        if (!strncmp(argv[i], "--connect=", 10))
+            continue;
+        size = (uint32)strlen(argv[i]);
+        if (!send_uint32(fd, size) || !send_all(fd, argv[i], size))
+            goto fail2;
     }
+    if (!send_uint32(fd, wasm_file_size)
+        || !send_all(fd, wasm_file, wasm_file_size))
+        goto fail2;
+
+    if (!recv_uint32(fd, &status) || !(message = recv_buffer(fd, 4096, &size))
+        || !(out = recv_buffer(fd, UINT32_MAX - 1, &out_size)))
+        goto fail2;
+
+    if (status != 0) {
+        snprintf(error_buf, error_buf_size, "%s", (char *)message);
+        goto fail2;
+    }
+
+    if (!(file = fopen(out_file_name, "wb"))) {
+        snprintf(error_buf, error_buf_size, "Open file %s failed",
+                 out_file_name);
+        goto fail2;
+    }
+    if (fwrite(out, 1, out_size, file) != out_size) {
+        snprintf(error_buf, error_buf_size, "Write file %s failed",
+                 out_file_name);
+        fclose(file);
+        goto fail2;
+    }
+    fclose(file);
+
+    ret = true;
 
 fail2:
+    if (out)
+        BH_FREE(out);
+    if (message)
+        BH_FREE(message);
+fail1:
+    if (fd >= 0)
+        close(fd);
+    bh_unmap_file((char *)wasm_file, wasm_file_size);
+    return ret;
+}
+#endif /* end of ENABLE_COMPILE_SERVER */
+
+int
+main(int argc, char *argv[])
+{
+    CommandArgs args;
+    char error_buf[128];
+    int exit_status = EXIT_FAILURE;
+
+    if (!parse_args(argc - 1, argv + 1, &args))
+        PRINT_HELP_AND_EXIT();
+
+    if (args.show_version) {
+        uint32 major, minor, patch;
+        wasm_runtime_get_version(&major, &minor, &patch);
+        printf("wasm2native %u.%u.%u\n", major, minor, patch);
+        return 0;
+    }
+
+#ifdef ENABLE_COMPILE_SERVER
+    /* The client doesn't initialize LLVM, which the server did */
+    if (args.connect_path && !args.use_dummy_wasm) {
+        if (compile_on_server(args.connect_path, argc - 1, argv + 1,
+                              args.wasm_file_name, args.out_file_name,
+                              error_buf, sizeof(error_buf))) {
+            printf("Compile success, file %s was generated.\n",
+                   args.out_file_name);
+            exit_status = EXIT_SUCCESS;
+        }
+        else {
+            printf("%s\n", error_buf);
+        }
+        goto fail1;
+    }
+#endif
+
+    /* initialize runtime environment */
+    if (!wasm_runtime_init()) {
+        printf("Init runtime environment failed.\n");
+        return -1;
+    }
+
+    bh_log_set_verbose_level(args.log_verbose_level);
+
+#ifdef ENABLE_COMPILE_SERVER
+    if (args.server_path) {
+        run_compile_server(args.server_path, args.cache_dir);
+    }
+    else
+#endif
+    if (args.batch_file_name) {
+        /* Share the runtime and LLVM initialization among the modules */
+        if (compile_batch(args.batch_file_name, &args.option, args.cache_dir)
+            == 0)
+            exit_status = EXIT_SUCCESS;
+    }
+    else if (args.use_dummy_wasm) {
+        /* load WASM byte buffer from dummy buffer, the help info is
+           printed when creating the compile context */
+        if (!compile_wasm_buffer(dummy_wasm_file, sizeof(dummy_wasm_file),
+                                 args.out_file_name, &args.option, false,
+                                 error_buf, sizeof(error_buf)))
+            printf("%s\n", error_buf);
+    }
+    else {
+        if (compile_wasm_file(args.wasm_file_name, args.out_file_name,
+                              &args.option, args.cache_dir, error_buf,
+                              sizeof(error_buf))) {
+            bh_print_time("Compile end");
+            printf("Compile success, file %s was generated.\n",
+                   args.out_file_name);
+            exit_status = EXIT_SUCCESS;
+        }
+        else {
+            printf("%s\n", error_buf);
+        }
+    }
+
     /* Destroy runtime environment */
     wasm_runtime_destroy();
 
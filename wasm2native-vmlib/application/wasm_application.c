@@ -1786,6 +1786,8 @@ execute_main(int32 argc, char *argv[])
     bh_assert(invoke_native);
 
     invoke_native(export_main->func_ptr, argv1, argv1);
+    /* flush the output buffered by libc-builtin at the export boundary */
+    wasm_flush_output();
 
     if (argv_buf)
         mem_allocator_free(heap_handle, argv_buf);
@@ -2093,6 +2095,7 @@ execute_func(const char *name, int32 argc, char *argv[])
     }
 
     invoke_native(export_func->func_ptr, argv1, argv1);
+    wasm_flush_output();
     if (wasm_get_exception())
         goto fail;
 
@@ -90,3 +90,6 @@ endif ()
 if (W2N_BUILD_SPEC_TEST EQUAL 1)
   message ("     Spec test compatible mode enabled")
 endif ()
+if (W2N_BUILD_THREAD_SAFE_HEAP EQUAL 1)
+  message ("     Thread-safe host-managed heap enabled")
+endif ()
@@ -42,6 +42,10 @@ include_directories (${IWASM_DIR}/include)
 include_directories (${IWASM_DIR}/interpreter)
 
 option(EXCLUDE_PTREHAD_SROUCE "Exclude pthread from sources" ON)
+if (W2N_BUILD_THREAD_SAFE_HEAP EQUAL 1)
+  # The thread-safe heap requires the mutex APIs in posix_thread.c
+  set (EXCLUDE_PTREHAD_SROUCE OFF)
+endif ()
 include (${SHARED_DIR}/platform/${W2N_BUILD_PLATFORM}/shared_platform.cmake)
 include (${SHARED_DIR}/utils/shared_utils.cmake)
 include (${SHARED_DIR}/mem-alloc/mem_alloc.cmake)